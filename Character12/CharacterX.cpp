@@ -163,7 +163,10 @@ void CharacterX::LoadAssets()
 		m_shaderLib->CreateShader(Shader::Stage::VS, VS_BASE_PASS, L"VSBasePass.cso");
 		m_shaderLib->CreateShader(Shader::Stage::PS, PS_BASE_PASS, L"PSBasePass.cso");
 		m_shaderLib->CreateShader(Shader::Stage::PS, PS_ALPHA_TEST, L"PSAlphaTest.cso");
+		m_shaderLib->CreateShader(Shader::Stage::PS, PS_BASE_PASS_ARRAY, L"PSBasePassArray.cso");
+		m_shaderLib->CreateShader(Shader::Stage::PS, PS_ALPHA_TEST_ARRAY, L"PSAlphaTestArray.cso");
 		m_shaderLib->CreateShader(Shader::Stage::CS, CS_SKINNING, L"CSSkinning.cso");
+		m_shaderLib->CreateShader(Shader::Stage::CS, CS_SKINNING_QUANTIZED, L"CSSkinningQuantized.cso");
 	}
 
 	// Create the command list.
@@ -175,9 +178,10 @@ void CharacterX::LoadAssets()
 	// Load character asset
 	{
 		m_pInputLayout = Character::CreateInputLayout(m_graphicsPipelineLib.get());
-		const auto textureLib = make_shared<TextureLib::element_type>();
+		const auto textureLib = TextureLibrary::MakeShared();
 		const auto characterMesh = Character::LoadSDKMesh(m_device.get(), L"Assets/Bright/Stars.sdkmesh",
-			L"Assets/Bright/Stars.sdkmesh_anim", textureLib);
+			L"Assets/Bright/Stars.sdkmesh_anim", textureLib, nullptr, nullptr,
+			API::DIRECTX_12, MESH_LOAD_QUANTIZE_VERTICES | MESH_LOAD_PACK_TEXTURES);
 		if (!characterMesh) ThrowIfFailed(E_FAIL);
 
 		m_character = Character::MakeUnique(L"Stars");
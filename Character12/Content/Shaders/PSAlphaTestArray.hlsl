@@ -0,0 +1,11 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------
+// Definitions
+//--------------------------------------------------------------------------------------
+#define	_ALPHA_TEST_
+#define	_TEXTURE_ARRAY_
+
+#include "PSBasePass.hlsl"
@@ -10,12 +10,26 @@
 
 #include "Common.hlsli"
 
+#ifdef _TEXTURE_ARRAY_
+Texture2DArray g_albedo;
+
+cbuffer cbMaterialSlice
+{
+	uint g_slice;
+};
+#else
 Texture2D g_albedo;
+#endif
 SamplerState g_sampler;
 
 float4 main(PS_Input input) : SV_TARGET
 {
-	const float4 albedo = g_albedo.Sample(g_sampler, input.UV);
+	const float4 albedo = g_albedo.Sample(g_sampler,
+#ifdef _TEXTURE_ARRAY_
+		float3(input.UV, g_slice));
+#else
+		input.UV);
+#endif
 #ifdef _ALPHA_TEST_
 	clip(albedo.w - 0.667);
 #endif
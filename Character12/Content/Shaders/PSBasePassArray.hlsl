@@ -0,0 +1,10 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------
+// Definitions
+//--------------------------------------------------------------------------------------
+#define	_TEXTURE_ARRAY_
+
+#include "PSBasePass.hlsl"
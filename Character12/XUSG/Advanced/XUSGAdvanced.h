@@ -43,6 +43,12 @@ static const float	XUSG_zFar = 1000.0f;
 
 #include "Core/XUSG.h"
 
+// The classes implemented by the sources in this folder are built along with the app, and
+// the others are imported from the XUSG library
+#ifndef XUSG_ADVANCED_INTERFACE
+#define XUSG_ADVANCED_INTERFACE
+#endif
+
 namespace XUSG
 {
 	//--------------------------------------------------------------------------------------
@@ -59,9 +65,36 @@ namespace XUSG
 			ALPHA_MODE_CUSTOM
 		};
 
-		class XUSG_INTERFACE Loader
+		enum MipFilter : uint8_t
+		{
+			MIP_FILTER_BOX,
+			MIP_FILTER_KAISER
+		};
+
+		struct TextureInfo
+		{
+			uint32_t	Width;
+			uint32_t	Height;
+			uint32_t	Depth;
+			uint32_t	MipCount;
+			uint32_t	ArraySize;	// Including the faces of cube maps
+			Format		Format;
+			AlphaMode	AlphaMode;
+		};
+
+		class XUSG_ADVANCED_INTERFACE Loader
 		{
 		public:
+			// A range of the surface data in a DDS file
+			struct DataRange
+			{
+				uint64_t	Offset;
+				size_t		Size;
+			};
+
+			// The headers with the DX10 extension, as read from the start of a file
+			static const uint32_t MAX_HEADER_SIZE = 148;
+
 			Loader();
 			virtual ~Loader();
 
@@ -75,6 +108,30 @@ namespace XUSG
 				AlphaMode* alphaMode = nullptr, ResourceState state = ResourceState::COMMON,
 				MemoryFlag memoryFlags = MemoryFlag::NONE, API api = API::DIRECTX_12);
 
+			// Read and validate a DDS file without touching the device; safe to call from any thread.
+			// The mips over a non-zero maxsize are not read, and the header is changed to match.
+			static bool LoadTextureData(const wchar_t* fileName, std::vector<uint8_t>& ddsData, size_t maxsize = 0);
+			// Read and validate the headers of a DDS file only
+			static bool LoadTextureInfo(const wchar_t* fileName, TextureInfo& info);
+			// For reading a DDS file in pieces, e.g. in a batch: validate the headers from the leading
+			// bytes of the file, up to MAX_HEADER_SIZE, and get the ranges of the surface data within
+			// a non-zero maxsize. The headers in ddsData are changed to describe the kept mips, and
+			// appending the ranges in order makes the data of LoadTextureData().
+			static bool GetTextureDataRanges(const uint8_t* pHeaderData, size_t headerDataSize, uint64_t fileSize,
+				size_t maxsize, std::vector<uint8_t>& ddsData, std::vector<DataRange>& ranges);
+
+			// Size in bytes of a mip of an array slice, or of a depth slice of a volume mip
+			static size_t GetSurfaceSize(uint32_t width, uint32_t height, Format fmt);
+
+			// Transcode all the surfaces of a DDS file on the CPU, between R8G8B8A8 and BC1-BC5 or BC7
+			// (UNORM), into a DDS file with the DX10 header
+			static bool TranscodeTextureData(const uint8_t* ddsData, size_t ddsDataSize,
+				Format format, std::vector<uint8_t>& outData);
+			// Generate the mip chain of a DDS file with an uncompressed 2D texture or array of a single
+			// mip, filtered in linear space; returns false if the file has mips or is not supported
+			static bool GenerateMipmaps(const uint8_t* ddsData, size_t ddsDataSize,
+				MipFilter filter, std::vector<uint8_t>& outData);
+
 			static size_t BitsPerPixel(Format fmt);
 		};
 	}
@@ -95,14 +152,227 @@ namespace XUSG
 
 	XUSG_DEF_ENUM_FLAG_OPERATORS(SubsetFlags);
 
+	enum MeshLoadFlags : uint16_t
+	{
+		MESH_LOAD_DEFAULT = 0,
+		MESH_LOAD_TRIM_CPU_DATA = 0x1,			// Release the vertex and index data on the CPU once uploaded
+		MESH_LOAD_OPTIMIZE_VERTEX_CACHE = 0x2,	// Reorder the triangles and vertices of each subset for the GPU caches
+		MESH_LOAD_BUILD_MESHLETS = 0x4,			// Split each subset into meshlets with culling bounds
+		MESH_LOAD_GENERATE_LODS = 0x8,			// Simplify each subset into LODs sharing the vertex buffers
+		MESH_LOAD_SPLIT_32BIT_SUBSETS = 0x10,	// Also split the subsets beyond the 16-bit index range, implying MESH_LOAD_NARROW_INDICES
+		MESH_LOAD_WELD_VERTICES = 0x20,			// Merge the bit-identical vertices of each vertex buffer
+		MESH_LOAD_SHARE_BUFFERS = 0x40,			// Share the vertex and index buffers with the meshes of identical geometry
+		MESH_LOAD_GENERATE_MIPS = 0x80,			// Generate the mips of the uncompressed textures authored without mips
+		MESH_LOAD_NARROW_INDICES = 0x100,		// Narrow the 32-bit index buffers to 16 bits where the subsets can be rebased
+		MESH_LOAD_REPACK_VERTICES = 0x200,		// Repack the skinned vertex buffers of other layouts into the skinning input layout
+		MESH_LOAD_QUANTIZE_VERTICES = 0x400,	// Quantize the skinning input to 24 bytes per vertex, read by CS_SKINNING_QUANTIZED only
+		MESH_LOAD_PACK_TEXTURES = 0x800			// Copy the material textures of the same formats and sizes into texture arrays
+	};
+
+	XUSG_DEF_ENUM_FLAG_OPERATORS(MeshLoadFlags);
+
+	// 128-bit hash of some content, with its size
+	struct ContentKey
+	{
+		uint64_t Hash[2];
+		uint64_t Size;
+
+		bool operator==(const ContentKey& key) const;
+	};
+
 	struct TextureRecord
 	{
 		Texture::sptr Texture;
 		uint8_t AlphaMode;
 	};
-	using TextureLib = std::shared_ptr<std::map<std::string, TextureRecord>>;
 
-	class XUSG_INTERFACE SDKMesh
+	//--------------------------------------------------------------------------------------
+	// Texture library shared by meshes, safe for concurrent lookups and insertions. The keys
+	// are interned as IDs of their normalized paths, and byte-identical texture files can
+	// share one record through their content hashes.
+	//--------------------------------------------------------------------------------------
+	class XUSG_ADVANCED_INTERFACE TextureLibrary
+	{
+	public:
+		//TextureLibrary();
+		virtual ~TextureLibrary() {};
+
+		// Return the ID of the key, which stays valid for the lifetime of the library
+		virtual uint32_t Intern(const std::string& key) = 0;
+
+		virtual bool Find(const std::string& key, TextureRecord* pRecord = nullptr) const = 0;
+		virtual bool Find(uint32_t id, TextureRecord* pRecord = nullptr) const = 0;
+		// Insert the record if the key is absent, and return the record held by the library
+		virtual TextureRecord Insert(const std::string& key, const TextureRecord& record) = 0;
+		virtual TextureRecord Insert(uint32_t id, const TextureRecord& record) = 0;
+		// Insert or replace the record, and return the replaced one
+		virtual TextureRecord Assign(const std::string& key, const TextureRecord& record) = 0;
+		virtual TextureRecord Assign(uint32_t id, const TextureRecord& record) = 0;
+		virtual bool Erase(const std::string& key) = 0;
+		virtual bool Erase(uint32_t id) = 0;
+		virtual void Clear() = 0;
+
+		// Content hashing is off by default; meshes hash the texture files they load if it is on
+		virtual void SetContentHashing(bool enable) = 0;
+		virtual bool IsContentHashing() const = 0;
+		// Find the current record of the first ID inserted with the content. Unlike the geometry
+		// cache, the bytes are not compared on a key match: the files are released once uploaded,
+		// and keeping them all for the comparison would cost more than the sharing saves. The
+		// textures are the app's own assets rather than adversarial input, so with the size in
+		// the key and 128 hash bits, n files collide with a chance of about n^2 / 2^129, i.e.
+		// below 10^-26 for a million textures.
+		virtual bool FindContent(const ContentKey& contentKey, TextureRecord* pRecord = nullptr) const = 0;
+		// Map the content to the ID if the content is absent
+		virtual void InsertContent(const ContentKey& contentKey, uint32_t id) = 0;
+
+		virtual size_t GetSize() const = 0;
+		// Bumped on every change of the records, so that the users can skip the lookups while
+		// it is unchanged
+		virtual uint64_t GetGeneration() const = 0;
+
+		// The 128-bit key of the content, so that distinct files never share a record
+		static ContentKey HashContent(const void* pData, size_t size, uint64_t seed = 0);
+
+		using uptr = std::unique_ptr<TextureLibrary>;
+		using sptr = std::shared_ptr<TextureLibrary>;
+
+		static uptr MakeUnique(API api = API::DIRECTX_12);
+		static sptr MakeShared(API api = API::DIRECTX_12);
+	};
+
+	using TextureLib = TextureLibrary::sptr;
+
+	//--------------------------------------------------------------------------------------
+	// Pak archive of asset files, memory-mapped once with a sorted and hashed directory.
+	// The loaders look up the mounted archives before the file system.
+	//--------------------------------------------------------------------------------------
+	class XUSG_ADVANCED_INTERFACE PakArchive
+	{
+	public:
+		//PakArchive();
+		virtual ~PakArchive() {};
+
+		// Map the archive; its files are found by their paths under the mount point
+		virtual bool Open(const wchar_t* fileName, const wchar_t* mountPoint = nullptr) = 0;
+		virtual void Close() = 0;
+
+		// Returns the bytes of the file in the mapped archive, or nullptr if it is absent. A
+		// compressed file is decompressed into pBuffer, and is not returned without it.
+		virtual const uint8_t* Find(const wchar_t* filePath, size_t* pSize = nullptr,
+			std::vector<uint8_t>* pBuffer = nullptr) const = 0;
+		virtual bool Contains(const wchar_t* filePath) const = 0;
+
+		virtual bool IsOpen() const = 0;
+		virtual uint32_t GetNumFiles() const = 0;
+
+		// Positioned reads of a file, compressed or not; only the chunks covering the range
+		// are decompressed
+		virtual bool GetFileSize(const wchar_t* filePath, uint64_t* pSize) const = 0;
+		virtual bool Read(const wchar_t* filePath, uint64_t offset, size_t size, uint8_t* pDst) const = 0;
+
+		using uptr = std::unique_ptr<PakArchive>;
+		using sptr = std::shared_ptr<PakArchive>;
+
+		// The most recently mounted archives are searched first; pArchive keeps the archive
+		// of the returned bytes mapped while they are in use, and also holds the bytes of a
+		// compressed file, which is only returned with pArchive
+		static void Mount(const sptr& archive);
+		static void Unmount(const PakArchive* pArchive);
+		static const uint8_t* FindMounted(const wchar_t* filePath, size_t* pSize = nullptr, sptr* pArchive = nullptr);
+		static sptr GetMounted(const wchar_t* filePath);
+		static bool ContainsMounted(const wchar_t* filePath);
+		// Copy the file, or decompress it straight, into the data, which are writable
+		static bool ReadMounted(const wchar_t* filePath, std::vector<uint8_t>& data);
+
+		// Pack the files into an archive, named by their paths relative to the root folder.
+		// The files are LZ-compressed by chunks, which are decompressed in parallel, unless
+		// compressing a file saves too little. The index buffers of the meshes are delta-coded
+		// apart, and decoded with SIMD.
+		static bool Create(const wchar_t* fileName, const wchar_t* rootPath,
+			uint32_t numFiles, const wchar_t* const* filePaths, bool compress = true);
+
+		static uptr MakeUnique(API api = API::DIRECTX_12);
+		static sptr MakeShared(API api = API::DIRECTX_12);
+	};
+
+	//--------------------------------------------------------------------------------------
+	// Texture mip streamer over a texture library. The tail mips of the registered textures
+	// are loaded first; the higher mips are streamed in the order of their screen sizes, and
+	// the least recently requested textures drop back to their tails over the memory budget.
+	// A streamed texture is recreated and replaced in the library, so the meshes using it
+	// pick it up with SDKMesh::RefreshTextures(), which Model::Update() calls. The replaced
+	// textures count against the budget until the frames in flight are done with them.
+	//--------------------------------------------------------------------------------------
+	class XUSG_ADVANCED_INTERFACE TextureStreamer
+	{
+	public:
+		//TextureStreamer();
+		virtual ~TextureStreamer() {};
+
+		virtual bool Init(const TextureLib& textureLib, uint64_t budget,
+			uint32_t tailSize = 64, uint32_t maxNumReads = 4) = 0;
+
+		// The key is the path of the DDS file, as in the texture library
+		virtual bool Register(const std::string& key, bool forceSRGB) = 0;
+		virtual void Unregister(const std::string& key) = 0;
+
+		// Screen-space size in pixels of the texture in the current frame
+		virtual void Request(const std::string& key, float screenSize) = 0;
+		// Schedule the reads of the current frame
+		virtual void Update() = 0;
+		// Create the textures of the completed reads, once per frame; returns the number of
+		// textures replaced in the library
+		virtual uint32_t Commit(CommandList* pCommandList, std::vector<Resource::uptr>& uploaders) = 0;
+
+		virtual void SetBudget(uint64_t budget) = 0;
+		virtual uint64_t GetBudget() const = 0;
+		virtual uint64_t GetResidentSize() const = 0;
+		virtual uint32_t GetResidentMip(const std::string& key) const = 0;
+
+		using uptr = std::unique_ptr<TextureStreamer>;
+		using sptr = std::shared_ptr<TextureStreamer>;
+
+		static uptr MakeUnique(API api = API::DIRECTX_12);
+		static sptr MakeShared(API api = API::DIRECTX_12);
+	};
+
+	//--------------------------------------------------------------------------------------
+	// Catalog of the DDS headers of asset trees, for decisions before any texel data is read.
+	// The headers are read in parallel, and the catalog is saved with the sizes and the write
+	// times of the files, so that a rebuild only reads the changed ones.
+	//--------------------------------------------------------------------------------------
+	class XUSG_ADVANCED_INTERFACE TextureCatalog
+	{
+	public:
+		//TextureCatalog();
+		virtual ~TextureCatalog() {};
+
+		// Catalog the DDS files under the folder and its subfolders, and drop the removed ones;
+		// returns the number of files whose headers were read
+		virtual uint32_t Build(const wchar_t* rootPath) = 0;
+		virtual bool Load(const wchar_t* fileName) = 0;
+		virtual bool Save(const wchar_t* fileName) const = 0;
+		virtual void Clear() = 0;
+
+		// Fails for the files changed since they were cataloged, by their sizes or write times,
+		// and for the files in the mounted archives, so that their headers are read instead
+		virtual bool Find(const wchar_t* filePath, DDS::TextureInfo* pInfo = nullptr) const = 0;
+		// Size in bytes of all the mips, or 0 if the file is not found
+		virtual uint64_t GetTextureSize(const wchar_t* filePath) const = 0;
+		virtual uint32_t GetNumTextures() const = 0;
+
+		using uptr = std::unique_ptr<TextureCatalog>;
+		using sptr = std::shared_ptr<TextureCatalog>;
+
+		// The catalog consulted by the texture streamer and the meshes, if set
+		static void SetDefault(const sptr& catalog);
+		static sptr GetDefault();
+
+		static uptr MakeUnique(API api = API::DIRECTX_12);
+		static sptr MakeShared(API api = API::DIRECTX_12);
+	};
+
+	class XUSG_ADVANCED_INTERFACE SDKMesh
 	{
 	public:
 		static const uint32_t MAX_VERTEX_STREAMS	= 16;
@@ -134,6 +404,52 @@ namespace XUSG
 			PT_TRIANGLE_PATCH_LIST
 		};
 
+		// Invoked when an asynchronous load completes, after its result is published, on the
+		// thread running the load: a worker, or a thread waiting on the thread pool
+		using LoadCallback = std::function<void(SDKMesh* pMesh, bool succeeded)>;
+		// Invoked on the same thread before the result is published, to finish the mesh, e.g.
+		// by binding an animation; returning false fails the load
+		using FinishCallback = std::function<bool(SDKMesh* pMesh)>;
+
+		// Post-transform vertex cache statistics of a mesh, simulated with a FIFO cache
+		struct VertexCacheStats
+		{
+			uint32_t NumTriangles;
+			uint32_t NumVertices;
+			uint32_t NumTransformedVertices;
+			float ACMR;	// Average cache miss ratio: transformed vertices per triangle
+			float ATVR;	// Average transformed vertex ratio: transformed vertices per vertex
+		};
+
+		// Meshlets of a subset, in the bind pose
+		struct Meshlet
+		{
+			uint32_t VertexOffset;		// Offset to the vertex indices of the meshlet
+			uint32_t VertexCount;
+			uint32_t PrimitiveOffset;	// Offset to the primitive indices of the meshlet
+			uint32_t PrimitiveCount;
+			uint32_t BoneOffset;		// Offset to the bones influencing the meshlet
+			uint32_t BoneCount;
+		};
+
+		struct MeshletBounds
+		{
+			DirectX::XMFLOAT3 Center;	// Bounding sphere
+			float Radius;
+			DirectX::XMFLOAT3 ConeApex;	// Normal cone; back-facing if dot(normalize(ConeApex - eye), ConeAxis) >= ConeCutoff
+			DirectX::XMFLOAT3 ConeAxis;
+			float ConeCutoff;			// 1 if the cone is too wide to be culled
+		};
+
+		struct MeshletSet
+		{
+			std::vector<Meshlet>		Meshlets;
+			std::vector<MeshletBounds>	Bounds;
+			std::vector<uint32_t>		VertexIndices;		// Relative to the VertexStart of the subset
+			std::vector<uint8_t>		PrimitiveIndices;	// 3 meshlet vertex indices per triangle
+			std::vector<uint8_t>		Bones;				// Frame influence indices, as in the vertices
+		};
+
 #pragma pack(push, 8)
 		struct Data
 		{
@@ -320,6 +636,49 @@ namespace XUSG
 		virtual DirectX::XMMATRIX	GetBindMatrix(uint32_t frameIndex) const = 0;
 		virtual bool				GetAnimationProperties(uint32_t* pNumKeys, float* pFrameTime) const = 0;
 
+		// Loading options, appended to keep the order of the virtual functions above; the new
+		// overloads are named apart, since MSVC groups the overloads in the virtual table
+		virtual void SetLoadFlags(MeshLoadFlags flags) = 0;	// Set before creating the mesh
+		virtual MeshLoadFlags GetLoadFlags() const = 0;
+		virtual bool CreateAsync(const Device* pDevice, const wchar_t* fileName, const TextureLib& textureLib,
+			bool isStaticMesh = false, const LoadCallback& callback = nullptr,
+			const FinishCallback& finish = nullptr) = 0;
+		virtual bool WaitForLoad() = 0;
+		virtual bool LoadAnimationFromMemory(const uint8_t* pData, size_t dataBytes) = 0;
+		// Pick up the textures replaced in the texture library, e.g. by a TextureStreamer;
+		// returns true if any material changed, so that its descriptor tables are recreated. The
+		// materials are only looked up again after the generation of the library has changed.
+		virtual bool RefreshTextures() = 0;
+		// Register the material textures to a streamer, returning the number of newly registered
+		// ones, and request them each frame with the screen size of the mesh, e.g. its diagonal
+		virtual uint32_t RegisterTextures(TextureStreamer* pStreamer) const = 0;
+		virtual void RequestTextures(TextureStreamer* pStreamer, float screenSize) const = 0;
+
+		virtual bool				GetVertexCacheStats(uint32_t mesh, VertexCacheStats* pBefore,
+			VertexCacheStats* pAfter = nullptr) const = 0;
+		virtual const MeshletSet*	GetMeshlets(uint32_t mesh, uint32_t subset) const = 0;
+
+		// Levels of detail, available if the mesh is created with MESH_LOAD_GENERATE_LODS
+		virtual const Subset*		GetLODSubset(uint32_t mesh, uint32_t subset, SubsetFlags materialType, uint32_t lod) const = 0;
+		virtual uint32_t			GetNumLODs() const = 0;
+		virtual float				GetLODError(uint32_t lod) const = 0;	// Relative to the diagonal of the bounds
+		virtual uint32_t			SelectLOD(float screenSize, float maxPixelError = 1.0f) const = 0;	// Screen size of the diagonal in pixels
+		virtual uint64_t			GetNumLODVertices(uint32_t mesh, uint32_t lod) const = 0;	// The vertices of a LOD are a prefix of the vertex buffer
+
+		// Quantized skinning input, if the mesh is created with MESH_LOAD_QUANTIZE_VERTICES and
+		// the vertices are within the error bounds; the position is the 16-bit value times the
+		// scale plus the bias
+		virtual bool				IsVertexQuantized() const = 0;
+		virtual void				GetVertexDequantization(uint32_t mesh, DirectX::XMFLOAT3* pScale,
+			DirectX::XMFLOAT3* pBias) const = 0;
+
+		// Texture arrays, if the mesh is created with MESH_LOAD_PACK_TEXTURES, of the albedo, normal
+		// and specular textures in order per set, and a slice per material. The slices are copies,
+		// so the textures replaced in the library later, e.g. by a streamer, are not reflected.
+		virtual uint32_t			GetNumTextureArraySets() const = 0;
+		virtual Texture*			GetTextureArray(uint32_t set, uint8_t channel) const = 0;
+		virtual uint32_t			GetMaterialTextureArraySet(uint32_t material, uint32_t* pSlice = nullptr) const = 0;	// UINT32_MAX if not packed
+
 		using uptr = std::unique_ptr<SDKMesh>;
 		using sptr = std::shared_ptr<SDKMesh>;
 
@@ -327,10 +686,48 @@ namespace XUSG
 		static sptr MakeShared(API api = API::DIRECTX_12);
 	};
 
+	//--------------------------------------------------------------------------------------
+	// Batch loader, overlapping the loads of many meshes and their animations. The mesh and
+	// animation files are read in one batch of overlapped reads.
+	//--------------------------------------------------------------------------------------
+	class XUSG_ADVANCED_INTERFACE BatchLoader
+	{
+	public:
+		// Invoked once all the assets of the batch are loaded and their animations bound, on a
+		// thread of the thread pool, or on a thread waiting on it. Wait() returns after the
+		// callback, which may release the loader.
+		using LoadCallback = std::function<void(BatchLoader* pBatchLoader, bool succeeded)>;
+
+		//BatchLoader();
+		virtual ~BatchLoader() {};
+
+		// Queue a mesh with an optional animation, and get its index in the batch;
+		// requests for the same files share one mesh
+		virtual uint32_t AddMesh(const wchar_t* meshFileName, const wchar_t* animFileName = nullptr,
+			bool isStaticMesh = false, MeshLoadFlags loadFlags = MESH_LOAD_DEFAULT) = 0;
+
+		// Start loading all the queued assets on the thread pool
+		virtual bool Load(const Device* pDevice, const TextureLib& textureLib,
+			const LoadCallback& callback = nullptr) = 0;
+		// Wait for the whole batch; returns false if any asset failed to load
+		virtual bool Wait() = 0;
+
+		virtual bool IsLoading() const = 0;
+		virtual bool HadLoadingError() const = 0;
+		virtual uint32_t GetNumMeshes() const = 0;
+		virtual SDKMesh::sptr GetMesh(uint32_t index) const = 0;
+
+		using uptr = std::unique_ptr<BatchLoader>;
+		using sptr = std::shared_ptr<BatchLoader>;
+
+		static uptr MakeUnique(API api = API::DIRECTX_12);
+		static sptr MakeShared(API api = API::DIRECTX_12);
+	};
+
 	//--------------------------------------------------------------------------------------
 	// Model base
 	//--------------------------------------------------------------------------------------
-	class XUSG_INTERFACE Model
+	class XUSG_ADVANCED_INTERFACE Model
 	{
 	public:
 		enum PipelineLayoutIndex : uint8_t
@@ -372,7 +769,8 @@ namespace XUSG
 		{
 			MATERIAL_OFFSET,
 			ALPHA_REF_OFFSET,
-			IMMUTABLE_OFFSET = ALPHA_REF_OFFSET
+			IMMUTABLE_OFFSET = ALPHA_REF_OFFSET,
+			MATERIAL_SLICE_OFFSET = ALPHA_REF_OFFSET	// Slice of the texture arrays in the base pass
 		};
 
 		enum CBVTableIndex : uint8_t
@@ -410,6 +808,10 @@ namespace XUSG
 
 		virtual bool IsTwoSidedAll() const = 0;
 
+		// Appended to keep the order of the virtual functions above
+		virtual void SetLOD(uint32_t lod) = 0;
+		virtual uint32_t GetLOD() const = 0;
+
 		Model* AsModel();
 
 		static const InputLayout* CreateInputLayout(Graphics::PipelineLib* pPipelineLib);
@@ -431,7 +833,7 @@ namespace XUSG
 	//--------------------------------------------------------------------------------------
 	// Character model
 	//--------------------------------------------------------------------------------------
-	class XUSG_INTERFACE Character :
+	class XUSG_ADVANCED_INTERFACE Character :
 		public virtual Model
 	{
 	public:
@@ -442,7 +844,10 @@ namespace XUSG
 			SHADOW_MAP,
 			IMMUTABLE = ALPHA_REF,
 #if XUSG_TEMPORAL
-			HISTORY = ALPHA_REF
+			HISTORY = ALPHA_REF,
+			MATERIAL_SLICE = SHADOW_MAP
+#else
+			MATERIAL_SLICE = ALPHA_REF
 #endif
 		};
 
@@ -486,7 +891,8 @@ namespace XUSG
 		static SDKMesh::sptr LoadSDKMesh(const Device* pDevice, const std::wstring& meshFileName,
 			const std::wstring& animFileName, const TextureLib& textureLib,
 			const std::shared_ptr<std::vector<MeshLink>>& meshLinks = nullptr,
-			std::vector<SDKMesh::sptr>* pLinkedMeshes = nullptr, API api = API::DIRECTX_12);
+			std::vector<SDKMesh::sptr>* pLinkedMeshes = nullptr, API api = API::DIRECTX_12,
+			MeshLoadFlags loadFlags = MESH_LOAD_REPACK_VERTICES);	// Always repacking the vertices
 
 		using uptr = std::unique_ptr<Character>;
 		using sptr = std::shared_ptr<Character>;
@@ -871,6 +1277,9 @@ namespace XUSG
 		PS_TONE_MAP,
 		PS_TEMPORAL_AA,
 
+		PS_BASE_PASS_ARRAY,
+		PS_ALPHA_TEST_ARRAY,
+
 		PS_NULL_INDEX
 	};
 
@@ -882,7 +1291,8 @@ namespace XUSG
 		CS_SH_SUM,
 		CS_SH_NORMALIZE,
 		//CS_BLIT_2D,
-		CS_LUM_ADAPT
+		CS_LUM_ADAPT,
+		CS_SKINNING_QUANTIZED
 	};
 }
 
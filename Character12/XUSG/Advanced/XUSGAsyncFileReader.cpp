@@ -0,0 +1,270 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "XUSGAsyncFileReader.h"
+#include "Core/XUSG_DX12.h"
+
+using namespace std;
+using namespace XUSG;
+
+AsyncFileReader::AsyncFileReader(uint32_t maxInFlight) :
+	m_maxInFlight((max)(maxInFlight, 1u))
+{
+}
+
+AsyncFileReader::~AsyncFileReader()
+{
+}
+
+bool AsyncFileReader::ReadFiles(const wstring* fileNames, uint32_t numFiles, const Completion& completion)
+{
+	vector<FileRange> ranges(numFiles);
+	for (auto i = 0u; i < numFiles; ++i) ranges[i] = { fileNames[i], 0, UINT64_MAX };
+
+	return ReadFileRanges(ranges.data(), numFiles, completion);
+}
+
+bool AsyncFileReader::ReadFileRanges(const FileRange* ranges, uint32_t numRanges, const Completion& completion)
+{
+	XUSG_C_RETURN(numRanges == 0, true);
+
+	// Fall back to the thread pool without a completion port
+	const auto hPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+	if (!hPort) return readFilesParallel(ranges, numRanges, completion);
+
+	const auto batch = make_shared<Batch>();
+	batch->Files.resize(numRanges);
+	batch->Callback = completion;
+	batch->NumPending = numRanges;
+	batch->HadError = false;
+	batch->Group = ThreadPool::GetDefault().CreateGroup();
+	const auto done = batch->Done.get_future();
+
+	readFilesOverlapped(hPort, ranges, batch);
+	CloseHandle(hPort);
+
+	// Help the pool with the completions still queued
+	ThreadPool::GetDefault().Wait(done, batch->Group);
+
+	return !batch->HadError;
+}
+
+vector<AsyncFileReader::FileData> AsyncFileReader::ReadFilesAsync(const vector<wstring>& fileNames,
+	ThreadPool::Group group)
+{
+	const auto numFiles = static_cast<uint32_t>(fileNames.size());
+	const auto promises = make_shared<vector<promise<shared_ptr<vector<uint8_t>>>>>(numFiles);
+
+	vector<FileData> fileData(numFiles);
+	for (auto i = 0u; i < numFiles; ++i) fileData[i] = (*promises)[i].get_future().share();
+
+	ThreadPool::GetDefault().Submit([this, fileNames, promises]()
+	{
+		ReadFiles(fileNames.data(), static_cast<uint32_t>(fileNames.size()),
+			[&promises](uint32_t i, vector<uint8_t>& data, bool succeeded)
+		{
+			shared_ptr<vector<uint8_t>> result;
+			if (succeeded) result = make_shared<vector<uint8_t>>(move(data));
+			(*promises)[i].set_value(result);
+		});
+	}, group);
+
+	return fileData;
+}
+
+AsyncFileReader& AsyncFileReader::GetDefault()
+{
+	static AsyncFileReader asyncFileReader;
+
+	return asyncFileReader;
+}
+
+//--------------------------------------------------------------------------------------
+// Issue the chunks in file order while there are free slots, and dispatch each completed
+// file to the thread pool. Opening the files lazily bounds the number of open handles.
+//--------------------------------------------------------------------------------------
+void AsyncFileReader::readFilesOverlapped(HANDLE hPort, const FileRange* ranges, const shared_ptr<Batch>& batch)
+{
+	auto& files = batch->Files;
+	const auto numFiles = static_cast<uint32_t>(files.size());
+
+	vector<ChunkRead> chunks(m_maxInFlight);
+	vector<ChunkRead*> freeChunks(m_maxInFlight);
+	for (auto i = 0u; i < m_maxInFlight; ++i) freeChunks[i] = &chunks[i];
+
+	// Hand a file over once none of its chunks is pending
+	const auto complete = [&batch](uint32_t i)
+	{
+		auto& file = batch->Files[i];
+		if (file.NumPendingChunks > 0) return;
+
+		if (file.hFile != INVALID_HANDLE_VALUE) CloseHandle(file.hFile);
+		file.hFile = INVALID_HANDLE_VALUE;
+
+		ThreadPool::GetDefault().Submit([batch, i]()
+		{
+			auto& file = batch->Files[i];
+			if (file.HadError)
+			{
+				file.Data.clear();
+				batch->HadError = true;
+			}
+
+			batch->Callback(i, file.Data, !file.HadError);
+			vector<uint8_t>().swap(file.Data);
+
+			// The last completion finishes the batch
+			if (--batch->NumPending == 0) batch->Done.set_value();
+		}, batch->Group);
+	};
+
+	auto i = 0u;
+	auto isIssuing = false;
+	auto numInFlight = 0u;
+	while (i < numFiles || numInFlight > 0)
+	{
+		while (i < numFiles && !freeChunks.empty())
+		{
+			auto& file = files[i];
+			if (!isIssuing)
+			{
+				// The mounted, empty and failed files have no chunks to read
+				file.hFile = INVALID_HANDLE_VALUE;
+				file.Offset = ranges[i].Offset;
+				file.NextOffset = 0;
+				file.NumPendingChunks = 0;
+				file.HadError = false;
+				isIssuing = openFile(hPort, ranges[i], i, file);
+				if (!isIssuing)
+				{
+					complete(i++);
+					continue;
+				}
+			}
+
+			// Stop issuing the file once it is fully issued or has failed
+			if (file.HadError || file.NextOffset >= file.Data.size())
+			{
+				isIssuing = false;
+				complete(i++);
+				continue;
+			}
+
+			auto& chunk = *freeChunks.back();
+			const auto offset = file.Offset + file.NextOffset;
+			memset(&chunk.Overlapped, 0, sizeof(OVERLAPPED));
+			chunk.Overlapped.Offset = static_cast<DWORD>(offset);
+			chunk.Overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+			chunk.FileIndex = i;
+			chunk.Size = static_cast<uint32_t>((min)(file.Data.size() - file.NextOffset, static_cast<uint64_t>(CHUNK_SIZE)));
+			if (!ReadFile(file.hFile, &file.Data[static_cast<size_t>(file.NextOffset)], chunk.Size, nullptr,
+				&chunk.Overlapped) && GetLastError() != ERROR_IO_PENDING)
+			{
+				file.HadError = true;
+				continue;
+			}
+
+			// Synchronously completed reads are queued to the port as well
+			freeChunks.pop_back();
+			file.NextOffset += chunk.Size;
+			++file.NumPendingChunks;
+			++numInFlight;
+		}
+
+		if (numInFlight == 0) continue;
+
+		// Wait for any chunk
+		DWORD numBytes;
+		ULONG_PTR key;
+		OVERLAPPED* pOverlapped;
+		const auto succeeded = GetQueuedCompletionStatus(hPort, &numBytes, &key, &pOverlapped, INFINITE);
+		assert(pOverlapped);
+
+		auto& chunk = *reinterpret_cast<ChunkRead*>(pOverlapped);
+		auto& file = files[chunk.FileIndex];
+		if (!succeeded || numBytes != chunk.Size) file.HadError = true;
+		--file.NumPendingChunks;
+		--numInFlight;
+		freeChunks.emplace_back(&chunk);
+
+		// The file being issued is handed over when its issuing stops
+		if (!isIssuing || chunk.FileIndex != i) complete(chunk.FileIndex);
+	}
+}
+
+bool AsyncFileReader::readFilesParallel(const FileRange* ranges, uint32_t numRanges, const Completion& completion)
+{
+	atomic_bool hadError(false);
+	ThreadPool::GetDefault().ParallelFor(numRanges, [&](uint32_t i)
+	{
+		vector<uint8_t> data;
+		const auto succeeded = readMounted(ranges[i], data) || readFile(ranges[i], data);
+		if (!succeeded)
+		{
+			data.clear();
+			hadError = true;
+		}
+
+		completion(i, data, succeeded);
+	});
+
+	return !hadError;
+}
+
+bool AsyncFileReader::openFile(HANDLE hPort, const FileRange& range, uint32_t index, FileRead& file)
+{
+	// Copy from a mounted archive if it has the file
+	if (readMounted(range, file.Data)) return false;
+
+	// The file has failed until it is ready for the reads
+	file.HadError = true;
+	file.hFile = CreateFileW(range.FileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	F_RETURN(file.hFile == INVALID_HANDLE_VALUE, cerr, MAKE_HRESULT(SEVERITY_ERROR, FACILITY_ITF, 0x0903), false);
+
+	LARGE_INTEGER fileSize;
+	F_RETURN(!GetFileSizeEx(file.hFile, &fileSize), cerr, GetLastError(), false);
+	F_RETURN(CreateIoCompletionPort(file.hFile, hPort, index, 0) != hPort, cerr, GetLastError(), false);
+
+	file.Data.resize(static_cast<size_t>(getRangeSize(range, static_cast<uint64_t>(fileSize.QuadPart))));
+	file.HadError = false;
+
+	return true;
+}
+
+bool AsyncFileReader::readMounted(const FileRange& range, vector<uint8_t>& data)
+{
+	// A whole file is decompressed straight into the data
+	if (isWholeFile(range)) return PakArchive::ReadMounted(range.FileName.c_str(), data);
+
+	uint64_t fileSize;
+	const auto archive = PakArchive::GetMounted(range.FileName.c_str());
+	XUSG_C_RETURN(!archive || !archive->GetFileSize(range.FileName.c_str(), &fileSize), false);
+
+	data.resize(static_cast<size_t>(getRangeSize(range, fileSize)));
+
+	return data.empty() || archive->Read(range.FileName.c_str(), range.Offset, data.size(), data.data());
+}
+
+bool AsyncFileReader::readFile(const FileRange& range, vector<uint8_t>& data)
+{
+	ifstream fileStream(range.FileName, ios::in | ios::binary);
+	F_RETURN(!fileStream, cerr, MAKE_HRESULT(SEVERITY_ERROR, FACILITY_ITF, 0x0903), false);
+
+	fileStream.seekg(0, fileStream.end);
+	data.resize(static_cast<size_t>(getRangeSize(range, static_cast<uint64_t>(fileStream.tellg()))));
+	fileStream.seekg(static_cast<streamoff>(data.empty() ? 0 : range.Offset));
+
+	return data.empty() || fileStream.read(reinterpret_cast<char*>(data.data()), data.size());
+}
+
+bool AsyncFileReader::isWholeFile(const FileRange& range)
+{
+	return range.Offset == 0 && range.Size == UINT64_MAX;
+}
+
+uint64_t AsyncFileReader::getRangeSize(const FileRange& range, uint64_t fileSize)
+{
+	return range.Offset < fileSize ? (min)(range.Size, fileSize - range.Offset) : 0;
+}
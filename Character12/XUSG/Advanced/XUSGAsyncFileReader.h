@@ -0,0 +1,94 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "XUSGAdvanced.h"
+#include "XUSGThreadPool.h"
+
+namespace XUSG
+{
+	//--------------------------------------------------------------------------------------
+	// Batched asynchronous reads of whole files, or of their ranges. The files are read in chunks with overlapped
+	// I/O on a completion port, so that many reads are in flight at once, and each file is
+	// handed to the thread pool as soon as its last chunk completes. The files in the mounted
+	// archives are copied instead, and the reads fall back to the thread pool if no completion
+	// port is available.
+	//--------------------------------------------------------------------------------------
+	class AsyncFileReader
+	{
+	public:
+		// The data may be moved out by the completion; it is empty if the read failed
+		using Completion = std::function<void(uint32_t index, std::vector<uint8_t>& data, bool succeeded)>;
+		// The data of a file read for a single user may be moved out by it
+		using FileData = std::shared_future<std::shared_ptr<std::vector<uint8_t>>>;
+
+		// The range is clamped to the end of the file, so the data may be shorter
+		struct FileRange
+		{
+			std::wstring	FileName;
+			uint64_t		Offset;
+			uint64_t		Size;
+		};
+
+		AsyncFileReader(uint32_t maxInFlight = 64);
+		virtual ~AsyncFileReader();
+
+		// Read the files, and return after all the completions ran on the thread pool; the
+		// result is false if any read failed
+		bool ReadFiles(const std::wstring* fileNames, uint32_t numFiles, const Completion& completion);
+		// Read the ranges of the files as ReadFiles() reads the whole files; the ranges of the
+		// same file are read independently
+		bool ReadFileRanges(const FileRange* ranges, uint32_t numRanges, const Completion& completion);
+		// Schedule the reads on the thread pool in the group, which the waits on the file data
+		// help with, and get the futures of the file data, which are null for the failed reads
+		std::vector<FileData> ReadFilesAsync(const std::vector<std::wstring>& fileNames,
+			ThreadPool::Group group = ThreadPool::NO_GROUP);
+
+		static AsyncFileReader& GetDefault();
+
+	protected:
+		static const uint32_t CHUNK_SIZE = 1 << 22;
+
+		struct FileRead
+		{
+			HANDLE hFile;
+			uint64_t Offset;
+			std::vector<uint8_t> Data;
+			uint64_t NextOffset;
+			uint32_t NumPendingChunks;
+			bool HadError;
+		};
+
+		// The overlapped structure leads, so that the completed ones map back to their chunks
+		struct ChunkRead
+		{
+			OVERLAPPED Overlapped;
+			uint32_t FileIndex;
+			uint32_t Size;
+		};
+
+		// Shared with the completions, which may still be running when the reading thread is done
+		struct Batch
+		{
+			std::vector<FileRead> Files;
+			Completion Callback;
+			std::atomic<uint32_t> NumPending;
+			std::atomic_bool HadError;
+			std::promise<void> Done;
+			ThreadPool::Group Group;	// Of the completions
+		};
+
+		void readFilesOverlapped(HANDLE hPort, const FileRange* ranges, const std::shared_ptr<Batch>& batch);
+		bool readFilesParallel(const FileRange* ranges, uint32_t numRanges, const Completion& completion);
+
+		static bool openFile(HANDLE hPort, const FileRange& range, uint32_t index, FileRead& file);
+		static bool readMounted(const FileRange& range, std::vector<uint8_t>& data);
+		static bool readFile(const FileRange& range, std::vector<uint8_t>& data);
+		static bool isWholeFile(const FileRange& range);
+		static uint64_t getRangeSize(const FileRange& range, uint64_t fileSize);
+
+		uint32_t m_maxInFlight;
+	};
+}
@@ -0,0 +1,194 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "XUSGBatchLoader.h"
+#include "XUSGSDKMesh.h"
+#include "XUSGHash.h"
+#include "Core/XUSG_DX12.h"
+
+using namespace std;
+using namespace XUSG;
+
+//--------------------------------------------------------------------------------------
+// Create interfaces
+//--------------------------------------------------------------------------------------
+BatchLoader::uptr BatchLoader::MakeUnique(API api)
+{
+	return make_unique<BatchLoader_Impl>(api);
+}
+
+BatchLoader::sptr BatchLoader::MakeShared(API api)
+{
+	return make_shared<BatchLoader_Impl>(api);
+}
+
+//--------------------------------------------------------------------------------------
+// Batch loader implementations
+//--------------------------------------------------------------------------------------
+BatchLoader_Impl::BatchLoader_Impl(API api) :
+	m_api(api),
+	m_requests(0),
+	m_requestIndices(),
+	m_animations(),
+	m_callback(nullptr),
+	m_numOutstandingRequests(0),
+	m_hadLoadingError(false),
+	m_completionThread(),
+	m_donePromise(nullptr),
+	m_done(),
+	m_readGroup(ThreadPool::NO_GROUP),
+	m_loadGroup(ThreadPool::NO_GROUP)
+{
+}
+
+BatchLoader_Impl::~BatchLoader_Impl()
+{
+	// The loader threads reference this object, unless the callback releases it, of which
+	// the completion thread would wait for itself
+	if (m_done.valid() && !isOnCompletionThread()) ThreadPool::GetDefault().Wait(m_done, m_loadGroup);
+}
+
+uint32_t BatchLoader_Impl::AddMesh(const wchar_t* meshFileName, const wchar_t* animFileName,
+	bool isStaticMesh, MeshLoadFlags loadFlags)
+{
+	assert(!m_done.valid());
+
+	MeshRequest request = { meshFileName, animFileName ? animFileName : L"", isStaticMesh, loadFlags, nullptr };
+
+	// Requests for the same files with the same options share the same mesh
+	const auto key = Hash::NormalizePath(request.MeshFileName) + L'|' + Hash::NormalizePath(request.AnimFileName) +
+		L'|' + to_wstring((isStaticMesh ? 0x10000 : 0) | loadFlags);
+
+	const auto result = m_requestIndices.emplace(key, static_cast<uint32_t>(m_requests.size()));
+	if (result.second) m_requests.emplace_back(move(request));
+
+	return result.first->second;
+}
+
+bool BatchLoader_Impl::Load(const Device* pDevice, const TextureLib& textureLib, const LoadCallback& callback)
+{
+	F_RETURN(m_done.valid(), cerr, E_ILLEGAL_METHOD_CALL, false);
+
+	m_callback = callback;
+	m_readGroup = ThreadPool::GetDefault().CreateGroup();
+	m_loadGroup = ThreadPool::GetDefault().CreateGroup();
+	m_donePromise = make_shared<promise<bool>>();
+	m_done = m_donePromise->get_future().share();
+	m_numOutstandingRequests = static_cast<uint32_t>(m_requests.size()) + 1;
+
+	// Read the mesh files, and then the animation files, in a batch; each mesh is parsed as
+	// soon as its file is read. The data of a mesh file are moved into the mesh, so a file
+	// shared by the requests with different options is read for each of them.
+	const auto numRequests = static_cast<uint32_t>(m_requests.size());
+	vector<wstring> fileNames;
+	fileNames.reserve(numRequests);
+	for (const auto& request : m_requests) fileNames.emplace_back(request.MeshFileName);
+	vector<wstring> animKeys;
+	for (const auto& request : m_requests)
+	{
+		if (request.AnimFileName.empty()) continue;
+
+		// Keyed by the normalized paths, as the requests are
+		auto animKey = Hash::NormalizePath(request.AnimFileName);
+		if (m_animations.emplace(animKey, FileData()).second)
+		{
+			fileNames.emplace_back(request.AnimFileName);
+			animKeys.emplace_back(move(animKey));
+		}
+	}
+
+	const auto fileData = AsyncFileReader::GetDefault().ReadFilesAsync(fileNames, m_readGroup);
+	for (auto i = 0u; i < animKeys.size(); ++i) m_animations[animKeys[i]] = fileData[numRequests + i];
+
+	for (auto i = 0u; i < numRequests; ++i)
+	{
+		auto& request = m_requests[i];
+		FileData animation;
+		if (!request.AnimFileName.empty()) animation = m_animations[Hash::NormalizePath(request.AnimFileName)];
+
+		const auto mesh = make_shared<SDKMesh_Impl>(m_api);
+		mesh->SetLoadFlags(request.LoadFlags);
+		request.Mesh = mesh;
+
+		// Bind the animation once the frames of the mesh are available, before the mesh is
+		// published as loaded
+		SDKMesh::FinishCallback finish = nullptr;
+		const auto readGroup = m_readGroup;
+		if (animation.valid()) finish = [animation, readGroup](SDKMesh* pMesh)
+		{
+			ThreadPool::GetDefault().Wait(animation, readGroup);
+			const auto& data = animation.get();
+
+			return data && pMesh->LoadAnimationFromMemory(data->data(), data->size());
+		};
+
+		const auto scheduled = mesh->CreateAsync(pDevice, request.MeshFileName.c_str(), fileData[i], textureLib,
+			request.IsStaticMesh, [this](SDKMesh*, bool succeeded) { completeRequest(succeeded); }, finish,
+			m_readGroup, m_loadGroup);
+
+		if (!scheduled) completeRequest(false);
+	}
+
+	// Release the reference held during scheduling
+	completeRequest(true);
+
+	return true;
+}
+
+bool BatchLoader_Impl::Wait()
+{
+	XUSG_N_RETURN(m_done.valid(), false);
+	ThreadPool::GetDefault().Wait(m_done, m_loadGroup);
+
+	return m_done.get();
+}
+
+bool BatchLoader_Impl::IsLoading() const
+{
+	return m_done.valid() && m_done.wait_for(chrono::seconds(0)) != future_status::ready;
+}
+
+bool BatchLoader_Impl::HadLoadingError() const
+{
+	return m_hadLoadingError;
+}
+
+uint32_t BatchLoader_Impl::GetNumMeshes() const
+{
+	return static_cast<uint32_t>(m_requests.size());
+}
+
+SDKMesh::sptr BatchLoader_Impl::GetMesh(uint32_t index) const
+{
+	assert(index < m_requests.size());
+
+	return m_requests[index].Mesh;
+}
+
+void BatchLoader_Impl::completeRequest(bool succeeded)
+{
+	if (!succeeded) m_hadLoadingError = true;
+
+	// The last completed request finishes the batch on the thread pool, also when it is the
+	// reference released by Load() on the calling thread
+	if (--m_numOutstandingRequests == 0)
+	{
+		ThreadPool::GetDefault().Submit([this]()
+		{
+			// The callback may release this object, so only the copies are used after it
+			const auto donePromise = m_donePromise;
+			const auto callback = m_callback;
+			const auto succeeded = !m_hadLoadingError.load();
+			m_completionThread = this_thread::get_id();
+			if (callback) callback(this, succeeded);
+			donePromise->set_value(succeeded);
+		}, m_loadGroup);
+	}
+}
+
+bool BatchLoader_Impl::isOnCompletionThread() const
+{
+	return m_done.wait_for(chrono::seconds(0)) != future_status::ready &&
+		m_completionThread.load() == this_thread::get_id();
+}
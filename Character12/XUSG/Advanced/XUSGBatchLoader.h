@@ -0,0 +1,60 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "XUSGAdvanced.h"
+#include "XUSGAsyncFileReader.h"
+
+namespace XUSG
+{
+	class BatchLoader_Impl :
+		public virtual BatchLoader
+	{
+	public:
+		BatchLoader_Impl(API api = API::DIRECTX_12);
+		virtual ~BatchLoader_Impl();
+
+		uint32_t AddMesh(const wchar_t* meshFileName, const wchar_t* animFileName = nullptr,
+			bool isStaticMesh = false, MeshLoadFlags loadFlags = MESH_LOAD_DEFAULT);
+
+		bool Load(const Device* pDevice, const TextureLib& textureLib, const LoadCallback& callback = nullptr);
+		bool Wait();
+
+		bool IsLoading() const;
+		bool HadLoadingError() const;
+		uint32_t GetNumMeshes() const;
+		SDKMesh::sptr GetMesh(uint32_t index) const;
+
+	protected:
+		using FileData = AsyncFileReader::FileData;
+
+		struct MeshRequest
+		{
+			std::wstring MeshFileName;
+			std::wstring AnimFileName;
+			bool IsStaticMesh;
+			MeshLoadFlags LoadFlags;
+			SDKMesh::sptr Mesh;
+		};
+
+		void completeRequest(bool succeeded);
+		bool isOnCompletionThread() const;
+
+		API m_api;
+
+		std::vector<MeshRequest> m_requests;
+		std::unordered_map<std::wstring, uint32_t> m_requestIndices;
+		std::unordered_map<std::wstring, FileData> m_animations;
+
+		LoadCallback m_callback;
+		std::atomic<uint32_t> m_numOutstandingRequests;
+		std::atomic_bool m_hadLoadingError;
+		std::atomic<std::thread::id> m_completionThread;	// The worker running the callback
+		std::shared_ptr<std::promise<bool>> m_donePromise;	// Outlives the loader released by the callback
+		std::shared_future<bool> m_done;
+		ThreadPool::Group m_readGroup;	// Of the file reads
+		ThreadPool::Group m_loadGroup;	// Of the mesh loads and the completion, which the waits help with
+	};
+}
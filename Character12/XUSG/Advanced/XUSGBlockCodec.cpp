@@ -0,0 +1,1055 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "XUSGBlockCodec.h"
+#include "XUSGThreadPool.h"
+
+#if defined(_M_IX86) || defined(_M_X64)
+#define XUSG_SSSE3_KERNELS 1
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#define XUSG_SSSE3_KERNELS 0
+#endif
+
+using namespace std;
+using namespace DirectX;
+using namespace XUSG;
+
+static const uint32_t NUM_TEXELS = BlockCodec::NUM_TEXELS;
+static const uint32_t NUM_FIT_ITERATIONS = 8;
+static const uint32_t NUM_REFINEMENTS = 2;
+
+//--------------------------------------------------------------------------------------
+// BC7 modes and tables
+//--------------------------------------------------------------------------------------
+struct BC7Mode
+{
+	uint8_t NumSubsets;
+	uint8_t PartitionBits;
+	uint8_t RotationBits;
+	uint8_t IndexSelectionBits;
+	uint8_t ColorBits;
+	uint8_t AlphaBits;
+	uint8_t EndpointPBits;
+	uint8_t SharedPBits;
+	uint8_t IndexBits;
+	uint8_t IndexBits2;
+};
+
+static const BC7Mode BC7_MODES[] =
+{
+	{ 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+	{ 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+	{ 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+	{ 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+	{ 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+	{ 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+	{ 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+	{ 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 }
+};
+
+static const uint8_t BC7_WEIGHTS2[] = { 0, 21, 43, 64 };
+static const uint8_t BC7_WEIGHTS3[] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+static const uint8_t BC7_WEIGHTS4[] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// Bit i is the subset of texel i
+static const uint16_t BC7_PARTITIONS2[] =
+{
+	0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80,
+	0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+	0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce,
+	0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+	0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a,
+	0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+	0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c,
+	0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22
+};
+
+static const uint8_t BC7_PARTITIONS3[][NUM_TEXELS] =
+{
+	{ 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2 },
+	{ 0, 0, 0, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1 },
+	{ 0, 0, 0, 0, 2, 0, 0, 1, 2, 2, 1, 1, 2, 2, 1, 1 },
+	{ 0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 1, 0, 1, 1, 1 },
+	{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2 },
+	{ 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 2, 2 },
+	{ 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1 },
+	{ 0, 0, 1, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1 },
+	{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2 },
+	{ 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2 },
+	{ 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2 },
+	{ 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2 },
+	{ 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2 },
+	{ 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2 },
+	{ 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2, 1, 2, 2, 2 },
+	{ 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0, 2, 2, 2, 0 },
+	{ 0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2 },
+	{ 0, 1, 1, 1, 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0 },
+	{ 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2 },
+	{ 0, 0, 2, 2, 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1 },
+	{ 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2, 0, 2, 2, 2 },
+	{ 0, 0, 0, 1, 0, 0, 0, 1, 2, 2, 2, 1, 2, 2, 2, 1 },
+	{ 0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2 },
+	{ 0, 0, 0, 0, 1, 1, 0, 0, 2, 2, 1, 0, 2, 2, 1, 0 },
+	{ 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1, 0, 0, 0, 0 },
+	{ 0, 0, 1, 2, 0, 0, 1, 2, 1, 1, 2, 2, 2, 2, 2, 2 },
+	{ 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1, 0, 1, 1, 0 },
+	{ 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1 },
+	{ 0, 0, 2, 2, 1, 1, 0, 2, 1, 1, 0, 2, 0, 0, 2, 2 },
+	{ 0, 1, 1, 0, 0, 1, 1, 0, 2, 0, 0, 2, 2, 2, 2, 2 },
+	{ 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1 },
+	{ 0, 0, 0, 0, 2, 0, 0, 0, 2, 2, 1, 1, 2, 2, 2, 1 },
+	{ 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 2, 2, 2 },
+	{ 0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 2, 0, 0, 1, 1 },
+	{ 0, 0, 1, 1, 0, 0, 1, 2, 0, 0, 2, 2, 0, 2, 2, 2 },
+	{ 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0 },
+	{ 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0 },
+	{ 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0 },
+	{ 0, 1, 2, 0, 2, 0, 1, 2, 1, 2, 0, 1, 0, 1, 2, 0 },
+	{ 0, 0, 1, 1, 2, 2, 0, 0, 1, 1, 2, 2, 0, 0, 1, 1 },
+	{ 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0, 1, 1 },
+	{ 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2 },
+	{ 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1 },
+	{ 0, 0, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2, 1, 1, 2, 2 },
+	{ 0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1 },
+	{ 0, 2, 2, 0, 1, 2, 2, 1, 0, 2, 2, 0, 1, 2, 2, 1 },
+	{ 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 1, 0, 1 },
+	{ 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1 },
+	{ 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2 },
+	{ 0, 2, 2, 2, 0, 1, 1, 1, 0, 2, 2, 2, 0, 1, 1, 1 },
+	{ 0, 0, 0, 2, 1, 1, 1, 2, 0, 0, 0, 2, 1, 1, 1, 2 },
+	{ 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2 },
+	{ 0, 2, 2, 2, 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2 },
+	{ 0, 0, 0, 2, 1, 1, 1, 2, 1, 1, 1, 2, 0, 0, 0, 2 },
+	{ 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2 },
+	{ 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2 },
+	{ 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2, 2, 2, 2, 2 },
+	{ 0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2 },
+	{ 0, 0, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2 },
+	{ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2 },
+	{ 0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 1 },
+	{ 0, 2, 2, 2, 1, 2, 2, 2, 0, 2, 2, 2, 1, 2, 2, 2 },
+	{ 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2 },
+	{ 0, 1, 1, 1, 2, 0, 1, 1, 2, 2, 0, 1, 2, 2, 2, 0 }
+};
+
+// Texels of the subsets other than the first, of which the index MSB is implicitly 0
+static const uint8_t BC7_ANCHORS2[] =
+{
+	15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+	15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,
+	15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6,
+	6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15
+};
+
+static const uint8_t BC7_ANCHORS3A[] =
+{
+	3, 3, 15, 15, 8, 3, 15, 15, 8, 8, 6, 6, 6, 5, 3, 3,
+	3, 3, 8, 15, 3, 3, 6, 10, 5, 8, 8, 6, 8, 5, 15, 15,
+	8, 15, 3, 5, 6, 10, 8, 15, 15, 3, 15, 5, 15, 15, 15, 15,
+	3, 15, 5, 5, 5, 8, 5, 10, 5, 10, 8, 13, 15, 12, 3, 3
+};
+
+static const uint8_t BC7_ANCHORS3B[] =
+{
+	15, 8, 8, 3, 15, 15, 3, 8, 15, 15, 15, 15, 15, 15, 15, 8,
+	15, 8, 15, 3, 15, 8, 15, 8, 3, 15, 6, 10, 15, 15, 10, 8,
+	15, 3, 15, 10, 10, 8, 9, 10, 6, 15, 8, 15, 3, 6, 6, 8,
+	15, 3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3, 15, 15, 8
+};
+
+//--------------------------------------------------------------------------------------
+// Bit fields, from the LSB of the first byte
+//--------------------------------------------------------------------------------------
+static uint32_t ReadBits(const uint8_t* pBlock, uint32_t& offset, uint32_t numBits)
+{
+	// The fields of the 16-byte blocks take at most 8 bits, so they span at most 2 bytes
+	assert(numBits <= 8 && offset + numBits <= 128);
+	const auto first = offset >> 3;
+	uint32_t word = pBlock[first];
+	if (first + 1 < 16) word |= pBlock[first + 1] << 8;
+
+	const auto value = (word >> (offset & 7)) & ((1u << numBits) - 1);
+	offset += numBits;
+
+	return value;
+}
+
+static void WriteBits(uint8_t* pBlock, uint32_t& offset, uint32_t value, uint32_t numBits)
+{
+	for (auto i = 0u; i < numBits; ++i, ++offset)
+		pBlock[offset >> 3] |= ((value >> i) & 1u) << (offset & 7);
+}
+
+//--------------------------------------------------------------------------------------
+// Palettes, shared by the decoders and the encoders
+//--------------------------------------------------------------------------------------
+static void GetColorPalette(uint16_t color0, uint16_t color1, bool isFourColor, uint8_t palette[4][4])
+{
+	const uint16_t colors[] = { color0, color1 };
+	for (auto i = 0u; i < 2; ++i)
+	{
+		const auto r = (colors[i] >> 11) & 0x1f;
+		const auto g = (colors[i] >> 5) & 0x3f;
+		const auto b = colors[i] & 0x1f;
+		palette[i][0] = static_cast<uint8_t>((r << 3) | (r >> 2));
+		palette[i][1] = static_cast<uint8_t>((g << 2) | (g >> 4));
+		palette[i][2] = static_cast<uint8_t>((b << 3) | (b >> 2));
+		palette[i][3] = 0xff;
+	}
+
+	for (auto c = 0u; c < 3; ++c)
+	{
+		const auto c0 = palette[0][c];
+		const auto c1 = palette[1][c];
+		if (isFourColor)
+		{
+			palette[2][c] = static_cast<uint8_t>((2 * c0 + c1 + 1) / 3);
+			palette[3][c] = static_cast<uint8_t>((c0 + 2 * c1 + 1) / 3);
+		}
+		else
+		{
+			palette[2][c] = static_cast<uint8_t>((c0 + c1 + 1) / 2);
+			palette[3][c] = 0;
+		}
+	}
+
+	palette[2][3] = 0xff;
+	palette[3][3] = isFourColor ? 0xff : 0;
+}
+
+static void GetAlphaPalette(uint8_t alpha0, uint8_t alpha1, uint8_t palette[8])
+{
+	palette[0] = alpha0;
+	palette[1] = alpha1;
+	if (alpha0 > alpha1)
+		for (auto i = 1u; i < 7; ++i)
+			palette[i + 1] = static_cast<uint8_t>(((7 - i) * alpha0 + i * alpha1 + 3) / 7);
+	else
+	{
+		for (auto i = 1u; i < 5; ++i)
+			palette[i + 1] = static_cast<uint8_t>(((5 - i) * alpha0 + i * alpha1 + 2) / 5);
+		palette[6] = 0;
+		palette[7] = 0xff;
+	}
+}
+
+static uint8_t InterpolateBC7(uint32_t e0, uint32_t e1, uint32_t weight)
+{
+	return static_cast<uint8_t>(((64 - weight) * e0 + weight * e1 + 32) >> 6);
+}
+
+static uint32_t GetBC7Weight(uint32_t indexBits, uint32_t index)
+{
+	switch (indexBits)
+	{
+	case 2:
+		return BC7_WEIGHTS2[index];
+	case 3:
+		return BC7_WEIGHTS3[index];
+	default:
+		return BC7_WEIGHTS4[index];
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// SSSE3 kernels of the palette decoders. The indices of a block are extracted in vectors,
+// and looked up in the palette with byte shuffles.
+//--------------------------------------------------------------------------------------
+#if XUSG_SSSE3_KERNELS
+static bool CheckSSSE3()
+{
+	int cpuInfo[4];
+	__cpuid(cpuInfo, 1);
+
+	return (cpuInfo[2] & (1 << 9)) != 0;
+}
+
+static bool IsSSSE3Supported()
+{
+	static const auto isSSSE3Supported = CheckSSSE3();
+
+	return isSSSE3Supported;
+}
+
+// The byte shuffles that look up a row of 4 texels in a color palette, indexed by the
+// 2-bit indices of the row
+struct ColorShuffleTable
+{
+	uint8_t Shuffles[256][16];
+};
+
+static ColorShuffleTable BuildColorShuffleTable()
+{
+	ColorShuffleTable table;
+	for (auto row = 0u; row < 256; ++row)
+		for (auto i = 0u; i < 4; ++i)
+			for (auto c = 0u; c < 4; ++c)
+				table.Shuffles[row][4 * i + c] = static_cast<uint8_t>(4 * ((row >> (2 * i)) & 0x3) + c);
+
+	return table;
+}
+
+static void LookUpColorsSSSE3(const uint8_t* pIndices, const uint8_t palette[4][4], uint8_t* pTexels)
+{
+	static const auto table = BuildColorShuffleTable();
+
+	const auto colors = _mm_loadu_si128(reinterpret_cast<const __m128i*>(palette));
+	for (auto r = 0u; r < 4; ++r)
+	{
+		const auto shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i*>(table.Shuffles[pIndices[r]]));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&pTexels[16 * r]), _mm_shuffle_epi8(colors, shuffle));
+	}
+}
+
+static void LookUpAlphasSSSE3(const uint8_t* pBlock, const uint8_t palette[8], uint8_t* pTexels, uint32_t channel)
+{
+	// Each 16-bit lane gets the 2 bytes covering the 3-bit index of a texel, which is then
+	// shifted to bits 7 to 9 by a multiply, since SSSE3 has no per-lane shifts
+	uint64_t bits = 0;
+	memcpy(&bits, &pBlock[2], 6);
+	const auto data = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&bits));
+	const auto scales = _mm_setr_epi16(1 << 7, 1 << 4, 1 << 1, 1 << 6, 1 << 3, 1 << 0, 1 << 5, 1 << 2);
+	const auto mask = _mm_set1_epi16(0x7);
+	const auto extract = [&](__m128i shuffle)
+	{
+		return _mm_and_si128(_mm_srli_epi16(_mm_mullo_epi16(_mm_shuffle_epi8(data, shuffle), scales), 7), mask);
+	};
+
+	const auto indices = _mm_packus_epi16(
+		extract(_mm_setr_epi8(0, 1, 0, 1, 0, 1, 1, 2, 1, 2, 1, 2, 2, 3, 2, 3)),
+		extract(_mm_setr_epi8(3, 4, 3, 4, 3, 4, 4, 5, 4, 5, 4, 5, 5, 6, 5, 6)));
+	const auto values = _mm_shuffle_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(palette)), indices);
+
+	// Widen the values to the channel of their texels
+	const auto zero = _mm_setzero_si128();
+	const auto shift = _mm_cvtsi32_si128(static_cast<int>(8 * channel));
+	const auto channelMask = _mm_sll_epi32(_mm_set1_epi32(0xff), shift);
+	const auto values16Lo = _mm_unpacklo_epi8(values, zero);
+	const auto values16Hi = _mm_unpackhi_epi8(values, zero);
+	const __m128i values32[] =
+	{
+		_mm_unpacklo_epi16(values16Lo, zero),
+		_mm_unpackhi_epi16(values16Lo, zero),
+		_mm_unpacklo_epi16(values16Hi, zero),
+		_mm_unpackhi_epi16(values16Hi, zero)
+	};
+
+	for (auto r = 0u; r < 4; ++r)
+	{
+		const auto pRow = reinterpret_cast<__m128i*>(&pTexels[16 * r]);
+		const auto texels = _mm_andnot_si128(channelMask, _mm_loadu_si128(pRow));
+		_mm_storeu_si128(pRow, _mm_or_si128(texels, _mm_sll_epi32(values32[r], shift)));
+	}
+}
+#endif
+
+//--------------------------------------------------------------------------------------
+// Decoders
+//--------------------------------------------------------------------------------------
+static void DecodeColorBlock(const uint8_t* pBlock, uint8_t* pTexels, bool isBC1)
+{
+	const auto color0 = static_cast<uint16_t>(pBlock[0] | (pBlock[1] << 8));
+	const auto color1 = static_cast<uint16_t>(pBlock[2] | (pBlock[3] << 8));
+
+	// BC2 and BC3 always use the 4-color palette, and their alphas are decoded afterwards
+	uint8_t palette[4][4];
+	GetColorPalette(color0, color1, !isBC1 || color0 > color1, palette);
+
+#if XUSG_SSSE3_KERNELS
+	if (IsSSSE3Supported())
+	{
+		LookUpColorsSSSE3(&pBlock[4], palette, pTexels);
+		return;
+	}
+#endif
+
+	for (auto i = 0u; i < NUM_TEXELS; ++i)
+	{
+		const auto index = (pBlock[4 + (i >> 2)] >> ((i & 3) << 1)) & 0x3;
+		memcpy(&pTexels[4 * i], palette[index], 4);
+	}
+}
+
+static void DecodeAlphaBlock(const uint8_t* pBlock, uint8_t* pTexels, uint32_t channel)
+{
+	uint8_t palette[8];
+	GetAlphaPalette(pBlock[0], pBlock[1], palette);
+
+#if XUSG_SSSE3_KERNELS
+	if (IsSSSE3Supported())
+	{
+		LookUpAlphasSSSE3(pBlock, palette, pTexels, channel);
+		return;
+	}
+#endif
+
+	// The 48 bits of the indices
+	uint64_t bits = 0;
+	for (auto i = 0u; i < 6; ++i) bits |= static_cast<uint64_t>(pBlock[2 + i]) << (8 * i);
+
+	for (auto i = 0u; i < NUM_TEXELS; ++i)
+		pTexels[4 * i + channel] = palette[(bits >> (3 * i)) & 0x7];
+}
+
+static void DecodeBC7Block(const uint8_t* pBlock, uint8_t* pTexels)
+{
+	// The mode is the number of the leading zero bits
+	auto mode = 0u;
+	while (mode < 8 && !(pBlock[0] & (1 << mode))) ++mode;
+
+	// Reserved modes decode to transparent black
+	if (mode >= 8)
+	{
+		memset(pTexels, 0, 4 * NUM_TEXELS);
+		return;
+	}
+
+	const auto& info = BC7_MODES[mode];
+	auto offset = mode + 1;
+	const auto partition = ReadBits(pBlock, offset, info.PartitionBits);
+	const auto rotation = ReadBits(pBlock, offset, info.RotationBits);
+	const auto indexSelection = ReadBits(pBlock, offset, info.IndexSelectionBits);
+
+	// Endpoints, stored channel by channel
+	const auto numEndpoints = 2u * info.NumSubsets;
+	uint32_t endpoints[6][4];
+	for (auto c = 0u; c < 3; ++c)
+		for (auto e = 0u; e < numEndpoints; ++e)
+			endpoints[e][c] = ReadBits(pBlock, offset, info.ColorBits);
+	for (auto e = 0u; e < numEndpoints; ++e)
+		endpoints[e][3] = ReadBits(pBlock, offset, info.AlphaBits);
+
+	uint32_t pBits[6] = {};
+	if (info.EndpointPBits)
+		for (auto e = 0u; e < numEndpoints; ++e) pBits[e] = ReadBits(pBlock, offset, 1);
+	else if (info.SharedPBits)
+		for (auto s = 0u; s < info.NumSubsets; ++s) pBits[2 * s] = pBits[2 * s + 1] = ReadBits(pBlock, offset, 1);
+
+	// Unquantize the endpoints to 8 bits
+	const auto hasPBits = info.EndpointPBits || info.SharedPBits;
+	for (auto e = 0u; e < numEndpoints; ++e)
+		for (auto c = 0u; c < 4; ++c)
+		{
+			auto numBits = c < 3 ? info.ColorBits : info.AlphaBits;
+			if (numBits == 0) endpoints[e][c] = 0xff;
+			else
+			{
+				auto value = endpoints[e][c];
+				if (hasPBits)
+				{
+					value = (value << 1) | pBits[e];
+					++numBits;
+				}
+				endpoints[e][c] = (value << (8 - numBits)) | (value >> (2 * numBits - 8));
+			}
+		}
+
+	// The first texel of each subset drops the MSB of its index
+	uint8_t subsets[NUM_TEXELS] = {};
+	bool isAnchors[NUM_TEXELS] = { true };
+	if (info.NumSubsets == 2)
+	{
+		for (auto i = 0u; i < NUM_TEXELS; ++i) subsets[i] = (BC7_PARTITIONS2[partition] >> i) & 1;
+		isAnchors[BC7_ANCHORS2[partition]] = true;
+	}
+	else if (info.NumSubsets == 3)
+	{
+		memcpy(subsets, BC7_PARTITIONS3[partition], NUM_TEXELS);
+		isAnchors[BC7_ANCHORS3A[partition]] = true;
+		isAnchors[BC7_ANCHORS3B[partition]] = true;
+	}
+
+	uint32_t indices[NUM_TEXELS];
+	uint32_t indices2[NUM_TEXELS] = {};
+	for (auto i = 0u; i < NUM_TEXELS; ++i)
+		indices[i] = ReadBits(pBlock, offset, info.IndexBits - (isAnchors[i] ? 1 : 0));
+	if (info.IndexBits2)
+		for (auto i = 0u; i < NUM_TEXELS; ++i)
+			indices2[i] = ReadBits(pBlock, offset, info.IndexBits2 - (i == 0 ? 1 : 0));
+
+	for (auto i = 0u; i < NUM_TEXELS; ++i)
+	{
+		const auto& e0 = endpoints[2 * subsets[i]];
+		const auto& e1 = endpoints[2 * subsets[i] + 1];
+
+		// Modes 4 and 5 index the colors and the alphas separately
+		auto colorWeight = GetBC7Weight(info.IndexBits, indices[i]);
+		auto alphaWeight = colorWeight;
+		if (info.IndexBits2)
+		{
+			alphaWeight = GetBC7Weight(info.IndexBits2, indices2[i]);
+			if (indexSelection) swap(colorWeight, alphaWeight);
+		}
+
+		const auto pTexel = &pTexels[4 * i];
+		for (auto c = 0u; c < 3; ++c) pTexel[c] = InterpolateBC7(e0[c], e1[c], colorWeight);
+		pTexel[3] = InterpolateBC7(e0[3], e1[3], alphaWeight);
+
+		// Swap the alpha back with the rotated channel
+		if (rotation) swap(pTexel[rotation - 1], pTexel[3]);
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Endpoint fitting
+//--------------------------------------------------------------------------------------
+static void FitPrincipalAxis(const XMVECTOR* points, uint32_t numPoints, XMVECTOR& minPoint, XMVECTOR& maxPoint)
+{
+	auto mean = XMVectorZero();
+	auto vMin = points[0];
+	auto vMax = points[0];
+	for (auto i = 0u; i < numPoints; ++i)
+	{
+		mean += points[i];
+		vMin = XMVectorMin(vMin, points[i]);
+		vMax = XMVectorMax(vMax, points[i]);
+	}
+	mean /= static_cast<float>(numPoints);
+
+	// Power iterations on the covariance, from the diagonal of the bounds
+	auto axis = vMax - vMin;
+	for (auto k = 0u; k < NUM_FIT_ITERATIONS; ++k)
+	{
+		auto product = XMVectorZero();
+		for (auto i = 0u; i < numPoints; ++i)
+		{
+			const auto d = points[i] - mean;
+			product += d * XMVector4Dot(d, axis);
+		}
+
+		if (XMVectorGetX(XMVector4LengthSq(product)) <= FLT_MIN) break;
+		axis = XMVector4Normalize(product);
+	}
+	axis = XMVector4Normalize(axis);
+
+	auto tMin = FLT_MAX;
+	auto tMax = -FLT_MAX;
+	for (auto i = 0u; i < numPoints; ++i)
+	{
+		const auto t = XMVectorGetX(XMVector4Dot(points[i] - mean, axis));
+		tMin = (min)(tMin, t);
+		tMax = (max)(tMax, t);
+	}
+
+	minPoint = mean + axis * tMin;
+	maxPoint = mean + axis * tMax;
+}
+
+// Least squares for the endpoints, given the weights of the first endpoint; the points
+// of negative weights are skipped
+static bool SolveEndpoints(const XMVECTOR* points, const float* weights, XMVECTOR& e0, XMVECTOR& e1)
+{
+	auto a = 0.0f, b = 0.0f, c = 0.0f;
+	auto x = XMVectorZero();
+	auto y = XMVectorZero();
+	for (auto i = 0u; i < NUM_TEXELS; ++i)
+	{
+		const auto w = weights[i];
+		if (w < 0.0f) continue;
+
+		a += w * w;
+		b += w * (1.0f - w);
+		c += (1.0f - w) * (1.0f - w);
+		x += points[i] * w;
+		y += points[i] * (1.0f - w);
+	}
+
+	const auto det = a * c - b * b;
+	XUSG_C_RETURN(fabsf(det) < 1e-6f, false);
+
+	const auto invDet = 1.0f / det;
+	const auto limit = XMVectorReplicate(255.0f);
+	e0 = XMVectorClamp((x * c - y * b) * invDet, XMVectorZero(), limit);
+	e1 = XMVectorClamp((y * a - x * b) * invDet, XMVectorZero(), limit);
+
+	return true;
+}
+
+static uint16_t QuantizeColor565(FXMVECTOR color)
+{
+	XMFLOAT4 c;
+	XMStoreFloat4(&c, XMVectorClamp(color, XMVectorZero(), XMVectorReplicate(255.0f)));
+	const auto r = static_cast<uint32_t>(c.x * (31.0f / 255.0f) + 0.5f);
+	const auto g = static_cast<uint32_t>(c.y * (63.0f / 255.0f) + 0.5f);
+	const auto b = static_cast<uint32_t>(c.z * (31.0f / 255.0f) + 0.5f);
+
+	return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+static XMVECTOR LoadTexel(const uint8_t* pTexel)
+{
+	return XMVectorSet(pTexel[0], pTexel[1], pTexel[2], pTexel[3]);
+}
+
+//--------------------------------------------------------------------------------------
+// Encoders
+//--------------------------------------------------------------------------------------
+static float AssignColorIndices(const XMVECTOR* texels, const bool* isTransparent,
+	uint16_t color0, uint16_t color1, bool isFourColor, uint32_t& indices)
+{
+	uint8_t palette[4][4];
+	GetColorPalette(color0, color1, isFourColor, palette);
+
+	XMVECTOR colors[4];
+	for (auto j = 0u; j < 4; ++j) colors[j] = XMVectorSet(palette[j][0], palette[j][1], palette[j][2], 0.0f);
+
+	const auto numColors = isFourColor ? 4u : 3u;
+	auto error = 0.0f;
+	indices = 0;
+	for (auto i = 0u; i < NUM_TEXELS; ++i)
+	{
+		auto index = 3u;
+		if (!isTransparent[i])
+		{
+			const auto texel = XMVectorSetW(texels[i], 0.0f);
+			auto minDistSq = FLT_MAX;
+			for (auto j = 0u; j < numColors; ++j)
+			{
+				const auto distSq = XMVectorGetX(XMVector3LengthSq(texel - colors[j]));
+				if (distSq < minDistSq)
+				{
+					minDistSq = distSq;
+					index = j;
+				}
+			}
+			error += minDistSq;
+		}
+
+		indices |= index << (2 * i);
+	}
+
+	return error;
+}
+
+static void EncodeColorBlock(const XMVECTOR* texels, uint8_t* pBlock, bool isBC1)
+{
+	// BC1 codes the texels of alpha below half as transparent, with the 3-color palette
+	bool isTransparent[NUM_TEXELS];
+	XMVECTOR points[NUM_TEXELS];
+	auto numPoints = 0u;
+	for (auto i = 0u; i < NUM_TEXELS; ++i)
+	{
+		isTransparent[i] = isBC1 && XMVectorGetW(texels[i]) < 128.0f;
+		if (!isTransparent[i]) points[numPoints++] = XMVectorSetW(texels[i], 0.0f);
+	}
+
+	uint16_t color0 = 0, color1 = 0;
+	auto indices = 0xffffffffu;
+	const auto isFourColor = numPoints == NUM_TEXELS;
+	if (numPoints > 0)
+	{
+		XMVECTOR e0, e1;
+		FitPrincipalAxis(points, numPoints, e1, e0);
+		color0 = QuantizeColor565(e0);
+		color1 = QuantizeColor565(e1);
+		auto error = AssignColorIndices(texels, isTransparent, color0, color1, isFourColor, indices);
+
+		// Refine the endpoints for the assigned indices
+		static const float weights4[] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+		static const float weights3[] = { 1.0f, 0.0f, 0.5f, -1.0f };
+		for (auto k = 0u; k < NUM_REFINEMENTS && error > 0.0f; ++k)
+		{
+			float weights[NUM_TEXELS];
+			for (auto i = 0u; i < NUM_TEXELS; ++i)
+			{
+				const auto index = (indices >> (2 * i)) & 0x3;
+				weights[i] = isTransparent[i] ? -1.0f : (isFourColor ? weights4[index] : weights3[index]);
+			}
+
+			XMVECTOR pointArray[NUM_TEXELS];
+			for (auto i = 0u; i < NUM_TEXELS; ++i) pointArray[i] = XMVectorSetW(texels[i], 0.0f);
+			if (!SolveEndpoints(pointArray, weights, e0, e1)) break;
+
+			uint32_t refinedIndices;
+			const auto refinedColor0 = QuantizeColor565(e0);
+			const auto refinedColor1 = QuantizeColor565(e1);
+			const auto refinedError = AssignColorIndices(texels, isTransparent,
+				refinedColor0, refinedColor1, isFourColor, refinedIndices);
+			if (refinedError >= error) break;
+
+			color0 = refinedColor0;
+			color1 = refinedColor1;
+			indices = refinedIndices;
+			error = refinedError;
+		}
+
+		// The 4-color palette needs color0 > color1, and the 3-color one color0 <= color1
+		if (isFourColor && color0 < color1)
+		{
+			swap(color0, color1);
+			indices ^= 0x55555555;
+		}
+		else if (isFourColor && color0 == color1) indices = 0;
+		else if (!isFourColor && color0 > color1)
+		{
+			swap(color0, color1);
+			for (auto i = 0u; i < NUM_TEXELS; ++i)
+				if (((indices >> (2 * i)) & 0x3) < 2) indices ^= 1u << (2 * i);
+		}
+	}
+
+	pBlock[0] = static_cast<uint8_t>(color0);
+	pBlock[1] = static_cast<uint8_t>(color0 >> 8);
+	pBlock[2] = static_cast<uint8_t>(color1);
+	pBlock[3] = static_cast<uint8_t>(color1 >> 8);
+	for (auto i = 0u; i < 4; ++i) pBlock[4 + i] = static_cast<uint8_t>(indices >> (8 * i));
+}
+
+static uint32_t AssignAlphaIndices(const uint8_t* values, uint8_t alpha0, uint8_t alpha1, uint8_t indices[NUM_TEXELS])
+{
+	uint8_t palette[8];
+	GetAlphaPalette(alpha0, alpha1, palette);
+
+	auto error = 0u;
+	for (auto i = 0u; i < NUM_TEXELS; ++i)
+	{
+		auto minDist = UINT32_MAX;
+		for (auto j = 0u; j < 8; ++j)
+		{
+			const auto dist = static_cast<uint32_t>(abs(values[i] - palette[j]));
+			if (dist < minDist)
+			{
+				minDist = dist;
+				indices[i] = static_cast<uint8_t>(j);
+			}
+		}
+		error += minDist * minDist;
+	}
+
+	return error;
+}
+
+static void EncodeAlphaBlock(const uint8_t* pTexels, uint32_t stride, uint8_t* pBlock)
+{
+	uint8_t values[NUM_TEXELS];
+	uint8_t minValue = 0xff, maxValue = 0;
+	uint8_t minInner = 0xff, maxInner = 0;
+	for (auto i = 0u; i < NUM_TEXELS; ++i)
+	{
+		values[i] = pTexels[stride * i];
+		minValue = (min)(minValue, values[i]);
+		maxValue = (max)(maxValue, values[i]);
+		if (values[i] > 0 && values[i] < 0xff)
+		{
+			minInner = (min)(minInner, values[i]);
+			maxInner = (max)(maxInner, values[i]);
+		}
+	}
+
+	// Either 8 levels over the range, or 6 levels over the range between 0 and 255
+	uint8_t indices[NUM_TEXELS];
+	auto alpha0 = maxValue;
+	auto alpha1 = minValue;
+	auto error = AssignAlphaIndices(values, alpha0, alpha1, indices);
+	if (error > 0 && minInner <= maxInner && (minValue == 0 || maxValue == 0xff))
+	{
+		uint8_t innerIndices[NUM_TEXELS];
+		const auto innerError = AssignAlphaIndices(values, minInner, maxInner, innerIndices);
+		if (innerError < error)
+		{
+			alpha0 = minInner;
+			alpha1 = maxInner;
+			memcpy(indices, innerIndices, sizeof(indices));
+		}
+	}
+
+	memset(pBlock, 0, 8);
+	pBlock[0] = alpha0;
+	pBlock[1] = alpha1;
+	auto offset = 16u;
+	for (auto i = 0u; i < NUM_TEXELS; ++i) WriteBits(pBlock, offset, indices[i], 3);
+}
+
+static float AssignBC7Indices(const XMVECTOR* texels, const uint32_t endpoints[2][4], uint8_t indices[NUM_TEXELS])
+{
+	XMVECTOR colors[16];
+	for (auto j = 0u; j < 16; ++j)
+	{
+		uint8_t color[4];
+		for (auto c = 0u; c < 4; ++c) color[c] = InterpolateBC7(endpoints[0][c], endpoints[1][c], BC7_WEIGHTS4[j]);
+		colors[j] = LoadTexel(color);
+	}
+
+	auto error = 0.0f;
+	for (auto i = 0u; i < NUM_TEXELS; ++i)
+	{
+		auto minDistSq = FLT_MAX;
+		for (auto j = 0u; j < 16; ++j)
+		{
+			const auto distSq = XMVectorGetX(XMVector4LengthSq(texels[i] - colors[j]));
+			if (distSq < minDistSq)
+			{
+				minDistSq = distSq;
+				indices[i] = static_cast<uint8_t>(j);
+			}
+		}
+		error += minDistSq;
+	}
+
+	return error;
+}
+
+static void EncodeBC7Block(const XMVECTOR* texels, uint8_t* pBlock)
+{
+	// Mode 6: a single subset of 7-bit RGBA endpoints with unique p-bits, and 4-bit indices
+	XMVECTOR e0, e1;
+	FitPrincipalAxis(texels, NUM_TEXELS, e0, e1);
+
+	uint32_t endpoints[2][4] = {};
+	uint32_t pBits[2] = {};
+	uint8_t indices[NUM_TEXELS] = {};
+	auto error = FLT_MAX;
+	for (auto k = 0u; k <= NUM_REFINEMENTS; ++k)
+	{
+		// Try all the p-bits for the endpoints
+		auto isImproved = false;
+		XMFLOAT4 points[2];
+		XMStoreFloat4(&points[0], e0);
+		XMStoreFloat4(&points[1], e1);
+		for (auto p = 0u; p < 4; ++p)
+		{
+			uint32_t candidates[2][4];
+			for (auto e = 0u; e < 2; ++e)
+			{
+				const auto pBit = (p >> e) & 1;
+				const auto point = &points[e].x;
+				for (auto c = 0u; c < 4; ++c)
+				{
+					const auto value = static_cast<int>((point[c] - pBit) * 0.5f + 0.5f);
+					candidates[e][c] = (static_cast<uint32_t>((min)((max)(value, 0), 127)) << 1) | pBit;
+				}
+			}
+
+			uint8_t candidateIndices[NUM_TEXELS];
+			const auto candidateError = AssignBC7Indices(texels, candidates, candidateIndices);
+			if (candidateError < error)
+			{
+				memcpy(endpoints, candidates, sizeof(endpoints));
+				memcpy(indices, candidateIndices, sizeof(indices));
+				pBits[0] = p & 1;
+				pBits[1] = p >> 1;
+				error = candidateError;
+				isImproved = true;
+			}
+		}
+
+		// Refine the endpoints for the assigned indices
+		if (!isImproved || error <= 0.0f || k >= NUM_REFINEMENTS) break;
+
+		float weights[NUM_TEXELS];
+		for (auto i = 0u; i < NUM_TEXELS; ++i) weights[i] = (64 - BC7_WEIGHTS4[indices[i]]) / 64.0f;
+		if (!SolveEndpoints(texels, weights, e0, e1)) break;
+	}
+
+	// The index MSB of the first texel is implicitly 0
+	if (indices[0] & 0x8)
+	{
+		for (auto c = 0u; c < 4; ++c) swap(endpoints[0][c], endpoints[1][c]);
+		swap(pBits[0], pBits[1]);
+		for (auto& index : indices) index = 15 - index;
+	}
+
+	memset(pBlock, 0, 16);
+	auto offset = 0u;
+	WriteBits(pBlock, offset, 1 << 6, 7);
+	for (auto c = 0u; c < 4; ++c)
+		for (auto e = 0u; e < 2; ++e)
+			WriteBits(pBlock, offset, endpoints[e][c] >> 1, 7);
+	WriteBits(pBlock, offset, pBits[0], 1);
+	WriteBits(pBlock, offset, pBits[1], 1);
+	for (auto i = 0u; i < NUM_TEXELS; ++i) WriteBits(pBlock, offset, indices[i], i ? 4 : 3);
+}
+
+//--------------------------------------------------------------------------------------
+// Block codec implementations
+//--------------------------------------------------------------------------------------
+bool BlockCodec::IsSupported(Format format)
+{
+	return GetBlockSize(format) > 0;
+}
+
+uint32_t BlockCodec::GetBlockSize(Format format)
+{
+	switch (format)
+	{
+	case Format::BC1_TYPELESS:
+	case Format::BC1_UNORM:
+	case Format::BC1_UNORM_SRGB:
+	case Format::BC4_TYPELESS:
+	case Format::BC4_UNORM:
+		return 8;
+	case Format::BC2_TYPELESS:
+	case Format::BC2_UNORM:
+	case Format::BC2_UNORM_SRGB:
+	case Format::BC3_TYPELESS:
+	case Format::BC3_UNORM:
+	case Format::BC3_UNORM_SRGB:
+	case Format::BC5_TYPELESS:
+	case Format::BC5_UNORM:
+	case Format::BC7_TYPELESS:
+	case Format::BC7_UNORM:
+	case Format::BC7_UNORM_SRGB:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+bool BlockCodec::Decode(Format format, uint32_t width, uint32_t height,
+	const uint8_t* pSrc, uint8_t* pDst, size_t dstRowPitch)
+{
+	const auto blockSize = GetBlockSize(format);
+	XUSG_C_RETURN(blockSize == 0 || !pSrc || !pDst, false);
+
+	const auto numBlocksX = XUSG_DIV_UP(width, 4);
+	const auto numBlocksY = XUSG_DIV_UP(height, 4);
+	ThreadPool::GetDefault().ParallelFor(numBlocksY, [&](uint32_t y)
+	{
+		uint8_t texels[4 * NUM_TEXELS];
+		for (auto x = 0u; x < numBlocksX; ++x)
+		{
+			DecodeBlock(format, &pSrc[blockSize * (numBlocksX * y + x)], texels);
+
+			// Clip the partial blocks
+			const auto w = (min)(width - 4 * x, 4u);
+			const auto h = (min)(height - 4 * y, 4u);
+			for (auto j = 0u; j < h; ++j)
+				memcpy(&pDst[dstRowPitch * (4 * y + j) + 16 * x], &texels[16 * j], 4 * w);
+		}
+	});
+
+	return true;
+}
+
+bool BlockCodec::Encode(Format format, uint32_t width, uint32_t height,
+	const uint8_t* pSrc, size_t srcRowPitch, uint8_t* pDst)
+{
+	const auto blockSize = GetBlockSize(format);
+	XUSG_C_RETURN(blockSize == 0 || !pSrc || !pDst || width == 0 || height == 0, false);
+
+	const auto numBlocksX = XUSG_DIV_UP(width, 4);
+	const auto numBlocksY = XUSG_DIV_UP(height, 4);
+	ThreadPool::GetDefault().ParallelFor(numBlocksY, [&](uint32_t y)
+	{
+		uint8_t texels[4 * NUM_TEXELS];
+		for (auto x = 0u; x < numBlocksX; ++x)
+		{
+			// Repeat the edge texels into the partial blocks
+			for (auto j = 0u; j < 4; ++j)
+			{
+				const auto v = (min)(4 * y + j, height - 1);
+				for (auto i = 0u; i < 4; ++i)
+				{
+					const auto u = (min)(4 * x + i, width - 1);
+					memcpy(&texels[4 * (4 * j + i)], &pSrc[srcRowPitch * v + 4 * u], 4);
+				}
+			}
+
+			EncodeBlock(format, texels, &pDst[blockSize * (numBlocksX * y + x)]);
+		}
+	});
+
+	return true;
+}
+
+void BlockCodec::DecodeBlock(Format format, const uint8_t* pBlock, uint8_t* pTexels)
+{
+	switch (format)
+	{
+	case Format::BC1_TYPELESS:
+	case Format::BC1_UNORM:
+	case Format::BC1_UNORM_SRGB:
+		DecodeColorBlock(pBlock, pTexels, true);
+		break;
+	case Format::BC2_TYPELESS:
+	case Format::BC2_UNORM:
+	case Format::BC2_UNORM_SRGB:
+		DecodeColorBlock(&pBlock[8], pTexels, false);
+		for (auto i = 0u; i < NUM_TEXELS; ++i)
+			pTexels[4 * i + 3] = static_cast<uint8_t>(((pBlock[i >> 1] >> ((i & 1) << 2)) & 0xf) * 17);
+		break;
+	case Format::BC3_TYPELESS:
+	case Format::BC3_UNORM:
+	case Format::BC3_UNORM_SRGB:
+		DecodeColorBlock(&pBlock[8], pTexels, false);
+		DecodeAlphaBlock(pBlock, pTexels, 3);
+		break;
+	case Format::BC4_TYPELESS:
+	case Format::BC4_UNORM:
+		for (auto i = 0u; i < NUM_TEXELS; ++i)
+		{
+			pTexels[4 * i + 1] = pTexels[4 * i + 2] = 0;
+			pTexels[4 * i + 3] = 0xff;
+		}
+		DecodeAlphaBlock(pBlock, pTexels, 0);
+		break;
+	case Format::BC5_TYPELESS:
+	case Format::BC5_UNORM:
+		for (auto i = 0u; i < NUM_TEXELS; ++i)
+		{
+			pTexels[4 * i + 2] = 0;
+			pTexels[4 * i + 3] = 0xff;
+		}
+		DecodeAlphaBlock(pBlock, pTexels, 0);
+		DecodeAlphaBlock(&pBlock[8], pTexels, 1);
+		break;
+	case Format::BC7_TYPELESS:
+	case Format::BC7_UNORM:
+	case Format::BC7_UNORM_SRGB:
+		DecodeBC7Block(pBlock, pTexels);
+		break;
+	default:
+		assert(!"Unsupported block format");
+	}
+}
+
+void BlockCodec::EncodeBlock(Format format, const uint8_t* pTexels, uint8_t* pBlock)
+{
+	XMVECTOR texels[NUM_TEXELS];
+	for (auto i = 0u; i < NUM_TEXELS; ++i) texels[i] = LoadTexel(&pTexels[4 * i]);
+
+	switch (format)
+	{
+	case Format::BC1_TYPELESS:
+	case Format::BC1_UNORM:
+	case Format::BC1_UNORM_SRGB:
+		EncodeColorBlock(texels, pBlock, true);
+		break;
+	case Format::BC2_TYPELESS:
+	case Format::BC2_UNORM:
+	case Format::BC2_UNORM_SRGB:
+		memset(pBlock, 0, 8);
+		for (auto i = 0u; i < NUM_TEXELS; ++i)
+		{
+			const auto alpha = (pTexels[4 * i + 3] * 15 + 127) / 255;
+			pBlock[i >> 1] |= static_cast<uint8_t>(alpha << ((i & 1) << 2));
+		}
+		EncodeColorBlock(texels, &pBlock[8], false);
+		break;
+	case Format::BC3_TYPELESS:
+	case Format::BC3_UNORM:
+	case Format::BC3_UNORM_SRGB:
+		EncodeAlphaBlock(&pTexels[3], 4, pBlock);
+		EncodeColorBlock(texels, &pBlock[8], false);
+		break;
+	case Format::BC4_TYPELESS:
+	case Format::BC4_UNORM:
+		EncodeAlphaBlock(pTexels, 4, pBlock);
+		break;
+	case Format::BC5_TYPELESS:
+	case Format::BC5_UNORM:
+		EncodeAlphaBlock(pTexels, 4, pBlock);
+		EncodeAlphaBlock(&pTexels[1], 4, &pBlock[8]);
+		break;
+	case Format::BC7_TYPELESS:
+	case Format::BC7_UNORM:
+	case Format::BC7_UNORM_SRGB:
+		EncodeBC7Block(texels, pBlock);
+		break;
+	default:
+		assert(!"Unsupported block format");
+	}
+}
@@ -0,0 +1,38 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "Core/XUSG.h"
+
+namespace XUSG
+{
+	//--------------------------------------------------------------------------------------
+	// CPU block compression of BC1-BC5 and BC7, to and from R8G8B8A8. The encoders fit the
+	// endpoints with DirectXMath vectors; BC7 is encoded in mode 6, and decoded in all modes.
+	// The BC1-BC5 decoders extract the indices and look up the palettes with SSSE3 shuffles
+	// if the CPU supports it. The surfaces are coded by block rows in parallel on the thread
+	// pool.
+	//--------------------------------------------------------------------------------------
+	class BlockCodec
+	{
+	public:
+		static const uint32_t NUM_TEXELS = 16;
+
+		static bool IsSupported(Format format);
+		// Bytes per 4x4 block, or 0 if the format is not supported
+		static uint32_t GetBlockSize(Format format);
+
+		// Surfaces; BC4 and BC5 decode the missing channels as 0, with opaque alpha, and the
+		// encoders repeat the edge texels into the partial blocks
+		static bool Decode(Format format, uint32_t width, uint32_t height,
+			const uint8_t* pSrc, uint8_t* pDst, size_t dstRowPitch);
+		static bool Encode(Format format, uint32_t width, uint32_t height,
+			const uint8_t* pSrc, size_t srcRowPitch, uint8_t* pDst);
+
+		// Single blocks of 16 R8G8B8A8 texels in rows
+		static void DecodeBlock(Format format, const uint8_t* pBlock, uint8_t* pTexels);
+		static void EncodeBlock(Format format, const uint8_t* pTexels, uint8_t* pBlock);
+	};
+}
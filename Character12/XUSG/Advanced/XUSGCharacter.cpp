@@ -27,11 +27,23 @@ Character::sptr Character::MakeShared(const wchar_t* name, API api)
 SDKMesh::sptr Character::LoadSDKMesh(const Device* pDevice, const wstring& meshFileName,
 	const wstring& animFileName, const TextureLib& textureLib,
 	const shared_ptr<vector<MeshLink>>& meshLinks,
-	vector<SDKMesh::sptr>* linkedMeshes, API api)
+	vector<SDKMesh::sptr>* linkedMeshes, API api, MeshLoadFlags loadFlags)
 {
-	// Load the animated mesh
-	const auto mesh = Model::LoadSDKMesh(pDevice, meshFileName, textureLib, false, api);
-	XUSG_N_RETURN(mesh->LoadAnimation(animFileName.c_str()), nullptr);
+	// Load the animated mesh together with the linked meshes; the skinned vertices are
+	// repacked into the skinning input layout
+	const auto batchLoader = BatchLoader::MakeUnique(api);
+	const auto meshIndex = batchLoader->AddMesh(meshFileName.c_str(), animFileName.c_str(),
+		false, loadFlags | MESH_LOAD_REPACK_VERTICES);
+
+	vector<uint32_t> linkedMeshIndices;
+	if (meshLinks)
+		for (const auto& meshLink : *meshLinks)
+			linkedMeshIndices.emplace_back(batchLoader->AddMesh(meshLink.MeshName.c_str()));
+
+	XUSG_N_RETURN(batchLoader->Load(pDevice, textureLib), nullptr);
+	XUSG_N_RETURN(batchLoader->Wait(), nullptr);
+
+	const auto mesh = batchLoader->GetMesh(meshIndex);
 	mesh->TransformBindPose(XMMatrixIdentity());
 
 	// Fix the frame name to avoid space
@@ -43,7 +55,7 @@ SDKMesh::sptr Character::LoadSDKMesh(const Device* pDevice, const wstring& meshF
 			if (szName[j] == ' ') szName[j] = '_';
 	}
 
-	// Load the linked meshes
+	// Attach the linked meshes to their bones
 	if (meshLinks)
 	{
 		const auto numLinks = static_cast<uint8_t>(meshLinks->size());
@@ -53,9 +65,7 @@ SDKMesh::sptr Character::LoadSDKMesh(const Device* pDevice, const wstring& meshF
 		{
 			auto& meshInfo = meshLinks->at(m);
 			meshInfo.BoneIndex = mesh->FindFrameIndex(meshInfo.BoneName.c_str());
-			linkedMeshes->at(m) = SDKMesh::MakeShared(api);
-			XUSG_N_RETURN(linkedMeshes->at(m)->Create(pDevice, meshInfo.MeshName.c_str(),
-				textureLib), nullptr);
+			linkedMeshes->at(m) = batchLoader->GetMesh(linkedMeshIndices[m]);
 		}
 	}
 
@@ -81,6 +91,7 @@ Character_Impl::Character_Impl(const wchar_t* name, API api) :
 	m_cbLinkedMatrices(0)
 {
 	m_variableSlot = VARIABLE_SLOT;
+	m_materialSliceSlot = MATERIAL_SLICE;
 }
 
 Character_Impl::~Character_Impl(void)
@@ -321,18 +332,22 @@ bool Character_Impl::createPipelineLayouts()
 {
 	// Skinning
 	{
+		const auto isQuantized = m_mesh->IsVertexQuantized();
 		auto roBoneWorld = 0u;
 		auto rwVertices = 0u;
 		auto roVertices = roBoneWorld + 1;
+		auto cbDequantization = 0u;
 
 		// Get compute shader slots
-		const auto reflector = m_shaderLib->GetReflector(Shader::Stage::CS, CS_SKINNING);
+		const auto reflector = m_shaderLib->GetReflector(Shader::Stage::CS,
+			isQuantized ? CS_SKINNING_QUANTIZED : CS_SKINNING);
 		if (reflector && reflector->IsValid())
 		{
 			// Get shader resource slots
 			rwVertices = reflector->GetResourceBindingPointByName("g_rwVertices", rwVertices);
 			roBoneWorld = reflector->GetResourceBindingPointByName("g_roDualQuat", roBoneWorld);
 			roVertices = reflector->GetResourceBindingPointByName("g_roVertices", roVertices);
+			cbDequantization = reflector->GetResourceBindingPointByName("cbDequantization", cbDequantization);
 		}
 
 		// Pipeline layout utility
@@ -348,6 +363,11 @@ bool Character_Impl::createPipelineLayouts()
 			DescriptorFlag::DATA_STATIC_WHILE_SET_AT_EXECUTE | DescriptorFlag::DESCRIPTORS_VOLATILE);
 		utilPipelineLayout->SetShaderStage(OUTPUT, Shader::Stage::CS);
 
+		// Dequantization of the input positions, padded to float4s as in the constant buffer
+		if (isQuantized)
+			utilPipelineLayout->SetConstants(DEQUANTIZATION, XUSG_UINT32_SIZE_OF(XMFLOAT4[2]),
+				cbDequantization, 0, Shader::Stage::CS);
+
 		// Get pipeline layout
 		XUSG_X_RETURN(m_skinningPipelineLayout, utilPipelineLayout->GetPipelineLayout(m_pipelineLayoutLib.get(),
 			PipelineLayoutFlag::NONE, m_name.empty() ? nullptr : (m_name + L".SkinningLayout").c_str()), false);
@@ -366,7 +386,8 @@ bool Character_Impl::createPipelineLayouts()
 			roVertices = reflector->GetResourceBindingPointByName("g_roVertices", roVertices);
 #endif
 
-		const auto utilPipelineLayout = initPipelineLayout(VS_BASE_PASS, PS_BASE_PASS);
+		const auto utilPipelineLayout = initPipelineLayout(VS_BASE_PASS,
+			m_useTextureArrays ? PS_BASE_PASS_ARRAY : PS_BASE_PASS);
 
 #if XUSG_TEMPORAL
 		utilPipelineLayout->SetRange(HISTORY, DescriptorType::SRV, 1, roVertices);
@@ -406,7 +427,8 @@ bool Character_Impl::createPipelines(const InputLayout* pInputLayout, uint32_t n
 	{
 		const auto state = Compute::State::MakeUnique(m_api);
 		state->SetPipelineLayout(m_skinningPipelineLayout);
-		state->SetShader(m_shaderLib->GetShader(Shader::Stage::CS, CS_SKINNING));
+		state->SetShader(m_shaderLib->GetShader(Shader::Stage::CS,
+			m_mesh->IsVertexQuantized() ? CS_SKINNING_QUANTIZED : CS_SKINNING));
 		XUSG_X_RETURN(m_skinningPipeline, state->GetPipeline(m_computePipelineLib.get(),
 			m_name.empty() ? nullptr : (m_name + L".SkinningPipe").c_str()), false);
 	}
@@ -456,8 +478,16 @@ void Character_Impl::skinning(const CommandList* pCommandList, bool reset)
 		pCommandList->SetComputeDescriptorTable(INPUT, m_srvSkinningTables[m_currentFrame][m]);
 		pCommandList->SetComputeDescriptorTable(OUTPUT, m_uavSkinningTables[m_currentFrame][m]);
 
-		// Skinning
-		const auto numVertices = static_cast<uint32_t>(m_mesh->GetNumVertices(m, 0));
+		if (m_mesh->IsVertexQuantized())
+		{
+			XMFLOAT4 dequantization[2] = {};
+			m_mesh->GetVertexDequantization(m, reinterpret_cast<XMFLOAT3*>(&dequantization[0]),
+				reinterpret_cast<XMFLOAT3*>(&dequantization[1]));
+			pCommandList->SetCompute32BitConstants(DEQUANTIZATION, XUSG_UINT32_SIZE_OF(dequantization), dequantization);
+		}
+
+		// Skinning, only the vertices referenced by the current LOD
+		const auto numVertices = static_cast<uint32_t>(m_mesh->GetNumLODVertices(m, m_lod));
 		pCommandList->Dispatch(XUSG_DIV_UP(numVertices, 64), 1, 1);
 	}
 }
@@ -48,7 +48,8 @@ namespace XUSG
 		enum SkinningDescriptorTableSlot : uint8_t
 		{
 			INPUT,
-			OUTPUT
+			OUTPUT,
+			DEQUANTIZATION
 		};
 
 		struct Vertex
@@ -3,6 +3,8 @@
 //--------------------------------------------------------------------------------------
 
 #include "XUSGAdvanced.h"
+#include "XUSGBlockCodec.h"
+#include "XUSGMipGenerator.h"
 #include "Core/XUSG_DX12.h"
 #include "Core/XUSGEnum_DX12.h"
 #include "dds.h"
@@ -21,46 +23,16 @@ typedef public unique_ptr<void, handle_closer> ScopedHandle;
 inline HANDLE safe_handle(HANDLE h) { return (h == INVALID_HANDLE_VALUE) ? 0 : h; }
 #endif
 
-static bool LoadTextureDataFromFile(const wchar_t* fileName,
-	unique_ptr<uint8_t[]>& ddsData, DDS_HEADER** header,
+static bool LoadTextureDataFromFile(const wchar_t* fileName, size_t maxsize,
+	vector<uint8_t>& ddsData, DDS_HEADER** header,
 	uint8_t** bitData, size_t* bitSize)
 {
 	F_RETURN(!header || !bitData || !bitSize, cerr, E_POINTER, false);
 
-	// Open the file
-	ifstream fileStream(fileName, ios::in | ios::binary);
-	F_RETURN(!fileStream, cerr, GetLastError(), false);
-
-	// Get the file size
-	fileStream.seekg(0, fileStream.end);
-	const auto fileSize = static_cast<uint32_t>(fileStream.tellg());
-	if (!fileStream.seekg(0))
-	{
-		fileStream.close();
-
-		return false;
-	}
-
-	// Need at least enough data to fill the header and magic number to be a valid DDS
-	XUSG_C_RETURN(fileSize < (sizeof(DDS_HEADER) + sizeof(uint32_t)), false);
-
-	// create enough space for the file data
-	ddsData.reset(new uint8_t[fileSize]);
-	F_RETURN(!ddsData, cerr, E_OUTOFMEMORY, false);
-
-	// read the data in
-	F_RETURN(!fileStream.read(reinterpret_cast<char*>(ddsData.get()), fileSize),
-		cerr, GetLastError(), false);
-
-	// DDS files always start with the same magic number ("DDS ")
-	const auto dwMagicNumber = *reinterpret_cast<const uint32_t*>(ddsData.get());
-	XUSG_C_RETURN(dwMagicNumber != DDS_MAGIC, false);
-
-	const auto hdr = reinterpret_cast<DDS_HEADER*>(ddsData.get() + sizeof(uint32_t));
-
-	// Verify header to validate DDS file
-	XUSG_C_RETURN(hdr->size != sizeof(DDS_HEADER) || hdr->ddspf.size != sizeof(DDS_PIXELFORMAT), false);
+	// Read and validate only the mips to keep
+	XUSG_N_RETURN(Loader::LoadTextureData(fileName, ddsData, maxsize), false);
 
+	const auto hdr = reinterpret_cast<DDS_HEADER*>(ddsData.data() + sizeof(uint32_t));
 	auto offset = sizeof(uint32_t) + sizeof(DDS_HEADER);
 
 	// Check for extensions
@@ -68,13 +40,10 @@ static bool LoadTextureDataFromFile(const wchar_t* fileName,
 		if (MAKEFOURCC('D', 'X', '1', '0') == hdr->ddspf.fourCC)
 			offset += sizeof(DDS_HEADER_DXT10);
 
-	// Must be long enough for all headers and magic value
-	XUSG_C_RETURN(fileSize < offset, false);
-
 	// setup the pointers in the process request
 	*header = hdr;
-	*bitData = ddsData.get() + offset;
-	*bitSize = fileSize - offset;
+	*bitData = ddsData.data() + offset;
+	*bitSize = ddsData.size() - offset;
 
 	return true;
 }
@@ -489,6 +458,204 @@ static Format MakeSRGB(Format format)
 	}
 }
 
+//--------------------------------------------------------------------------------------
+// Get the layout of the surface data from the header, before any limits are validated
+//--------------------------------------------------------------------------------------
+static bool GetBitLayout(const DDS_HEADER* header, uint32_t& width, uint32_t& height,
+	uint32_t& depth, uint32_t& mipCount, uint32_t& arraySize, Format& format)
+{
+	width = header->width;
+	height = header->height;
+	depth = 1;
+	mipCount = (max)(header->mipMapCount, 1u);
+	arraySize = 1;
+
+	if ((header->ddspf.flags & DDS_FOURCC) && (MAKEFOURCC('D', 'X', '1', '0') == header->ddspf.fourCC))
+	{
+		const auto d3d10ext = reinterpret_cast<const DDS_HEADER_DXT10*>
+			(reinterpret_cast<const char*>(header) + sizeof(DDS_HEADER));
+
+		arraySize = d3d10ext->arraySize;
+		format = GetFormat(d3d10ext->dxgiFormat);
+
+		switch (d3d10ext->resourceDimension)
+		{
+		case DDS_DIMENSION_TEXTURE1D:
+			height = 1;
+			break;
+		case DDS_DIMENSION_TEXTURE2D:
+			if (d3d10ext->miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE) arraySize *= 6;
+			break;
+		case DDS_DIMENSION_TEXTURE3D:
+			depth = header->depth;
+			break;
+		default:
+			return false;
+		}
+	}
+	else
+	{
+		format = GetFormat(header->ddspf);
+		if (header->flags & DDS_HEADER_FLAGS_VOLUME) depth = header->depth;
+		else if (header->caps2 & DDS_CUBEMAP) arraySize = 6;
+	}
+
+	return arraySize > 0 && Loader::BitsPerPixel(format) > 0;
+}
+
+//--------------------------------------------------------------------------------------
+// Call func with the size of the file and its positioned reads, from a mounted archive if
+// it has the file, or else from the file
+//--------------------------------------------------------------------------------------
+template<typename T>
+static bool AccessTextureFile(const wchar_t* fileName, const T& func)
+{
+	// A compressed file in the archive is decompressed by the chunks of each read
+	uint64_t pakFileSize;
+	const auto archive = PakArchive::GetMounted(fileName);
+	if (archive && archive->GetFileSize(fileName, &pakFileSize)) return func(pakFileSize,
+		[&archive, fileName](uint64_t offset, size_t size, uint8_t* pDst)
+	{
+		return archive->Read(fileName, offset, size, pDst);
+	});
+
+	// Open the file
+	ifstream fileStream(fileName, ios::in | ios::binary);
+	F_RETURN(!fileStream, cerr, GetLastError(), false);
+
+	// Get the file size
+	fileStream.seekg(0, fileStream.end);
+	const auto fileSize = static_cast<uint64_t>(fileStream.tellg());
+
+	return func(fileSize, [&fileStream](uint64_t offset, size_t size, uint8_t* pDst)
+	{
+		F_RETURN(!fileStream.seekg(static_cast<streamoff>(offset)) ||
+			!fileStream.read(reinterpret_cast<char*>(pDst), static_cast<streamsize>(size)),
+			cerr, GetLastError(), false);
+
+		return true;
+	});
+}
+
+//--------------------------------------------------------------------------------------
+// Read and validate the headers; ddsData may also hold the leading bytes of the surfaces
+//--------------------------------------------------------------------------------------
+template<typename T>
+static bool ReadTextureHeaders(uint64_t fileSize, vector<uint8_t>& ddsData, size_t& offset, const T& read)
+{
+	// Need at least enough data to fill the header and magic number to be a valid DDS
+	XUSG_C_RETURN(fileSize < (sizeof(DDS_HEADER) + sizeof(uint32_t)), false);
+
+	const auto headerSize = static_cast<size_t>((min)(fileSize,
+		static_cast<uint64_t>(sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10))));
+	ddsData.resize(headerSize);
+	XUSG_N_RETURN(read(0, headerSize, ddsData.data()), false);
+
+	// DDS files always start with the same magic number ("DDS ")
+	const auto magicNumber = *reinterpret_cast<const uint32_t*>(ddsData.data());
+	XUSG_C_RETURN(magicNumber != DDS_MAGIC, false);
+
+	// Verify header to validate DDS file
+	const auto header = reinterpret_cast<const DDS_HEADER*>(ddsData.data() + sizeof(uint32_t));
+	XUSG_C_RETURN(header->size != sizeof(DDS_HEADER) || header->ddspf.size != sizeof(DDS_PIXELFORMAT), false);
+
+	offset = sizeof(uint32_t) + sizeof(DDS_HEADER);
+
+	// Check for extensions
+	if (header->ddspf.flags & DDS_FOURCC)
+		if (MAKEFOURCC('D', 'X', '1', '0') == header->ddspf.fourCC)
+			offset += sizeof(DDS_HEADER_DXT10);
+
+	// Must be long enough for all headers and magic value
+	XUSG_C_RETURN(fileSize < offset, false);
+
+	return true;
+}
+
+//--------------------------------------------------------------------------------------
+// Get the ranges of the surface data after the validated headers in ddsData, of only the
+// mips within maxsize. The headers are rewritten to describe the kept mips, so the data
+// with the ranges appended remain a valid DDS file, which the texture creation does not
+// need to trim again.
+//--------------------------------------------------------------------------------------
+static void GetDataRanges(uint64_t fileSize, size_t offset, size_t maxsize,
+	vector<uint8_t>& ddsData, vector<Loader::DataRange>& ranges)
+{
+	ddsData.resize(offset);
+	ranges.clear();
+	const auto header = reinterpret_cast<DDS_HEADER*>(ddsData.data() + sizeof(uint32_t));
+
+	// The mips over maxsize lead every array slice, as in FillInitData()
+	uint32_t width, height, depth, mipCount, arraySize;
+	Format format;
+	auto skipMip = 0u;
+	size_t skipBytes = 0;
+	size_t sliceBytes = 0;
+	if (maxsize && GetBitLayout(header, width, height, depth, mipCount, arraySize, format))
+	{
+		auto w = width;
+		auto h = height;
+		auto d = depth;
+		for (auto i = 0u; i < mipCount; ++i)
+		{
+			size_t numBytes = 0;
+			GetSurfaceInfo(w, h, format, &numBytes, nullptr, nullptr);
+			if (mipCount > 1 && (w > maxsize || h > maxsize || d > maxsize))
+			{
+				++skipMip;
+				skipBytes += numBytes * d;
+			}
+			sliceBytes += numBytes * d;
+
+			w = (max)(w >> 1, 1u);
+			h = (max)(h >> 1, 1u);
+			d = (max)(d >> 1, 1u);
+		}
+	}
+
+	// Read the whole file if all the mips are kept, or if it is too short, which fails the creation
+	if (skipMip == 0 || skipMip >= mipCount || fileSize - offset < static_cast<uint64_t>(sliceBytes) * arraySize)
+	{
+		if (fileSize > offset) ranges.push_back({ offset, static_cast<size_t>(fileSize - offset) });
+
+		return;
+	}
+
+	const auto keptBytes = sliceBytes - skipBytes;
+	for (auto j = 0u; j < arraySize; ++j) ranges.push_back({ offset + sliceBytes * j + skipBytes, keptBytes });
+
+	// Describe the kept mips
+	header->width = (max)(width >> skipMip, 1u);
+	header->height = (max)(height >> skipMip, 1u);
+	if (header->flags & DDS_HEADER_FLAGS_VOLUME) header->depth = (max)(depth >> skipMip, 1u);
+	header->mipMapCount = mipCount - skipMip;
+}
+
+//--------------------------------------------------------------------------------------
+// Read the headers first, and then only the mips of each array slice within maxsize with
+// positioned reads
+//--------------------------------------------------------------------------------------
+template<typename T>
+static bool ReadTextureData(uint64_t fileSize, size_t maxsize, vector<uint8_t>& ddsData, const T& read)
+{
+	size_t offset;
+	vector<Loader::DataRange> ranges;
+	XUSG_N_RETURN(ReadTextureHeaders(fileSize, ddsData, offset, read), false);
+	GetDataRanges(fileSize, offset, maxsize, ddsData, ranges);
+
+	auto dataSize = offset;
+	for (const auto& range : ranges) dataSize += range.Size;
+	ddsData.resize(dataSize);
+
+	for (const auto& range : ranges)
+	{
+		XUSG_N_RETURN(read(range.Offset, range.Size, &ddsData[offset]), false);
+		offset += range.Size;
+	}
+
+	return true;
+}
+
 static bool FillInitData(uint32_t width, uint32_t height, uint32_t depth,
 	uint32_t mipCount, uint32_t arraySize, Format format,
 	size_t maxsize, size_t bitSize, const uint8_t* bitData,
@@ -754,6 +921,52 @@ static bool CreateTexture(CommandList* pCommandList, const DDS_HEADER* header,
 	return true;
 }
 
+//--------------------------------------------------------------------------------------
+// Formats of the CPU transcoding
+//--------------------------------------------------------------------------------------
+#define TO_DXGI_FORMAT(fmt) case Format::fmt: return DXGI_FORMAT_##fmt
+
+static bool IsTranscodable(Format format)
+{
+	switch (format)
+	{
+	case Format::R8G8B8A8_TYPELESS:
+	case Format::R8G8B8A8_UNORM:
+	case Format::R8G8B8A8_UNORM_SRGB:
+		return true;
+	default:
+		return BlockCodec::IsSupported(format);
+	}
+}
+
+static DXGI_FORMAT ToDXGIFormat(Format format)
+{
+	switch (format)
+	{
+		TO_DXGI_FORMAT(R8G8B8A8_TYPELESS);
+		TO_DXGI_FORMAT(R8G8B8A8_UNORM);
+		TO_DXGI_FORMAT(R8G8B8A8_UNORM_SRGB);
+		TO_DXGI_FORMAT(BC1_TYPELESS);
+		TO_DXGI_FORMAT(BC1_UNORM);
+		TO_DXGI_FORMAT(BC1_UNORM_SRGB);
+		TO_DXGI_FORMAT(BC2_TYPELESS);
+		TO_DXGI_FORMAT(BC2_UNORM);
+		TO_DXGI_FORMAT(BC2_UNORM_SRGB);
+		TO_DXGI_FORMAT(BC3_TYPELESS);
+		TO_DXGI_FORMAT(BC3_UNORM);
+		TO_DXGI_FORMAT(BC3_UNORM_SRGB);
+		TO_DXGI_FORMAT(BC4_TYPELESS);
+		TO_DXGI_FORMAT(BC4_UNORM);
+		TO_DXGI_FORMAT(BC5_TYPELESS);
+		TO_DXGI_FORMAT(BC5_UNORM);
+		TO_DXGI_FORMAT(BC7_TYPELESS);
+		TO_DXGI_FORMAT(BC7_UNORM);
+		TO_DXGI_FORMAT(BC7_UNORM_SRGB);
+	default:
+		return DXGI_FORMAT_UNKNOWN;
+	}
+}
+
 static AlphaMode GetAlphaMode(const DDS_HEADER* header)
 {
 	if (header->ddspf.flags & DDS_FOURCC)
@@ -834,12 +1047,19 @@ bool Loader::CreateTextureFromFile(CommandList* pCommandList, const wchar_t* fil
 	if (alphaMode)* alphaMode = ALPHA_MODE_UNKNOWN;
 	F_RETURN(!pCommandList || !fileName, cerr, E_INVALIDARG, false);
 
+	// Create from a mounted archive in place if it has the file
+	size_t ddsDataSize;
+	PakArchive::sptr archive;
+	const auto pDDSData = PakArchive::FindMounted(fileName, &ddsDataSize, &archive);
+	if (pDDSData) return CreateTextureFromMemory(pCommandList, pDDSData, ddsDataSize, maxsize,
+		forceSRGB, texture, pUploader, alphaMode, state, memoryFlags, api);
+
 	DDS_HEADER* header = nullptr;
 	uint8_t* bitData = nullptr;
 	size_t bitSize = 0;
 
-	unique_ptr<uint8_t[]> ddsData;
-	XUSG_N_RETURN(LoadTextureDataFromFile(fileName, ddsData, &header, &bitData, &bitSize), false);
+	vector<uint8_t> ddsData;
+	XUSG_N_RETURN(LoadTextureDataFromFile(fileName, maxsize, ddsData, &header, &bitData, &bitSize), false);
 
 	XUSG_N_RETURN(CreateTexture(pCommandList, header, bitData, bitSize, maxsize,
 		forceSRGB, texture, pUploader, state, memoryFlags, fileName, api), false);
@@ -849,6 +1069,218 @@ bool Loader::CreateTextureFromFile(CommandList* pCommandList, const wchar_t* fil
 	return true;
 }
 
+bool Loader::LoadTextureData(const wchar_t* fileName, vector<uint8_t>& ddsData, size_t maxsize)
+{
+	F_RETURN(!fileName, cerr, E_INVALIDARG, false);
+
+	return AccessTextureFile(fileName, [&](uint64_t fileSize, const auto& read)
+	{
+		return ReadTextureData(fileSize, maxsize, ddsData, read);
+	});
+}
+
+bool Loader::GetTextureDataRanges(const uint8_t* pHeaderData, size_t headerDataSize, uint64_t fileSize,
+	size_t maxsize, vector<uint8_t>& ddsData, vector<DataRange>& ranges)
+{
+	F_RETURN(!pHeaderData, cerr, E_INVALIDARG, false);
+
+	size_t offset;
+	XUSG_N_RETURN(ReadTextureHeaders(fileSize, ddsData, offset, [&](uint64_t pos, size_t size, uint8_t* pDst)
+	{
+		// Only the leading bytes are available
+		XUSG_C_RETURN(pos + size > headerDataSize, false);
+		memcpy(pDst, &pHeaderData[pos], size);
+
+		return true;
+	}), false);
+	GetDataRanges(fileSize, offset, maxsize, ddsData, ranges);
+
+	return true;
+}
+
+bool Loader::LoadTextureInfo(const wchar_t* fileName, TextureInfo& info)
+{
+	F_RETURN(!fileName, cerr, E_INVALIDARG, false);
+
+	vector<uint8_t> ddsData;
+	size_t offset;
+	XUSG_N_RETURN(AccessTextureFile(fileName, [&](uint64_t fileSize, const auto& read)
+	{
+		return ReadTextureHeaders(fileSize, ddsData, offset, read);
+	}), false);
+
+	const auto header = reinterpret_cast<const DDS_HEADER*>(ddsData.data() + sizeof(uint32_t));
+	XUSG_N_RETURN(GetBitLayout(header, info.Width, info.Height, info.Depth,
+		info.MipCount, info.ArraySize, info.Format), false);
+	info.AlphaMode = GetAlphaMode(header);
+
+	return true;
+}
+
+size_t Loader::GetSurfaceSize(uint32_t width, uint32_t height, Format fmt)
+{
+	size_t numBytes;
+	GetSurfaceInfo(width, height, fmt, &numBytes, nullptr, nullptr);
+
+	return numBytes;
+}
+
+bool Loader::TranscodeTextureData(const uint8_t* ddsData, size_t ddsDataSize,
+	Format format, vector<uint8_t>& outData)
+{
+	F_RETURN(!ddsData || !IsTranscodable(format), cerr, E_INVALIDARG, false);
+
+	size_t offset;
+	vector<uint8_t> headerData;
+	XUSG_N_RETURN(ReadTextureHeaders(ddsDataSize, headerData, offset, [ddsData](uint64_t srcOffset, size_t size, uint8_t* pDst)
+	{
+		memcpy(pDst, ddsData + srcOffset, size);
+
+		return true;
+	}), false);
+
+	const auto header = reinterpret_cast<const DDS_HEADER*>(ddsData + sizeof(uint32_t));
+	uint32_t width, height, depth, mipCount, arraySize;
+	Format srcFormat;
+	XUSG_N_RETURN(GetBitLayout(header, width, height, depth, mipCount, arraySize, srcFormat), false);
+	F_RETURN(!IsTranscodable(srcFormat), cerr, ERROR_NOT_SUPPORTED, false);
+
+	// Sizes of the surfaces of an array slice
+	size_t srcSliceBytes = 0;
+	size_t dstSliceBytes = 0;
+	for (auto i = 0u; i < mipCount; ++i)
+	{
+		size_t srcBytes, dstBytes;
+		const auto d = (max)(depth >> i, 1u);
+		GetSurfaceInfo((max)(width >> i, 1u), (max)(height >> i, 1u), srcFormat, &srcBytes, nullptr, nullptr);
+		GetSurfaceInfo((max)(width >> i, 1u), (max)(height >> i, 1u), format, &dstBytes, nullptr, nullptr);
+		srcSliceBytes += srcBytes * d;
+		dstSliceBytes += dstBytes * d;
+	}
+	F_RETURN(ddsDataSize - offset < srcSliceBytes * arraySize, cerr, ERROR_HANDLE_EOF, false);
+
+	// Headers
+	const auto dstOffset = sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10);
+	outData.resize(dstOffset + dstSliceBytes * arraySize);
+	reinterpret_cast<uint32_t&>(outData[0]) = DDS_MAGIC;
+
+	const auto isDstCompressed = BlockCodec::IsSupported(format);
+	const auto dstHeader = reinterpret_cast<DDS_HEADER*>(&outData[sizeof(uint32_t)]);
+	size_t dstNumBytes, dstRowBytes;
+	GetSurfaceInfo(width, height, format, &dstNumBytes, &dstRowBytes, nullptr);
+	*dstHeader = *header;
+	dstHeader->ddspf = DDSPF_DX10;
+	dstHeader->flags &= ~(DDS_HEADER_FLAGS_PITCH | DDS_HEADER_FLAGS_LINEARSIZE);
+	dstHeader->flags |= isDstCompressed ? DDS_HEADER_FLAGS_LINEARSIZE : DDS_HEADER_FLAGS_PITCH;
+	dstHeader->pitchOrLinearSize = static_cast<uint32_t>(isDstCompressed ? dstNumBytes : dstRowBytes);
+
+	const auto d3d10ext = reinterpret_cast<DDS_HEADER_DXT10*>(&outData[sizeof(uint32_t) + sizeof(DDS_HEADER)]);
+	if (offset > sizeof(uint32_t) + sizeof(DDS_HEADER))
+		*d3d10ext = *reinterpret_cast<const DDS_HEADER_DXT10*>(&headerData[sizeof(uint32_t) + sizeof(DDS_HEADER)]);
+	else
+	{
+		const auto isCubeMap = (header->caps2 & DDS_CUBEMAP) != 0;
+		d3d10ext->resourceDimension = (header->flags & DDS_HEADER_FLAGS_VOLUME) ?
+			DDS_DIMENSION_TEXTURE3D : DDS_DIMENSION_TEXTURE2D;
+		d3d10ext->miscFlag = isCubeMap ? DDS_RESOURCE_MISC_TEXTURECUBE : 0;
+		d3d10ext->arraySize = isCubeMap ? arraySize / 6 : arraySize;
+		d3d10ext->miscFlags2 = GetAlphaMode(header);
+	}
+	d3d10ext->dxgiFormat = ToDXGIFormat(format);
+
+	// Decode the source surfaces to R8G8B8A8 if compressed, and then encode them if required
+	const auto isSrcCompressed = BlockCodec::IsSupported(srcFormat);
+	auto pSrc = ddsData + offset;
+	auto pDst = &outData[dstOffset];
+	vector<uint8_t> texels;
+	for (auto j = 0u; j < arraySize; ++j)
+	{
+		for (auto i = 0u; i < mipCount; ++i)
+		{
+			const auto w = (max)(width >> i, 1u);
+			const auto h = (max)(height >> i, 1u);
+			const auto d = (max)(depth >> i, 1u);
+
+			size_t srcBytes, dstBytes;
+			GetSurfaceInfo(w, h, srcFormat, &srcBytes, nullptr, nullptr);
+			GetSurfaceInfo(w, h, format, &dstBytes, nullptr, nullptr);
+			for (auto k = 0u; k < d; ++k)
+			{
+				auto pTexels = pSrc;
+				if (isSrcCompressed)
+				{
+					texels.resize(sizeof(uint32_t) * w * h);
+					BlockCodec::Decode(srcFormat, w, h, pSrc, texels.data(), sizeof(uint32_t) * w);
+					pTexels = texels.data();
+				}
+
+				if (isDstCompressed) BlockCodec::Encode(format, w, h, pTexels, sizeof(uint32_t) * w, pDst);
+				else memcpy(pDst, pTexels, dstBytes);
+
+				pSrc += srcBytes;
+				pDst += dstBytes;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool Loader::GenerateMipmaps(const uint8_t* ddsData, size_t ddsDataSize,
+	MipFilter filter, vector<uint8_t>& outData)
+{
+	F_RETURN(!ddsData, cerr, E_INVALIDARG, false);
+
+	size_t offset;
+	vector<uint8_t> headerData;
+	XUSG_N_RETURN(ReadTextureHeaders(ddsDataSize, headerData, offset, [ddsData](uint64_t srcOffset, size_t size, uint8_t* pDst)
+	{
+		memcpy(pDst, ddsData + srcOffset, size);
+
+		return true;
+	}), false);
+
+	const auto header = reinterpret_cast<const DDS_HEADER*>(ddsData + sizeof(uint32_t));
+	uint32_t width, height, depth, mipCount, arraySize;
+	Format format;
+	XUSG_N_RETURN(GetBitLayout(header, width, height, depth, mipCount, arraySize, format), false);
+	XUSG_C_RETURN(mipCount > 1 || depth > 1 || !MipGenerator::IsSupported(format), false);
+
+	// Full mip chain of each array slice
+	auto numMips = 1u;
+	while ((max)(width, height) >> numMips) ++numMips;
+	XUSG_C_RETURN(numMips == 1, false);
+
+	size_t srcSliceBytes = 0;
+	size_t dstSliceBytes = 0;
+	GetSurfaceInfo(width, height, format, &srcSliceBytes, nullptr, nullptr);
+	for (auto i = 0u; i < numMips; ++i)
+	{
+		size_t numBytes;
+		GetSurfaceInfo((max)(width >> i, 1u), (max)(height >> i, 1u), format, &numBytes, nullptr, nullptr);
+		dstSliceBytes += numBytes;
+	}
+	F_RETURN(ddsDataSize - offset < srcSliceBytes * arraySize, cerr, ERROR_HANDLE_EOF, false);
+
+	// Headers, with the mip count
+	outData.resize(offset + dstSliceBytes * arraySize);
+	memcpy(outData.data(), ddsData, offset);
+
+	const auto dstHeader = reinterpret_cast<DDS_HEADER*>(&outData[sizeof(uint32_t)]);
+	dstHeader->mipMapCount = numMips;
+	dstHeader->flags |= DDS_HEADER_FLAGS_MIPMAP;
+	dstHeader->caps |= DDS_SURFACE_FLAGS_MIPMAP;
+
+	for (auto j = 0u; j < arraySize; ++j)
+	{
+		const auto pDst = &outData[offset + dstSliceBytes * j];
+		memcpy(pDst, &ddsData[offset + srcSliceBytes * j], srcSliceBytes);
+		XUSG_N_RETURN(MipGenerator::Generate(format, filter, width, height, numMips, pDst), false);
+	}
+
+	return true;
+}
+
 size_t Loader::BitsPerPixel(Format fmt)
 {
 	switch (fmt)
@@ -0,0 +1,121 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "XUSGFileIndex.h"
+#include "XUSGHash.h"
+
+using namespace std;
+using namespace XUSG;
+
+FileIndex::FileIndex() :
+	m_listings(),
+	m_listingGroup(ThreadPool::GetDefault().CreateGroup())
+{
+}
+
+FileIndex::~FileIndex()
+{
+}
+
+void FileIndex::Prefetch(const wstring& path)
+{
+	wstring directory, fileName;
+	splitPath(path, directory, fileName);
+	getListing(directory);
+}
+
+void FileIndex::Invalidate(const wstring& path)
+{
+	wstring directory, fileName;
+	splitPath(path, directory, fileName);
+
+	lock_guard<mutex> lock(m_mutex);
+	m_listings.erase(directory);
+}
+
+void FileIndex::Clear()
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_listings.clear();
+}
+
+bool FileIndex::Exists(const wstring& filePath)
+{
+	uint64_t size;
+
+	return GetSize(filePath, size);
+}
+
+bool FileIndex::GetSize(const wstring& filePath, uint64_t& size)
+{
+	wstring directory, fileName;
+	splitPath(filePath, directory, fileName);
+	XUSG_C_RETURN(fileName.empty(), false);
+
+	// Help with the listings while this one is still in flight
+	const auto listingFuture = getListing(directory);
+	ThreadPool::GetDefault().Wait(listingFuture, m_listingGroup);
+
+	const auto& listing = *listingFuture.get();
+	const auto fileIter = listing.find(fileName);
+	XUSG_C_RETURN(fileIter == listing.cend(), false);
+
+	size = fileIter->second;
+
+	return true;
+}
+
+FileIndex& FileIndex::GetDefault()
+{
+	static FileIndex fileIndex;
+
+	return fileIndex;
+}
+
+FileIndex::ListingFuture FileIndex::getListing(const wstring& directory)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	const auto listingIter = m_listings.find(directory);
+	if (listingIter != m_listings.cend()) return listingIter->second;
+
+	ListingFuture listingFuture = ThreadPool::GetDefault().Enqueue([directory]()
+	{
+		return listDirectory(directory);
+	}, m_listingGroup).share();
+	m_listings.emplace(directory, listingFuture);
+
+	return listingFuture;
+}
+
+shared_ptr<const FileIndex::Listing> FileIndex::listDirectory(const wstring& directory)
+{
+	const auto listing = make_shared<Listing>();
+
+	WIN32_FIND_DATAW findData;
+	const auto hFind = FindFirstFileExW((directory + L"*").c_str(), FindExInfoBasic, &findData,
+		FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+	if (hFind == INVALID_HANDLE_VALUE) return listing;
+
+	do
+	{
+		if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+
+		wstring fileName = findData.cFileName;
+		transform(fileName.begin(), fileName.end(), fileName.begin(), towlower);
+		(*listing)[fileName] = (static_cast<uint64_t>(findData.nFileSizeHigh) << 32) | findData.nFileSizeLow;
+	} while (FindNextFileW(hFind, &findData));
+
+	FindClose(hFind);
+
+	return listing;
+}
+
+void FileIndex::splitPath(const wstring& path, wstring& directory, wstring& fileName)
+{
+	const auto normalizedPath = Hash::NormalizePath(path);
+	const auto found = normalizedPath.find_last_of(L'\\');
+	directory = found == wstring::npos ? L".\\" : normalizedPath.substr(0, found + 1);
+	fileName = found == wstring::npos ? normalizedPath : normalizedPath.substr(found + 1);
+}
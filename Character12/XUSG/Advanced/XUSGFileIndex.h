@@ -0,0 +1,48 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "XUSGThreadPool.h"
+
+namespace XUSG
+{
+	//--------------------------------------------------------------------------------------
+	// Directory index of the asset folders. Each folder is listed once, in the background, and
+	// then answered from memory. The meshes probe their material textures through it, so that
+	// the missing ones, e.g. the optional specular maps, cost no failed opens; the files found
+	// are still opened by their loaders, and the other loaders open their files directly.
+	//--------------------------------------------------------------------------------------
+	class FileIndex
+	{
+	public:
+		FileIndex();
+		virtual ~FileIndex();
+
+		// Start listing the folder of the path on the thread pool, if not yet indexed
+		void Prefetch(const std::wstring& path);
+		// Drop the listing of the folder of the path, e.g. after its files were changed
+		void Invalidate(const std::wstring& path);
+		void Clear();
+
+		bool Exists(const std::wstring& filePath);
+		bool GetSize(const std::wstring& filePath, uint64_t& size);
+
+		static FileIndex& GetDefault();
+
+	protected:
+		// Lower-case file name to file size
+		using Listing = std::unordered_map<std::wstring, uint64_t>;
+		using ListingFuture = std::shared_future<std::shared_ptr<const Listing>>;
+
+		ListingFuture getListing(const std::wstring& directory);
+
+		static std::shared_ptr<const Listing> listDirectory(const std::wstring& directory);
+		static void splitPath(const std::wstring& path, std::wstring& directory, std::wstring& fileName);
+
+		std::mutex m_mutex;
+		std::unordered_map<std::wstring, ListingFuture> m_listings;
+		ThreadPool::Group m_listingGroup;
+	};
+}
@@ -0,0 +1,100 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "XUSGGeometryCache.h"
+
+using namespace std;
+using namespace XUSG;
+
+//--------------------------------------------------------------------------------------
+// Geometry cache implementations
+//--------------------------------------------------------------------------------------
+GeometryCache::GeometryCache()
+{
+}
+
+GeometryCache::~GeometryCache()
+{
+}
+
+GeometryCache::Key GeometryCache::GetKey(const uint8_t* pData, size_t size, uint32_t numOffsets,
+	const uintptr_t* pOffsets, uint32_t stride)
+{
+	// Seed the content hash with the layout
+	vector<uint64_t> layout(numOffsets + 2);
+	layout[0] = stride;
+	layout[1] = numOffsets;
+	for (auto i = 0u; i < numOffsets; ++i) layout[i + 2] = pOffsets[i];
+	const auto layoutKey = Hash::GetContentKey(layout.data(), sizeof(uint64_t) * layout.size());
+
+	return Hash::GetContentKey(pData, size, layoutKey.Hash[0] ^ layoutKey.Hash[1]);
+}
+
+VertexBuffer::sptr GeometryCache::FindVertexBuffer(const Key& key, const uint8_t* pData, size_t size) const
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	return find(m_vertexBuffers, key, pData, size);
+}
+
+IndexBuffer::sptr GeometryCache::FindIndexBuffer(const Key& key, const uint8_t* pData, size_t size) const
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	return find(m_indexBuffers, key, pData, size);
+}
+
+void GeometryCache::InsertVertexBuffer(const Key& key, const VertexBuffer::sptr& vertexBuffer, const BufferData& data)
+{
+	lock_guard<mutex> lock(m_mutex);
+	insert(m_vertexBuffers, key, vertexBuffer, data);
+}
+
+void GeometryCache::InsertIndexBuffer(const Key& key, const IndexBuffer::sptr& indexBuffer, const BufferData& data)
+{
+	lock_guard<mutex> lock(m_mutex);
+	insert(m_indexBuffers, key, indexBuffer, data);
+}
+
+GeometryCache& GeometryCache::GetDefault()
+{
+	static GeometryCache geometryCache;
+
+	return geometryCache;
+}
+
+template<typename T>
+shared_ptr<T> GeometryCache::find(const BufferMap<T>& buffers, const Key& key,
+	const uint8_t* pData, size_t size)
+{
+	const auto bufferIter = buffers.find(key);
+	if (bufferIter == buffers.cend()) return nullptr;
+
+	// The key may collide, so only share the buffer of identical bytes
+	const auto& data = bufferIter->second.Data;
+	if (!data || data->size() != size || (size > 0 && memcmp(data->data(), pData, size) != 0))
+		return nullptr;
+
+	return bufferIter->second.Buffer.lock();
+}
+
+template<typename T>
+void GeometryCache::insert(BufferMap<T>& buffers, const Key& key,
+	const shared_ptr<T>& buffer, const BufferData& data)
+{
+	// Drop the released buffers with their bytes
+	for (auto bufferIter = buffers.begin(); bufferIter != buffers.end();)
+	{
+		if (bufferIter->second.Buffer.expired()) bufferIter = buffers.erase(bufferIter);
+		else ++bufferIter;
+	}
+
+	if (!buffer || !data) return;
+	auto& cachedBuffer = buffers[key];
+	if (cachedBuffer.Buffer.expired())
+	{
+		cachedBuffer.Buffer = buffer;
+		cachedBuffer.Data = data;
+	}
+}
@@ -0,0 +1,68 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <mutex>
+#include <unordered_map>
+#include "XUSGHash.h"
+
+namespace XUSG
+{
+	//--------------------------------------------------------------------------------------
+	// Geometry cache, sharing the uploaded vertex and index buffers of identical content
+	// across meshes. The buffers are weakly referenced, so they are released with the
+	// last mesh using them. The source bytes are kept with each buffer, and compared
+	// before sharing, so that a key collision never hands out a wrong buffer; they are
+	// the uploaded bytes, unless the buffer is uploaded in a derived form, e.g. quantized,
+	// which the stride in the key then tells apart.
+	//--------------------------------------------------------------------------------------
+	class GeometryCache
+	{
+	public:
+		using Key = ContentKey;
+		using BufferData = std::shared_ptr<const std::vector<uint8_t>>;
+
+		GeometryCache();
+		virtual ~GeometryCache();
+
+		// Content key of the buffer data, including the layout of the views
+		static Key GetKey(const uint8_t* pData, size_t size, uint32_t numOffsets,
+			const uintptr_t* pOffsets, uint32_t stride = 0);
+
+		// Returns the live buffer of the key, only if its source bytes equal the data
+		VertexBuffer::sptr FindVertexBuffer(const Key& key, const uint8_t* pData, size_t size) const;
+		IndexBuffer::sptr FindIndexBuffer(const Key& key, const uint8_t* pData, size_t size) const;
+
+		// Insert the buffer with its source bytes, unless a live buffer of the same key exists
+		void InsertVertexBuffer(const Key& key, const VertexBuffer::sptr& vertexBuffer, const BufferData& data);
+		void InsertIndexBuffer(const Key& key, const IndexBuffer::sptr& indexBuffer, const BufferData& data);
+
+		static GeometryCache& GetDefault();
+
+	protected:
+		using KeyHasher = Hash::ContentKeyHasher;
+
+		template<typename T>
+		struct CachedBuffer
+		{
+			std::weak_ptr<T> Buffer;
+			BufferData Data;
+		};
+
+		template<typename T>
+		using BufferMap = std::unordered_map<Key, CachedBuffer<T>, KeyHasher>;
+
+		template<typename T>
+		static std::shared_ptr<T> find(const BufferMap<T>& buffers, const Key& key,
+			const uint8_t* pData, size_t size);
+		template<typename T>
+		static void insert(BufferMap<T>& buffers, const Key& key,
+			const std::shared_ptr<T>& buffer, const BufferData& data);
+
+		mutable std::mutex m_mutex;
+		BufferMap<VertexBuffer> m_vertexBuffers;
+		BufferMap<IndexBuffer> m_indexBuffers;
+	};
+}
@@ -0,0 +1,193 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "XUSGHash.h"
+
+using namespace std;
+using namespace XUSG;
+
+//--------------------------------------------------------------------------------------
+// XXH64 primes
+//--------------------------------------------------------------------------------------
+static const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ull;
+static const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4Full;
+static const uint64_t PRIME64_3 = 0x165667B19E3779F9ull;
+static const uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ull;
+static const uint64_t PRIME64_5 = 0x27D4EB2F165667C5ull;
+
+static inline uint64_t RotateLeft(uint64_t x, uint8_t r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t Read64(const uint8_t* p)
+{
+	uint64_t value;
+	memcpy(&value, p, sizeof(uint64_t));
+
+	return value;
+}
+
+static inline uint32_t Read32(const uint8_t* p)
+{
+	uint32_t value;
+	memcpy(&value, p, sizeof(uint32_t));
+
+	return value;
+}
+
+static inline uint64_t HashRound(uint64_t acc, uint64_t input)
+{
+	acc += input * PRIME64_2;
+	acc = RotateLeft(acc, 31);
+
+	return acc * PRIME64_1;
+}
+
+static inline uint64_t HashMergeRound(uint64_t acc, uint64_t value)
+{
+	acc ^= HashRound(0, value);
+
+	return acc * PRIME64_1 + PRIME64_4;
+}
+
+static inline char ToLower(char c)
+{
+	return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+static inline wchar_t ToLower(wchar_t c)
+{
+	return static_cast<wchar_t>(towlower(c));
+}
+
+template<typename T>
+static basic_string<T> NormalizePathT(const basic_string<T>& path, bool isFolder)
+{
+	// File names are case-insensitive, and both separators are accepted
+	auto normalizedPath = path;
+	for (auto& c : normalizedPath)
+		c = c == T('/') ? T('\\') : ToLower(c);
+
+	const T currentFolder[] = { T('.'), T('\\'), T('\0') };
+	while (normalizedPath.compare(0, 2, currentFolder) == 0) normalizedPath.erase(0, 2);
+	if (isFolder && !normalizedPath.empty() && normalizedPath.back() != T('\\')) normalizedPath += T('\\');
+
+	return normalizedPath;
+}
+
+bool ContentKey::operator==(const ContentKey& key) const
+{
+	return Hash[0] == key.Hash[0] && Hash[1] == key.Hash[1] && Size == key.Size;
+}
+
+//--------------------------------------------------------------------------------------
+// Hash implementations
+//--------------------------------------------------------------------------------------
+size_t Hash::ContentKeyHasher::operator()(const ContentKey& key) const
+{
+	return static_cast<size_t>(key.Hash[0] ^ key.Hash[1]);
+}
+
+ContentKey Hash::GetContentKey(const void* pData, size_t size, uint64_t seed)
+{
+	auto p = static_cast<const uint8_t*>(pData);
+	const auto pEnd = p + size;
+
+	// The second half merges the lanes in the reverse order, and takes the tail with its own
+	// rotations, so that it does not follow from the first
+	uint64_t h[2];
+	if (size >= 32)
+	{
+		uint64_t v[] = { seed + PRIME64_1 + PRIME64_2, seed + PRIME64_2, seed, seed - PRIME64_1 };
+		for (const auto pLimit = pEnd - 32; p <= pLimit; p += 32)
+		{
+			v[0] = HashRound(v[0], Read64(p));
+			v[1] = HashRound(v[1], Read64(p + 8));
+			v[2] = HashRound(v[2], Read64(p + 16));
+			v[3] = HashRound(v[3], Read64(p + 24));
+		}
+
+		h[0] = RotateLeft(v[0], 1) + RotateLeft(v[1], 7) + RotateLeft(v[2], 12) + RotateLeft(v[3], 18);
+		h[1] = RotateLeft(v[3], 1) + RotateLeft(v[2], 7) + RotateLeft(v[1], 12) + RotateLeft(v[0], 18);
+		for (auto i = 0u; i < 4; ++i)
+		{
+			h[0] = HashMergeRound(h[0], v[i]);
+			h[1] = HashMergeRound(h[1], v[3 - i]);
+		}
+	}
+	else
+	{
+		h[0] = seed + PRIME64_5;
+		h[1] = seed + PRIME64_3;
+	}
+
+	h[0] += size;
+	h[1] += size;
+
+	for (; p + 8 <= pEnd; p += 8)
+	{
+		const auto k = HashRound(0, Read64(p));
+		h[0] ^= k;
+		h[0] = RotateLeft(h[0], 27) * PRIME64_1 + PRIME64_4;
+		h[1] ^= k;
+		h[1] = RotateLeft(h[1], 29) * PRIME64_2 + PRIME64_5;
+	}
+
+	if (p + 4 <= pEnd)
+	{
+		const auto k = Read32(p) * PRIME64_1;
+		h[0] ^= k;
+		h[0] = RotateLeft(h[0], 23) * PRIME64_2 + PRIME64_3;
+		h[1] ^= k;
+		h[1] = RotateLeft(h[1], 19) * PRIME64_1 + PRIME64_4;
+		p += 4;
+	}
+
+	for (; p < pEnd; ++p)
+	{
+		const auto k = *p * PRIME64_5;
+		h[0] ^= k;
+		h[0] = RotateLeft(h[0], 11) * PRIME64_1;
+		h[1] ^= k;
+		h[1] = RotateLeft(h[1], 13) * PRIME64_2;
+	}
+
+	// Avalanche, by XXH64 and by MurmurHash3
+	h[0] ^= h[0] >> 33;
+	h[0] *= PRIME64_2;
+	h[0] ^= h[0] >> 29;
+	h[0] *= PRIME64_3;
+	h[0] ^= h[0] >> 32;
+
+	h[1] ^= h[1] >> 33;
+	h[1] *= 0xff51afd7ed558ccdull;
+	h[1] ^= h[1] >> 33;
+	h[1] *= 0xc4ceb9fe1a85ec53ull;
+	h[1] ^= h[1] >> 33;
+
+	return { { h[0], h[1] }, size };
+}
+
+uint64_t Hash::HashString(const wstring& str)
+{
+	auto hash = 14695981039346656037ull;
+	for (const auto& c : str)
+	{
+		hash ^= static_cast<uint16_t>(c);
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+wstring Hash::NormalizePath(const wstring& path, bool isFolder)
+{
+	return NormalizePathT(path, isFolder);
+}
+
+string Hash::NormalizePath(const string& path, bool isFolder)
+{
+	return NormalizePathT(path, isFolder);
+}
@@ -0,0 +1,34 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "XUSGAdvanced.h"
+
+namespace XUSG
+{
+	//--------------------------------------------------------------------------------------
+	// Hashes and path keys shared by the caches, the texture library and the archives. The
+	// content keys are 128-bit: the bulk is hashed in the four lanes of XXH64 at memory speed,
+	// and the lanes and the tail are merged into two independent halves, the first of which
+	// is XXH64. The short strings, e.g. the paths in the archive directories, are hashed with
+	// 64-bit FNV-1a.
+	//--------------------------------------------------------------------------------------
+	class Hash
+	{
+	public:
+		struct ContentKeyHasher
+		{
+			size_t operator()(const ContentKey& key) const;
+		};
+
+		static ContentKey GetContentKey(const void* pData, size_t size, uint64_t seed = 0);
+		static uint64_t HashString(const std::wstring& str);
+
+		// Lower-case with backslashes and without the leading ".\", so that the spellings of a
+		// path match; the folders end with a backslash
+		static std::wstring NormalizePath(const std::wstring& path, bool isFolder = false);
+		static std::string NormalizePath(const std::string& path, bool isFolder = false);
+	};
+}
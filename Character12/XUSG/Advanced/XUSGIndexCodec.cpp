@@ -0,0 +1,298 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "XUSGIndexCodec.h"
+
+#if defined(_M_IX86) || defined(_M_X64)
+#define XUSG_SSSE3_KERNELS 1
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#define XUSG_SSSE3_KERNELS 0
+#endif
+
+using namespace std;
+using namespace XUSG;
+
+static inline uint16_t EncodeZigzag(uint16_t delta)
+{
+	return static_cast<uint16_t>((delta << 1) ^ (0u - (delta >> 15)));
+}
+
+static inline uint32_t EncodeZigzag(uint32_t delta)
+{
+	return (delta << 1) ^ (0u - (delta >> 31));
+}
+
+static inline uint32_t DecodeZigzag(uint32_t code)
+{
+	return (code >> 1) ^ (0u - (code & 1));
+}
+
+#if XUSG_SSSE3_KERNELS
+static bool CheckSSSE3()
+{
+	int cpuInfo[4];
+	__cpuid(cpuInfo, 1);
+
+	return (cpuInfo[2] & (1 << 9)) != 0;
+}
+
+// The byte shuffles that widen the packed values of a group to their lanes, and the data
+// sizes of the groups, indexed by the control bytes
+struct ShuffleTables
+{
+	uint8_t Shuffles16[256][16];
+	uint8_t Shuffles32[256][16];
+	uint8_t DataSizes16[256];
+	uint8_t DataSizes32[256];
+};
+
+static ShuffleTables BuildShuffleTables()
+{
+	ShuffleTables tables;
+	for (auto control = 0u; control < 256; ++control)
+	{
+		// A value takes 1 or 2 bytes, and the missing high byte is zeroed
+		auto offset = 0u;
+		for (auto i = 0u; i < 8; ++i)
+		{
+			const auto numBytes = 1 + ((control >> i) & 1);
+			tables.Shuffles16[control][2 * i] = static_cast<uint8_t>(offset);
+			tables.Shuffles16[control][2 * i + 1] = static_cast<uint8_t>(numBytes > 1 ? offset + 1 : 0x80);
+			offset += numBytes;
+		}
+		tables.DataSizes16[control] = static_cast<uint8_t>(offset);
+
+		// A value takes 1 to 4 bytes
+		offset = 0;
+		for (auto i = 0u; i < 4; ++i)
+		{
+			const auto numBytes = 1 + ((control >> (2 * i)) & 3);
+			for (auto j = 0u; j < 4; ++j)
+				tables.Shuffles32[control][4 * i + j] = static_cast<uint8_t>(j < numBytes ? offset + j : 0x80);
+			offset += numBytes;
+		}
+		tables.DataSizes32[control] = static_cast<uint8_t>(offset);
+	}
+
+	return tables;
+}
+
+static const ShuffleTables& GetShuffleTables()
+{
+	static const auto shuffleTables = BuildShuffleTables();
+
+	return shuffleTables;
+}
+
+//--------------------------------------------------------------------------------------
+// Decode the full groups while 16 bytes of data can be loaded, and return the number of the
+// decoded groups. The deltas are summed up in the lanes with log-step shifts, and offset by
+// the last index of the previous group.
+//--------------------------------------------------------------------------------------
+static size_t DecodeGroups16SSSE3(const uint8_t* pControls, const uint8_t*& pData, const uint8_t* pDataEnd,
+	size_t numGroups, uint16_t* pIndices, uint16_t& prevIndex)
+{
+	const auto& tables = GetShuffleTables();
+	const auto zero = _mm_setzero_si128();
+	const auto one = _mm_set1_epi16(1);
+	const auto broadcastLast = _mm_set1_epi16(0x0f0e);
+
+	auto prev = _mm_set1_epi16(static_cast<short>(prevIndex));
+	auto i = size_t(0);
+	for (; i < numGroups && pDataEnd - pData >= 16; ++i)
+	{
+		const auto control = pControls[i];
+		const auto shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables.Shuffles16[control]));
+		auto v = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pData)), shuffle);
+		pData += tables.DataSizes16[control];
+
+		v = _mm_xor_si128(_mm_srli_epi16(v, 1), _mm_sub_epi16(zero, _mm_and_si128(v, one)));
+		v = _mm_add_epi16(v, _mm_slli_si128(v, 2));
+		v = _mm_add_epi16(v, _mm_slli_si128(v, 4));
+		v = _mm_add_epi16(v, _mm_slli_si128(v, 8));
+		v = _mm_add_epi16(v, prev);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&pIndices[8 * i]), v);
+		prev = _mm_shuffle_epi8(v, broadcastLast);
+	}
+
+	prevIndex = static_cast<uint16_t>(_mm_extract_epi16(prev, 0));
+
+	return i;
+}
+
+static size_t DecodeGroups32SSSE3(const uint8_t* pControls, const uint8_t*& pData, const uint8_t* pDataEnd,
+	size_t numGroups, uint32_t* pIndices, uint32_t& prevIndex)
+{
+	const auto& tables = GetShuffleTables();
+	const auto zero = _mm_setzero_si128();
+	const auto one = _mm_set1_epi32(1);
+
+	auto prev = _mm_set1_epi32(static_cast<int>(prevIndex));
+	auto i = size_t(0);
+	for (; i < numGroups && pDataEnd - pData >= 16; ++i)
+	{
+		const auto control = pControls[i];
+		const auto shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables.Shuffles32[control]));
+		auto v = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pData)), shuffle);
+		pData += tables.DataSizes32[control];
+
+		v = _mm_xor_si128(_mm_srli_epi32(v, 1), _mm_sub_epi32(zero, _mm_and_si128(v, one)));
+		v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+		v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+		v = _mm_add_epi32(v, prev);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&pIndices[4 * i]), v);
+		prev = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3));
+	}
+
+	prevIndex = static_cast<uint32_t>(_mm_cvtsi128_si32(prev));
+
+	return i;
+}
+#endif
+
+bool IndexCodec::IsSSSE3Supported()
+{
+#if XUSG_SSSE3_KERNELS
+	static const auto isSSSE3Supported = CheckSSSE3();
+
+	return isSSSE3Supported;
+#else
+	return false;
+#endif
+}
+
+size_t IndexCodec::GetMaxEncodedSize(size_t numIndices, uint32_t indexSize)
+{
+	const auto groupSize = indexSize == sizeof(uint16_t) ? GROUP_SIZE16 : GROUP_SIZE32;
+
+	return XUSG_DIV_UP(numIndices, groupSize) + indexSize * numIndices;
+}
+
+size_t IndexCodec::Encode(const void* pIndices, size_t numIndices, uint32_t indexSize,
+	uint8_t* pDst, size_t dstCapacity)
+{
+	XUSG_C_RETURN(indexSize != sizeof(uint16_t) && indexSize != sizeof(uint32_t), 0);
+	XUSG_C_RETURN(!pDst || (numIndices > 0 && !pIndices), 0);
+
+	// The control bytes lead, so that the decoder finds the data of each group without parsing
+	const auto groupSize = indexSize == sizeof(uint16_t) ? GROUP_SIZE16 : GROUP_SIZE32;
+	const auto numControls = XUSG_DIV_UP(numIndices, groupSize);
+	XUSG_C_RETURN(dstCapacity < numControls, 0);
+	memset(pDst, 0, numControls);
+
+	const auto pDstEnd = pDst + dstCapacity;
+	auto pData = pDst + numControls;
+	if (indexSize == sizeof(uint16_t))
+	{
+		const auto pSrc = static_cast<const uint16_t*>(pIndices);
+		uint16_t prevIndex = 0;
+		for (auto i = size_t(0); i < numIndices; ++i)
+		{
+			const auto code = EncodeZigzag(static_cast<uint16_t>(pSrc[i] - prevIndex));
+			const auto numBytes = code > 0xff ? 2u : 1u;
+			XUSG_C_RETURN(static_cast<size_t>(pDstEnd - pData) < numBytes, 0);
+			pDst[i / GROUP_SIZE16] |= static_cast<uint8_t>((numBytes - 1) << (i % GROUP_SIZE16));
+			for (auto j = 0u; j < numBytes; ++j) *pData++ = static_cast<uint8_t>(code >> (8 * j));
+			prevIndex = pSrc[i];
+		}
+	}
+	else
+	{
+		const auto pSrc = static_cast<const uint32_t*>(pIndices);
+		uint32_t prevIndex = 0;
+		for (auto i = size_t(0); i < numIndices; ++i)
+		{
+			const auto code = EncodeZigzag(pSrc[i] - prevIndex);
+			const auto numBytes = code > 0xffffff ? 4u : (code > 0xffff ? 3u : (code > 0xff ? 2u : 1u));
+			XUSG_C_RETURN(static_cast<size_t>(pDstEnd - pData) < numBytes, 0);
+			pDst[i / GROUP_SIZE32] |= static_cast<uint8_t>((numBytes - 1) << (2 * (i % GROUP_SIZE32)));
+			for (auto j = 0u; j < numBytes; ++j) *pData++ = static_cast<uint8_t>(code >> (8 * j));
+			prevIndex = pSrc[i];
+		}
+	}
+
+	return static_cast<size_t>(pData - pDst);
+}
+
+bool IndexCodec::Decode(const uint8_t* pSrc, size_t srcSize, size_t numIndices,
+	uint32_t indexSize, void* pIndices)
+{
+	XUSG_C_RETURN(numIndices > 0 && (!pSrc || !pIndices), false);
+
+	switch (indexSize)
+	{
+	case sizeof(uint16_t):
+		return decode16(pSrc, srcSize, numIndices, static_cast<uint16_t*>(pIndices));
+	case sizeof(uint32_t):
+		return decode32(pSrc, srcSize, numIndices, static_cast<uint32_t*>(pIndices));
+	default:
+		return false;
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// The full groups are decoded with SIMD where possible; the groups near the end of the data,
+// and the last partial group, are decoded value by value with bounds checks.
+//--------------------------------------------------------------------------------------
+bool IndexCodec::decode16(const uint8_t* pSrc, size_t srcSize, size_t numIndices, uint16_t* pIndices)
+{
+	const auto numControls = XUSG_DIV_UP(numIndices, GROUP_SIZE16);
+	XUSG_C_RETURN(srcSize < numControls, false);
+
+	const auto pSrcEnd = pSrc + srcSize;
+	auto pData = pSrc + numControls;
+	uint16_t prevIndex = 0;
+	auto i = size_t(0);
+#if XUSG_SSSE3_KERNELS
+	if (IsSSSE3Supported())
+		i = GROUP_SIZE16 * DecodeGroups16SSSE3(pSrc, pData, pSrcEnd, numIndices / GROUP_SIZE16, pIndices, prevIndex);
+#endif
+
+	for (; i < numIndices; ++i)
+	{
+		const auto numBytes = 1u + ((pSrc[i / GROUP_SIZE16] >> (i % GROUP_SIZE16)) & 1);
+		XUSG_C_RETURN(static_cast<size_t>(pSrcEnd - pData) < numBytes, false);
+
+		uint32_t code = pData[0];
+		if (numBytes > 1) code |= pData[1] << 8;
+		pData += numBytes;
+
+		prevIndex = static_cast<uint16_t>(prevIndex + DecodeZigzag(code));
+		pIndices[i] = prevIndex;
+	}
+
+	return pData == pSrcEnd;
+}
+
+bool IndexCodec::decode32(const uint8_t* pSrc, size_t srcSize, size_t numIndices, uint32_t* pIndices)
+{
+	const auto numControls = XUSG_DIV_UP(numIndices, GROUP_SIZE32);
+	XUSG_C_RETURN(srcSize < numControls, false);
+
+	const auto pSrcEnd = pSrc + srcSize;
+	auto pData = pSrc + numControls;
+	uint32_t prevIndex = 0;
+	auto i = size_t(0);
+#if XUSG_SSSE3_KERNELS
+	if (IsSSSE3Supported())
+		i = GROUP_SIZE32 * DecodeGroups32SSSE3(pSrc, pData, pSrcEnd, numIndices / GROUP_SIZE32, pIndices, prevIndex);
+#endif
+
+	for (; i < numIndices; ++i)
+	{
+		const auto numBytes = 1u + ((pSrc[i / GROUP_SIZE32] >> (2 * (i % GROUP_SIZE32))) & 3);
+		XUSG_C_RETURN(static_cast<size_t>(pSrcEnd - pData) < numBytes, false);
+
+		uint32_t code = 0;
+		for (auto j = 0u; j < numBytes; ++j) code |= static_cast<uint32_t>(pData[j]) << (8 * j);
+		pData += numBytes;
+
+		prevIndex += DecodeZigzag(code);
+		pIndices[i] = prevIndex;
+	}
+
+	return pData == pSrcEnd;
+}
@@ -0,0 +1,40 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "Core/XUSG.h"
+
+namespace XUSG
+{
+	//--------------------------------------------------------------------------------------
+	// Index buffer coding. The indices are delta-coded with zigzag signs, and packed as group
+	// varints with the control bytes ahead of the data bytes: 16-bit indices take 1 or 2 bytes
+	// with a control bit each, in groups of 8, and 32-bit indices take 1 to 4 bytes with 2
+	// control bits each, in groups of 4. The groups are decoded with SSSE3 byte shuffles and
+	// SIMD prefix sums if the CPU supports it.
+	//--------------------------------------------------------------------------------------
+	class IndexCodec
+	{
+	public:
+		static bool IsSSSE3Supported();
+
+		// The index size is 2 or 4 bytes
+		static size_t GetMaxEncodedSize(size_t numIndices, uint32_t indexSize);
+
+		// Returns the encoded size, or 0 if dstCapacity is too small
+		static size_t Encode(const void* pIndices, size_t numIndices, uint32_t indexSize,
+			uint8_t* pDst, size_t dstCapacity);
+		// Fails unless the data decode to exactly numIndices indices
+		static bool Decode(const uint8_t* pSrc, size_t srcSize, size_t numIndices,
+			uint32_t indexSize, void* pIndices);
+
+	protected:
+		static const uint32_t GROUP_SIZE16 = 8;
+		static const uint32_t GROUP_SIZE32 = 4;
+
+		static bool decode16(const uint8_t* pSrc, size_t srcSize, size_t numIndices, uint16_t* pIndices);
+		static bool decode32(const uint8_t* pSrc, size_t srcSize, size_t numIndices, uint32_t* pIndices);
+	};
+}
@@ -0,0 +1,173 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "XUSGLZCodec.h"
+
+using namespace std;
+using namespace XUSG;
+
+static inline uint32_t Read32(const uint8_t* p)
+{
+	uint32_t value;
+	memcpy(&value, p, sizeof(uint32_t));
+
+	return value;
+}
+
+static inline uint32_t HashSequence(uint32_t sequence, uint32_t hashLog)
+{
+	return (sequence * 2654435761u) >> (32 - hashLog);
+}
+
+size_t LZCodec::GetMaxCompressedSize(size_t srcSize)
+{
+	return srcSize + srcSize / 255 + 16;
+}
+
+size_t LZCodec::Compress(const uint8_t* pSrc, size_t srcSize, uint8_t* pDst, size_t dstCapacity)
+{
+	XUSG_C_RETURN(!pDst || (srcSize > 0 && !pSrc), 0);
+
+	// The sequence starts are the positions in the source
+	vector<uint32_t> hashTable(1 << HASH_LOG, 0);
+	const auto pDstEnd = pDst + dstCapacity;
+	auto pOut = pDst;
+	size_t anchor = 0;
+
+	// Emit the literals since the anchor, followed by a match unless it is the last sequence
+	const auto emitSequence = [&](size_t literalLength, size_t offset, size_t matchLength)
+	{
+		const auto worstSize = 1 + literalLength / 255 + 1 + literalLength + 2 + matchLength / 255 + 1;
+		XUSG_C_RETURN(static_cast<size_t>(pDstEnd - pOut) < worstSize, false);
+
+		auto& token = *pOut++;
+		token = static_cast<uint8_t>((min)(literalLength, static_cast<size_t>(RUN_MASK)) << 4);
+		if (literalLength >= RUN_MASK) pOut = writeLength(pOut, literalLength - RUN_MASK);
+		if (literalLength > 0) memcpy(pOut, &pSrc[anchor], literalLength);
+		pOut += literalLength;
+
+		if (matchLength > 0)
+		{
+			*pOut++ = static_cast<uint8_t>(offset);
+			*pOut++ = static_cast<uint8_t>(offset >> 8);
+
+			matchLength -= MIN_MATCH;
+			token |= static_cast<uint8_t>((min)(matchLength, static_cast<size_t>(RUN_MASK)));
+			if (matchLength >= RUN_MASK) pOut = writeLength(pOut, matchLength - RUN_MASK);
+		}
+
+		return true;
+	};
+
+	if (srcSize > MATCH_FIND_LIMIT)
+	{
+		const auto matchLimit = srcSize - LAST_LITERALS;
+		const auto matchFindLimit = srcSize - MATCH_FIND_LIMIT;
+		size_t pos = 0;
+		while (pos < matchFindLimit)
+		{
+			const auto sequence = Read32(&pSrc[pos]);
+			auto& candidate = hashTable[HashSequence(sequence, HASH_LOG)];
+			size_t ref = candidate;
+			candidate = static_cast<uint32_t>(pos);
+
+			if (ref >= pos || pos - ref > MAX_OFFSET || Read32(&pSrc[ref]) != sequence)
+			{
+				// Skip faster over the incompressible runs
+				pos += 1 + ((pos - anchor) >> 6);
+				continue;
+			}
+
+			// Extend the match backwards over the pending literals, and then forwards
+			while (pos > anchor && ref > 0 && pSrc[pos - 1] == pSrc[ref - 1])
+			{
+				--pos;
+				--ref;
+			}
+
+			auto matchLength = static_cast<size_t>(MIN_MATCH);
+			while (pos + matchLength < matchLimit && pSrc[ref + matchLength] == pSrc[pos + matchLength]) ++matchLength;
+
+			XUSG_N_RETURN(emitSequence(pos - anchor, pos - ref, matchLength), 0);
+			pos += matchLength;
+			anchor = pos;
+
+			// Index a position within the match for the next probes
+			if (pos < matchFindLimit) hashTable[HashSequence(Read32(&pSrc[pos - 2]), HASH_LOG)] = static_cast<uint32_t>(pos - 2);
+		}
+	}
+
+	XUSG_N_RETURN(emitSequence(srcSize - anchor, 0, 0), 0);
+
+	return static_cast<size_t>(pOut - pDst);
+}
+
+bool LZCodec::Decompress(const uint8_t* pSrc, size_t srcSize, uint8_t* pDst, size_t dstSize)
+{
+	XUSG_C_RETURN(!pSrc || (dstSize > 0 && !pDst), false);
+
+	const auto pSrcEnd = pSrc + srcSize;
+	const auto pDstEnd = pDst + dstSize;
+	auto pIn = pSrc;
+	auto pOut = pDst;
+
+	const auto readLength = [&](size_t& length)
+	{
+		uint8_t value;
+		do
+		{
+			XUSG_C_RETURN(pIn >= pSrcEnd, false);
+			value = *pIn++;
+			length += value;
+		} while (value == 255);
+
+		return true;
+	};
+
+	while (pIn < pSrcEnd)
+	{
+		const auto token = *pIn++;
+
+		// Literals; the short runs are copied in fixed 16-byte moves when far from the ends
+		size_t literalLength = token >> 4;
+		if (literalLength == RUN_MASK) XUSG_N_RETURN(readLength(literalLength), false);
+		XUSG_C_RETURN(literalLength > static_cast<size_t>(pSrcEnd - pIn) ||
+			literalLength > static_cast<size_t>(pDstEnd - pOut), false);
+		if (literalLength <= 16 && pSrcEnd - pIn >= 16 && pDstEnd - pOut >= 16) memcpy(pOut, pIn, 16);
+		else if (literalLength > 0) memcpy(pOut, pIn, literalLength);
+		pIn += literalLength;
+		pOut += literalLength;
+
+		// The last sequence has no match
+		if (pIn == pSrcEnd) break;
+
+		XUSG_C_RETURN(pSrcEnd - pIn < 2, false);
+		const auto offset = static_cast<size_t>(pIn[0] | (pIn[1] << 8));
+		pIn += 2;
+		XUSG_C_RETURN(offset == 0 || offset > static_cast<size_t>(pOut - pDst), false);
+
+		size_t matchLength = token & RUN_MASK;
+		if (matchLength == RUN_MASK) XUSG_N_RETURN(readLength(matchLength), false);
+		matchLength += MIN_MATCH;
+		XUSG_C_RETURN(matchLength > static_cast<size_t>(pDstEnd - pOut), false);
+
+		// Matches at least 8 bytes behind are copied in 8-byte moves, which repeat the
+		// overlapping ones correctly
+		const auto pMatch = pOut - offset;
+		if (offset >= 8 && static_cast<size_t>(pDstEnd - pOut) >= matchLength + 7)
+			for (size_t i = 0; i < matchLength; i += 8) memcpy(&pOut[i], &pMatch[i], 8);
+		else for (size_t i = 0; i < matchLength; ++i) pOut[i] = pMatch[i];
+		pOut += matchLength;
+	}
+
+	return pOut == pDstEnd;
+}
+
+uint8_t* LZCodec::writeLength(uint8_t* pDst, size_t length)
+{
+	for (; length >= 255; length -= 255) *pDst++ = 255;
+	*pDst++ = static_cast<uint8_t>(length);
+
+	return pDst;
+}
@@ -0,0 +1,38 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "Core/XUSG.h"
+
+namespace XUSG
+{
+	//--------------------------------------------------------------------------------------
+	// Byte-oriented LZ compression in the LZ4 block format, with a 64 KB window. The encoder
+	// is a greedy single-probe hash matcher, and the decoder is bounds-checked, so that the
+	// blocks of damaged archives fail instead of overrunning.
+	//--------------------------------------------------------------------------------------
+	class LZCodec
+	{
+	public:
+		static size_t GetMaxCompressedSize(size_t srcSize);
+
+		// Returns the compressed size, or 0 if dstCapacity is too small
+		static size_t Compress(const uint8_t* pSrc, size_t srcSize, uint8_t* pDst, size_t dstCapacity);
+		// Fails unless the block decodes to exactly dstSize bytes
+		static bool Decompress(const uint8_t* pSrc, size_t srcSize, uint8_t* pDst, size_t dstSize);
+
+	protected:
+		static const uint32_t MIN_MATCH = 4;
+		static const uint32_t MAX_OFFSET = 0xffff;
+		static const uint32_t HASH_LOG = 14;
+		static const uint32_t RUN_MASK = 0xf;
+
+		// The format keeps the last bytes as literals, and starts no match near the end
+		static const uint32_t LAST_LITERALS = 5;
+		static const uint32_t MATCH_FIND_LIMIT = 12;
+
+		static uint8_t* writeLength(uint8_t* pDst, size_t length);
+	};
+}
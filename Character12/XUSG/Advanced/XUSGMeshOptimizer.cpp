@@ -0,0 +1,273 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "Core/XUSG.h"
+#include "XUSGMeshOptimizer.h"
+
+using namespace std;
+using namespace DirectX;
+using namespace XUSG;
+
+//--------------------------------------------------------------------------------------
+// Cache statistics
+//--------------------------------------------------------------------------------------
+float MeshOptimizer::CacheStats::GetACMR() const
+{
+	return NumTriangles ? static_cast<float>(NumTransformedVertices) / NumTriangles : 0.0f;
+}
+
+float MeshOptimizer::CacheStats::GetATVR() const
+{
+	return NumVertices ? static_cast<float>(NumTransformedVertices) / NumVertices : 0.0f;
+}
+
+MeshOptimizer::CacheStats& MeshOptimizer::CacheStats::operator+=(const CacheStats& stats)
+{
+	NumTriangles += stats.NumTriangles;
+	NumVertices += stats.NumVertices;
+	NumTransformedVertices += stats.NumTransformedVertices;
+
+	return *this;
+}
+
+//--------------------------------------------------------------------------------------
+// Mesh optimizer
+//--------------------------------------------------------------------------------------
+template<typename T>
+MeshOptimizer::CacheStats MeshOptimizer::AnalyzeVertexCache(const T* indices, uint32_t indexCount,
+	uint32_t vertexCount, uint32_t cacheSize)
+{
+	CacheStats stats = {};
+	stats.NumTriangles = indexCount / 3;
+
+	// Simulate a FIFO cache with time stamps of insertion
+	vector<uint32_t> cacheTimes(vertexCount, 0);
+	auto timeStamp = cacheSize + 1;
+
+	for (auto i = 0u; i < stats.NumTriangles * 3; ++i)
+	{
+		const auto v = indices[i];
+		assert(v < vertexCount);
+
+		if (cacheTimes[v] == 0) ++stats.NumVertices;
+		if (timeStamp - cacheTimes[v] > cacheSize)
+		{
+			cacheTimes[v] = timeStamp++;
+			++stats.NumTransformedVertices;
+		}
+	}
+
+	return stats;
+}
+
+template<typename T>
+void MeshOptimizer::OptimizeVertexCache(T* indices, uint32_t indexCount, uint32_t vertexCount,
+	uint32_t cacheSize, vector<uint32_t>* pClusters)
+{
+	const auto numTriangles = indexCount / 3;
+	if (pClusters) pClusters->assign(1, 0);
+	if (numTriangles == 0) return;
+
+	// Build the vertex-triangle adjacency
+	vector<uint32_t> liveTriangles(vertexCount, 0);
+	for (auto i = 0u; i < numTriangles * 3; ++i) ++liveTriangles[indices[i]];
+
+	vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (auto v = 0u; v < vertexCount; ++v)
+		adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+
+	vector<uint32_t> adjacency(numTriangles * 3);
+	{
+		vector<uint32_t> cursors(adjacencyOffsets.cbegin(), adjacencyOffsets.cend() - 1);
+		for (auto i = 0u; i < numTriangles * 3; ++i)
+			adjacency[cursors[indices[i]]++] = i / 3;
+	}
+
+	vector<uint32_t> cacheTimes(vertexCount, 0);
+	vector<uint32_t> deadEnds;
+	vector<uint32_t> candidates;
+	vector<bool> isEmitted(numTriangles, false);
+	vector<T> output;
+	deadEnds.reserve(numTriangles * 3);
+	output.reserve(numTriangles * 3);
+
+	auto timeStamp = cacheSize + 1;
+	auto cursor = 0u;
+
+	// Pick a vertex with live triangles from the dead-end stack, or else in input order
+	const auto skipDeadEnd = [&]()
+	{
+		while (!deadEnds.empty())
+		{
+			const auto v = deadEnds.back();
+			deadEnds.pop_back();
+			if (liveTriangles[v] > 0) return v;
+		}
+
+		for (; cursor < vertexCount; ++cursor)
+			if (liveTriangles[cursor] > 0) return cursor;
+
+		return UINT32_MAX;
+	};
+
+	auto fanningVertex = skipDeadEnd();
+	while (fanningVertex != UINT32_MAX)
+	{
+		// Emit the one-ring of the fanning vertex
+		candidates.clear();
+		for (auto a = adjacencyOffsets[fanningVertex]; a < adjacencyOffsets[fanningVertex + 1]; ++a)
+		{
+			const auto t = adjacency[a];
+			if (isEmitted[t]) continue;
+
+			for (auto k = 0u; k < 3; ++k)
+			{
+				const auto v = indices[t * 3 + k];
+				output.emplace_back(v);
+				deadEnds.emplace_back(v);
+				candidates.emplace_back(v);
+				--liveTriangles[v];
+				if (timeStamp - cacheTimes[v] > cacheSize) cacheTimes[v] = timeStamp++;
+			}
+			isEmitted[t] = true;
+		}
+
+		// Select the candidate that will still be in the cache after its fan is emitted,
+		// preferring the oldest one
+		auto nextVertex = UINT32_MAX;
+		auto bestPriority = -1;
+		for (const auto& v : candidates)
+		{
+			if (liveTriangles[v] == 0) continue;
+
+			auto priority = 0;
+			if (timeStamp - cacheTimes[v] + 2 * liveTriangles[v] <= cacheSize)
+				priority = static_cast<int>(timeStamp - cacheTimes[v]);
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				nextVertex = v;
+			}
+		}
+
+		if (nextVertex == UINT32_MAX)
+		{
+			// The locality is broken here, which starts a new cluster
+			nextVertex = skipDeadEnd();
+			const auto clusterStart = static_cast<uint32_t>(output.size());
+			if (pClusters && nextVertex != UINT32_MAX && pClusters->back() != clusterStart)
+				pClusters->emplace_back(clusterStart);
+		}
+
+		fanningVertex = nextVertex;
+	}
+
+	assert(output.size() == numTriangles * 3);
+	memcpy(indices, output.data(), sizeof(T) * output.size());
+}
+
+template<typename T>
+void MeshOptimizer::OptimizeOverdraw(T* indices, uint32_t indexCount, const vector<uint32_t>& clusters,
+	const uint8_t* pPositions, uint32_t positionStride, uint32_t vertexCount)
+{
+	const auto numClusters = static_cast<uint32_t>(clusters.size());
+	if (numClusters <= 1 || !pPositions) return;
+
+	indexCount = indexCount / 3 * 3;
+	const auto loadPosition = [&](T v)
+	{
+		assert(v < vertexCount);
+		return XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(&pPositions[positionStride * v]));
+	};
+
+	// Mesh centroid
+	auto meshCentroid = XMVectorZero();
+	for (auto i = 0u; i < indexCount; ++i) meshCentroid += loadPosition(indices[i]);
+	meshCentroid /= static_cast<float>((max)(indexCount, 1u));
+
+	// Sort key of each cluster: how far its centroid is pushed out along its average normal
+	vector<pair<float, uint32_t>> sortKeys(numClusters);
+	for (auto c = 0u; c < numClusters; ++c)
+	{
+		const auto clusterStart = clusters[c];
+		const auto clusterEnd = c + 1 < numClusters ? clusters[c + 1] : indexCount;
+
+		auto centroid = XMVectorZero();
+		auto normal = XMVectorZero();
+		for (auto i = clusterStart; i < clusterEnd; i += 3)
+		{
+			const auto p0 = loadPosition(indices[i]);
+			const auto p1 = loadPosition(indices[i + 1]);
+			const auto p2 = loadPosition(indices[i + 2]);
+			centroid += p0 + p1 + p2;
+			normal += XMVector3Cross(p1 - p0, p2 - p0);	// Area weighted
+		}
+
+		centroid /= static_cast<float>((max)(clusterEnd - clusterStart, 1u));
+		normal = XMVector3Normalize(normal);
+		sortKeys[c] = make_pair(-XMVectorGetX(XMVector3Dot(centroid - meshCentroid, normal)), c);
+	}
+
+	stable_sort(sortKeys.begin(), sortKeys.end(),
+		[](const pair<float, uint32_t>& a, const pair<float, uint32_t>& b) { return a.first < b.first; });
+
+	// Rebuild the index list in cluster order
+	vector<T> output;
+	output.reserve(indexCount);
+	for (const auto& sortKey : sortKeys)
+	{
+		const auto c = sortKey.second;
+		const auto clusterEnd = c + 1 < numClusters ? clusters[c + 1] : indexCount;
+		output.insert(output.end(), indices + clusters[c], indices + clusterEnd);
+	}
+
+	memcpy(indices, output.data(), sizeof(T) * output.size());
+}
+
+template<typename T>
+bool MeshOptimizer::OptimizeVertexFetch(uint8_t* pVertices, uint32_t vertexStride, uint32_t vertexCount,
+	uint32_t numRanges, T* const* ppIndices, const uint32_t* indexCounts)
+{
+	// All the indices must address the vertex range
+	for (auto r = 0u; r < numRanges; ++r)
+		for (auto i = 0u; i < indexCounts[r]; ++i)
+			XUSG_C_RETURN(ppIndices[r][i] >= vertexCount, false);
+
+	// New vertex order by first use
+	vector<uint32_t> remap(vertexCount, UINT32_MAX);
+	auto numVertices = 0u;
+	for (auto r = 0u; r < numRanges; ++r)
+		for (auto i = 0u; i < indexCounts[r]; ++i)
+		{
+			auto& v = remap[ppIndices[r][i]];
+			if (v == UINT32_MAX) v = numVertices++;
+		}
+
+	for (auto& v : remap)
+		if (v == UINT32_MAX) v = numVertices++;
+
+	// Reorder the vertices
+	const vector<uint8_t> vertices(pVertices, pVertices + static_cast<size_t>(vertexStride) * vertexCount);
+	for (auto v = 0u; v < vertexCount; ++v)
+		memcpy(&pVertices[static_cast<size_t>(vertexStride) * remap[v]], &vertices[static_cast<size_t>(vertexStride) * v], vertexStride);
+
+	// Remap the indices
+	for (auto r = 0u; r < numRanges; ++r)
+		for (auto i = 0u; i < indexCounts[r]; ++i)
+			ppIndices[r][i] = static_cast<T>(remap[ppIndices[r][i]]);
+
+	return true;
+}
+
+//--------------------------------------------------------------------------------------
+// Explicit instantiations for 16 and 32-bit indices
+//--------------------------------------------------------------------------------------
+template MeshOptimizer::CacheStats MeshOptimizer::AnalyzeVertexCache(const uint16_t*, uint32_t, uint32_t, uint32_t);
+template MeshOptimizer::CacheStats MeshOptimizer::AnalyzeVertexCache(const uint32_t*, uint32_t, uint32_t, uint32_t);
+template void MeshOptimizer::OptimizeVertexCache(uint16_t*, uint32_t, uint32_t, uint32_t, vector<uint32_t>*);
+template void MeshOptimizer::OptimizeVertexCache(uint32_t*, uint32_t, uint32_t, uint32_t, vector<uint32_t>*);
+template void MeshOptimizer::OptimizeOverdraw(uint16_t*, uint32_t, const vector<uint32_t>&, const uint8_t*, uint32_t, uint32_t);
+template void MeshOptimizer::OptimizeOverdraw(uint32_t*, uint32_t, const vector<uint32_t>&, const uint8_t*, uint32_t, uint32_t);
+template bool MeshOptimizer::OptimizeVertexFetch(uint8_t*, uint32_t, uint32_t, uint32_t, uint16_t* const*, const uint32_t*);
+template bool MeshOptimizer::OptimizeVertexFetch(uint8_t*, uint32_t, uint32_t, uint32_t, uint32_t* const*, const uint32_t*);
@@ -0,0 +1,51 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+namespace XUSG
+{
+	//--------------------------------------------------------------------------------------
+	// Mesh optimizer for the post-transform vertex cache, overdraw and vertex fetch.
+	// Indices are triangle lists relative to the first vertex of the range.
+	//--------------------------------------------------------------------------------------
+	class MeshOptimizer
+	{
+	public:
+		static const uint32_t DEFAULT_CACHE_SIZE = 16;
+
+		struct CacheStats
+		{
+			uint32_t NumTriangles;
+			uint32_t NumVertices;			// Unique vertices referenced
+			uint32_t NumTransformedVertices;	// Cache misses of a FIFO cache
+
+			float GetACMR() const;	// Average cache miss ratio: transformed vertices per triangle
+			float GetATVR() const;	// Average transformed vertex ratio: transformed vertices per vertex
+
+			CacheStats& operator+=(const CacheStats& stats);
+		};
+
+		template<typename T>
+		static CacheStats AnalyzeVertexCache(const T* indices, uint32_t indexCount,
+			uint32_t vertexCount, uint32_t cacheSize = DEFAULT_CACHE_SIZE);
+
+		// Tipsify [Sander et al. 2007]; optionally outputs the first index of each cluster
+		template<typename T>
+		static void OptimizeVertexCache(T* indices, uint32_t indexCount, uint32_t vertexCount,
+			uint32_t cacheSize = DEFAULT_CACHE_SIZE, std::vector<uint32_t>* pClusters = nullptr);
+
+		// Sort the clusters from the vertex cache optimization so that outward facing,
+		// outer clusters are drawn first; positions are float3
+		template<typename T>
+		static void OptimizeOverdraw(T* indices, uint32_t indexCount, const std::vector<uint32_t>& clusters,
+			const uint8_t* pPositions, uint32_t positionStride, uint32_t vertexCount);
+
+		// Reorder the vertices by their first use in the index ranges, and remap the indices;
+		// unreferenced vertices are moved to the end
+		template<typename T>
+		static bool OptimizeVertexFetch(uint8_t* pVertices, uint32_t vertexStride, uint32_t vertexCount,
+			uint32_t numRanges, T* const* ppIndices, const uint32_t* indexCounts);
+	};
+}
@@ -0,0 +1,335 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "Core/XUSG.h"
+#include "XUSGMeshSimplifier.h"
+
+using namespace std;
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+using namespace XUSG;
+
+//--------------------------------------------------------------------------------------
+// Quadric helpers
+//--------------------------------------------------------------------------------------
+// Symmetric 4x4 matrix of the summed squared plane distances, with the summed area weights
+struct Quadric
+{
+	double A00, A01, A02, A11, A12, A22;
+	double B0, B1, B2;
+	double C;
+	double Weight;
+};
+
+static void AddPlane(Quadric& q, const double n[3], double d, double w)
+{
+	q.A00 += w * n[0] * n[0];
+	q.A01 += w * n[0] * n[1];
+	q.A02 += w * n[0] * n[2];
+	q.A11 += w * n[1] * n[1];
+	q.A12 += w * n[1] * n[2];
+	q.A22 += w * n[2] * n[2];
+	q.B0 += w * n[0] * d;
+	q.B1 += w * n[1] * d;
+	q.B2 += w * n[2] * d;
+	q.C += w * d * d;
+	q.Weight += w;
+}
+
+static void AddQuadric(Quadric& q, const Quadric& r)
+{
+	q.A00 += r.A00;
+	q.A01 += r.A01;
+	q.A02 += r.A02;
+	q.A11 += r.A11;
+	q.A12 += r.A12;
+	q.A22 += r.A22;
+	q.B0 += r.B0;
+	q.B1 += r.B1;
+	q.B2 += r.B2;
+	q.C += r.C;
+	q.Weight += r.Weight;
+}
+
+// Area-weighted mean of the squared distances to the planes
+static float EvaluateQuadric(const Quadric& q, const XMFLOAT3& p)
+{
+	const double x = p.x, y = p.y, z = p.z;
+	const auto r = q.A00 * x * x + q.A11 * y * y + q.A22 * z * z +
+		2.0 * (q.A01 * x * y + q.A02 * x * z + q.A12 * y * z) +
+		2.0 * (q.B0 * x + q.B1 * y + q.B2 * z) + q.C;
+
+	return q.Weight > 0.0 ? static_cast<float>(fabs(r) / q.Weight) : 0.0f;
+}
+
+static XMVECTOR GetTriangleNormal(const XMFLOAT3& p0, const XMFLOAT3& p1, const XMFLOAT3& p2)
+{
+	const auto v0 = XMLoadFloat3(&p0);
+
+	return XMVector3Cross(XMLoadFloat3(&p1) - v0, XMLoadFloat3(&p2) - v0);
+}
+
+//--------------------------------------------------------------------------------------
+// Mesh simplifier
+//--------------------------------------------------------------------------------------
+template<typename T>
+uint32_t MeshSimplifier::Simplify(T* indices, uint32_t indexCount, const VertexData& vertexData,
+	uint32_t targetIndexCount, float targetError, float* pError)
+{
+	enum VertexKind : uint8_t
+	{
+		VERTEX_FREE,
+		VERTEX_WEIGHT_BOUNDARY,	// Only slides along the boundary of its dominant bone
+		VERTEX_LOCKED			// Seams, borders and non-manifold vertices
+	};
+
+	struct Collapse
+	{
+		float Cost;
+		uint32_t From;
+		uint32_t To;
+	};
+
+	if (pError) *pError = 0.0f;
+	indexCount = indexCount / 3 * 3;
+	const auto numVertices = vertexData.NumVertices;
+	for (auto i = 0u; i < indexCount; ++i)
+		XUSG_C_RETURN(indices[i] >= numVertices, indexCount);
+
+	vector<XMFLOAT3> positions(numVertices);
+	vector<bool> isReferenced(numVertices, false);
+	for (auto v = 0u; v < numVertices; ++v)
+		memcpy(&positions[v], &vertexData.pVertices[vertexData.Stride * v + vertexData.PositionOffset], sizeof(XMFLOAT3));
+	for (auto i = 0u; i < indexCount; ++i) isReferenced[indices[i]] = true;
+
+	// Weld the vertices by position; the referenced vertices sharing a position form attribute seams
+	vector<VertexKind> kinds(numVertices, VERTEX_FREE);
+	vector<uint32_t> welded(numVertices);
+	{
+		vector<uint32_t> order(numVertices);
+		for (auto v = 0u; v < numVertices; ++v) order[v] = v;
+		sort(order.begin(), order.end(), [&positions](uint32_t a, uint32_t b)
+		{
+			return memcmp(&positions[a], &positions[b], sizeof(XMFLOAT3)) < 0;
+		});
+
+		for (auto i = 0u; i < numVertices;)
+		{
+			auto j = i;
+			auto numReferenced = 0u;
+			for (; j < numVertices && memcmp(&positions[order[i]], &positions[order[j]], sizeof(XMFLOAT3)) == 0; ++j)
+			{
+				welded[order[j]] = order[i];
+				if (isReferenced[order[j]]) ++numReferenced;
+			}
+
+			if (numReferenced > 1)
+				for (auto k = i; k < j; ++k) kinds[order[k]] = VERTEX_LOCKED;
+			i = j;
+		}
+	}
+
+	// Lock the vertices on open borders and non-manifold edges of the welded mesh
+	{
+		vector<uint64_t> edges;
+		edges.reserve(indexCount);
+		for (auto i = 0u; i < indexCount; i += 3)
+		{
+			for (auto k = 0u; k < 3; ++k)
+			{
+				const auto a = welded[indices[i + k]];
+				const auto b = welded[indices[i + (k + 1) % 3]];
+				if (a != b) edges.emplace_back((static_cast<uint64_t>((min)(a, b)) << 32) | (max)(a, b));
+			}
+		}
+		sort(edges.begin(), edges.end());
+
+		vector<bool> isWeldedLocked(numVertices, false);
+		for (size_t i = 0; i < edges.size();)
+		{
+			auto j = i;
+			while (j < edges.size() && edges[j] == edges[i]) ++j;
+			if (j - i != 2)
+			{
+				isWeldedLocked[static_cast<uint32_t>(edges[i] >> 32)] = true;
+				isWeldedLocked[static_cast<uint32_t>(edges[i])] = true;
+			}
+			i = j;
+		}
+
+		for (auto v = 0u; v < numVertices; ++v)
+			if (isWeldedLocked[welded[v]]) kinds[v] = VERTEX_LOCKED;
+	}
+
+	// The dominant bone of each vertex; triangles across dominant bones form skin-weight boundaries
+	vector<uint8_t> dominantBones(numVertices, 0);
+	if (vertexData.WeightsOffset != INVALID_OFFSET && vertexData.BonesOffset != INVALID_OFFSET)
+	{
+		for (auto v = 0u; v < numVertices; ++v)
+		{
+			const auto pVertex = &vertexData.pVertices[vertexData.Stride * v];
+			const auto pWeights = &pVertex[vertexData.WeightsOffset];
+			const auto pBones = &pVertex[vertexData.BonesOffset];
+			dominantBones[v] = pBones[max_element(pWeights, pWeights + 4) - pWeights];
+		}
+
+		for (auto i = 0u; i < indexCount; i += 3)
+		{
+			const auto i0 = indices[i], i1 = indices[i + 1], i2 = indices[i + 2];
+			if (dominantBones[i0] != dominantBones[i1] || dominantBones[i0] != dominantBones[i2])
+				for (const auto& v : { i0, i1, i2 })
+					if (kinds[v] == VERTEX_FREE) kinds[v] = VERTEX_WEIGHT_BOUNDARY;
+		}
+	}
+
+	// Plane quadrics weighted by the triangle areas
+	vector<Quadric> quadrics(numVertices, Quadric());
+	for (auto i = 0u; i < indexCount; i += 3)
+	{
+		const auto& p0 = positions[indices[i]];
+		const auto normal = GetTriangleNormal(p0, positions[indices[i + 1]], positions[indices[i + 2]]);
+		const double n[] = { XMVectorGetX(normal), XMVectorGetY(normal), XMVectorGetZ(normal) };
+		const auto length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (length <= 0.0) continue;
+
+		const double plane[] = { n[0] / length, n[1] / length, n[2] / length };
+		const auto d = -(plane[0] * p0.x + plane[1] * p0.y + plane[2] * p0.z);
+		for (auto k = 0u; k < 3; ++k) AddPlane(quadrics[indices[i + k]], plane, d, 0.5 * length);
+	}
+
+	const auto canCollapse = [&kinds, &dominantBones](uint32_t from, uint32_t to)
+	{
+		switch (kinds[from])
+		{
+		case VERTEX_FREE:
+			return true;
+		case VERTEX_WEIGHT_BOUNDARY:
+			return kinds[to] == VERTEX_WEIGHT_BOUNDARY && dominantBones[from] == dominantBones[to];
+		default:
+			return false;
+		}
+	};
+
+	const auto targetErrorSq = targetError * targetError;
+	auto maxErrorSq = 0.0f;
+	vector<uint32_t> adjacencyOffsets(numVertices + 1);
+	vector<uint32_t> adjacency;
+	vector<uint32_t> remap(numVertices);
+	vector<bool> isTouched(numVertices);
+	vector<Collapse> collapses;
+
+	while (indexCount > targetIndexCount)
+	{
+		// Build the vertex-triangle adjacency of the current triangles
+		fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+		for (auto i = 0u; i < indexCount; ++i) ++adjacencyOffsets[indices[i] + 1];
+		for (auto v = 0u; v < numVertices; ++v) adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+
+		adjacency.resize(indexCount);
+		{
+			vector<uint32_t> cursors(adjacencyOffsets.cbegin(), adjacencyOffsets.cend() - 1);
+			for (auto i = 0u; i < indexCount; ++i) adjacency[cursors[indices[i]]++] = i / 3;
+		}
+
+		// The cheapest collapse of each vertex along its edges
+		collapses.clear();
+		{
+			vector<Collapse> bestCollapses(numVertices, Collapse{ FLT_MAX, UINT32_MAX, UINT32_MAX });
+			for (auto i = 0u; i < indexCount; i += 3)
+			{
+				for (auto k = 0u; k < 6; ++k)
+				{
+					const auto from = indices[i + k % 3];
+					const auto to = indices[i + (k < 3 ? (k + 1) % 3 : (k + 2) % 3)];
+					if (!canCollapse(from, to)) continue;
+
+					const auto cost = EvaluateQuadric(quadrics[from], positions[to]);
+					if (cost < bestCollapses[from].Cost) bestCollapses[from] = Collapse{ cost, from, to };
+				}
+			}
+
+			for (const auto& collapse : bestCollapses)
+				if (collapse.From != UINT32_MAX && collapse.Cost <= targetErrorSq)
+					collapses.emplace_back(collapse);
+		}
+
+		sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.Cost < b.Cost; });
+
+		// Collapse the independent edges of the cheapest cost first
+		for (auto v = 0u; v < numVertices; ++v) remap[v] = v;
+		fill(isTouched.begin(), isTouched.end(), false);
+		const auto numTrianglesToRemove = (indexCount - targetIndexCount + 2) / 3;
+		auto numTrianglesRemoved = 0u;
+		auto numCollapses = 0u;
+
+		for (const auto& collapse : collapses)
+		{
+			if (numTrianglesRemoved >= numTrianglesToRemove) break;
+
+			const auto from = collapse.From;
+			const auto to = collapse.To;
+			if (isTouched[from] || isTouched[to]) continue;
+
+			// Reject the collapses flipping any remaining triangle
+			auto isFlipped = false;
+			auto numRemoved = 0u;
+			for (auto a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1] && !isFlipped; ++a)
+			{
+				const auto t = adjacency[a] * 3;
+				const T tri[] = { indices[t], indices[t + 1], indices[t + 2] };
+				if (tri[0] == to || tri[1] == to || tri[2] == to)
+				{
+					++numRemoved;
+					continue;
+				}
+
+				const auto n0 = GetTriangleNormal(positions[tri[0]], positions[tri[1]], positions[tri[2]]);
+				const auto n1 = GetTriangleNormal(positions[tri[0] == from ? to : tri[0]],
+					positions[tri[1] == from ? to : tri[1]], positions[tri[2] == from ? to : tri[2]]);
+				isFlipped = XMVectorGetX(XMVector3Dot(n0, n1)) <= 0.0f;
+			}
+			if (isFlipped) continue;
+
+			remap[from] = to;
+			AddQuadric(quadrics[to], quadrics[from]);
+			maxErrorSq = (max)(maxErrorSq, collapse.Cost);
+			numTrianglesRemoved += numRemoved;
+			++numCollapses;
+
+			// The neighborhood has changed, so it is frozen for the rest of this pass
+			for (auto a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1]; ++a)
+			{
+				const auto t = adjacency[a] * 3;
+				for (auto k = 0u; k < 3; ++k) isTouched[indices[t + k]] = true;
+			}
+		}
+
+		if (numCollapses == 0) break;
+
+		// Apply the collapses and remove the degenerated triangles
+		auto numIndices = 0u;
+		for (auto i = 0u; i < indexCount; i += 3)
+		{
+			const auto i0 = remap[indices[i]];
+			const auto i1 = remap[indices[i + 1]];
+			const auto i2 = remap[indices[i + 2]];
+			if (i0 == i1 || i1 == i2 || i2 == i0) continue;
+
+			indices[numIndices++] = static_cast<T>(i0);
+			indices[numIndices++] = static_cast<T>(i1);
+			indices[numIndices++] = static_cast<T>(i2);
+		}
+		indexCount = numIndices;
+	}
+
+	if (pError) *pError = sqrtf(maxErrorSq);
+
+	return indexCount;
+}
+
+//--------------------------------------------------------------------------------------
+// Explicit instantiations for 16 and 32-bit indices
+//--------------------------------------------------------------------------------------
+template uint32_t MeshSimplifier::Simplify(uint16_t*, uint32_t, const VertexData&, uint32_t, float, float*);
+template uint32_t MeshSimplifier::Simplify(uint32_t*, uint32_t, const VertexData&, uint32_t, float, float*);
@@ -0,0 +1,36 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+namespace XUSG
+{
+	//--------------------------------------------------------------------------------------
+	// Mesh simplifier with quadric error metrics [Garland and Heckbert 1997], using half-edge
+	// collapses only, so that the simplified indices keep sharing the vertex buffer.
+	// Attribute seams, open borders and skin-weight boundaries are preserved.
+	// Indices are triangle lists relative to the first vertex of the range.
+	//--------------------------------------------------------------------------------------
+	class MeshSimplifier
+	{
+	public:
+		static const uint32_t INVALID_OFFSET = UINT32_MAX;
+
+		struct VertexData
+		{
+			const uint8_t* pVertices;
+			uint32_t NumVertices;
+			uint32_t Stride;
+			uint32_t PositionOffset;	// float3
+			uint32_t WeightsOffset;		// UBYTE4N, or INVALID_OFFSET if the mesh is not skinned
+			uint32_t BonesOffset;		// UBYTE4, or INVALID_OFFSET if the mesh is not skinned
+		};
+
+		// Simplify the triangles in place toward the target index count, without exceeding the
+		// target error (a distance); returns the new index count and outputs the error reached
+		template<typename T>
+		static uint32_t Simplify(T* indices, uint32_t indexCount, const VertexData& vertexData,
+			uint32_t targetIndexCount, float targetError, float* pError = nullptr);
+	};
+}
@@ -0,0 +1,243 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "XUSGMeshletBuilder.h"
+
+using namespace std;
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+using namespace XUSG;
+
+template<typename T>
+bool MeshletBuilder::Build(SDKMesh::MeshletSet& meshletSet, const T* indices, uint32_t indexCount,
+	const VertexData& vertexData, uint32_t maxVertices, uint32_t maxPrimitives)
+{
+	// Local vertex indices are 8-bit
+	maxVertices = (min)((max)(maxVertices, 3u), 256u);
+	maxPrimitives = (max)(maxPrimitives, 1u);
+
+	const auto numTriangles = indexCount / 3;
+	const auto numVertices = vertexData.NumVertices;
+	for (auto i = 0u; i < numTriangles * 3; ++i)
+		XUSG_C_RETURN(indices[i] >= numVertices, false);
+
+	// Build the vertex-triangle adjacency
+	vector<uint32_t> adjacencyOffsets(numVertices + 1, 0);
+	for (auto i = 0u; i < numTriangles * 3; ++i) ++adjacencyOffsets[indices[i] + 1];
+	for (auto v = 0u; v < numVertices; ++v) adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+
+	vector<uint32_t> adjacency(numTriangles * 3);
+	{
+		vector<uint32_t> cursors(adjacencyOffsets.cbegin(), adjacencyOffsets.cend() - 1);
+		for (auto i = 0u; i < numTriangles * 3; ++i)
+			adjacency[cursors[indices[i]]++] = i / 3;
+	}
+
+	vector<bool> isEmitted(numTriangles, false);
+	vector<uint32_t> localIndices(numVertices, UINT32_MAX);
+	auto cursor = 0u;
+
+	SDKMesh::Meshlet meshlet = {};
+	meshlet.VertexOffset = static_cast<uint32_t>(meshletSet.VertexIndices.size());
+	meshlet.PrimitiveOffset = static_cast<uint32_t>(meshletSet.PrimitiveIndices.size() / 3);
+
+	const auto countNewVertices = [&](uint32_t t)
+	{
+		auto count = 0u;
+		for (auto k = 0u; k < 3; ++k)
+			if (localIndices[indices[t * 3 + k]] == UINT32_MAX) ++count;
+
+		return count;
+	};
+
+	const auto flush = [&]()
+	{
+		if (meshlet.PrimitiveCount == 0) return;
+
+		SDKMesh::MeshletBounds bounds;
+		computeBounds(bounds, meshletSet, meshlet, vertexData);
+		collectBones(meshletSet, meshlet, vertexData);
+		meshletSet.Meshlets.emplace_back(meshlet);
+		meshletSet.Bounds.emplace_back(bounds);
+
+		for (auto i = 0u; i < meshlet.VertexCount; ++i)
+			localIndices[meshletSet.VertexIndices[meshlet.VertexOffset + i]] = UINT32_MAX;
+
+		meshlet = {};
+		meshlet.VertexOffset = static_cast<uint32_t>(meshletSet.VertexIndices.size());
+		meshlet.PrimitiveOffset = static_cast<uint32_t>(meshletSet.PrimitiveIndices.size() / 3);
+	};
+
+	for (auto n = 0u; n < numTriangles; ++n)
+	{
+		// Prefer the adjacent triangle adding the fewest vertices to the meshlet
+		auto bestTriangle = UINT32_MAX;
+		auto bestNewVertices = 4u;
+		for (auto i = 0u; i < meshlet.VertexCount && bestNewVertices > 0; ++i)
+		{
+			const auto v = meshletSet.VertexIndices[meshlet.VertexOffset + i];
+			for (auto a = adjacencyOffsets[v]; a < adjacencyOffsets[v + 1]; ++a)
+			{
+				const auto t = adjacency[a];
+				if (isEmitted[t]) continue;
+
+				const auto newVertices = countNewVertices(t);
+				if (newVertices < bestNewVertices || (newVertices == bestNewVertices && t < bestTriangle))
+				{
+					bestNewVertices = newVertices;
+					bestTriangle = t;
+				}
+			}
+		}
+
+		// Otherwise continue with the next triangle in order
+		if (bestTriangle == UINT32_MAX)
+		{
+			while (isEmitted[cursor]) ++cursor;
+			bestTriangle = cursor;
+			bestNewVertices = countNewVertices(bestTriangle);
+		}
+
+		if (meshlet.VertexCount + bestNewVertices > maxVertices || meshlet.PrimitiveCount >= maxPrimitives)
+		{
+			flush();
+			bestNewVertices = countNewVertices(bestTriangle);
+		}
+
+		for (auto k = 0u; k < 3; ++k)
+		{
+			const auto v = indices[bestTriangle * 3 + k];
+			auto& localIndex = localIndices[v];
+			if (localIndex == UINT32_MAX)
+			{
+				localIndex = meshlet.VertexCount++;
+				meshletSet.VertexIndices.emplace_back(v);
+			}
+			meshletSet.PrimitiveIndices.emplace_back(static_cast<uint8_t>(localIndex));
+		}
+
+		++meshlet.PrimitiveCount;
+		isEmitted[bestTriangle] = true;
+	}
+
+	flush();
+
+	return true;
+}
+
+void MeshletBuilder::computeBounds(SDKMesh::MeshletBounds& bounds, const SDKMesh::MeshletSet& meshletSet,
+	const SDKMesh::Meshlet& meshlet, const VertexData& vertexData)
+{
+	const auto loadPosition = [&](uint32_t localIndex)
+	{
+		const auto v = meshletSet.VertexIndices[meshlet.VertexOffset + localIndex];
+
+		return XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(&vertexData.pVertices[vertexData.Stride * v + vertexData.PositionOffset]));
+	};
+
+	// Bounding sphere around the center of the bounding box
+	auto lower = XMVectorReplicate(FLT_MAX);
+	auto upper = XMVectorReplicate(-FLT_MAX);
+	for (auto i = 0u; i < meshlet.VertexCount; ++i)
+	{
+		const auto pos = loadPosition(i);
+		lower = XMVectorMin(lower, pos);
+		upper = XMVectorMax(upper, pos);
+	}
+
+	const auto center = (lower + upper) * 0.5f;
+	auto radiusSq = 0.0f;
+	for (auto i = 0u; i < meshlet.VertexCount; ++i)
+		radiusSq = (max)(radiusSq, XMVectorGetX(XMVector3LengthSq(loadPosition(i) - center)));
+
+	XMStoreFloat3(&bounds.Center, center);
+	bounds.Radius = sqrtf(radiusSq);
+
+	// Normal cone from the triangle normals
+	const auto pPrimitives = &meshletSet.PrimitiveIndices[meshlet.PrimitiveOffset * 3];
+	vector<XMFLOAT3> normals;
+	normals.reserve(meshlet.PrimitiveCount);
+	auto axis = XMVectorZero();
+	for (auto i = 0u; i < meshlet.PrimitiveCount; ++i)
+	{
+		const auto p0 = loadPosition(pPrimitives[i * 3]);
+		const auto p1 = loadPosition(pPrimitives[i * 3 + 1]);
+		const auto p2 = loadPosition(pPrimitives[i * 3 + 2]);
+		const auto normal = XMVector3Cross(p1 - p0, p2 - p0);
+		if (XMVectorGetX(XMVector3LengthSq(normal)) <= FLT_MIN) continue;	// Degenerated
+
+		normals.emplace_back();
+		XMStoreFloat3(&normals.back(), XMVector3Normalize(normal));
+		axis += XMLoadFloat3(&normals.back());
+	}
+
+	// Never culled by default
+	bounds.ConeApex = bounds.Center;
+	bounds.ConeAxis = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	bounds.ConeCutoff = 1.0f;
+	if (normals.empty() || XMVectorGetX(XMVector3LengthSq(axis)) <= FLT_MIN) return;
+
+	axis = XMVector3Normalize(axis);
+	XMStoreFloat3(&bounds.ConeAxis, axis);
+
+	auto minDot = 1.0f;
+	for (const auto& normal : normals)
+		minDot = (min)(minDot, XMVectorGetX(XMVector3Dot(XMLoadFloat3(&normal), axis)));
+
+	// The cone spans more than a hemisphere
+	if (minDot <= 0.1f) return;
+
+	// Move the apex back along the axis, so that every triangle plane is in front of it
+	auto maxT = 0.0f;
+	auto n = 0u;
+	for (auto i = 0u; i < meshlet.PrimitiveCount; ++i)
+	{
+		const auto p0 = loadPosition(pPrimitives[i * 3]);
+		const auto p1 = loadPosition(pPrimitives[i * 3 + 1]);
+		const auto p2 = loadPosition(pPrimitives[i * 3 + 2]);
+		if (XMVectorGetX(XMVector3LengthSq(XMVector3Cross(p1 - p0, p2 - p0))) <= FLT_MIN) continue;
+
+		const auto normal = XMLoadFloat3(&normals[n++]);
+		const auto t = XMVectorGetX(XMVector3Dot(center - p0, normal)) / XMVectorGetX(XMVector3Dot(axis, normal));
+		maxT = (max)(maxT, t);
+	}
+
+	XMStoreFloat3(&bounds.ConeApex, center - axis * maxT);
+	bounds.ConeCutoff = sqrtf(1.0f - minDot * minDot);
+}
+
+void MeshletBuilder::collectBones(SDKMesh::MeshletSet& meshletSet, SDKMesh::Meshlet& meshlet,
+	const VertexData& vertexData)
+{
+	meshlet.BoneOffset = static_cast<uint32_t>(meshletSet.Bones.size());
+	meshlet.BoneCount = 0;
+	if (vertexData.WeightsOffset == INVALID_OFFSET || vertexData.BonesOffset == INVALID_OFFSET) return;
+
+	bool isInfluenced[256] = {};
+	for (auto i = 0u; i < meshlet.VertexCount; ++i)
+	{
+		const auto pVertex = &vertexData.pVertices[vertexData.Stride * meshletSet.VertexIndices[meshlet.VertexOffset + i]];
+		const auto& weights = reinterpret_cast<const XMUBYTEN4&>(pVertex[vertexData.WeightsOffset]);
+		const auto& bones = reinterpret_cast<const XMUBYTE4&>(pVertex[vertexData.BonesOffset]);
+		if (weights.x) isInfluenced[bones.x] = true;
+		if (weights.y) isInfluenced[bones.y] = true;
+		if (weights.z) isInfluenced[bones.z] = true;
+		if (weights.w) isInfluenced[bones.w] = true;
+	}
+
+	for (auto i = 0u; i < 256; ++i)
+	{
+		if (isInfluenced[i])
+		{
+			meshletSet.Bones.emplace_back(static_cast<uint8_t>(i));
+			++meshlet.BoneCount;
+		}
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Explicit instantiations for 16 and 32-bit indices
+//--------------------------------------------------------------------------------------
+template bool MeshletBuilder::Build(SDKMesh::MeshletSet&, const uint16_t*, uint32_t, const VertexData&, uint32_t, uint32_t);
+template bool MeshletBuilder::Build(SDKMesh::MeshletSet&, const uint32_t*, uint32_t, const VertexData&, uint32_t, uint32_t);
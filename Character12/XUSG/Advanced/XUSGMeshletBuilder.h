@@ -0,0 +1,45 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "XUSGAdvanced.h"
+
+namespace XUSG
+{
+	//--------------------------------------------------------------------------------------
+	// Meshlet builder, splitting triangle lists into clusters of bounded vertex and
+	// primitive counts, with bounding spheres, normal cones and bone influences.
+	// Indices are triangle lists relative to the first vertex of the range.
+	//--------------------------------------------------------------------------------------
+	class MeshletBuilder
+	{
+	public:
+		static const uint32_t DEFAULT_MAX_VERTICES		= 64;
+		static const uint32_t DEFAULT_MAX_PRIMITIVES	= 124;
+		static const uint32_t INVALID_OFFSET			= UINT32_MAX;
+
+		struct VertexData
+		{
+			const uint8_t* pVertices;
+			uint32_t NumVertices;
+			uint32_t Stride;
+			uint32_t PositionOffset;	// float3
+			uint32_t WeightsOffset;		// UBYTE4N, or INVALID_OFFSET if the mesh is not skinned
+			uint32_t BonesOffset;		// UBYTE4, or INVALID_OFFSET if the mesh is not skinned
+		};
+
+		// Append the meshlets of the triangles to the set; returns false if an index is out of range
+		template<typename T>
+		static bool Build(SDKMesh::MeshletSet& meshletSet, const T* indices, uint32_t indexCount,
+			const VertexData& vertexData, uint32_t maxVertices = DEFAULT_MAX_VERTICES,
+			uint32_t maxPrimitives = DEFAULT_MAX_PRIMITIVES);
+
+	protected:
+		static void computeBounds(SDKMesh::MeshletBounds& bounds, const SDKMesh::MeshletSet& meshletSet,
+			const SDKMesh::Meshlet& meshlet, const VertexData& vertexData);
+		static void collectBones(SDKMesh::MeshletSet& meshletSet, SDKMesh::Meshlet& meshlet,
+			const VertexData& vertexData);
+	};
+}
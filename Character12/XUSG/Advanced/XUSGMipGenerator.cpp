@@ -0,0 +1,325 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "XUSGMipGenerator.h"
+#include "XUSGThreadPool.h"
+
+using namespace std;
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+using namespace XUSG;
+
+// Kaiser-windowed sinc over two lobes on each side, in units of destination texels
+static const float KAISER_RADIUS = 2.0f;
+static const float KAISER_ALPHA = 4.0f;
+
+static float BesselI0(float x)
+{
+	// Power series of the zeroth order modified Bessel function of the first kind
+	auto sum = 1.0f;
+	auto term = 1.0f;
+	const auto q = x * x * 0.25f;
+	for (auto k = 1u; k < 32 && term > sum * 1e-7f; ++k)
+	{
+		term *= q / static_cast<float>(k * k);
+		sum += term;
+	}
+
+	return sum;
+}
+
+static float EvaluateKaiser(float t)
+{
+	const auto x = t / KAISER_RADIUS;
+	if (fabsf(x) >= 1.0f) return 0.0f;
+
+	const auto window = BesselI0(KAISER_ALPHA * sqrtf(1.0f - x * x)) / BesselI0(KAISER_ALPHA);
+	const auto sinc = fabsf(t) < 1e-5f ? 1.0f : sinf(XM_PI * t) / (XM_PI * t);
+
+	return sinc * window;
+}
+
+static bool IsSRGB(Format format)
+{
+	switch (format)
+	{
+	case Format::R8G8B8A8_UNORM_SRGB:
+	case Format::B8G8R8A8_UNORM_SRGB:
+	case Format::B8G8R8X8_UNORM_SRGB:
+		return true;
+	default:
+		return false;
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Mip generator implementations
+//--------------------------------------------------------------------------------------
+bool MipGenerator::IsSupported(Format format)
+{
+	switch (format)
+	{
+	case Format::R8G8B8A8_TYPELESS:
+	case Format::R8G8B8A8_UNORM:
+	case Format::R8G8B8A8_UNORM_SRGB:
+	case Format::B8G8R8A8_TYPELESS:
+	case Format::B8G8R8A8_UNORM:
+	case Format::B8G8R8A8_UNORM_SRGB:
+	case Format::B8G8R8X8_TYPELESS:
+	case Format::B8G8R8X8_UNORM:
+	case Format::B8G8R8X8_UNORM_SRGB:
+	case Format::R10G10B10A2_UNORM:
+	case Format::R16G16B16A16_FLOAT:
+	case Format::R16G16B16A16_UNORM:
+	case Format::R32G32B32A32_FLOAT:
+	case Format::R8G8_UNORM:
+	case Format::R16G16_FLOAT:
+	case Format::R16G16_UNORM:
+	case Format::R32G32_FLOAT:
+	case Format::R8_UNORM:
+	case Format::A8_UNORM:
+	case Format::R16_FLOAT:
+	case Format::R16_UNORM:
+	case Format::R32_FLOAT:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool MipGenerator::Generate(Format format, DDS::MipFilter filter, uint32_t width,
+	uint32_t height, uint32_t mipCount, uint8_t* pData)
+{
+	XUSG_C_RETURN(!IsSupported(format) || !pData || width == 0 || height == 0, false);
+
+	// Filter in linear space
+	const auto isSRGB = IsSRGB(format);
+	const auto pixelSize = static_cast<uint32_t>(DDS::Loader::BitsPerPixel(format) / 8);
+	vector<XMVECTOR> texels(width * height);
+	auto& threadPool = ThreadPool::GetDefault();
+	threadPool.ParallelFor(height, [&](uint32_t y)
+	{
+		const auto pRow = &texels[width * y];
+		loadRow(format, &pData[pixelSize * width * y], width, pRow);
+		if (isSRGB) for (auto x = 0u; x < width; ++x) pRow[x] = XMColorSRGBToRGB(pRow[x]);
+	});
+
+	Kernel kernelX, kernelY;
+	vector<XMVECTOR> rows, mipTexels;
+	auto pDst = pData + pixelSize * width * height;
+	for (auto i = 1u; i < mipCount; ++i)
+	{
+		const auto srcWidth = (max)(width >> (i - 1), 1u);
+		const auto srcHeight = (max)(height >> (i - 1), 1u);
+		const auto w = (max)(width >> i, 1u);
+		const auto h = (max)(height >> i, 1u);
+		buildKernel(filter, srcWidth, w, kernelX);
+		buildKernel(filter, srcHeight, h, kernelY);
+
+		// Horizontal pass over the source rows
+		rows.resize(w * srcHeight);
+		threadPool.ParallelFor(srcHeight, [&](uint32_t y)
+		{
+			const auto pSrcRow = &texels[srcWidth * y];
+			for (auto x = 0u; x < w; ++x)
+			{
+				auto sum = XMVectorZero();
+				for (auto t = kernelX.FirstTaps[x]; t < kernelX.FirstTaps[x + 1]; ++t)
+					sum = XMVectorMultiplyAdd(pSrcRow[kernelX.Taps[t].Index], XMVectorReplicate(kernelX.Taps[t].Weight), sum);
+				rows[w * y + x] = sum;
+			}
+		});
+
+		// Vertical pass, and then store the mip
+		mipTexels.resize(w * h);
+		threadPool.ParallelFor(h, [&](uint32_t y)
+		{
+			const auto pRow = &mipTexels[w * y];
+			for (auto x = 0u; x < w; ++x)
+			{
+				auto sum = XMVectorZero();
+				for (auto t = kernelY.FirstTaps[y]; t < kernelY.FirstTaps[y + 1]; ++t)
+					sum = XMVectorMultiplyAdd(rows[w * kernelY.Taps[t].Index + x], XMVectorReplicate(kernelY.Taps[t].Weight), sum);
+				pRow[x] = sum;
+			}
+
+			vector<XMVECTOR> encoded(pRow, pRow + w);
+			if (isSRGB) for (auto& texel : encoded) texel = XMColorRGBToSRGB(XMVectorSaturate(texel));
+			storeRow(format, encoded.data(), w, &pDst[pixelSize * w * y]);
+		});
+
+		texels.swap(mipTexels);
+		pDst += pixelSize * w * h;
+	}
+
+	return true;
+}
+
+void MipGenerator::buildKernel(DDS::MipFilter filter, uint32_t srcSize, uint32_t dstSize, Kernel& kernel)
+{
+	kernel.FirstTaps.resize(dstSize + 1);
+	kernel.Taps.clear();
+
+	// The texel centers are at half-integers; the edges are clamped
+	const auto scale = static_cast<float>(srcSize) / dstSize;
+	const auto radius = srcSize == dstSize ? 0.0f : (filter == DDS::MIP_FILTER_KAISER ? KAISER_RADIUS : 0.5f) * scale;
+	for (auto x = 0u; x < dstSize; ++x)
+	{
+		kernel.FirstTaps[x] = static_cast<uint32_t>(kernel.Taps.size());
+
+		const auto center = (x + 0.5f) * scale;
+		const auto first = static_cast<int32_t>(floorf(center - radius));
+		const auto last = static_cast<int32_t>(ceilf(center + radius));
+		auto sum = 0.0f;
+		for (auto i = first; i < (max)(last, first + 1); ++i)
+		{
+			float weight;
+			if (radius <= 0.0f) weight = 1.0f;
+			else if (filter == DDS::MIP_FILTER_KAISER) weight = EvaluateKaiser((i + 0.5f - center) / scale);
+			else weight = (min)(i + 1.0f, center + radius) - (max)(static_cast<float>(i), center - radius);
+			if (weight == 0.0f) continue;
+
+			const auto index = static_cast<uint32_t>((min)((max)(i, 0), static_cast<int32_t>(srcSize) - 1));
+			kernel.Taps.push_back({ index, weight });
+			sum += weight;
+		}
+
+		for (auto t = kernel.FirstTaps[x]; t < kernel.Taps.size(); ++t)
+			kernel.Taps[t].Weight /= sum;
+	}
+
+	kernel.FirstTaps[dstSize] = static_cast<uint32_t>(kernel.Taps.size());
+}
+
+void MipGenerator::loadRow(Format format, const uint8_t* pSrc, uint32_t width, XMVECTOR* pDst)
+{
+	switch (format)
+	{
+	case Format::R8G8B8A8_TYPELESS:
+	case Format::R8G8B8A8_UNORM:
+	case Format::R8G8B8A8_UNORM_SRGB:
+		for (auto i = 0u; i < width; ++i) pDst[i] = XMLoadUByteN4(&reinterpret_cast<const XMUBYTEN4*>(pSrc)[i]);
+		break;
+	case Format::B8G8R8A8_TYPELESS:
+	case Format::B8G8R8A8_UNORM:
+	case Format::B8G8R8A8_UNORM_SRGB:
+		for (auto i = 0u; i < width; ++i) pDst[i] = XMLoadColor(&reinterpret_cast<const XMCOLOR*>(pSrc)[i]);
+		break;
+	case Format::B8G8R8X8_TYPELESS:
+	case Format::B8G8R8X8_UNORM:
+	case Format::B8G8R8X8_UNORM_SRGB:
+		for (auto i = 0u; i < width; ++i)
+			pDst[i] = XMVectorSetW(XMLoadColor(&reinterpret_cast<const XMCOLOR*>(pSrc)[i]), 1.0f);
+		break;
+	case Format::R10G10B10A2_UNORM:
+		for (auto i = 0u; i < width; ++i) pDst[i] = XMLoadUDecN4(&reinterpret_cast<const XMUDECN4*>(pSrc)[i]);
+		break;
+	case Format::R16G16B16A16_FLOAT:
+		for (auto i = 0u; i < width; ++i) pDst[i] = XMLoadHalf4(&reinterpret_cast<const XMHALF4*>(pSrc)[i]);
+		break;
+	case Format::R16G16B16A16_UNORM:
+		for (auto i = 0u; i < width; ++i) pDst[i] = XMLoadUShortN4(&reinterpret_cast<const XMUSHORTN4*>(pSrc)[i]);
+		break;
+	case Format::R32G32B32A32_FLOAT:
+		for (auto i = 0u; i < width; ++i) pDst[i] = XMLoadFloat4(&reinterpret_cast<const XMFLOAT4*>(pSrc)[i]);
+		break;
+	case Format::R8G8_UNORM:
+		for (auto i = 0u; i < width; ++i) pDst[i] = XMLoadUByteN2(&reinterpret_cast<const XMUBYTEN2*>(pSrc)[i]);
+		break;
+	case Format::R16G16_FLOAT:
+		for (auto i = 0u; i < width; ++i) pDst[i] = XMLoadHalf2(&reinterpret_cast<const XMHALF2*>(pSrc)[i]);
+		break;
+	case Format::R16G16_UNORM:
+		for (auto i = 0u; i < width; ++i) pDst[i] = XMLoadUShortN2(&reinterpret_cast<const XMUSHORTN2*>(pSrc)[i]);
+		break;
+	case Format::R32G32_FLOAT:
+		for (auto i = 0u; i < width; ++i) pDst[i] = XMLoadFloat2(&reinterpret_cast<const XMFLOAT2*>(pSrc)[i]);
+		break;
+	case Format::R8_UNORM:
+		for (auto i = 0u; i < width; ++i) pDst[i] = XMVectorSetX(XMVectorZero(), pSrc[i] / 255.0f);
+		break;
+	case Format::A8_UNORM:
+		for (auto i = 0u; i < width; ++i) pDst[i] = XMVectorSetW(XMVectorZero(), pSrc[i] / 255.0f);
+		break;
+	case Format::R16_FLOAT:
+		for (auto i = 0u; i < width; ++i)
+			pDst[i] = XMVectorSetX(XMVectorZero(), XMConvertHalfToFloat(reinterpret_cast<const HALF*>(pSrc)[i]));
+		break;
+	case Format::R16_UNORM:
+		for (auto i = 0u; i < width; ++i)
+			pDst[i] = XMVectorSetX(XMVectorZero(), reinterpret_cast<const uint16_t*>(pSrc)[i] / 65535.0f);
+		break;
+	case Format::R32_FLOAT:
+		for (auto i = 0u; i < width; ++i) pDst[i] = XMVectorSetX(XMVectorZero(), reinterpret_cast<const float*>(pSrc)[i]);
+		break;
+	default:
+		assert(!"Unsupported format");
+	}
+}
+
+void MipGenerator::storeRow(Format format, const XMVECTOR* pSrc, uint32_t width, uint8_t* pDst)
+{
+	// The normalized stores saturate the filter overshoots
+	switch (format)
+	{
+	case Format::R8G8B8A8_TYPELESS:
+	case Format::R8G8B8A8_UNORM:
+	case Format::R8G8B8A8_UNORM_SRGB:
+		for (auto i = 0u; i < width; ++i) XMStoreUByteN4(&reinterpret_cast<XMUBYTEN4*>(pDst)[i], pSrc[i]);
+		break;
+	case Format::B8G8R8A8_TYPELESS:
+	case Format::B8G8R8A8_UNORM:
+	case Format::B8G8R8A8_UNORM_SRGB:
+	case Format::B8G8R8X8_TYPELESS:
+	case Format::B8G8R8X8_UNORM:
+	case Format::B8G8R8X8_UNORM_SRGB:
+		for (auto i = 0u; i < width; ++i) XMStoreColor(&reinterpret_cast<XMCOLOR*>(pDst)[i], pSrc[i]);
+		break;
+	case Format::R10G10B10A2_UNORM:
+		for (auto i = 0u; i < width; ++i) XMStoreUDecN4(&reinterpret_cast<XMUDECN4*>(pDst)[i], pSrc[i]);
+		break;
+	case Format::R16G16B16A16_FLOAT:
+		for (auto i = 0u; i < width; ++i) XMStoreHalf4(&reinterpret_cast<XMHALF4*>(pDst)[i], pSrc[i]);
+		break;
+	case Format::R16G16B16A16_UNORM:
+		for (auto i = 0u; i < width; ++i) XMStoreUShortN4(&reinterpret_cast<XMUSHORTN4*>(pDst)[i], pSrc[i]);
+		break;
+	case Format::R32G32B32A32_FLOAT:
+		for (auto i = 0u; i < width; ++i) XMStoreFloat4(&reinterpret_cast<XMFLOAT4*>(pDst)[i], pSrc[i]);
+		break;
+	case Format::R8G8_UNORM:
+		for (auto i = 0u; i < width; ++i) XMStoreUByteN2(&reinterpret_cast<XMUBYTEN2*>(pDst)[i], pSrc[i]);
+		break;
+	case Format::R16G16_FLOAT:
+		for (auto i = 0u; i < width; ++i) XMStoreHalf2(&reinterpret_cast<XMHALF2*>(pDst)[i], pSrc[i]);
+		break;
+	case Format::R16G16_UNORM:
+		for (auto i = 0u; i < width; ++i) XMStoreUShortN2(&reinterpret_cast<XMUSHORTN2*>(pDst)[i], pSrc[i]);
+		break;
+	case Format::R32G32_FLOAT:
+		for (auto i = 0u; i < width; ++i) XMStoreFloat2(&reinterpret_cast<XMFLOAT2*>(pDst)[i], pSrc[i]);
+		break;
+	case Format::R8_UNORM:
+		for (auto i = 0u; i < width; ++i)
+			pDst[i] = static_cast<uint8_t>(XMVectorGetX(XMVectorSaturate(pSrc[i])) * 255.0f + 0.5f);
+		break;
+	case Format::A8_UNORM:
+		for (auto i = 0u; i < width; ++i)
+			pDst[i] = static_cast<uint8_t>(XMVectorGetW(XMVectorSaturate(pSrc[i])) * 255.0f + 0.5f);
+		break;
+	case Format::R16_FLOAT:
+		for (auto i = 0u; i < width; ++i)
+			reinterpret_cast<HALF*>(pDst)[i] = XMConvertFloatToHalf(XMVectorGetX(pSrc[i]));
+		break;
+	case Format::R16_UNORM:
+		for (auto i = 0u; i < width; ++i)
+			reinterpret_cast<uint16_t*>(pDst)[i] = static_cast<uint16_t>(XMVectorGetX(XMVectorSaturate(pSrc[i])) * 65535.0f + 0.5f);
+		break;
+	case Format::R32_FLOAT:
+		for (auto i = 0u; i < width; ++i) reinterpret_cast<float*>(pDst)[i] = XMVectorGetX(pSrc[i]);
+		break;
+	default:
+		assert(!"Unsupported format");
+	}
+}
@@ -0,0 +1,44 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "XUSGAdvanced.h"
+
+namespace XUSG
+{
+	//--------------------------------------------------------------------------------------
+	// CPU mip chain generation of uncompressed formats. The texels are filtered as DirectXMath
+	// vectors in linear space, separably and by rows in parallel on the thread pool; each mip
+	// is filtered from the previous one without requantization.
+	//--------------------------------------------------------------------------------------
+	class MipGenerator
+	{
+	public:
+		static bool IsSupported(Format format);
+
+		// The surfaces of the mips are tightly packed after the top mip in pData, which is
+		// sized for all of them
+		static bool Generate(Format format, DDS::MipFilter filter, uint32_t width,
+			uint32_t height, uint32_t mipCount, uint8_t* pData);
+
+	protected:
+		struct Tap
+		{
+			uint32_t Index;
+			float Weight;
+		};
+
+		// Taps of each destination texel along an axis
+		struct Kernel
+		{
+			std::vector<uint32_t> FirstTaps;
+			std::vector<Tap> Taps;
+		};
+
+		static void buildKernel(DDS::MipFilter filter, uint32_t srcSize, uint32_t dstSize, Kernel& kernel);
+		static void loadRow(Format format, const uint8_t* pSrc, uint32_t width, DirectX::XMVECTOR* pDst);
+		static void storeRow(Format format, const DirectX::XMVECTOR* pSrc, uint32_t width, uint8_t* pDst);
+	};
+}
@@ -3,6 +3,7 @@
 //--------------------------------------------------------------------------------------
 
 #include "XUSGModel.h"
+#include "XUSGTexturePacker.h"
 
 using namespace std;
 using namespace DirectX;
@@ -61,6 +62,7 @@ Model_Impl::Model_Impl(const wchar_t* name, API api) :
 	m_api(api),
 	m_currentFrame(0),
 	m_variableSlot(VARIABLE_SLOT),
+	m_materialSliceSlot(VARIABLE_SLOT + MATERIAL_SLICE_OFFSET),
 	m_mesh(nullptr),
 	m_shaderLib(nullptr),
 	m_graphicsPipelineLib(nullptr),
@@ -69,7 +71,12 @@ Model_Impl::Model_Impl(const wchar_t* name, API api) :
 	m_pipelineLayouts(),
 	m_pipelines(),
 	m_cbvTables(),
-	m_srvTables(0)
+	m_srvTables(0),
+	m_opaqueSubsetOrders(0),
+	m_arraySrvTables(0),
+	m_materialSlices(0),
+	m_useTextureArrays(false),
+	m_lod(0)
 {
 	if (name) m_name = name;
 	else m_name = L"";
@@ -97,6 +104,13 @@ bool Model_Impl::Init(const Device* pDevice, const InputLayout* pInputLayout,
 	// Get SDKMesh
 	m_mesh = mesh;
 
+	// The base pass samples the texture arrays of the mesh, if the array shaders are provided
+	// for all the base-pass pixel shaders
+	m_useTextureArrays = m_mesh->GetNumTextureArraySets() > 0 &&
+		m_shaderLib->GetShader(Shader::Stage::PS, PS_BASE_PASS_ARRAY) &&
+		(!m_shaderLib->GetShader(Shader::Stage::PS, PS_ALPHA_TEST) ||
+			m_shaderLib->GetShader(Shader::Stage::PS, PS_ALPHA_TEST_ARRAY));
+
 	// Create buffers
 	XUSG_N_RETURN(createConstantBuffers(pDevice), false);
 
@@ -122,35 +136,16 @@ bool Model_Impl::CreateDescriptorTables()
 #endif
 	}
 
-	// Materials
-	const auto numMaterials = m_mesh->GetNumMaterials();
-	m_srvTables.resize(numMaterials);
-	for (auto m = 0u; m < numMaterials; ++m)
-	{
-		const auto pMaterial = m_mesh->GetMaterial(m);
-
-		if (pMaterial && pMaterial->pAlbedo && pMaterial->pNormal && pMaterial->pSpecular)
-		{
-			const auto descriptorTable = Util::DescriptorTable::MakeUnique(m_api);
-			const Descriptor descriptors[] =
-			{
-				pMaterial->pAlbedo->GetSRV(),
-				pMaterial->pNormal->GetSRV(),
-				pMaterial->pSpecular->GetSRV()
-			};
-			descriptorTable->SetDescriptors(0, static_cast<uint32_t>(size(descriptors)), descriptors);
-			XUSG_X_RETURN(m_srvTables[m], descriptorTable->GetCbvSrvUavTable(m_descriptorTableLib.get()), false);
-		}
-		else m_srvTables[m] = XUSG_NULL;
-	}
-
-	return true;
+	return createMaterialTables();
 }
 
 void Model_Impl::Update(uint8_t frameIndex)
 {
 	m_currentFrame = frameIndex;
 	m_previousFrame = (frameIndex + FrameCount - 1) % FrameCount;
+
+	// Pick up the textures replaced in the library, e.g. by a texture streamer
+	if (m_mesh && m_mesh->RefreshTextures() && !m_srvTables.empty()) createMaterialTables();
 }
 
 void Model_Impl::SetMatrices(CXMMATRIX world, bool isTemporal)
@@ -207,6 +202,12 @@ void Model_Impl::SetPipeline(const CommandList* pCommandList, SubsetFlags subset
 	}
 }
 
+void Model_Impl::SetLOD(uint32_t lod)
+{
+	// Only the full detail without a mesh
+	m_lod = m_mesh ? (min)(lod, m_mesh->GetNumLODs() - 1) : 0;
+}
+
 void Model_Impl::Render(const CommandList* pCommandList, SubsetFlags subsetFlags, uint8_t matrixTableIndex,
 	PipelineLayoutIndex layout, const DescriptorTable* pCbvPerFrameTable, uint32_t numInstances)
 {
@@ -239,6 +240,11 @@ bool Model_Impl::IsTwoSidedAll() const
 	return m_twoSidedAll;
 }
 
+uint32_t Model_Impl::GetLOD() const
+{
+	return m_lod;
+}
+
 bool Model_Impl::createConstantBuffers(const Device* pDevice)
 {
 	m_cbMatrices = ConstantBuffer::MakeUnique(m_api);
@@ -266,6 +272,95 @@ bool Model_Impl::createConstantBuffers(const Device* pDevice)
 	return true;
 }
 
+bool Model_Impl::createMaterialTables()
+{
+	// Materials
+	const auto numMaterials = m_mesh->GetNumMaterials();
+	m_srvTables.resize(numMaterials);
+	for (auto m = 0u; m < numMaterials; ++m)
+	{
+		const auto pMaterial = m_mesh->GetMaterial(m);
+
+		if (pMaterial && pMaterial->pAlbedo && pMaterial->pNormal && pMaterial->pSpecular)
+		{
+			const auto descriptorTable = Util::DescriptorTable::MakeUnique(m_api);
+			const Descriptor descriptors[] =
+			{
+				pMaterial->pAlbedo->GetSRV(),
+				pMaterial->pNormal->GetSRV(),
+				pMaterial->pSpecular->GetSRV()
+			};
+			descriptorTable->SetDescriptors(0, static_cast<uint32_t>(size(descriptors)), descriptors);
+			XUSG_X_RETURN(m_srvTables[m], descriptorTable->GetCbvSrvUavTable(m_descriptorTableLib.get()), false);
+		}
+		else m_srvTables[m] = XUSG_NULL;
+	}
+
+	// Texture arrays, of which the tables are shared by the materials of a set
+	if (m_useTextureArrays)
+	{
+		const auto numSets = m_mesh->GetNumTextureArraySets();
+		vector<DescriptorTable> arrayTables(numSets);
+		for (auto i = 0u; i < numSets; ++i)
+		{
+			const auto descriptorTable = Util::DescriptorTable::MakeUnique(m_api);
+			const Descriptor descriptors[] =
+			{
+				m_mesh->GetTextureArray(i, TexturePacker::ALBEDO)->GetSRV(),
+				m_mesh->GetTextureArray(i, TexturePacker::NORMAL)->GetSRV(),
+				m_mesh->GetTextureArray(i, TexturePacker::SPECULAR)->GetSRV()
+			};
+			descriptorTable->SetDescriptors(0, static_cast<uint32_t>(size(descriptors)), descriptors);
+			XUSG_X_RETURN(arrayTables[i], descriptorTable->GetCbvSrvUavTable(m_descriptorTableLib.get()), false);
+		}
+
+		m_arraySrvTables.resize(numMaterials);
+		m_materialSlices.resize(numMaterials);
+		for (auto m = 0u; m < numMaterials; ++m)
+		{
+			const auto set = m_mesh->GetMaterialTextureArraySet(m, &m_materialSlices[m]);
+			m_arraySrvTables[m] = set < numSets ? arrayTables[set] : XUSG_NULL;
+		}
+	}
+
+	// The materials of the same textures get the same table from the library; draw the opaque
+	// subsets grouped by their tables, so that the tables are switched once per group, and by
+	// their slices of the texture arrays
+	const auto& srvTables = m_useTextureArrays ? m_arraySrvTables : m_srvTables;
+	const auto numMeshes = m_mesh->GetNumMeshes();
+	m_opaqueSubsetOrders.resize(numMeshes);
+	for (auto m = 0u; m < numMeshes; ++m)
+	{
+		auto& subsetOrder = m_opaqueSubsetOrders[m];
+		subsetOrder.resize(m_mesh->GetNumSubsets(m, SUBSET_OPAQUE));
+		for (auto i = 0u; i < subsetOrder.size(); ++i) subsetOrder[i] = i;
+
+		const auto getTable = [&](uint32_t subset)
+		{
+			const auto materialID = m_mesh->GetSubset(m, subset, SUBSET_OPAQUE)->MaterialID;
+
+			return materialID < numMaterials ? srvTables[materialID] : XUSG_NULL;
+		};
+
+		const auto getSlice = [&](uint32_t subset)
+		{
+			const auto materialID = m_mesh->GetSubset(m, subset, SUBSET_OPAQUE)->MaterialID;
+
+			return m_useTextureArrays && materialID < numMaterials ? m_materialSlices[materialID] : 0;
+		};
+
+		stable_sort(subsetOrder.begin(), subsetOrder.end(), [&](uint32_t a, uint32_t b)
+		{
+			const auto tableA = getTable(a);
+			const auto tableB = getTable(b);
+
+			return tableA < tableB || (tableA == tableB && getSlice(a) < getSlice(b));
+		});
+	}
+
+	return true;
+}
+
 bool Model_Impl::createPipelines(const InputLayout* pInputLayout, uint32_t numRTVs, const Format* rtvFormats,
 	Format dsvFormat, Format shadowFormat, bool isStatic, bool useZEqual)
 {
@@ -286,7 +381,8 @@ bool Model_Impl::createPipelines(const InputLayout* pInputLayout, uint32_t numRT
 		state->IASetPrimitiveTopologyType(PrimitiveTopologyType::TRIANGLE);
 		state->SetPipelineLayout(m_pipelineLayouts[BASE_PASS]);
 		state->SetShader(Shader::Stage::VS, m_shaderLib->GetShader(Shader::Stage::VS, vsBasePass));
-		state->SetShader(Shader::Stage::PS, m_shaderLib->GetShader(Shader::Stage::PS, PS_BASE_PASS));
+		state->SetShader(Shader::Stage::PS, m_shaderLib->GetShader(Shader::Stage::PS,
+			m_useTextureArrays ? PS_BASE_PASS_ARRAY : PS_BASE_PASS));
 		state->DSSetState(useZEqual ? Graphics::DepthStencilPreset::DEPTH_READ_EQUAL :
 			Graphics::DepthStencilPreset::DEFAULT_LESS, m_graphicsPipelineLib.get());
 		state->OMSetRTVFormats(numRTVs, rtvFormats);
@@ -305,7 +401,8 @@ bool Model_Impl::createPipelines(const InputLayout* pInputLayout, uint32_t numRT
 		XUSG_X_RETURN(m_pipelines[ALPHA_TWO_SIDED], state->GetPipeline(m_graphicsPipelineLib.get(),
 			m_name.empty() ? nullptr : (m_name + L".AlphaTwoSided").c_str()), false);
 
-		const auto psAlphaTest = m_shaderLib->GetShader(Shader::Stage::PS, PS_ALPHA_TEST);
+		const auto psAlphaTest = m_shaderLib->GetShader(Shader::Stage::PS,
+			m_useTextureArrays ? PS_ALPHA_TEST_ARRAY : PS_ALPHA_TEST);
 		if (psAlphaTest)
 		{
 			// Get alpha-test two-sided pipelines
@@ -396,16 +493,36 @@ void Model_Impl::render(const CommandList* pCommandList, uint32_t mesh, Pipeline
 
 	//const uint8_t materialSlot = psBaseSlot + MATERIAL;
 	const auto numSubsets = m_mesh->GetNumSubsets(mesh, materialType);
-	for (auto subset = 0u; subset < numSubsets; ++subset)
+	const auto pSubsetOrder = materialType == SUBSET_OPAQUE && mesh < m_opaqueSubsetOrders.size() &&
+		m_opaqueSubsetOrders[mesh].size() == numSubsets ? m_opaqueSubsetOrders[mesh].data() : nullptr;
+	// The base pass samples the texture arrays with the slice of each material
+	const auto useTextureArrays = m_useTextureArrays && layout == BASE_PASS;
+	const auto& srvTables = useTextureArrays ? m_arraySrvTables : m_srvTables;
+	DescriptorTable srvTable = XUSG_NULL;
+	auto slice = UINT32_MAX;
+	for (auto i = 0u; i < numSubsets; ++i)
 	{
 		// Get subset
-		const auto pSubset = m_mesh->GetSubset(mesh, subset, materialType);
+		const auto subset = pSubsetOrder ? pSubsetOrder[i] : i;
+		const auto pSubset = m_mesh->GetLODSubset(mesh, subset, materialType, m_lod);
 		const auto primType = m_mesh->GetPrimitiveType(SDKMesh::PrimitiveType(pSubset->PrimitiveType));
 		pCommandList->IASetPrimitiveTopology(primType);
 
-		// Set material
-		if (layout != DEPTH_PASS && m_mesh->GetMaterial(pSubset->MaterialID) && m_srvTables[pSubset->MaterialID])
-			pCommandList->SetGraphicsDescriptorTable(m_variableSlot + MATERIAL_OFFSET, m_srvTables[pSubset->MaterialID]);
+		// Set material, unless the table is already set
+		if (layout != DEPTH_PASS && m_mesh->GetMaterial(pSubset->MaterialID) && srvTables[pSubset->MaterialID])
+		{
+			if (srvTables[pSubset->MaterialID] != srvTable)
+			{
+				srvTable = srvTables[pSubset->MaterialID];
+				pCommandList->SetGraphicsDescriptorTable(m_variableSlot + MATERIAL_OFFSET, srvTable);
+			}
+
+			if (useTextureArrays && m_materialSlices[pSubset->MaterialID] != slice)
+			{
+				slice = m_materialSlices[pSubset->MaterialID];
+				pCommandList->SetGraphics32BitConstant(m_materialSliceSlot, slice);
+			}
+		}
 
 		// Draw
 		pCommandList->DrawIndexed(static_cast<uint32_t>(pSubset->IndexCount), numInstances,
@@ -425,6 +542,7 @@ Util::PipelineLayout::sptr Model_Impl::initPipelineLayout(VertexShader vs, Pixel
 	auto txBaseColor = 0u;
 	auto txNormal = txBaseColor + 1;
 	auto txSpecular = txNormal + 1;
+	auto cbMaterialSlice = 0u;
 	auto smpAnisoWrap = 0u;
 
 	// Get vertex shader slots
@@ -456,6 +574,7 @@ Util::PipelineLayout::sptr Model_Impl::initPipelineLayout(VertexShader vs, Pixel
 			txBaseColor = reflector->GetResourceBindingPointByName("g_txBaseColor", txBaseColor);
 			txNormal = reflector->GetResourceBindingPointByName("g_txNormal", txNormal);
 			txSpecular = reflector->GetResourceBindingPointByName("g_txSpecular", txSpecular);
+			cbMaterialSlice = reflector->GetResourceBindingPointByName("cbMaterialSlice", cbMaterialSlice);
 			
 			// Get sampler slots
 			smpAnisoWrap = reflector->GetResourceBindingPointByName("g_smpLinear", smpAnisoWrap);
@@ -503,6 +622,10 @@ Util::PipelineLayout::sptr Model_Impl::initPipelineLayout(VertexShader vs, Pixel
 			utilPipelineLayout->SetConstants(m_variableSlot + ALPHA_REF_OFFSET,
 				XUSG_UINT32_SIZE_OF(XMFLOAT2), cbPerObject, 0, Shader::Stage::PS);
 
+		// Slice of the texture arrays, shared by the alpha-test pixel shader
+		if (ps == PS_BASE_PASS_ARRAY)
+			utilPipelineLayout->SetConstants(m_materialSliceSlot, 1, cbMaterialSlice, 0, Shader::Stage::PS);
+
 		// Samplers
 		const Sampler* pSamplers[] =
 		{
@@ -31,11 +31,13 @@ namespace XUSG
 		void SetPipelineLayout(const CommandList* pCommandList, PipelineLayoutIndex layout);
 		void SetPipeline(const CommandList* pCommandList, PipelineIndex pipeline);
 		void SetPipeline(const CommandList* pCommandList, SubsetFlags subsetFlag, PipelineLayoutIndex layout);
+		void SetLOD(uint32_t lod);
 		void Render(const CommandList* pCommandList, SubsetFlags subsetFlags, uint8_t matrixTableIndex,
 			PipelineLayoutIndex layout = NUM_PIPELINE_LAYOUT, const DescriptorTable* pCbvPerFrameTable = nullptr,
 			uint32_t numInstances = 1);
 
 		bool IsTwoSidedAll() const;
+		uint32_t GetLOD() const;
 
 	protected:
 		struct CBMatrices
@@ -48,6 +50,7 @@ namespace XUSG
 		};
 
 		bool createConstantBuffers(const Device* pDevice);
+		bool createMaterialTables();
 		bool createPipelines(const InputLayout* pInputLayout, uint32_t numRTVs, const Format* rtvFormats,
 			Format dsvFormat, Format shadowFormat, bool isStatic, bool useZEqual);
 		void render(const CommandList* pCommandList, uint32_t mesh, PipelineLayoutIndex layout,
@@ -62,6 +65,7 @@ namespace XUSG
 		uint8_t	m_previousFrame;
 
 		uint8_t	m_variableSlot;
+		uint8_t	m_materialSliceSlot;
 
 		SDKMesh::sptr				m_mesh;
 		ShaderLib::sptr				m_shaderLib;
@@ -82,7 +86,14 @@ namespace XUSG
 		Pipeline				m_pipelines[NUM_PIPELINE];
 		DescriptorTable			m_cbvTables[FrameCount][NUM_CBV_TABLE];
 		std::vector<DescriptorTable> m_srvTables;
+		std::vector<std::vector<uint32_t>> m_opaqueSubsetOrders;
+
+		// Tables of the texture arrays and the slices per material, used by the base pass
+		std::vector<DescriptorTable> m_arraySrvTables;
+		std::vector<uint32_t>	m_materialSlices;
 
 		bool					m_twoSidedAll;
+		bool					m_useTextureArrays;
+		uint32_t				m_lod;
 	};
 }
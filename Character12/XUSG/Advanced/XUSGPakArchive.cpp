@@ -0,0 +1,698 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include <shared_mutex>
+#include <unordered_set>
+#include "XUSGPakArchive.h"
+#include "XUSGThreadPool.h"
+#include "XUSGLZCodec.h"
+#include "XUSGIndexCodec.h"
+#include "XUSGSDKMesh.h"
+#include "Core/XUSG_DX12.h"
+
+using namespace std;
+using namespace XUSG;
+
+struct MountTable
+{
+	shared_timed_mutex Mutex;
+	vector<PakArchive::sptr> Archives;
+};
+
+// Decompressed file, held along with its archive
+struct DecompressedFile
+{
+	PakArchive::sptr Archive;
+	vector<uint8_t> Data;
+};
+
+static MountTable& GetMountTable()
+{
+	static MountTable mountTable;
+
+	return mountTable;
+}
+
+// Find the archive under the lock, so that the file data are read outside of it
+static PakArchive::sptr FindMountedArchive(const wchar_t* filePath)
+{
+	auto& mountTable = GetMountTable();
+	shared_lock<shared_timed_mutex> lock(mountTable.Mutex);
+
+	const auto& archives = mountTable.Archives;
+	for (auto archiveIter = archives.crbegin(); archiveIter != archives.crend(); ++archiveIter)
+		if ((*archiveIter)->Contains(filePath)) return *archiveIter;
+
+	return nullptr;
+}
+
+//--------------------------------------------------------------------------------------
+// Find the index buffers of a mesh file, sorted by their offsets; the overlapping ones, and
+// the files of other versions, are left to the LZ chunks
+//--------------------------------------------------------------------------------------
+static bool FindIndexStreams(const wstring& name, const uint8_t* pData, size_t size,
+	vector<PakArchive_Impl::IndexStream>& indexStreams)
+{
+	static const wstring extension = L".sdkmesh";
+	XUSG_C_RETURN(name.size() < extension.size() ||
+		name.compare(name.size() - extension.size(), extension.size(), extension) != 0, false);
+	XUSG_C_RETURN(size < sizeof(SDKMesh_Impl::Header), false);
+
+	const auto pHeader = reinterpret_cast<const SDKMesh_Impl::Header*>(pData);
+	XUSG_C_RETURN(pHeader->Version != SDKMESH_FILE_VERSION, false);
+	XUSG_C_RETURN(pHeader->IndexStreamHeadersOffset > size ||
+		(size - pHeader->IndexStreamHeadersOffset) / sizeof(SDKMesh_Impl::IndexBufferHeader) < pHeader->NumIndexBuffers, false);
+
+	const auto pIndexBufferHeaders = reinterpret_cast<const SDKMesh_Impl::IndexBufferHeader*>(pData + pHeader->IndexStreamHeadersOffset);
+	indexStreams.clear();
+	for (auto i = 0u; i < pHeader->NumIndexBuffers; ++i)
+	{
+		const auto& ibHeader = pIndexBufferHeaders[i];
+		const auto indexSize = ibHeader.IndexType == SDKMesh::IT_32BIT ? sizeof(uint32_t) : sizeof(uint16_t);
+		if (ibHeader.NumIndices == 0 || ibHeader.DataOffset > size ||
+			(size - ibHeader.DataOffset) / indexSize < ibHeader.NumIndices) continue;
+
+		PakArchive_Impl::IndexStream indexStream = {};
+		indexStream.Offset = ibHeader.DataOffset;
+		indexStream.NumIndices = ibHeader.NumIndices;
+		indexStream.IndexSize = static_cast<uint32_t>(indexSize);
+		indexStreams.emplace_back(indexStream);
+	}
+
+	sort(indexStreams.begin(), indexStreams.end(), [](const PakArchive_Impl::IndexStream& a, const PakArchive_Impl::IndexStream& b)
+	{
+		return a.Offset < b.Offset;
+	});
+
+	// Keep the first of the overlapping index buffers
+	auto numStreams = size_t(0);
+	auto streamEnd = uint64_t(0);
+	for (const auto& indexStream : indexStreams)
+	{
+		if (indexStream.Offset < streamEnd) continue;
+		streamEnd = indexStream.Offset + indexStream.IndexSize * indexStream.NumIndices;
+		indexStreams[numStreams++] = indexStream;
+	}
+	indexStreams.resize(numStreams);
+
+	return !indexStreams.empty();
+}
+
+static bool IsLess(const PakArchive_Impl::Entry& a, const wchar_t* pNameA,
+	const PakArchive_Impl::Entry& b, const wchar_t* pNameB)
+{
+	if (a.Hash != b.Hash) return a.Hash < b.Hash;
+
+	return lexicographical_compare(pNameA, pNameA + a.NameLength, pNameB, pNameB + b.NameLength);
+}
+
+//--------------------------------------------------------------------------------------
+// Create interfaces
+//--------------------------------------------------------------------------------------
+PakArchive::uptr PakArchive::MakeUnique(API api)
+{
+	return make_unique<PakArchive_Impl>(api);
+}
+
+PakArchive::sptr PakArchive::MakeShared(API api)
+{
+	return make_shared<PakArchive_Impl>(api);
+}
+
+//--------------------------------------------------------------------------------------
+// Mounted archives
+//--------------------------------------------------------------------------------------
+void PakArchive::Mount(const sptr& archive)
+{
+	assert(archive);
+	auto& mountTable = GetMountTable();
+	lock_guard<shared_timed_mutex> lock(mountTable.Mutex);
+
+	auto& archives = mountTable.Archives;
+	if (find(archives.cbegin(), archives.cend(), archive) == archives.cend())
+		archives.emplace_back(archive);
+}
+
+void PakArchive::Unmount(const PakArchive* pArchive)
+{
+	auto& mountTable = GetMountTable();
+	lock_guard<shared_timed_mutex> lock(mountTable.Mutex);
+
+	auto& archives = mountTable.Archives;
+	archives.erase(remove_if(archives.begin(), archives.end(),
+		[pArchive](const sptr& archive) { return archive.get() == pArchive; }), archives.end());
+}
+
+const uint8_t* PakArchive::FindMounted(const wchar_t* filePath, size_t* pSize, sptr* pArchive)
+{
+	const auto archive = FindMountedArchive(filePath);
+	XUSG_N_RETURN(archive, nullptr);
+
+	vector<uint8_t> buffer;
+	const auto pData = archive->Find(filePath, pSize, pArchive ? &buffer : nullptr);
+	XUSG_N_RETURN(pData, nullptr);
+
+	if (pArchive)
+	{
+		if (buffer.empty()) *pArchive = archive;
+		else
+		{
+			// The returned archive also owns the decompressed bytes; moving keeps them in place
+			const auto decompressedFile = make_shared<DecompressedFile>();
+			decompressedFile->Archive = archive;
+			decompressedFile->Data = move(buffer);
+			*pArchive = sptr(decompressedFile, archive.get());
+		}
+	}
+
+	return pData;
+}
+
+PakArchive::sptr PakArchive::GetMounted(const wchar_t* filePath)
+{
+	return FindMountedArchive(filePath);
+}
+
+bool PakArchive::ContainsMounted(const wchar_t* filePath)
+{
+	auto& mountTable = GetMountTable();
+	shared_lock<shared_timed_mutex> lock(mountTable.Mutex);
+
+	const auto& archives = mountTable.Archives;
+	for (const auto& archive : archives)
+		if (archive->Contains(filePath)) return true;
+
+	return false;
+}
+
+bool PakArchive::ReadMounted(const wchar_t* filePath, vector<uint8_t>& data)
+{
+	const auto archive = FindMountedArchive(filePath);
+	XUSG_N_RETURN(archive, false);
+
+	size_t fileSize;
+	const auto pData = archive->Find(filePath, &fileSize, &data);
+	XUSG_N_RETURN(pData, false);
+
+	// A compressed file is decompressed into the data already
+	if (pData != data.data()) data.assign(pData, pData + fileSize);
+
+	return true;
+}
+
+bool PakArchive::Create(const wchar_t* fileName, const wchar_t* rootPath,
+	uint32_t numFiles, const wchar_t* const* filePaths, bool compress)
+{
+	F_RETURN(!fileName || (numFiles > 0 && !filePaths), cerr, E_INVALIDARG, false);
+
+	ofstream pakStream(fileName, ios::out | ios::binary);
+	F_RETURN(!pakStream, cerr, MAKE_HRESULT(SEVERITY_ERROR, FACILITY_ITF, 0x0903), false);
+
+	PakArchive_Impl::Header header = {};
+	header.Magic = PakArchive_Impl::MAGIC;
+	header.Version = PakArchive_Impl::VERSION;
+	header.ChunkSize = PakArchive_Impl::CHUNK_SIZE;
+	XUSG_N_RETURN(pakStream.write(reinterpret_cast<const char*>(&header), sizeof(header)), false);
+
+	const auto root = rootPath ? Hash::NormalizePath(rootPath, true) : wstring();
+	const char padding[PakArchive_Impl::DATA_ALIGNMENT] = {};
+
+	vector<PakArchive_Impl::Entry> entries;
+	unordered_set<wstring> names;
+	wstring nameTable;
+	vector<uint8_t> data;
+	vector<uint8_t> compressed;
+	uint64_t offset = sizeof(header);
+	entries.reserve(numFiles);
+	for (auto i = 0u; i < numFiles; ++i)
+	{
+		// Files are named by their paths relative to the root, and the first of the same name is kept
+		auto name = Hash::NormalizePath(filePaths[i]);
+		if (name.compare(0, root.size(), root) == 0) name.erase(0, root.size());
+		if (name.empty() || !names.emplace(name).second) continue;
+
+		ifstream fileStream(filePaths[i], ios::in | ios::binary);
+		F_RETURN(!fileStream, cerr, MAKE_HRESULT(SEVERITY_ERROR, FACILITY_ITF, 0x0903), false);
+
+		fileStream.seekg(0, fileStream.end);
+		const auto fileSize = static_cast<size_t>(fileStream.tellg());
+		fileStream.seekg(0);
+
+		data.resize(fileSize);
+		XUSG_N_RETURN(fileStream.read(reinterpret_cast<char*>(data.data()), fileSize), false);
+
+		const auto flags = compress ? PakArchive_Impl::Compress(name, data.data(), fileSize, compressed) : 0;
+		const auto& storedData = flags ? compressed : data;
+
+		// Align the file data in the view for aligned loads
+		const auto paddingSize = static_cast<size_t>(XUSG_DIV_UP(offset, PakArchive_Impl::DATA_ALIGNMENT) *
+			PakArchive_Impl::DATA_ALIGNMENT - offset);
+		pakStream.write(padding, paddingSize);
+		pakStream.write(reinterpret_cast<const char*>(storedData.data()), storedData.size());
+		XUSG_N_RETURN(pakStream, false);
+
+		offset += paddingSize;
+		entries.push_back({ Hash::HashString(name), offset, fileSize, storedData.size(), flags, 0,
+			static_cast<uint32_t>(nameTable.size()), static_cast<uint32_t>(name.size()) });
+		nameTable += name;
+		offset += storedData.size();
+	}
+
+	const auto pNameTable = nameTable.c_str();
+	sort(entries.begin(), entries.end(), [pNameTable](const PakArchive_Impl::Entry& a, const PakArchive_Impl::Entry& b)
+	{
+		return IsLess(a, pNameTable + a.NameOffset, b, pNameTable + b.NameOffset);
+	});
+
+	// Write the directory and the name table after the file data
+	const auto paddingSize = static_cast<size_t>(XUSG_DIV_UP(offset, sizeof(uint64_t)) * sizeof(uint64_t) - offset);
+	pakStream.write(padding, paddingSize);
+	offset += paddingSize;
+
+	header.NumEntries = static_cast<uint32_t>(entries.size());
+	header.NameTableLength = static_cast<uint32_t>(nameTable.size());
+	header.DirectoryOffset = offset;
+	header.NameTableOffset = offset + sizeof(PakArchive_Impl::Entry) * entries.size();
+	pakStream.write(reinterpret_cast<const char*>(entries.data()), sizeof(PakArchive_Impl::Entry) * entries.size());
+	pakStream.write(reinterpret_cast<const char*>(pNameTable), sizeof(wchar_t) * nameTable.size());
+
+	pakStream.seekp(0);
+	pakStream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	XUSG_N_RETURN(pakStream.flush(), false);
+
+	return true;
+}
+
+//--------------------------------------------------------------------------------------
+// Pak archive implementations
+//--------------------------------------------------------------------------------------
+PakArchive_Impl::PakArchive_Impl(API api) :
+	m_hFile(INVALID_HANDLE_VALUE),
+	m_hMapping(nullptr),
+	m_pView(nullptr),
+	m_viewSize(0),
+	m_pHeader(nullptr),
+	m_pEntries(nullptr),
+	m_pNameTable(nullptr),
+	m_mountPoint()
+{
+}
+
+PakArchive_Impl::~PakArchive_Impl()
+{
+	Close();
+}
+
+bool PakArchive_Impl::Open(const wchar_t* fileName, const wchar_t* mountPoint)
+{
+	Close();
+	F_RETURN(!fileName, cerr, E_INVALIDARG, false);
+
+	// Map the whole archive once; the files are read in place by the loaders
+	m_hFile = CreateFileW(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	F_RETURN(m_hFile == INVALID_HANDLE_VALUE, cerr, GetLastError(), false);
+
+	// The handles of a partially opened archive are released by Close()
+	LARGE_INTEGER fileSize;
+	F_RETURN(!GetFileSizeEx(m_hFile, &fileSize), cerr, GetLastError(), false);
+
+	m_hMapping = CreateFileMappingW(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	F_RETURN(!m_hMapping, cerr, GetLastError(), false);
+
+	m_pView = static_cast<const uint8_t*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+	F_RETURN(!m_pView, cerr, GetLastError(), false);
+
+	XUSG_N_RETURN(setView(m_pView, static_cast<uint64_t>(fileSize.QuadPart)), false);
+
+	m_mountPoint = mountPoint ? Hash::NormalizePath(mountPoint, true) : wstring();
+
+	return true;
+}
+
+void PakArchive_Impl::Close()
+{
+	if (m_pView) UnmapViewOfFile(m_pView);
+	if (m_hMapping) CloseHandle(m_hMapping);
+	if (m_hFile != INVALID_HANDLE_VALUE) CloseHandle(m_hFile);
+
+	m_hFile = INVALID_HANDLE_VALUE;
+	m_hMapping = nullptr;
+	m_pView = nullptr;
+	m_viewSize = 0;
+	m_pHeader = nullptr;
+	m_pEntries = nullptr;
+	m_pNameTable = nullptr;
+	m_mountPoint.clear();
+}
+
+const uint8_t* PakArchive_Impl::Find(const wchar_t* filePath, size_t* pSize, vector<uint8_t>* pBuffer) const
+{
+	const auto pEntry = findEntry(filePath);
+	XUSG_N_RETURN(pEntry, nullptr);
+
+	if (pSize) *pSize = static_cast<size_t>(pEntry->Size);
+	if (pEntry->Flags == 0) return m_pView + pEntry->Offset;
+
+	XUSG_N_RETURN(pBuffer && decompress(*pEntry, *pBuffer), nullptr);
+
+	return pBuffer->data();
+}
+
+bool PakArchive_Impl::Contains(const wchar_t* filePath) const
+{
+	return findEntry(filePath) != nullptr;
+}
+
+bool PakArchive_Impl::IsOpen() const
+{
+	return m_pHeader != nullptr;
+}
+
+uint32_t PakArchive_Impl::GetNumFiles() const
+{
+	return m_pHeader ? m_pHeader->NumEntries : 0;
+}
+
+bool PakArchive_Impl::GetFileSize(const wchar_t* filePath, uint64_t* pSize) const
+{
+	const auto pEntry = findEntry(filePath);
+	XUSG_N_RETURN(pEntry, false);
+
+	if (pSize) *pSize = pEntry->Size;
+
+	return true;
+}
+
+bool PakArchive_Impl::Read(const wchar_t* filePath, uint64_t offset, size_t size, uint8_t* pDst) const
+{
+	const auto pEntry = findEntry(filePath);
+	XUSG_N_RETURN(pEntry, false);
+	XUSG_C_RETURN(offset > pEntry->Size || size > pEntry->Size - offset, false);
+	if (size == 0) return true;
+
+	const auto pStoredData = m_pView + pEntry->Offset;
+	if (pEntry->Flags == 0)
+	{
+		memcpy(pDst, &pStoredData[offset], size);
+
+		return true;
+	}
+
+	if (pEntry->Flags == ENTRY_LZ_CHUNKS)
+		return readChunks(pStoredData, pEntry->StoredSize, pEntry->Size, offset, size, pDst);
+
+	// The index streams of a mesh are decoded over its chunks, so the whole file is decoded
+	vector<uint8_t> data;
+	XUSG_N_RETURN(decompress(*pEntry, data), false);
+	memcpy(pDst, &data[static_cast<size_t>(offset)], size);
+
+	return true;
+}
+
+uint32_t PakArchive_Impl::Compress(const wstring& name, const uint8_t* pData, size_t size, vector<uint8_t>& compressed)
+{
+	XUSG_C_RETURN(size == 0, 0);
+
+	// Code the index buffers of a mesh apart, and zero their ranges for the LZ chunks
+	vector<IndexStream> indexStreams;
+	vector<uint8_t> image;
+	compressed.clear();
+	if (FindIndexStreams(name, pData, size, indexStreams))
+	{
+		const auto numStreams = static_cast<uint32_t>(indexStreams.size());
+		vector<vector<uint8_t>> encodedStreams(numStreams);
+		ThreadPool::GetDefault().ParallelFor(numStreams, [&](uint32_t i)
+		{
+			auto& indexStream = indexStreams[i];
+			const auto numIndices = static_cast<size_t>(indexStream.NumIndices);
+			auto& encodedStream = encodedStreams[i];
+			encodedStream.resize(IndexCodec::GetMaxEncodedSize(numIndices, indexStream.IndexSize));
+			encodedStream.resize(IndexCodec::Encode(&pData[indexStream.Offset], numIndices,
+				indexStream.IndexSize, encodedStream.data(), encodedStream.size()));
+			indexStream.EncodedSize = encodedStream.size();
+		});
+
+		image.assign(pData, pData + size);
+		for (const auto& indexStream : indexStreams)
+			memset(&image[static_cast<size_t>(indexStream.Offset)], 0, static_cast<size_t>(indexStream.IndexSize * indexStream.NumIndices));
+		pData = image.data();
+
+		const auto numStreams64 = static_cast<uint64_t>(numStreams);
+		compressed.resize(sizeof(uint64_t) + sizeof(IndexStream) * numStreams);
+		memcpy(compressed.data(), &numStreams64, sizeof(uint64_t));
+		memcpy(&compressed[sizeof(uint64_t)], indexStreams.data(), sizeof(IndexStream) * numStreams);
+		for (const auto& encodedStream : encodedStreams)
+			compressed.insert(compressed.end(), encodedStream.cbegin(), encodedStream.cend());
+	}
+
+	compressChunks(pData, size, compressed);
+
+	// Save at least 1/16 of the size
+	XUSG_C_RETURN(compressed.size() >= size - size / 16, 0);
+
+	return indexStreams.empty() ? ENTRY_LZ_CHUNKS : ENTRY_LZ_CHUNKS | ENTRY_INDEX_STREAMS;
+}
+
+void PakArchive_Impl::compressChunks(const uint8_t* pData, size_t size, vector<uint8_t>& compressed)
+{
+	// Each chunk keeps its compressed bytes only if they are fewer
+	const auto numChunks = static_cast<uint32_t>(XUSG_DIV_UP(size, CHUNK_SIZE));
+	vector<vector<uint8_t>> chunks(numChunks);
+	ThreadPool::GetDefault().ParallelFor(numChunks, [&](uint32_t i)
+	{
+		const auto pChunk = &pData[static_cast<size_t>(CHUNK_SIZE) * i];
+		const auto chunkSize = (min)(size - static_cast<size_t>(CHUNK_SIZE) * i, static_cast<size_t>(CHUNK_SIZE));
+		auto& chunk = chunks[i];
+		chunk.resize(LZCodec::GetMaxCompressedSize(chunkSize));
+		const auto compressedSize = LZCodec::Compress(pChunk, chunkSize, chunk.data(), chunk.size());
+		if (compressedSize > 0 && compressedSize < chunkSize) chunk.resize(compressedSize);
+		else chunk.assign(pChunk, pChunk + chunkSize);
+	});
+
+	const auto chunkTableOffset = compressed.size();
+	compressed.resize(chunkTableOffset + sizeof(uint32_t) * numChunks);
+	for (auto i = 0u; i < numChunks; ++i)
+	{
+		const auto chunkSize = static_cast<uint32_t>(chunks[i].size());
+		memcpy(&compressed[chunkTableOffset + sizeof(uint32_t) * i], &chunkSize, sizeof(uint32_t));
+		compressed.insert(compressed.end(), chunks[i].cbegin(), chunks[i].cend());
+	}
+}
+
+const PakArchive_Impl::Entry* PakArchive_Impl::findEntry(const wchar_t* filePath) const
+{
+	XUSG_C_RETURN(!m_pHeader || !filePath, nullptr);
+
+	// Paths outside the mount point are not in the archive
+	auto name = Hash::NormalizePath(filePath);
+	XUSG_C_RETURN(name.compare(0, m_mountPoint.size(), m_mountPoint) != 0, nullptr);
+	name.erase(0, m_mountPoint.size());
+
+	Entry key = {};
+	key.Hash = Hash::HashString(name);
+	key.NameLength = static_cast<uint32_t>(name.size());
+
+	// Binary search in the directory without touching the data of the other files
+	const auto pNameTable = m_pNameTable;
+	const auto pName = name.c_str();
+	const auto pEntriesEnd = m_pEntries + m_pHeader->NumEntries;
+	const auto pEntry = lower_bound(m_pEntries, pEntriesEnd, key, [pNameTable, pName](const Entry& entry, const Entry& key)
+	{
+		return IsLess(entry, pNameTable + entry.NameOffset, key, pName);
+	});
+
+	XUSG_C_RETURN(pEntry == pEntriesEnd || pEntry->Hash != key.Hash || pEntry->NameLength != key.NameLength, nullptr);
+	XUSG_C_RETURN(!equal(pName, pName + key.NameLength, pNameTable + pEntry->NameOffset), nullptr);
+
+	return pEntry;
+}
+
+//--------------------------------------------------------------------------------------
+// Decompress the chunks of the file in parallel, and then decode the index streams over
+// their zeroed ranges in parallel. The reads from the mapped view page the chunks in
+// concurrently with the decompression of the others.
+//--------------------------------------------------------------------------------------
+bool PakArchive_Impl::decompress(const Entry& entry, vector<uint8_t>& data) const
+{
+	auto pStoredData = m_pView + entry.Offset;
+	auto storedSize = entry.StoredSize;
+
+	// Validate the index streams before touching the data
+	vector<IndexStream> indexStreams;
+	vector<uint64_t> streamOffsets(1, 0);
+	if (entry.Flags & ENTRY_INDEX_STREAMS)
+	{
+		uint64_t numStreams;
+		XUSG_C_RETURN(storedSize < sizeof(uint64_t), false);
+		memcpy(&numStreams, pStoredData, sizeof(uint64_t));
+		XUSG_C_RETURN((storedSize - sizeof(uint64_t)) / sizeof(IndexStream) < numStreams, false);
+
+		indexStreams.resize(static_cast<size_t>(numStreams));
+		memcpy(indexStreams.data(), &pStoredData[sizeof(uint64_t)], sizeof(IndexStream) * indexStreams.size());
+
+		auto streamEnd = uint64_t(0);
+		streamOffsets[0] = sizeof(uint64_t) + sizeof(IndexStream) * numStreams;
+		streamOffsets.resize(indexStreams.size() + 1);
+		for (size_t i = 0; i < indexStreams.size(); ++i)
+		{
+			const auto& indexStream = indexStreams[i];
+			XUSG_C_RETURN(indexStream.IndexSize != sizeof(uint16_t) && indexStream.IndexSize != sizeof(uint32_t), false);
+			XUSG_C_RETURN(indexStream.Offset < streamEnd || indexStream.Offset > entry.Size ||
+				(entry.Size - indexStream.Offset) / indexStream.IndexSize < indexStream.NumIndices, false);
+			XUSG_C_RETURN(indexStream.EncodedSize > storedSize - streamOffsets[i], false);
+			streamEnd = indexStream.Offset + indexStream.IndexSize * indexStream.NumIndices;
+			streamOffsets[i + 1] = streamOffsets[i] + indexStream.EncodedSize;
+		}
+
+		pStoredData += streamOffsets.back();
+		storedSize -= streamOffsets.back();
+	}
+
+	data.resize(static_cast<size_t>(entry.Size));
+	auto succeeded = true;
+	if (entry.Flags & ENTRY_LZ_CHUNKS) succeeded = decompressChunks(pStoredData, storedSize, data.data(), entry.Size);
+	else if (storedSize == entry.Size) memcpy(data.data(), pStoredData, data.size());
+	else succeeded = false;
+
+	if (succeeded && !indexStreams.empty())
+	{
+		const auto pStreamData = m_pView + entry.Offset;
+		atomic_bool hadError(false);
+		ThreadPool::GetDefault().ParallelFor(static_cast<uint32_t>(indexStreams.size()), [&](uint32_t i)
+		{
+			const auto& indexStream = indexStreams[i];
+			if (!IndexCodec::Decode(&pStreamData[streamOffsets[i]], static_cast<size_t>(indexStream.EncodedSize),
+				static_cast<size_t>(indexStream.NumIndices), indexStream.IndexSize, &data[static_cast<size_t>(indexStream.Offset)]))
+				hadError = true;
+		});
+		succeeded = !hadError;
+	}
+
+	if (!succeeded) data.clear();
+
+	return succeeded;
+}
+
+bool PakArchive_Impl::decompressChunks(const uint8_t* pSrc, uint64_t srcSize, uint8_t* pDst, uint64_t dstSize) const
+{
+	vector<uint64_t> chunkOffsets;
+	XUSG_N_RETURN(getChunkOffsets(pSrc, srcSize, dstSize, chunkOffsets), false);
+
+	const auto chunkSize = static_cast<uint64_t>(m_pHeader->ChunkSize);
+	const auto numChunks = static_cast<uint32_t>(chunkOffsets.size() - 1);
+	atomic_bool hadError(false);
+	ThreadPool::GetDefault().ParallelFor(numChunks, [&](uint32_t i)
+	{
+		const auto pChunk = &pSrc[chunkOffsets[i]];
+		const auto storedChunkSize = static_cast<size_t>(chunkOffsets[i + 1] - chunkOffsets[i]);
+		const auto dstOffset = chunkSize * i;
+		const auto dstChunkSize = static_cast<size_t>((min)(dstSize - dstOffset, chunkSize));
+		if (storedChunkSize == dstChunkSize) memcpy(&pDst[dstOffset], pChunk, dstChunkSize);
+		else if (!LZCodec::Decompress(pChunk, storedChunkSize, &pDst[dstOffset], dstChunkSize)) hadError = true;
+	});
+
+	return !hadError;
+}
+
+//--------------------------------------------------------------------------------------
+// Decompress only the chunks covering [offset, offset + size) of the file; the partly
+// covered chunks at the ends are decompressed aside
+//--------------------------------------------------------------------------------------
+bool PakArchive_Impl::readChunks(const uint8_t* pSrc, uint64_t srcSize, uint64_t dstSize,
+	uint64_t offset, size_t size, uint8_t* pDst) const
+{
+	vector<uint64_t> chunkOffsets;
+	XUSG_N_RETURN(getChunkOffsets(pSrc, srcSize, dstSize, chunkOffsets), false);
+
+	const auto chunkSize = static_cast<uint64_t>(m_pHeader->ChunkSize);
+	const auto rangeEnd = offset + size;
+	const auto firstChunk = static_cast<uint32_t>(offset / chunkSize);
+	const auto numChunks = static_cast<uint32_t>(XUSG_DIV_UP(rangeEnd, chunkSize)) - firstChunk;
+
+	atomic_bool hadError(false);
+	ThreadPool::GetDefault().ParallelFor(numChunks, [&](uint32_t i)
+	{
+		i += firstChunk;
+		const auto pChunk = &pSrc[chunkOffsets[i]];
+		const auto storedChunkSize = static_cast<size_t>(chunkOffsets[i + 1] - chunkOffsets[i]);
+		const auto srcOffset = chunkSize * i;
+		const auto srcChunkSize = static_cast<size_t>((min)(dstSize - srcOffset, chunkSize));
+
+		const auto copyBegin = (max)(offset, srcOffset);
+		const auto copySize = static_cast<size_t>((min)(rangeEnd, srcOffset + srcChunkSize) - copyBegin);
+		const auto pCopyDst = &pDst[copyBegin - offset];
+		if (storedChunkSize == srcChunkSize) memcpy(pCopyDst, &pChunk[copyBegin - srcOffset], copySize);
+		else if (copySize == srcChunkSize)
+		{
+			if (!LZCodec::Decompress(pChunk, storedChunkSize, pCopyDst, srcChunkSize)) hadError = true;
+		}
+		else
+		{
+			vector<uint8_t> chunk(srcChunkSize);
+			if (LZCodec::Decompress(pChunk, storedChunkSize, chunk.data(), srcChunkSize))
+				memcpy(pCopyDst, &chunk[static_cast<size_t>(copyBegin - srcOffset)], copySize);
+			else hadError = true;
+		}
+	});
+
+	return !hadError;
+}
+
+bool PakArchive_Impl::getChunkOffsets(const uint8_t* pSrc, uint64_t srcSize, uint64_t dstSize,
+	vector<uint64_t>& chunkOffsets) const
+{
+	const auto chunkSize = static_cast<uint64_t>(m_pHeader->ChunkSize);
+	const auto numChunks = static_cast<uint32_t>(XUSG_DIV_UP(dstSize, chunkSize));
+	XUSG_C_RETURN(srcSize / sizeof(uint32_t) < numChunks, false);
+
+	chunkOffsets.resize(numChunks + 1);
+	chunkOffsets[0] = sizeof(uint32_t) * numChunks;
+	for (auto i = 0u; i < numChunks; ++i)
+	{
+		uint32_t storedChunkSize;
+		memcpy(&storedChunkSize, &pSrc[sizeof(uint32_t) * i], sizeof(uint32_t));
+		chunkOffsets[i + 1] = chunkOffsets[i] + storedChunkSize;
+	}
+	XUSG_C_RETURN(chunkOffsets[numChunks] > srcSize, false);
+
+	return true;
+}
+
+bool PakArchive_Impl::setView(const uint8_t* pView, uint64_t viewSize)
+{
+	XUSG_C_RETURN(viewSize < sizeof(Header), false);
+
+	const auto pHeader = reinterpret_cast<const Header*>(pView);
+	XUSG_C_RETURN(pHeader->Magic != MAGIC || pHeader->Version != VERSION, false);
+	XUSG_C_RETURN(pHeader->ChunkSize == 0, false);
+
+	// Validate the directory once, so that the lookups need no bounds checks
+	XUSG_C_RETURN(pHeader->DirectoryOffset % alignof(Entry) != 0, false);
+	XUSG_C_RETURN(pHeader->DirectoryOffset > viewSize ||
+		(viewSize - pHeader->DirectoryOffset) / sizeof(Entry) < pHeader->NumEntries, false);
+	XUSG_C_RETURN(pHeader->NameTableOffset % sizeof(wchar_t) != 0, false);
+	XUSG_C_RETURN(pHeader->NameTableOffset > viewSize ||
+		(viewSize - pHeader->NameTableOffset) / sizeof(wchar_t) < pHeader->NameTableLength, false);
+
+	const auto pEntries = reinterpret_cast<const Entry*>(pView + pHeader->DirectoryOffset);
+	const auto pNameTable = reinterpret_cast<const wchar_t*>(pView + pHeader->NameTableOffset);
+	for (auto i = 0u; i < pHeader->NumEntries; ++i)
+	{
+		const auto& entry = pEntries[i];
+		XUSG_C_RETURN(entry.Offset > viewSize || entry.StoredSize > viewSize - entry.Offset, false);
+		XUSG_C_RETURN(entry.Flags == 0 && entry.StoredSize != entry.Size, false);
+		XUSG_C_RETURN(entry.NameOffset > pHeader->NameTableLength ||
+			entry.NameLength > pHeader->NameTableLength - entry.NameOffset, false);
+		XUSG_C_RETURN(i > 0 && !IsLess(pEntries[i - 1], pNameTable + pEntries[i - 1].NameOffset,
+			entry, pNameTable + entry.NameOffset), false);
+	}
+
+	m_viewSize = viewSize;
+	m_pHeader = pHeader;
+	m_pEntries = pEntries;
+	m_pNameTable = pNameTable;
+
+	return true;
+}
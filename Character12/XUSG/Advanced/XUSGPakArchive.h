@@ -0,0 +1,107 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "XUSGHash.h"
+
+namespace XUSG
+{
+	class PakArchive_Impl :
+		public virtual PakArchive
+	{
+	public:
+		PakArchive_Impl(API api = API::DIRECTX_12);
+		virtual ~PakArchive_Impl();
+
+		bool Open(const wchar_t* fileName, const wchar_t* mountPoint = nullptr);
+		void Close();
+
+		const uint8_t* Find(const wchar_t* filePath, size_t* pSize = nullptr,
+			std::vector<uint8_t>* pBuffer = nullptr) const;
+		bool Contains(const wchar_t* filePath) const;
+
+		bool IsOpen() const;
+		uint32_t GetNumFiles() const;
+
+		bool GetFileSize(const wchar_t* filePath, uint64_t* pSize) const;
+		bool Read(const wchar_t* filePath, uint64_t offset, size_t size, uint8_t* pDst) const;
+
+		static const uint32_t MAGIC = 0x4b415058;	// "XPAK"
+		static const uint32_t VERSION = 3;
+		static const uint32_t DATA_ALIGNMENT = 64;
+		static const uint32_t CHUNK_SIZE = 1 << 18;
+
+		// The file data follow the header; the directory and the name table follow the data
+		struct Header
+		{
+			uint32_t Magic;
+			uint32_t Version;
+			uint32_t NumEntries;
+			uint32_t NameTableLength;	// In characters
+			uint64_t DirectoryOffset;
+			uint64_t NameTableOffset;
+			uint32_t ChunkSize;			// Of the compressed files, before compression
+			uint32_t Reserved;
+		};
+
+		// The file data are stored raw without flags
+		static const uint32_t ENTRY_LZ_CHUNKS = (1 << 0);
+		static const uint32_t ENTRY_INDEX_STREAMS = (1 << 1);
+
+		// Sorted by the hashes, and then the names, of the paths. The LZ chunks of a file start
+		// with their uint32_t sizes, and a chunk is stored raw if its size is the size before
+		// compression. The index streams of a mesh lead its chunks, in which their ranges are
+		// zeroed: a uint64_t count, the IndexStream descriptions, and the encoded streams.
+		struct Entry
+		{
+			uint64_t Hash;
+			uint64_t Offset;
+			uint64_t Size;
+			uint64_t StoredSize;
+			uint32_t Flags;
+			uint32_t Reserved;
+			uint32_t NameOffset;		// In characters
+			uint32_t NameLength;
+		};
+
+		// An index buffer of a mesh file, coded by IndexCodec; sorted by the offsets
+		struct IndexStream
+		{
+			uint64_t Offset;			// In the file
+			uint64_t NumIndices;
+			uint64_t EncodedSize;
+			uint32_t IndexSize;
+			uint32_t Reserved;
+		};
+
+		// Compress the data by chunks in parallel, with the index buffers of a mesh coded apart;
+		// returns the entry flags, or 0 if it saves too little to lose the in-place access
+		static uint32_t Compress(const std::wstring& name, const uint8_t* pData, size_t size,
+			std::vector<uint8_t>& compressed);
+
+	protected:
+		static void compressChunks(const uint8_t* pData, size_t size, std::vector<uint8_t>& compressed);
+
+		const Entry* findEntry(const wchar_t* filePath) const;
+		bool decompress(const Entry& entry, std::vector<uint8_t>& data) const;
+		bool decompressChunks(const uint8_t* pSrc, uint64_t srcSize, uint8_t* pDst, uint64_t dstSize) const;
+		bool readChunks(const uint8_t* pSrc, uint64_t srcSize, uint64_t dstSize,
+			uint64_t offset, size_t size, uint8_t* pDst) const;
+		bool getChunkOffsets(const uint8_t* pSrc, uint64_t srcSize, uint64_t dstSize,
+			std::vector<uint64_t>& chunkOffsets) const;
+		bool setView(const uint8_t* pView, uint64_t viewSize);
+
+		HANDLE			m_hFile;
+		HANDLE			m_hMapping;
+
+		const uint8_t*	m_pView;
+		uint64_t		m_viewSize;
+		const Header*	m_pHeader;
+		const Entry*	m_pEntries;
+		const wchar_t*	m_pNameTable;
+
+		std::wstring	m_mountPoint;
+	};
+}
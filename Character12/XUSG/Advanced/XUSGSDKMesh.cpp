@@ -3,6 +3,7 @@
 //--------------------------------------------------------------------------------------
 
 #include "XUSGSDKMesh.h"
+#include "XUSGFileIndex.h"
 #include "Core/XUSG_DX12.h"
 
 using namespace std;
@@ -52,8 +53,14 @@ PrimitiveTopology SDKMesh::GetPrimitiveType(PrimitiveType primType)
 SDKMesh_Impl::SDKMesh_Impl(API api) :
 	m_api(api),
 	//m_device(nullptr),
+	m_loadFlags(MESH_LOAD_DEFAULT),
 	m_numOutstandingResources(0),
+	m_numOutstandingBuffers(0),
 	m_isLoading(false),
+	m_hadLoadingError(false),
+	m_loadTask(),
+	m_loadThread(),
+	m_loadGroup(ThreadPool::NO_GROUP),
 	m_pStaticMeshData(nullptr),
 	m_heapData(0),
 	m_animation(0),
@@ -69,38 +76,102 @@ SDKMesh_Impl::SDKMesh_Impl(API api) :
 	m_pSubsetArray(nullptr),
 	m_pFrameArray(nullptr),
 	m_pMaterialArray(nullptr),
+	m_vertexBufferKey(),
+	m_indexBufferKey(),
+	m_vertexBufferData(nullptr),
+	m_indexBufferData(nullptr),
+	m_indexBufferViews(0),
+	m_textureGeneration(UINT64_MAX),
 	m_pAdjIndexBufferArray(nullptr),
 	m_pAnimationHeader(nullptr),
 	m_pAnimationFrameData(nullptr),
 	m_bindPoseFrameMatrices(0),
 	m_transformedFrameMatrices(0),
-	m_worldPoseFrameMatrices(0)
+	m_worldPoseFrameMatrices(0),
+	m_cacheStatsBefore(0),
+	m_cacheStatsAfter(0),
+	m_meshlets(0),
+	m_lodSubsets(0),
+	m_lodIndices(0),
+	m_lodErrors(0),
+	m_lodNumVertices(0),
+	m_splitSubsets(0),
+	m_splitSubsetIndices(0)
 {
 }
 
 //--------------------------------------------------------------------------------------
 SDKMesh_Impl::~SDKMesh_Impl()
 {
+	// The loader thread references this object, unless the last reference is released in
+	// the load callback, on the loader thread, where nothing touches this object afterwards
+	if (m_loadTask.valid() && !isOnLoadThread()) ThreadPool::GetDefault().Wait(m_loadTask, m_loadGroup);
 }
 
 //--------------------------------------------------------------------------------------
+void SDKMesh_Impl::SetLoadFlags(MeshLoadFlags flags)
+{
+	m_loadFlags = flags;
+}
+
+MeshLoadFlags SDKMesh_Impl::GetLoadFlags() const
+{
+	return m_loadFlags;
+}
+
 bool SDKMesh_Impl::Create(const Device* pDevice, const wchar_t* fileName,
 	const TextureLib& textureLib, bool isStaticMesh)
 {
-	return createFromFile(pDevice, fileName, textureLib, isStaticMesh);
+	XUSG_C_RETURN(isLoadPending(), false);
+
+	m_numOutstandingResources = 1;
+	m_numOutstandingBuffers = 1;
+
+	return finishLoading(createFromFile(pDevice, fileName, textureLib, isStaticMesh));
 }
 
 bool SDKMesh_Impl::Create(const Device* pDevice, uint8_t* pData,
 	const TextureLib& textureLib, size_t dataBytes,
 	bool isStaticMesh, bool copyStatic)
 {
-	return createFromMemory(pDevice, pData, textureLib, dataBytes, isStaticMesh, copyStatic);
+	XUSG_C_RETURN(isLoadPending(), false);
+
+	m_numOutstandingResources = 1;
+	m_numOutstandingBuffers = 1;
+
+	return finishLoading(createFromMemory(pDevice, pData, textureLib, dataBytes, isStaticMesh, copyStatic));
+}
+
+bool SDKMesh_Impl::CreateAsync(const Device* pDevice, const wchar_t* fileName,
+	const TextureLib& textureLib, bool isStaticMesh, const LoadCallback& callback,
+	const FinishCallback& finish)
+{
+	const wstring filePath = fileName;
+
+	return loadAsync([this, pDevice, filePath, textureLib, isStaticMesh]()
+	{
+		return createFromFile(pDevice, filePath.c_str(), textureLib, isStaticMesh);
+	}, callback, finish);
+}
+
+bool SDKMesh_Impl::WaitForLoad()
+{
+	// The load has finished if waited for in the load callback
+	if (m_loadTask.valid() && !isOnLoadThread()) ThreadPool::GetDefault().Wait(m_loadTask, m_loadGroup);
+
+	return !m_hadLoadingError;
 }
 
 bool SDKMesh_Impl::LoadAnimation(const wchar_t* fileName)
 {
 	wchar_t filePath[MAX_PATH];
 
+	// Read from a mounted archive if it has the file
+	size_t dataBytes;
+	PakArchive::sptr archive;
+	const auto pData = PakArchive::FindMounted(fileName, &dataBytes, &archive);
+	if (pData) return LoadAnimationFromMemory(pData, dataBytes);
+
 	// Find the path for the file
 	wcsncpy_s(filePath, MAX_PATH, fileName, wcslen(fileName));
 
@@ -125,23 +196,98 @@ bool SDKMesh_Impl::LoadAnimation(const wchar_t* fileName)
 
 	fileStream.close();
 
-	// pointer fixup
-	m_pAnimationHeader = reinterpret_cast<AnimationFileHeader*>(m_animation.data());
-	m_pAnimationFrameData = reinterpret_cast<AnimationFrameData*>(m_animation.data() + m_pAnimationHeader->AnimationDataOffset);
+	setupAnimation();
 
-	const auto BaseOffset = sizeof(AnimationFileHeader);
+	return true;
+}
 
-	for (auto i = 0u; i < m_pAnimationHeader->NumFrames; ++i)
+bool SDKMesh_Impl::LoadAnimationFromMemory(const uint8_t* pData, size_t dataBytes)
+{
+	F_RETURN(!pData || dataBytes < sizeof(AnimationFileHeader), cerr, E_INVALIDARG, false);
+
+	const auto pFileHeader = reinterpret_cast<const AnimationFileHeader*>(pData);
+	const auto cBytes = static_cast<size_t>(sizeof(AnimationFileHeader) + pFileHeader->AnimationDataSize);
+	F_RETURN(dataBytes < cBytes, cerr, E_FAIL, false);
+
+	m_animation.assign(pData, pData + cBytes);
+	setupAnimation();
+
+	return true;
+}
+
+bool SDKMesh_Impl::RefreshTextures()
+{
+	XUSG_C_RETURN(isLoadPending() || !m_textureLib || !m_pMaterialArray, false);
+
+	// Nothing has been replaced since the last refresh. The generation is read before the
+	// lookups, so that a change during them is picked up by the next refresh.
+	const auto generation = m_textureLib->GetGeneration();
+	XUSG_C_RETURN(generation == m_textureGeneration, false);
+	m_textureGeneration = generation;
+
+	auto isChanged = false;
+	const auto refreshTexture = [&](const char* textureName, uint64_t& texture64,
+		ShaderResource*& pTexture, uint64_t& alphaMode)
 	{
-		m_pAnimationFrameData[i].pAnimationData = reinterpret_cast<AnimationData*>
-			(m_animation.data() + m_pAnimationFrameData[i].DataOffset + BaseOffset);
+		TextureRecord record;
+		if (textureName[0] == 0 || IsErrorResource(texture64)) return;
+		if (!m_textureLib->Find(m_filePath + textureName, &record) || record.Texture.get() == pTexture) return;
 
-		const auto pFrame = FindFrame(m_pAnimationFrameData[i].FrameName);
+		pTexture = record.Texture.get();
+		alphaMode = record.AlphaMode;
+		isChanged = true;
+	};
 
-		if (pFrame) pFrame->AnimationDataIndex = i;
+	for (auto m = 0u; m < m_pMeshHeader->NumMaterials; ++m)
+	{
+		auto& material = m_pMaterialArray[m];
+		refreshTexture(material.AlbedoTexture, material.Albedo64, material.pAlbedo, material.AlphaModeAlbedo);
+		refreshTexture(material.NormalTexture, material.Normal64, material.pNormal, material.AlphaModeNormal);
+		refreshTexture(material.SpecularTexture, material.Specular64, material.pSpecular, material.AlphaModeSpecular);
 	}
 
-	return true;
+	return isChanged;
+}
+
+uint32_t SDKMesh_Impl::RegisterTextures(TextureStreamer* pStreamer) const
+{
+	XUSG_C_RETURN(!pStreamer || isLoadPending() || !m_pMaterialArray, 0);
+
+	auto numRegistered = 0u;
+	const auto registerTexture = [&](const char* textureName, uint64_t texture64, bool forceSRGB)
+	{
+		if (textureName[0] == 0 || IsErrorResource(texture64)) return;
+		if (pStreamer->Register(m_filePath + textureName, forceSRGB)) ++numRegistered;
+	};
+
+	for (auto m = 0u; m < m_pMeshHeader->NumMaterials; ++m)
+	{
+		const auto& material = m_pMaterialArray[m];
+		registerTexture(material.AlbedoTexture, material.Albedo64, true);
+		registerTexture(material.NormalTexture, material.Normal64, false);
+		registerTexture(material.SpecularTexture, material.Specular64, false);
+	}
+
+	return numRegistered;
+}
+
+void SDKMesh_Impl::RequestTextures(TextureStreamer* pStreamer, float screenSize) const
+{
+	if (!pStreamer || isLoadPending() || !m_pMaterialArray) return;
+
+	const auto requestTexture = [&](const char* textureName, uint64_t texture64)
+	{
+		if (textureName[0] == 0 || IsErrorResource(texture64)) return;
+		pStreamer->Request(m_filePath + textureName, screenSize);
+	};
+
+	for (auto m = 0u; m < m_pMeshHeader->NumMaterials; ++m)
+	{
+		const auto& material = m_pMaterialArray[m];
+		requestTexture(material.AlbedoTexture, material.Albedo64);
+		requestTexture(material.NormalTexture, material.Normal64);
+		requestTexture(material.SpecularTexture, material.Specular64);
+	}
 }
 
 void SDKMesh_Impl::Destroy()
@@ -171,9 +317,25 @@ void SDKMesh_Impl::Destroy()
 	m_bindPoseFrameMatrices.clear();
 	m_transformedFrameMatrices.clear();
 	m_worldPoseFrameMatrices.clear();
+	m_cacheStatsBefore.clear();
+	m_cacheStatsAfter.clear();
+	m_meshlets.clear();
+	m_lodSubsets.clear();
+	m_lodIndices.clear();
+	m_lodErrors.clear();
+	m_lodNumVertices.clear();
+	m_splitSubsets.clear();
+	m_splitSubsetIndices.clear();
+	m_indexBufferViews.clear();
 
 	m_vertices.clear();
 	m_indices.clear();
+	m_vertexLayouts.clear();
+	m_repackedVertices.clear();
+	m_quantizedVertices.clear();
+	m_vertexDequantizations.clear();
+	m_textureArrays.clear();
+	m_materialSlots.clear();
 
 	m_pMeshHeader = nullptr;
 	m_pVertexBufferArray = nullptr;
@@ -250,7 +412,7 @@ const VertexBufferView& SDKMesh_Impl::GetVertexBufferView(uint32_t mesh, uint32_
 
 const IndexBufferView& SDKMesh_Impl::GetIndexBufferView(uint32_t mesh) const
 {
-	return m_indexBuffer->GetIBV(m_pMeshArray[mesh].IndexBuffer);
+	return m_indexBufferViews[m_pMeshArray[mesh].IndexBuffer];
 }
 
 const IndexBufferView& SDKMesh_Impl::GetAdjIndexBufferView(uint32_t mesh) const
@@ -270,7 +432,7 @@ const VertexBufferView& SDKMesh_Impl::GetVertexBufferViewAt(uint32_t vb) const
 
 const IndexBufferView& SDKMesh_Impl::GetIndexBufferViewAt(uint32_t ib) const
 {
-	return m_indexBuffer->GetIBV(ib);
+	return m_indexBufferViews[ib];
 }
 
 //--------------------------------------------------------------------------------------
@@ -348,6 +510,14 @@ SDKMesh::Subset* SDKMesh_Impl::GetSubset(uint32_t mesh, uint32_t subset, SubsetF
 	return &m_pSubsetArray[m_classifiedSubsets[materialType - 1][mesh][subset]];
 }
 
+const SDKMesh::Subset* SDKMesh_Impl::GetLODSubset(uint32_t mesh, uint32_t subset, SubsetFlags materialType, uint32_t lod) const
+{
+	const auto pSubset = GetSubset(mesh, subset, materialType);
+	if (lod == 0 || lod > m_lodSubsets.size()) return pSubset;
+
+	return &m_lodSubsets[lod - 1][pSubset - m_pSubsetArray];
+}
+
 uint32_t SDKMesh_Impl::GetVertexStride(uint32_t mesh, uint32_t i) const
 {
 	return static_cast<uint32_t>(m_pVertexBufferArray[m_pMeshArray[mesh].VertexBuffers[i]].StrideBytes);
@@ -401,8 +571,119 @@ XMVECTOR SDKMesh_Impl::GetMeshBBoxExtents(uint32_t mesh) const
 	return XMLoadFloat3(&m_pMeshArray[mesh].BoundingBoxExtents);
 }
 
+bool SDKMesh_Impl::GetVertexCacheStats(uint32_t mesh, VertexCacheStats* pBefore, VertexCacheStats* pAfter) const
+{
+	// Only available if the mesh is created with MESH_LOAD_OPTIMIZE_VERTEX_CACHE
+	if (mesh >= m_cacheStatsBefore.size()) return false;
+
+	const auto getStats = [](const MeshOptimizer::CacheStats& cacheStats, VertexCacheStats* pStats)
+	{
+		if (!pStats) return;
+		pStats->NumTriangles = cacheStats.NumTriangles;
+		pStats->NumVertices = cacheStats.NumVertices;
+		pStats->NumTransformedVertices = cacheStats.NumTransformedVertices;
+		pStats->ACMR = cacheStats.GetACMR();
+		pStats->ATVR = cacheStats.GetATVR();
+	};
+
+	getStats(m_cacheStatsBefore[mesh], pBefore);
+	getStats(m_cacheStatsAfter[mesh], pAfter);
+
+	return true;
+}
+
+const SDKMesh::MeshletSet* SDKMesh_Impl::GetMeshlets(uint32_t mesh, uint32_t subset) const
+{
+	// Only available if the mesh is created with MESH_LOAD_BUILD_MESHLETS
+	if (mesh >= m_meshlets.size() || subset >= m_meshlets[mesh].size()) return nullptr;
+
+	return &m_meshlets[mesh][subset];
+}
+
+uint32_t SDKMesh_Impl::GetNumLODs() const
+{
+	// Only the full detail, unless the mesh is created with MESH_LOAD_GENERATE_LODS
+	return static_cast<uint32_t>(m_lodSubsets.size()) + 1;
+}
+
+float SDKMesh_Impl::GetLODError(uint32_t lod) const
+{
+	return lod > 0 && lod <= m_lodErrors.size() ? m_lodErrors[lod - 1] : 0.0f;
+}
+
+uint32_t SDKMesh_Impl::SelectLOD(float screenSize, float maxPixelError) const
+{
+	// The coarsest LOD of which the error is below the pixel error on screen
+	for (auto lod = GetNumLODs() - 1; lod > 0; --lod)
+		if (GetLODError(lod) * screenSize <= maxPixelError) return lod;
+
+	return 0;
+}
+
+uint64_t SDKMesh_Impl::GetNumLODVertices(uint32_t mesh, uint32_t lod) const
+{
+	if (lod == 0 || mesh >= m_lodNumVertices.size() || lod > m_lodNumVertices[mesh].size())
+		return GetNumVertices(mesh, 0);
+
+	return m_lodNumVertices[mesh][lod - 1];
+}
+
+bool SDKMesh_Impl::IsVertexQuantized() const
+{
+	return !m_vertexDequantizations.empty();
+}
+
+void SDKMesh_Impl::GetVertexDequantization(uint32_t mesh, XMFLOAT3* pScale, XMFLOAT3* pBias) const
+{
+	assert(IsVertexQuantized());
+	const auto& dequantization = m_vertexDequantizations[m_pMeshArray[mesh].VertexBuffers[0]];
+	if (pScale) *pScale = dequantization.Scale;
+	if (pBias) *pBias = dequantization.Bias;
+}
+
+uint32_t SDKMesh_Impl::GetNumTextureArraySets() const
+{
+	return static_cast<uint32_t>(m_textureArrays.size() / TexturePacker::NUM_CHANNEL);
+}
+
+Texture* SDKMesh_Impl::GetTextureArray(uint32_t set, uint8_t channel) const
+{
+	assert(channel < TexturePacker::NUM_CHANNEL);
+	return m_textureArrays[TexturePacker::NUM_CHANNEL * set + channel].get();
+}
+
+uint32_t SDKMesh_Impl::GetMaterialTextureArraySet(uint32_t material, uint32_t* pSlice) const
+{
+	if (material >= m_materialSlots.size()) return UINT32_MAX;
+	if (pSlice) *pSlice = m_materialSlots[material].Slice;
+
+	return m_materialSlots[material].Set;
+}
+
+bool SDKMesh_Impl::CreateAsync(const Device* pDevice, const wchar_t* fileName,
+	const AsyncFileReader::FileData& fileData, const TextureLib& textureLib,
+	bool isStaticMesh, const LoadCallback& callback, const FinishCallback& finish,
+	ThreadPool::Group readGroup, ThreadPool::Group loadGroup)
+{
+	const wstring filePath = fileName;
+
+	return loadAsync([this, pDevice, filePath, fileData, textureLib, isStaticMesh, readGroup]()
+	{
+		// Help the pool with the reads until the file data are ready
+		ThreadPool::GetDefault().Wait(fileData, readGroup);
+		const auto& pFileData = fileData.get();
+		XUSG_N_RETURN(pFileData, false);
+
+		return createFromFileData(pDevice, filePath.c_str(), *pFileData, textureLib, isStaticMesh);
+	}, callback, finish, loadGroup);
+}
+
 uint32_t SDKMesh_Impl::GetOutstandingResources() const
 {
+	// Nothing is visible before the loader thread has published the mesh
+	const uint32_t numOutstandingResources = m_numOutstandingResources;
+	if (numOutstandingResources > 0) return numOutstandingResources;
+
 	auto outstandingResources = 0u;
 	if (!m_pMeshHeader) return 1;
 
@@ -428,7 +709,8 @@ uint32_t SDKMesh_Impl::GetOutstandingResources() const
 
 uint32_t SDKMesh_Impl::GetOutstandingBufferResources() const
 {
-	uint32_t outstandingResources = 0;
+	const uint32_t outstandingResources = m_numOutstandingBuffers;
+	if (outstandingResources > 0) return outstandingResources;
 	if (!m_pMeshHeader) return 1;
 
 	return outstandingResources;
@@ -436,7 +718,7 @@ uint32_t SDKMesh_Impl::GetOutstandingBufferResources() const
 
 bool SDKMesh_Impl::CheckLoadDone()
 {
-	if (0 == GetOutstandingResources())
+	if (m_hadLoadingError || 0 == GetOutstandingResources())
 	{
 		m_isLoading = false;
 
@@ -448,7 +730,7 @@ bool SDKMesh_Impl::CheckLoadDone()
 
 bool SDKMesh_Impl::IsLoaded() const
 {
-	if (m_pStaticMeshData && !m_isLoading)
+	if (!m_isLoading && 0 == m_numOutstandingResources && !m_hadLoadingError && m_pStaticMeshData)
 	{
 		return true;
 	}
@@ -468,7 +750,7 @@ void SDKMesh_Impl::SetLoading(bool loading)
 
 bool SDKMesh_Impl::HadLoadingError() const
 {
-	return false;
+	return m_hadLoadingError;
 }
 
 //--------------------------------------------------------------------------------------
@@ -528,15 +810,54 @@ bool SDKMesh_Impl::GetAnimationProperties(uint32_t* pNumKeys, float* pFrameTime)
 
 //--------------------------------------------------------------------------------------
 void SDKMesh_Impl::loadMaterials(CommandList* pCommandList, Material* pMaterials,
-	uint32_t numMaterials, vector<Resource::uptr>& uploaders)
+	uint32_t numMaterials, vector<Resource::uptr>& uploaders, vector<Texture::sptr>& discardedTextures)
 {
-	string filePath;
-	wstring filePathW;
-	DDS::Loader textureLoader;
-	DDS::AlphaMode alphaMode;
+	struct TextureFile
+	{
+		string FilePath;
+		uint32_t ID;
+		bool ForceSRGB;
+		bool IsCached;
+		ContentKey ContentKey;
+		TextureRecord Record;
+		vector<uint8_t> Data;
+		const uint8_t* pData;		// In Data, or in the mapping of Archive
+		size_t DataSize;
+		PakArchive::sptr Archive;
+	};
+
+	enum MaterialTextureSlot : uint8_t
+	{
+		ALBEDO_SLOT,
+		NORMAL_SLOT,
+		SPECULAR_SLOT,
+
+		NUM_TEXTURE_SLOT
+	};
 
 	if (!pCommandList) return;
 
+	// Gather the unique texture files of all the materials
+	auto& fileIndex = FileIndex::GetDefault();
+	vector<TextureFile> textureFiles;
+	unordered_map<uint32_t, uint32_t> textureFileIndices;
+	vector<uint32_t> materialTextures(numMaterials * NUM_TEXTURE_SLOT, UINT32_MAX);
+	const auto addTextureFile = [&](const char* textureName, bool forceSRGB)
+	{
+		const auto filePath = m_filePath + textureName;
+		const auto id = m_textureLib->Intern(filePath);
+		const auto result = textureFileIndices.emplace(id, static_cast<uint32_t>(textureFiles.size()));
+		if (result.second)
+		{
+			textureFiles.emplace_back();
+			textureFiles.back().FilePath = filePath;
+			textureFiles.back().ID = id;
+			textureFiles.back().ForceSRGB = forceSRGB;
+		}
+
+		return result.first->second;
+	};
+
 	for (auto m = 0u; m < numMaterials; ++m)
 	{
 		pMaterials[m].pAlbedo = nullptr;
@@ -546,136 +867,357 @@ void SDKMesh_Impl::loadMaterials(CommandList* pCommandList, Material* pMaterials
 		pMaterials[m].AlphaModeNormal = 0;
 		pMaterials[m].AlphaModeSpecular = 0;
 
-		// load textures
-		if (pMaterials[m].AlbedoTexture[0] != 0)
+		if (pMaterials[m].SpecularTexture[0] == 0)
 		{
-			filePath = m_filePath + pMaterials[m].AlbedoTexture;
-			const auto textureIter = m_textureLib->find(filePath);
+			string specularTexture = pMaterials[m].AlbedoTexture;
+			const auto found = specularTexture.rfind('.');
+			if (found != string::npos) specularTexture.replace(found, 1, "S.");
 
-			if (textureIter != m_textureLib->end())
-			{
-				pMaterials[m].pAlbedo = textureIter->second.Texture.get();
-				pMaterials[m].AlphaModeAlbedo = textureIter->second.AlphaMode;
-			}
+			const auto filePath = m_filePath + specularTexture;
+			const wstring filePathW(filePath.cbegin(), filePath.cend());
+			if (PakArchive::ContainsMounted(filePathW.c_str()) || fileIndex.Exists(filePathW))
+				memcpy(pMaterials[m].SpecularTexture, specularTexture.c_str(), specularTexture.length() + 1);
 			else
 			{
-				Texture::sptr texture;
-				uploaders.emplace_back(Resource::MakeUnique(m_api));
-
-				filePathW.assign(filePath.cbegin(), filePath.cend());
-				if (!textureLoader.CreateTextureFromFile(pCommandList, filePathW.c_str(), 8192,
-					true, texture, uploaders.back().get(), &alphaMode, ResourceState::COMMON,
-					MemoryFlag::NONE, m_api))
-					pMaterials[m].Albedo64 = ERROR_RESOURCE_VALUE;
-				else
-				{
-					pMaterials[m].pAlbedo = texture.get();
-					pMaterials[m].AlphaModeAlbedo = alphaMode;
-					(*m_textureLib)[filePath] = { texture, alphaMode };
-				}
+				const char defaultSpecularTexture[] = "default-specularmap.dds";
+				memcpy(pMaterials[m].SpecularTexture, defaultSpecularTexture, sizeof(defaultSpecularTexture));
 			}
 		}
-		if (pMaterials[m].NormalTexture[0] != 0)
-		{
-			filePath = m_filePath + pMaterials[m].NormalTexture;
-			const auto textureIter = m_textureLib->find(filePath);
 
-			if (textureIter != m_textureLib->end())
+		const auto textures = &materialTextures[NUM_TEXTURE_SLOT * m];
+		if (pMaterials[m].AlbedoTexture[0] != 0) textures[ALBEDO_SLOT] = addTextureFile(pMaterials[m].AlbedoTexture, true);
+		if (pMaterials[m].NormalTexture[0] != 0) textures[NORMAL_SLOT] = addTextureFile(pMaterials[m].NormalTexture, false);
+		if (pMaterials[m].SpecularTexture[0] != 0) textures[SPECULAR_SLOT] = addTextureFile(pMaterials[m].SpecularTexture, false);
+	}
+
+	// Look up the texture library
+	vector<uint32_t> missingFiles;
+	for (auto i = 0u; i < textureFiles.size(); ++i)
+	{
+		auto& textureFile = textureFiles[i];
+		textureFile.IsCached = m_textureLib->Find(textureFile.ID, &textureFile.Record);
+		if (!textureFile.IsCached) missingFiles.emplace_back(i);
+	}
+
+	// The files in the mounted archives are used in place, and the other existing files are
+	// read in a batch with many reads in flight
+	vector<uint32_t> mountedFiles;
+	vector<uint32_t> diskFiles;
+	vector<wstring> diskFileNames;
+	for (const auto& i : missingFiles)
+	{
+		auto& textureFile = textureFiles[i];
+		const wstring filePathW(textureFile.FilePath.cbegin(), textureFile.FilePath.cend());
+		textureFile.pData = PakArchive::FindMounted(filePathW.c_str(), &textureFile.DataSize, &textureFile.Archive);
+		textureFile.ContentKey = {};
+		if (textureFile.pData) mountedFiles.emplace_back(i);
+		else
+		{
+			textureFile.DataSize = 0;
+			if (fileIndex.Exists(filePathW))
 			{
-				pMaterials[m].pNormal = textureIter->second.Texture.get();
-				pMaterials[m].AlphaModeNormal = textureIter->second.AlphaMode;
+				diskFiles.emplace_back(i);
+				diskFileNames.emplace_back(filePathW);
 			}
+		}
+	}
+
+	// Process each texture file as soon as its data are available
+	const size_t maxTextureSize = 8192;
+	const auto isContentHashing = m_textureLib->IsContentHashing();
+	const auto processTextureFile = [&](TextureFile& textureFile)
+	{
+		// Complete the mip chains before the upload
+		vector<uint8_t> ddsData;
+		if ((m_loadFlags & MESH_LOAD_GENERATE_MIPS) && textureFile.DataSize > 0 &&
+			DDS::Loader::GenerateMipmaps(textureFile.pData, textureFile.DataSize, DDS::MIP_FILTER_KAISER, ddsData))
+		{
+			textureFile.Data.swap(ddsData);
+			textureFile.pData = textureFile.Data.data();
+			textureFile.DataSize = textureFile.Data.size();
+			textureFile.Archive.reset();
+		}
+
+		// Hash the content to upload, seeded by the sRGB view that it is created with
+		if (isContentHashing && textureFile.DataSize > 0)
+			textureFile.ContentKey = TextureLibrary::HashContent(textureFile.pData,
+				textureFile.DataSize, textureFile.ForceSRGB ? 1 : 0);
+	};
+
+	// Read the headers of the disk files in a batch, and then only the surface data of the mips
+	// within the size limit in another, as DDS::Loader::LoadTextureData() reads a single file
+	struct DiskRead
+	{
+		size_t HeaderSize;
+		atomic<uint32_t> NumPendingRanges;
+		atomic_bool HadError;
+	};
+
+	const auto numDiskFiles = static_cast<uint32_t>(diskFiles.size());
+	vector<DiskRead> diskReads(numDiskFiles);
+	vector<vector<DDS::Loader::DataRange>> dataRanges(numDiskFiles);
+	vector<AsyncFileReader::FileRange> fileRanges(numDiskFiles);
+	for (auto i = 0u; i < numDiskFiles; ++i) fileRanges[i] = { diskFileNames[i], 0, DDS::Loader::MAX_HEADER_SIZE };
+
+	AsyncFileReader::GetDefault().ReadFileRanges(fileRanges.data(), numDiskFiles,
+		[&](uint32_t i, vector<uint8_t>& data, bool)
+	{
+		// The headers are rewritten to describe the kept mips, and followed by their data
+		auto& textureFile = textureFiles[diskFiles[i]];
+		uint64_t fileSize;
+		const auto succeeded = !data.empty() && fileIndex.GetSize(diskFileNames[i], fileSize) &&
+			DDS::Loader::GetTextureDataRanges(data.data(), data.size(), fileSize, maxTextureSize,
+				textureFile.Data, dataRanges[i]);
+
+		if (!succeeded) dataRanges[i].clear();
+
+		auto dataSize = textureFile.Data.size();
+		diskReads[i].HeaderSize = dataSize;
+		for (const auto& range : dataRanges[i]) dataSize += range.Size;
+		textureFile.Data.resize(dataSize);
+		diskReads[i].HadError = !succeeded;
+	});
+
+	const auto finishDiskFile = [&](uint32_t i)
+	{
+		// The data are empty if any read failed
+		auto& textureFile = textureFiles[diskFiles[i]];
+		if (diskReads[i].HadError) vector<uint8_t>().swap(textureFile.Data);
+		textureFile.pData = textureFile.Data.data();
+		textureFile.DataSize = textureFile.Data.size();
+		processTextureFile(textureFile);
+	};
+
+	// The ranges of a file are copied after its headers in order
+	vector<pair<uint32_t, size_t>> rangeTargets;
+	fileRanges.clear();
+	for (auto i = 0u; i < numDiskFiles; ++i)
+	{
+		const auto& ranges = dataRanges[i];
+		auto dataOffset = diskReads[i].HeaderSize;
+		for (const auto& range : ranges)
+		{
+			fileRanges.push_back({ diskFileNames[i], range.Offset, range.Size });
+			rangeTargets.emplace_back(i, dataOffset);
+			dataOffset += range.Size;
+		}
+
+		diskReads[i].NumPendingRanges = static_cast<uint32_t>(ranges.size());
+		if (ranges.empty()) finishDiskFile(i);
+	}
+
+	AsyncFileReader::GetDefault().ReadFileRanges(fileRanges.data(), static_cast<uint32_t>(fileRanges.size()),
+		[&](uint32_t r, vector<uint8_t>& data, bool)
+	{
+		// The data are short if the read failed, or if the file has changed since the headers
+		const auto i = rangeTargets[r].first;
+		auto& textureFile = textureFiles[diskFiles[i]];
+		if (data.size() == fileRanges[r].Size) memcpy(&textureFile.Data[rangeTargets[r].second], data.data(), data.size());
+		else diskReads[i].HadError = true;
+
+		if (--diskReads[i].NumPendingRanges == 0) finishDiskFile(i);
+	});
+
+	ThreadPool::GetDefault().ParallelFor(static_cast<uint32_t>(mountedFiles.size()), [&](uint32_t i)
+	{
+		processTextureFile(textureFiles[mountedFiles[i]]);
+	});
+
+	// Create the textures; command lists can only be recorded on a single thread
+	DDS::Loader textureLoader;
+	for (const auto& i : missingFiles)
+	{
+		auto& textureFile = textureFiles[i];
+		if (textureFile.DataSize == 0) continue;
+
+		// Share the texture of a byte-identical file under another path
+		TextureRecord record;
+		if (isContentHashing && m_textureLib->FindContent(textureFile.ContentKey, &record))
+		{
+			textureFile.Record = m_textureLib->Insert(textureFile.ID, record);
+			textureFile.IsCached = true;
+			textureFile.Data.clear();
+			textureFile.Data.shrink_to_fit();
+			textureFile.Archive.reset();
+			continue;
+		}
+
+		// Another mesh may have loaded the same texture meanwhile
+		if (m_textureLib->Find(textureFile.ID, &textureFile.Record))
+		{
+			textureFile.IsCached = true;
+			textureFile.Data.clear();
+			textureFile.Data.shrink_to_fit();
+			textureFile.Archive.reset();
+			continue;
+		}
+
+		Texture::sptr texture;
+		DDS::AlphaMode alphaMode;
+		uploaders.emplace_back(Resource::MakeUnique(m_api));
+		if (textureLoader.CreateTextureFromMemory(pCommandList, textureFile.pData, textureFile.DataSize,
+			maxTextureSize, textureFile.ForceSRGB, texture, uploaders.back().get(), &alphaMode, ResourceState::COMMON,
+			MemoryFlag::NONE, m_api))
+		{
+			// If another mesh has inserted it since the lookup above, its record is kept, and the
+			// texture recorded here is retained until the upload commands have been executed
+			textureFile.Record = m_textureLib->Insert(textureFile.ID, { texture, alphaMode });
+			textureFile.IsCached = true;
+			if (textureFile.Record.Texture != texture) discardedTextures.emplace_back(texture);
+			if (isContentHashing) m_textureLib->InsertContent(textureFile.ContentKey, textureFile.ID);
+		}
+
+		textureFile.Data.clear();
+		textureFile.Data.shrink_to_fit();
+		textureFile.Archive.reset();
+	}
+
+	// Assign the textures to the materials
+	for (auto m = 0u; m < numMaterials; ++m)
+	{
+		const auto textures = &materialTextures[NUM_TEXTURE_SLOT * m];
+
+		if (textures[ALBEDO_SLOT] != UINT32_MAX)
+		{
+			const auto& textureFile = textureFiles[textures[ALBEDO_SLOT]];
+			if (!textureFile.IsCached) pMaterials[m].Albedo64 = ERROR_RESOURCE_VALUE;
 			else
 			{
-				Texture::sptr texture;
-				uploaders.emplace_back(Resource::MakeUnique(m_api));
-
-				filePathW.assign(filePath.cbegin(), filePath.cend());
-				if (!textureLoader.CreateTextureFromFile(pCommandList, filePathW.c_str(), 8192,
-					false, texture, uploaders.back().get(), &alphaMode, ResourceState::COMMON,
-					MemoryFlag::NONE, m_api))
-					pMaterials[m].Normal64 = ERROR_RESOURCE_VALUE;
-				else
-				{
-					pMaterials[m].pNormal = texture.get();
-					pMaterials[m].AlphaModeNormal = alphaMode;
-					(*m_textureLib)[filePath] = { texture, alphaMode };
-				}
+				pMaterials[m].pAlbedo = textureFile.Record.Texture.get();
+				pMaterials[m].AlphaModeAlbedo = textureFile.Record.AlphaMode;
 			}
 		}
-		if (pMaterials[m].SpecularTexture[0] == 0)
-		{
-			string specularTexture = pMaterials[m].AlbedoTexture;
-			const auto found = specularTexture.rfind('.');
-			if (found != string::npos) specularTexture.replace(found, 1, "S.");
 
-			filePath = m_filePath + specularTexture;
-			ifstream fileStream(filePath, ios::in | ios::binary);
-			if (fileStream)
+		if (textures[NORMAL_SLOT] != UINT32_MAX)
+		{
+			const auto& textureFile = textureFiles[textures[NORMAL_SLOT]];
+			if (!textureFile.IsCached) pMaterials[m].Normal64 = ERROR_RESOURCE_VALUE;
+			else
 			{
-				fileStream.close();
-				memcpy(pMaterials[m].SpecularTexture, specularTexture.c_str(), specularTexture.length() + 1);
+				pMaterials[m].pNormal = textureFile.Record.Texture.get();
+				pMaterials[m].AlphaModeNormal = textureFile.Record.AlphaMode;
 			}
+		}
+
+		if (textures[SPECULAR_SLOT] != UINT32_MAX)
+		{
+			const auto& textureFile = textureFiles[textures[SPECULAR_SLOT]];
+			if (!textureFile.IsCached) pMaterials[m].Specular64 = ERROR_RESOURCE_VALUE;
 			else
 			{
-				const char defaultSpecularTexture[] = "default-specularmap.dds";
-				memcpy(pMaterials[m].SpecularTexture, defaultSpecularTexture, sizeof(defaultSpecularTexture));
+				pMaterials[m].pSpecular = textureFile.Record.Texture.get();
+				pMaterials[m].AlphaModeSpecular = textureFile.Record.AlphaMode;
 			}
 		}
-		if (pMaterials[m].SpecularTexture[0] != 0)
+	}
+}
+
+void SDKMesh_Impl::packTextures(CommandList* pCommandList)
+{
+	// Describe the albedo, normal and specular textures of each material; the missing and the
+	// failed ones leave the material unpacked
+	const auto numMaterials = m_pMeshHeader->NumMaterials;
+	vector<TexturePacker::TextureDesc> textureDescs(TexturePacker::NUM_CHANNEL * numMaterials);
+	for (auto m = 0u; m < numMaterials; ++m)
+	{
+		const auto& material = m_pMaterialArray[m];
+		const Texture* pTextures[] =
 		{
-			filePath = m_filePath + pMaterials[m].SpecularTexture;
-			const auto textureIter = m_textureLib->find(filePath);
+			IsErrorResource(material.Albedo64) ? nullptr : dynamic_cast<const Texture*>(material.pAlbedo),
+			IsErrorResource(material.Normal64) ? nullptr : dynamic_cast<const Texture*>(material.pNormal),
+			IsErrorResource(material.Specular64) ? nullptr : dynamic_cast<const Texture*>(material.pSpecular)
+		};
 
-			if (textureIter != m_textureLib->end())
+		for (uint8_t c = 0; c < TexturePacker::NUM_CHANNEL; ++c)
+		{
+			auto& desc = textureDescs[TexturePacker::NUM_CHANNEL * m + c];
+			desc = {};
+			if (pTextures[c])
 			{
-				pMaterials[m].pSpecular = textureIter->second.Texture.get();
-				pMaterials[m].AlphaModeSpecular = textureIter->second.AlphaMode;
+				desc.pTexture = pTextures[c];
+				desc.Format = pTextures[c]->GetFormat();
+				desc.Width = static_cast<uint32_t>(pTextures[c]->GetWidth());
+				desc.Height = pTextures[c]->GetHeight();
+				desc.ArraySize = pTextures[c]->GetArraySize();
+				desc.NumMips = pTextures[c]->GetNumMips();
 			}
-			else
+		}
+	}
+
+	vector<TexturePacker::ArraySet> arraySets;
+	vector<TexturePacker::Slot> materialSlots;
+	if (!TexturePacker::Pack(textureDescs.data(), numMaterials, arraySets, materialSlots)) return;
+
+	// Create all the arrays before recording any copies, so that a failure leaves no copies
+	// to the released arrays. The arrays of a single slice get two, since a single texture is
+	// viewed as a non-array texture.
+	const auto pDevice = pCommandList->GetDevice();
+	vector<Texture::sptr> textureArrays(TexturePacker::NUM_CHANNEL * arraySets.size());
+	for (auto s = 0u; s < arraySets.size(); ++s)
+	{
+		const auto numSlices = static_cast<uint16_t>((max)(arraySets[s].GetNumSlices(), 2u));
+		for (uint8_t c = 0; c < TexturePacker::NUM_CHANNEL; ++c)
+		{
+			const auto& desc = arraySets[s].Descs[c];
+			auto& textureArray = textureArrays[TexturePacker::NUM_CHANNEL * s + c];
+			textureArray = Texture::MakeShared(m_api);
+			if (!textureArray->Create(pDevice, desc.Width, desc.Height, desc.Format, numSlices,
+				ResourceFlag::NONE, desc.NumMips, 1, false, MemoryFlag::NONE,
+				m_name.empty() ? nullptr : (m_name + L".TextureArray").c_str())) return;
+		}
+	}
+
+	// Copy the textures into the slices of the arrays. The sources are in the common state
+	// after their uploads, so they are promoted to the copy source implicitly.
+	for (auto s = 0u; s < arraySets.size(); ++s)
+	{
+		const auto& arraySet = arraySets[s];
+		for (uint8_t c = 0; c < TexturePacker::NUM_CHANNEL; ++c)
+		{
+			const auto& desc = arraySet.Descs[c];
+			const auto& textureArray = textureArrays[TexturePacker::NUM_CHANNEL * s + c];
+
+			ResourceBarrier barrier;
+			auto numBarriers = textureArray->SetBarrier(&barrier, ResourceState::COPY_DEST);
+			pCommandList->Barrier(numBarriers, &barrier);
+
+			for (auto i = 0u; i < arraySet.GetNumSlices(); ++i)
 			{
-				Texture::sptr texture;
-				uploaders.emplace_back(Resource::MakeUnique(m_api));
-
-				filePathW.assign(filePath.cbegin(), filePath.cend());
-				if (!textureLoader.CreateTextureFromFile(pCommandList, filePathW.c_str(), 8192,
-					false, texture, uploaders.back().get(), nullptr, ResourceState::COMMON,
-					MemoryFlag::NONE, m_api))
-					pMaterials[m].Specular64 = ERROR_RESOURCE_VALUE;
-				else
-				{
-					pMaterials[m].pSpecular = texture.get();
-					pMaterials[m].AlphaModeNormal = alphaMode;
-					(*m_textureLib)[filePath] = { texture, alphaMode };
-				}
+				const auto pSrc = static_cast<const Texture*>(arraySet.Slices[TexturePacker::NUM_CHANNEL * i + c]);
+				for (uint8_t mip = 0; mip < desc.NumMips; ++mip)
+					pCommandList->CopyTextureRegion(TextureCopyLocation(textureArray.get(),
+						textureArray->CalculateSubresource(mip, i)), 0, 0, 0,
+						TextureCopyLocation(pSrc, pSrc->CalculateSubresource(mip)));
 			}
+
+			numBarriers = textureArray->SetBarrier(&barrier, ResourceState::COMMON);
+			pCommandList->Barrier(numBarriers, &barrier);
 		}
 	}
+
+	m_textureArrays.swap(textureArrays);
+	m_materialSlots.swap(materialSlots);
 }
 
 bool SDKMesh_Impl::createVertexBuffer(CommandList* pCommandList, std::vector<Resource::uptr>& uploaders)
 {
-	// Vertex buffer info
+	// Vertex buffer info; the views of one buffer share its stride, so mixed strides are rejected
 	size_t numVertices = 0;
-	const auto byteStride = static_cast<uint32_t>(m_pVertexBufferArray->StrideBytes);
+	const auto srcStride = static_cast<uint32_t>(m_pVertexBufferArray->StrideBytes);
+	const auto isQuantized = !m_quantizedVertices.empty();
+	const auto byteStride = isQuantized ? static_cast<uint32_t>(sizeof(VertexQuantizer::QuantizedVertex)) : srcStride;
 	vector<uintptr_t> firstVertices(m_pMeshHeader->NumVertexBuffers);
 
 	for (auto i = 0u; i < m_pMeshHeader->NumVertexBuffers; ++i)
 	{
+		F_RETURN(m_pVertexBufferArray[i].StrideBytes != srcStride, cerr, E_INVALIDARG, false);
 		firstVertices[i] = numVertices;
-		numVertices += static_cast<size_t>(m_pVertexBufferArray[i].SizeBytes / byteStride);
+		numVertices += static_cast<size_t>(m_pVertexBufferArray[i].SizeBytes / srcStride);
 	}
 
-	// Create a vertex Buffer
-	m_vertexBuffer = VertexBuffer::MakeShared(m_api);
-	XUSG_N_RETURN(m_vertexBuffer->Create(pCommandList->GetDevice(), numVertices, byteStride, ResourceFlag::NONE,
-		MemoryType::DEFAULT, m_pMeshHeader->NumVertexBuffers, firstVertices.data(),
-		m_pMeshHeader->NumVertexBuffers, firstVertices.data(), 1, nullptr, MemoryFlag::NONE,
-		m_name.empty() ? nullptr : (m_name + L".VertexBuffer").c_str()), false);
-
 	// Copy vertices into one buffer
 	size_t offset = 0;
-	vector<uint8_t> bufferData(byteStride * numVertices);
+	vector<uint8_t> bufferData(srcStride * numVertices);
 
 	for (auto i = 0u; i < m_pMeshHeader->NumVertexBuffers; ++i)
 	{
@@ -684,65 +1226,147 @@ bool SDKMesh_Impl::createVertexBuffer(CommandList* pCommandList, std::vector<Res
 		offset += sizeBytes;
 	}
 
-	// Upload vertices
-	uploaders.emplace_back(Resource::MakeUnique(m_api));
-
-	return m_vertexBuffer->Upload(pCommandList, uploaders.back().get(), bufferData.data(), bufferData.size());
-}
-
-bool SDKMesh_Impl::createIndexBuffer(CommandList* pCommandList, std::vector<Resource::uptr>& uploaders)
-{
-	// Index buffer info
-	size_t byteWidth = 0;
-	vector<uintptr_t> offsets(m_pMeshHeader->NumIndexBuffers);
-
-	for (auto i = 0u; i < m_pMeshHeader->NumIndexBuffers; ++i)
+	// Share the vertex buffer of identical content loaded before; the quantized buffers are
+	// keyed by their source vertices with the quantized stride
+	if (m_loadFlags & MESH_LOAD_SHARE_BUFFERS)
 	{
-		offsets[i] = byteWidth;
-		byteWidth += static_cast<size_t>(m_pIndexBufferArray[i].SizeBytes);
+		m_vertexBufferKey = GeometryCache::GetKey(bufferData.data(), bufferData.size(),
+			m_pMeshHeader->NumVertexBuffers, firstVertices.data(), byteStride);
+		m_vertexBuffer = GeometryCache::GetDefault().FindVertexBuffer(m_vertexBufferKey,
+			bufferData.data(), bufferData.size());
+		if (m_vertexBuffer)
+		{
+			m_quantizedVertices.clear();
+			return true;
+		}
 	}
 
-	// Create a index Buffer
-	m_indexBuffer = IndexBuffer::MakeShared(m_api);
-	XUSG_N_RETURN(m_indexBuffer->Create(pCommandList->GetDevice(), byteWidth, m_pIndexBufferArray->IndexType == IT_32BIT ?
-		Format::R32_UINT : Format::R16_UINT, ResourceFlag::DENY_SHADER_RESOURCE, MemoryType::DEFAULT,
-		m_pMeshHeader->NumIndexBuffers, offsets.data(), 1, nullptr, 1, nullptr, MemoryFlag::NONE,
-		m_name.empty() ? nullptr : (m_name + L".IndexBuffer").c_str()), false);
+	// Copy the quantized vertices into the buffer to upload instead
+	vector<uint8_t> quantizedData;
+	if (isQuantized)
+	{
+		offset = 0;
+		quantizedData.resize(byteStride * numVertices);
+		for (const auto& vertices : m_quantizedVertices)
+		{
+			const auto sizeBytes = sizeof(VertexQuantizer::QuantizedVertex) * vertices.size();
+			memcpy(&quantizedData[offset], vertices.data(), sizeBytes);
+			offset += sizeBytes;
+		}
+		m_quantizedVertices.clear();
+	}
+	const auto& uploadData = isQuantized ? quantizedData : bufferData;
+
+	// Create a vertex Buffer
+	m_vertexBuffer = VertexBuffer::MakeShared(m_api);
+	XUSG_N_RETURN(m_vertexBuffer->Create(pCommandList->GetDevice(), numVertices, byteStride, ResourceFlag::NONE,
+		MemoryType::DEFAULT, m_pMeshHeader->NumVertexBuffers, firstVertices.data(),
+		m_pMeshHeader->NumVertexBuffers, firstVertices.data(), 1, nullptr, MemoryFlag::NONE,
+		m_name.empty() ? nullptr : (m_name + L".VertexBuffer").c_str()), false);
+
+	// Upload vertices
+	uploaders.emplace_back(Resource::MakeUnique(m_api));
+
+	XUSG_N_RETURN(m_vertexBuffer->Upload(pCommandList, uploaders.back().get(), uploadData.data(), uploadData.size()), false);
+
+	// Keep the source bytes to compare with the meshes loaded later
+	if (m_loadFlags & MESH_LOAD_SHARE_BUFFERS)
+		m_vertexBufferData = make_shared<vector<uint8_t>>(move(bufferData));
+
+	return true;
+}
+
+bool SDKMesh_Impl::createIndexBuffer(CommandList* pCommandList, std::vector<Resource::uptr>& uploaders)
+{
+	// Index buffer info, with the index buffers aligned to 32 bits as their formats may differ
+	size_t byteWidth = 0;
+	const auto numIndexBuffers = m_pMeshHeader->NumIndexBuffers;
+	vector<uintptr_t> offsets(numIndexBuffers);
+	vector<uint32_t> sizes(numIndexBuffers);
+
+	for (auto i = 0u; i < numIndexBuffers; ++i)
+	{
+		offsets[i] = byteWidth;
+		sizes[i] = static_cast<uint32_t>(m_pIndexBufferArray[i].SizeBytes);
+		if (i < m_lodIndices.size()) sizes[i] += static_cast<uint32_t>(m_lodIndices[i].size());
+		byteWidth += XUSG_DIV_UP(sizes[i], 4) * 4;
+	}
 
 	// Copy indices into one buffer
-	size_t offset = 0;
 	vector<uint8_t> bufferData(byteWidth);
 
-	for (auto i = 0u; i < m_pMeshHeader->NumVertexBuffers; ++i)
+	for (auto i = 0u; i < numIndexBuffers; ++i)
 	{
 		const auto sizeBytes = static_cast<size_t>(m_pIndexBufferArray[i].SizeBytes);
-		memcpy(&bufferData[offset], m_indices[i], sizeBytes);
-		offset += sizeBytes;
+		memcpy(&bufferData[offsets[i]], m_indices[i], sizeBytes);
+
+		// LOD indices follow the indices of each index buffer
+		if (i < m_lodIndices.size() && !m_lodIndices[i].empty())
+			memcpy(&bufferData[offsets[i] + sizeBytes], m_lodIndices[i].data(), m_lodIndices[i].size());
+	}
+
+	// Share the index buffer of identical content loaded before
+	auto isShared = false;
+	if (m_loadFlags & MESH_LOAD_SHARE_BUFFERS)
+	{
+		m_indexBufferKey = GeometryCache::GetKey(bufferData.data(), bufferData.size(), numIndexBuffers, offsets.data());
+		m_indexBuffer = GeometryCache::GetDefault().FindIndexBuffer(m_indexBufferKey,
+			bufferData.data(), bufferData.size());
+		isShared = m_indexBuffer != nullptr;
 	}
 
+	// Create a index Buffer
+	if (!isShared)
+	{
+		m_indexBuffer = IndexBuffer::MakeShared(m_api);
+		XUSG_N_RETURN(m_indexBuffer->Create(pCommandList->GetDevice(), byteWidth, Format::R32_UINT,
+			ResourceFlag::DENY_SHADER_RESOURCE, MemoryType::DEFAULT, 1, nullptr, 1, nullptr, 1, nullptr,
+			MemoryFlag::NONE, m_name.empty() ? nullptr : (m_name + L".IndexBuffer").c_str()), false);
+	}
+
+	// Create the views with the index format of each index buffer
+	m_indexBufferViews.resize(numIndexBuffers);
+	for (auto i = 0u; i < numIndexBuffers; ++i)
+		m_indexBuffer->CreateIBV(m_indexBufferViews[i], m_pIndexBufferArray[i].IndexType == IT_32BIT ?
+			Format::R32_UINT : Format::R16_UINT, sizes[i], offsets[i]);
+	if (isShared) return true;
+
 	// Upload indices
 	uploaders.emplace_back(Resource::MakeUnique(m_api));
 
-	return m_indexBuffer->Upload(pCommandList, uploaders.back().get(), bufferData.data(), bufferData.size());
+	XUSG_N_RETURN(m_indexBuffer->Upload(pCommandList, uploaders.back().get(), bufferData.data(), bufferData.size()), false);
+
+	// Keep the uploaded bytes to compare with the meshes loaded later
+	if (m_loadFlags & MESH_LOAD_SHARE_BUFFERS)
+		m_indexBufferData = make_shared<vector<uint8_t>>(move(bufferData));
+
+	return true;
 }
 
 //--------------------------------------------------------------------------------------
 bool SDKMesh_Impl::createFromFile(const Device* pDevice, const wchar_t* fileName,
 	const TextureLib& textureLib, bool isStaticMesh)
 {
-	// Find the path for the file
-	m_filePathW = fileName;
+	// Look up the mounted archives before opening the file. The mesh data are modified in
+	// place, so they are copied, or decompressed straight, into the heap data once.
+	const auto isMounted = PakArchive::ReadMounted(fileName, m_heapData);
+	ifstream fileStream;
+	if (!isMounted)
+	{
+		fileStream.open(fileName, ios::in | ios::binary);
+		F_RETURN(!fileStream, cerr, MAKE_HRESULT(SEVERITY_ERROR, FACILITY_ITF, 0x0903), false);
+	}
 
-	// Open the file
-	ifstream fileStream(m_filePathW, ios::in | ios::binary);
-	F_RETURN(!fileStream, cerr, MAKE_HRESULT(SEVERITY_ERROR, FACILITY_ITF, 0x0903), false);
+	setFilePath(fileName);
+	if (isMounted)
+	{
+		m_pStaticMeshData = m_heapData.data();
 
-	// Change the path to just the directory
-	const auto found = m_filePathW.find_last_of(L"/\\");
-	m_name = m_filePathW.substr(found + 1);
-	m_filePathW = m_filePathW.substr(0, found + 1);
-	m_filePath.resize(m_filePathW.size());
-	for (size_t i = 0; i < m_filePath.size(); ++i) m_filePath[i] = static_cast<char>(m_filePathW[i]);
+		return createFromMemory(pDevice, m_pStaticMeshData, textureLib, m_heapData.size(), isStaticMesh, false);
+	}
+
+	// List the asset folder while the mesh file is being read
+	FileIndex::GetDefault().Prefetch(m_filePathW);
 
 	// Get the file size
 	F_RETURN(!fileStream.seekg(0, fileStream.end), fileStream.close(); cerr, E_FAIL, false);
@@ -761,6 +1385,21 @@ bool SDKMesh_Impl::createFromFile(const Device* pDevice, const wchar_t* fileName
 	return createFromMemory(pDevice, m_pStaticMeshData, textureLib, cBytes, isStaticMesh, false);
 }
 
+bool SDKMesh_Impl::createFromFileData(const Device* pDevice, const wchar_t* fileName,
+	vector<uint8_t>& fileData, const TextureLib& textureLib, bool isStaticMesh)
+{
+	setFilePath(fileName);
+
+	// List the asset folder for the textures, unless the file is in a mounted archive
+	if (!PakArchive::ContainsMounted(fileName)) FileIndex::GetDefault().Prefetch(m_filePathW);
+
+	// The mesh data are modified in place
+	m_heapData = move(fileData);
+	m_pStaticMeshData = m_heapData.data();
+
+	return createFromMemory(pDevice, m_pStaticMeshData, textureLib, m_heapData.size(), isStaticMesh, false);
+}
+
 bool SDKMesh_Impl::createFromMemory(const Device* pDevice, uint8_t* pData,
 	const TextureLib& textureLib, size_t dataBytes,
 	bool isStaticMesh, bool copyStatic)
@@ -780,9 +1419,6 @@ bool SDKMesh_Impl::createFromMemory(const Device* pDevice, uint8_t* pData,
 
 	F_RETURN(dataBytes < sizeof(Header), cerr, E_FAIL, false);
 
-	// Set outstanding resources to zero
-	m_numOutstandingResources = 0;
-
 	if (copyStatic)
 	{
 		const auto pHeader = reinterpret_cast<Header*>(pData);
@@ -816,22 +1452,40 @@ bool SDKMesh_Impl::createFromMemory(const Device* pDevice, uint8_t* pData,
 	// error condition
 	F_RETURN(m_pMeshHeader->Version != SDKMESH_FILE_VERSION, cerr, E_NOINTERFACE, false);
 
-	// Create VBs
+	// Create VBs, and decode their vertex declarations once
 	m_vertices.resize(m_pMeshHeader->NumVertexBuffers);
+	m_vertexLayouts.resize(m_pMeshHeader->NumVertexBuffers);
 	for (auto i = 0u; i < m_pMeshHeader->NumVertexBuffers; ++i)
-		m_vertices[i] = reinterpret_cast<uint8_t*>(pData + m_pVertexBufferArray[i].DataOffset);
+	{
+		const auto& vbHeader = m_pVertexBufferArray[i];
+		m_vertices[i] = reinterpret_cast<uint8_t*>(pData + vbHeader.DataOffset);
+		m_vertexLayouts[i].Decode(vbHeader.Decl, MAX_VERTEX_ELEMENTS, static_cast<uint32_t>(vbHeader.StrideBytes));
+	}
 
 	// Create IBs
 	m_indices.resize(m_pMeshHeader->NumIndexBuffers);
 	for (auto i = 0u; i < m_pMeshHeader->NumIndexBuffers; ++i)
 		m_indices[i] = reinterpret_cast<uint8_t*>(pData + m_pIndexBufferArray[i].DataOffset);
 
-	// Uploader buffers
+	// Uploader buffers, and the textures recorded but superseded in the library
 	vector<Resource::uptr> uploaders;
+	vector<Texture::sptr> discardedTextures;
 
 	// Load Materials
 	m_textureLib = textureLib;
-	if (pDevice) loadMaterials(pCommandList, m_pMaterialArray, m_pMeshHeader->NumMaterials, uploaders);
+	m_textureGeneration = UINT64_MAX;
+	if (pDevice) loadMaterials(pCommandList, m_pMaterialArray, m_pMeshHeader->NumMaterials, uploaders, discardedTextures);
+
+	// Copy the material textures into texture arrays
+	if (pDevice && (m_loadFlags & MESH_LOAD_PACK_TEXTURES)) packTextures(pCommandList);
+
+	// Textures and buffers are outstanding until the GPU has finished uploading them
+	auto numOutstandingResources = 2u;
+	for (auto i = 0u; i < m_pMeshHeader->NumMaterials; ++i)
+		numOutstandingResources += (m_pMaterialArray[i].pAlbedo ? 1 : 0) +
+		(m_pMaterialArray[i].pNormal ? 1 : 0) + (m_pMaterialArray[i].pSpecular ? 1 : 0);
+	m_numOutstandingBuffers = 2;
+	m_numOutstandingResources = numOutstandingResources;
 
 	// Create a place to store our bind pose frame matrices
 	m_bindPoseFrameMatrices.resize(m_pMeshHeader->NumFrames);
@@ -840,22 +1494,42 @@ bool SDKMesh_Impl::createFromMemory(const Device* pDevice, uint8_t* pData,
 	m_transformedFrameMatrices.resize(m_pMeshHeader->NumFrames);
 	m_worldPoseFrameMatrices.resize(m_pMeshHeader->NumFrames);
 
+	// Repack the skinned vertices of other layouts for skinning; static meshes are drawn as they are
+	if (!isStaticMesh && (m_loadFlags & MESH_LOAD_REPACK_VERTICES)) repackVertices();
+
 	// Process as a static mesh
 	if (isStaticMesh) createAsStaticMesh();
 
+	// Weld the bit-identical vertices
+	if (m_loadFlags & MESH_LOAD_WELD_VERTICES) weldVertices();
+
+	// Narrow the 32-bit indices to 16 bits where the subsets can be rebased or split
+	if (m_loadFlags & (MESH_LOAD_NARROW_INDICES | MESH_LOAD_SPLIT_32BIT_SUBSETS)) narrowIndices();
+
+	// Optimize for the post-transform vertex cache and vertex fetch
+	if (m_loadFlags & MESH_LOAD_OPTIMIZE_VERTEX_CACHE) optimizeVertexCache();
+
+	// Simplify the subsets into LODs sharing the vertex buffers
+	if (m_loadFlags & MESH_LOAD_GENERATE_LODS) generateLODs();
+
+	// Split the subsets into meshlets, following the optimized triangle order
+	if (m_loadFlags & MESH_LOAD_BUILD_MESHLETS) buildMeshlets();
+
 	Subset* pSubset = nullptr;
 	PrimitiveTopology primType;
 
 	// update bounding volume
 	Data* currentMesh = m_pMeshArray;
-	auto tris = 0;
+	auto tris = 0u;
 
 	for (auto m = 0u; m < m_pMeshHeader->NumMeshes; ++m)
 	{
-		lower.x = FLT_MAX; lower.y = FLT_MAX; lower.z = FLT_MAX;
-		upper.x = -FLT_MAX; upper.y = -FLT_MAX; upper.z = -FLT_MAX;
+		auto vLower = XMVectorReplicate(FLT_MAX);
+		auto vUpper = XMVectorReplicate(-FLT_MAX);
+		auto hasBounds = false;
 		currentMesh = GetMesh(m);
-		const auto indSize = m_pIndexBufferArray[currentMesh->IndexBuffer].IndexType == IT_16BIT ? 2 : 4;
+		const auto vb = currentMesh->VertexBuffers[0];
+		const auto is16Bit = m_pIndexBufferArray[currentMesh->IndexBuffer].IndexType == IT_16BIT;
 
 		for (auto subset = 0u; subset < currentMesh->NumSubsets; ++subset)
 		{
@@ -866,6 +1540,8 @@ bool SDKMesh_Impl::createFromMemory(const Device* pDevice, uint8_t* pData,
 
 			const auto indexCount = static_cast<uint32_t>(pSubset->IndexCount);
 			const auto indexStart = static_cast<uint32_t>(pSubset->IndexStart);
+			const auto vertexStart = static_cast<uint32_t>(pSubset->VertexStart);
+			tris += indexCount;
 
 			//if (bAdjacent)
 			//{
@@ -873,46 +1549,34 @@ bool SDKMesh_Impl::createFromMemory(const Device* pDevice, uint8_t* pData,
 			//	IndexStart *= 2;
 			//}
 
-			//uint8_t* pIndices = nullptr;
-			//m_ppIndices[i]
-			const auto indices = reinterpret_cast<uint32_t*>(m_indices[currentMesh->IndexBuffer]);
-			const auto vertices = reinterpret_cast<float*>(m_vertices[currentMesh->VertexBuffers[0]]);
-			auto byteStride = static_cast<uint32_t>(m_pVertexBufferArray[currentMesh->VertexBuffers[0]].StrideBytes);
-			assert(byteStride % 4 == 0);
-			byteStride /= 4;
-
-			for (auto vertIdx = indexStart; vertIdx < indexStart + indexCount; ++vertIdx)
+			// Dispatch on the index and position types once per subset, instead of per vertex
+			const auto pIndices = m_indices[currentMesh->IndexBuffer];
+			m_vertexLayouts[vb].Visit(VertexLayout::USAGE_POSITION, m_vertices[vb], [&](const auto& positions)
 			{
-				auto currentIndex = 0u;
-				if (indSize == 2)
+				const auto expand = [&](const auto indices)
 				{
-					const auto ind_div2 = vertIdx / 2;
-					currentIndex = indices[ind_div2];
-					if (vertIdx % 2 == 0)
+					for (auto i = indexStart; i < indexStart + indexCount; ++i)
 					{
-						currentIndex = currentIndex << 16;
-						currentIndex = currentIndex >> 16;
+						const auto pos = positions.Load(indices[i] + vertexStart);
+						vLower = XMVectorMin(vLower, pos);
+						vUpper = XMVectorMax(vUpper, pos);
+						hasBounds = true;
 					}
-					else
-					{
-						currentIndex = currentIndex >> 16;
-					}
-				}
-				else currentIndex = indices[vertIdx];
-				++tris;
-				const auto pt = reinterpret_cast<XMFLOAT3*>(&vertices[byteStride * currentIndex]);
-				if (pt->x < lower.x) lower.x = pt->x;
-				if (pt->y < lower.y) lower.y = pt->y;
-				if (pt->z < lower.z) lower.z = pt->z;
-				if (pt->x > upper.x) upper.x = pt->x;
-				if (pt->y > upper.y) upper.y = pt->y;
-				if (pt->z > upper.z) upper.z = pt->z;
-				//uint8_t** m_ppVertices;
-				//uint8_t** m_ppIndices;
-			}
+				};
+
+				if (is16Bit) expand(reinterpret_cast<const uint16_t*>(pIndices));
+				else expand(reinterpret_cast<const uint32_t*>(pIndices));
+			});
 			//pd3dDeviceContext->DrawIndexed(IndexCount, IndexStart, VertexStart);
 		}
 
+		// Keep the bounds stored in the file if the positions cannot be decoded, e.g. if they
+		// are missing or packed in a type without a DirectXMath load
+		if (!hasBounds) continue;
+
+		XMStoreFloat3(&lower, vLower);
+		XMStoreFloat3(&upper, vUpper);
+
 		XMFLOAT3 half((upper.x - lower.x) * 0.5f, (upper.y - lower.y) * 0.5f, (upper.z - lower.z) * 0.5f);
 
 		currentMesh->BoundingBoxCenter.x = lower.x + half.x;
@@ -925,12 +1589,30 @@ bool SDKMesh_Impl::createFromMemory(const Device* pDevice, uint8_t* pData,
 	// Classify material type for each subset
 	classifyMaterialType();
 
+	// Quantize the skinning input once the vertices are final; static meshes are drawn as they are
+	if (!isStaticMesh && (m_loadFlags & MESH_LOAD_QUANTIZE_VERTICES)) quantizeVertices();
+
 	//Create vertex Buffer and index buffer
 	XUSG_N_RETURN(createVertexBuffer(pCommandList, uploaders), false);
 	XUSG_N_RETURN(createIndexBuffer(pCommandList, uploaders), false);
 
 	// Execute commands
-	return executeCommandList(pCommandList);
+	XUSG_N_RETURN(executeCommandList(pCommandList), false);
+
+	// Share the uploaded buffers with the meshes loaded later
+	if (m_loadFlags & MESH_LOAD_SHARE_BUFFERS)
+	{
+		auto& geometryCache = GeometryCache::GetDefault();
+		geometryCache.InsertVertexBuffer(m_vertexBufferKey, m_vertexBuffer, m_vertexBufferData);
+		geometryCache.InsertIndexBuffer(m_indexBufferKey, m_indexBuffer, m_indexBufferData);
+		m_vertexBufferData.reset();
+		m_indexBufferData.reset();
+	}
+
+	// The vertices and indices are only needed by the GPU from now on
+	if ((m_loadFlags & MESH_LOAD_TRIM_CPU_DATA) && pDevice) trimCPUData();
+
+	return true;
 }
 
 void SDKMesh_Impl::createAsStaticMesh()
@@ -962,61 +1644,150 @@ void SDKMesh_Impl::createAsStaticMesh()
 		const auto& m = m_pFrameArray[i].Mesh;
 		if (m != INVALID_MESH)
 		{
-			const auto numVerts = GetNumVertices(m, 0);
+			const auto numVerts = static_cast<size_t>(GetNumVertices(m, 0));
 			const auto vb = m_pMeshArray[m].VertexBuffers[0];
 			const auto local = GetBindMatrix(i);
 			const auto verts = m_vertices[vb];
 			const auto byteStride = GetVertexStride(m, 0);
 			const auto localIT = XMMatrixTranspose(XMMatrixInverse(nullptr, local));
-			const auto& pDecl = m_pVertexBufferArray[vb].Decl;
 
-			for (auto i = 0u; i < numVerts; ++i)
+			// Transform the whole streams; UV is unchanged. The batch kernels handle float3 positions
+			// and half4 normals, and the other types go through the strided accessors of the layout
+			const auto& layout = m_vertexLayouts[vb];
+			const auto positionOffset = layout.GetOffset(VertexLayout::USAGE_POSITION, VertexLayout::TYPE_FLOAT3);
+			if (positionOffset != VertexLayout::INVALID_OFFSET)
+				VertexKernels::TransformPositions(verts + positionOffset, byteStride, numVerts, local);
+			else layout.Visit(VertexLayout::USAGE_POSITION, verts, [&](const auto& positions)
 			{
-				uint8_t element = 0;
-				auto offset = byteStride * i;
-				if (pDecl[element].Usage == 0)
-				{
-					assert(pDecl[element].Stream == 0 && pDecl[element].Offset == offset % byteStride);
-					auto& pos = reinterpret_cast<XMFLOAT3&>(verts[offset]);
-					XMStoreFloat3(&pos, XMVector3TransformCoord(XMLoadFloat3(&pos), local));
-					offset += sizeof(XMFLOAT3);
-				}
+				for (auto v = 0u; v < numVerts; ++v)
+					positions.Store(v, XMVectorSelect(positions.Load(v),
+						XMVector3TransformCoord(positions.Load(v), local), g_XMSelect1110));
+			});
 
-				if (pDecl[++element].Usage == 3)
+			const auto transformNormals = [&](VertexLayout::DeclUsage usage, CXMMATRIX matrix, bool preserveW)
+			{
+				const auto offset = layout.GetOffset(usage, VertexLayout::TYPE_FLOAT16_4);
+				if (offset != VertexLayout::INVALID_OFFSET)
+					VertexKernels::TransformNormals(verts + offset, byteStride, numVerts, matrix, preserveW);
+				else layout.Visit(usage, verts, [&](const auto& normals)
 				{
-					assert(pDecl[element].Stream == 0 && pDecl[element].Offset == offset % byteStride);
-					auto& norm = reinterpret_cast<XMHALF4&>(verts[offset]);
-					XMStoreHalf4(&norm, XMVector3TransformNormal(XMLoadHalf4(&norm), localIT));
-					offset += sizeof(XMHALF4);
-				}
+					for (auto v = 0u; v < numVerts; ++v)
+					{
+						const auto normal = normals.Load(v);
+						const auto transformed = XMVector3TransformNormal(normal, matrix);
+						normals.Store(v, preserveW ? XMVectorSelect(normal, transformed, g_XMSelect1110) : transformed);
+					}
+				});
+			};
 
-				if (pDecl[++element].Usage == 5)
-				{
-					// UV is unchanged
-					assert(pDecl[element].Stream == 0 && pDecl[element].Offset == offset % byteStride);
-					offset += sizeof(XMHALF2);
-				}
+			transformNormals(VertexLayout::USAGE_NORMAL, localIT, false);
+			transformNormals(VertexLayout::USAGE_TANGENT, local, true);	// w is the handedness
+			transformNormals(VertexLayout::USAGE_BINORMAL, local, false);
+		}
+	}
+}
 
-				if (pDecl[++element].Usage == 6)
-				{
-					assert(pDecl[element].Stream == 0 && pDecl[element].Offset == offset % byteStride);
-					auto& tan = reinterpret_cast<XMHALF4&>(verts[offset]);
-					auto vec = XMLoadHalf4(&tan);
-					const auto w = XMVectorGetW(vec);
-					vec = XMVector3TransformNormal(vec, local);
-					vec = XMVectorSetW(vec, w);
-					XMStoreHalf4(&tan, vec);
-					offset += sizeof(XMHALF4);
-				}
+void SDKMesh_Impl::repackVertices()
+{
+	// All the vertex buffers share one stride in the GPU buffer, so either every buffer is
+	// repacked, or none is; the unskinned buffers are drawn as they are
+	const auto numVertexBuffers = m_pMeshHeader->NumVertexBuffers;
+	for (auto vb = 0u; vb < numVertexBuffers; ++vb)
+	{
+		const auto& layout = m_vertexLayouts[vb];
+		if (!layout.GetElement(VertexLayout::USAGE_BLENDWEIGHT) ||
+			!layout.GetElement(VertexLayout::USAGE_BLENDINDICES)) return;
+	}
 
-				if (pDecl[++element].Usage == 7)
-				{
-					assert(pDecl[element].Stream == 0 && pDecl[element].Offset == offset % byteStride);
-					auto& biNorm = reinterpret_cast<XMHALF4&>(verts[offset]);
-					XMStoreHalf4(&biNorm, XMVector3TransformNormal(XMLoadHalf4(&biNorm), local));
-				}
-			}
-		}
+	vector<vector<VertexRepacker::Vertex>> repackedVertices(numVertexBuffers);
+	vector<uint8_t> isRepacked(numVertexBuffers, 1);
+
+	auto& threadPool = ThreadPool::GetDefault();
+	threadPool.ParallelFor(numVertexBuffers, [&](uint32_t vb)
+	{
+		const auto& layout = m_vertexLayouts[vb];
+		if (VertexRepacker::IsCanonical(layout)) return;
+
+		// Keep the source vertices if they cannot be repacked losslessly enough
+		const auto numVertices = static_cast<uint32_t>(m_pVertexBufferArray[vb].NumVertices);
+		auto& vertices = repackedVertices[vb];
+		vertices.resize(numVertices);
+		isRepacked[vb] = VertexRepacker::Repack(vertices.data(), m_vertices[vb], layout, numVertices) &&
+			VertexRepacker::Validate(vertices.data(), m_vertices[vb], layout, numVertices);
+	});
+
+	for (const auto& repacked : isRepacked)
+		if (!repacked) return;
+
+	m_repackedVertices.resize(numVertexBuffers);
+	for (auto vb = 0u; vb < numVertexBuffers; ++vb)
+	{
+		if (VertexRepacker::IsCanonical(m_vertexLayouts[vb])) continue;
+
+		m_repackedVertices[vb].swap(repackedVertices[vb]);
+		m_vertices[vb] = reinterpret_cast<uint8_t*>(m_repackedVertices[vb].data());
+
+		auto& vbHeader = m_pVertexBufferArray[vb];
+		vbHeader.StrideBytes = sizeof(VertexRepacker::Vertex);
+		vbHeader.SizeBytes = sizeof(VertexRepacker::Vertex) * vbHeader.NumVertices;
+		VertexRepacker::GetCanonicalDecl(vbHeader.Decl, MAX_VERTEX_ELEMENTS);
+		m_vertexLayouts[vb].Decode(vbHeader.Decl, MAX_VERTEX_ELEMENTS, static_cast<uint32_t>(vbHeader.StrideBytes));
+	}
+}
+
+void SDKMesh_Impl::quantizeVertices()
+{
+	// All the vertex buffers share one stride in the GPU buffer, so either every buffer is
+	// quantized, or none is; only the skinning input layout is quantized
+	const auto numVertexBuffers = m_pMeshHeader->NumVertexBuffers;
+	for (auto vb = 0u; vb < numVertexBuffers; ++vb)
+		if (!VertexRepacker::IsCanonical(m_vertexLayouts[vb]) ||
+			m_pVertexBufferArray[vb].StrideBytes != sizeof(VertexRepacker::Vertex)) return;
+
+	vector<vector<VertexQuantizer::QuantizedVertex>> quantizedVertices(numVertexBuffers);
+	vector<VertexQuantizer::Dequantization> dequantizations(numVertexBuffers);
+	vector<uint8_t> isQuantized(numVertexBuffers, 0);
+
+	auto& threadPool = ThreadPool::GetDefault();
+	threadPool.ParallelFor(numVertexBuffers, [&](uint32_t vb)
+	{
+		// The positions are quantized in the bounds of each vertex buffer
+		const auto numVertices = static_cast<uint32_t>(m_pVertexBufferArray[vb].NumVertices);
+		const auto pVertices = reinterpret_cast<const VertexRepacker::Vertex*>(m_vertices[vb]);
+		XMFLOAT3 center, extents;
+		VertexQuantizer::GetBounds(pVertices, numVertices, center, extents);
+
+		// Keep the full precision vertices if any error exceeds the bounds
+		auto& vertices = quantizedVertices[vb];
+		vertices.resize(numVertices);
+		VertexQuantizer::Quantize(vertices.data(), pVertices, numVertices, center, extents);
+		isQuantized[vb] = VertexQuantizer::Validate(vertices.data(), pVertices, numVertices, center, extents);
+		dequantizations[vb] = VertexQuantizer::GetDequantization(center, extents);
+	});
+
+	for (const auto& quantized : isQuantized)
+		if (!quantized) return;
+
+	m_quantizedVertices.swap(quantizedVertices);
+	m_vertexDequantizations.swap(dequantizations);
+}
+
+void SDKMesh_Impl::setupAnimation()
+{
+	// pointer fixup
+	m_pAnimationHeader = reinterpret_cast<AnimationFileHeader*>(m_animation.data());
+	m_pAnimationFrameData = reinterpret_cast<AnimationFrameData*>(m_animation.data() + m_pAnimationHeader->AnimationDataOffset);
+
+	const auto BaseOffset = sizeof(AnimationFileHeader);
+
+	for (auto i = 0u; i < m_pAnimationHeader->NumFrames; ++i)
+	{
+		m_pAnimationFrameData[i].pAnimationData = reinterpret_cast<AnimationData*>
+			(m_animation.data() + m_pAnimationFrameData[i].DataOffset + BaseOffset);
+
+		const auto pFrame = FindFrame(m_pAnimationFrameData[i].FrameName);
+
+		if (pFrame) pFrame->AnimationDataIndex = i;
 	}
 }
 
@@ -1026,6 +1797,7 @@ void SDKMesh_Impl::classifyMaterialType()
 	for (auto& subsets : m_classifiedSubsets)
 		subsets.resize(numMeshes);
 
+	const auto catalog = TextureCatalog::GetDefault();
 	for (auto m = 0u; m < numMeshes; ++m)
 	{
 		const auto& numSubsets = m_pMeshArray[m].NumSubsets;
@@ -1035,10 +1807,23 @@ void SDKMesh_Impl::classifyMaterialType()
 			const auto& pSubset = m_pSubsetArray[subsetIdx];
 			const auto pMaterial = GetMaterial(pSubset.MaterialID);
 
-			auto subsetType = SUBSET_OPAQUE - 1;
+			// The albedo textures not loaded yet, e.g. without a device, are looked up in the
+			// default texture catalog
+			auto format = Format::UNKNOWN;
 			if (pMaterial && pMaterial->pAlbedo && !IsErrorResource(pMaterial->Albedo64))
+				format = pMaterial->pAlbedo->GetFormat();
+			else if (pMaterial && !pMaterial->pAlbedo && pMaterial->AlbedoTexture[0] != 0 && catalog)
 			{
-				switch (pMaterial->pAlbedo->GetFormat())
+				const string textureName = pMaterial->AlbedoTexture;
+				const auto filePath = m_filePathW + wstring(textureName.cbegin(), textureName.cend());
+				DDS::TextureInfo info;
+				if (catalog->Find(filePath.c_str(), &info)) format = info.Format;
+			}
+
+			auto subsetType = SUBSET_OPAQUE - 1;
+			if (format != Format::UNKNOWN)
+			{
+				switch (format)
 				{
 				case Format::BC2_TYPELESS:
 				case Format::BC2_UNORM:
@@ -1075,6 +1860,871 @@ void SDKMesh_Impl::classifyMaterialType()
 	}
 }
 
+void SDKMesh_Impl::weldVertices()
+{
+	struct IndexRange
+	{
+		uint32_t IndexBuffer;
+		uint64_t IndexStart;
+		uint64_t IndexCount;
+		uint64_t VertexStart;
+		uint32_t VertexBase;
+		vector<uint32_t> Subsets;
+	};
+
+	const auto numMeshes = m_pMeshHeader->NumMeshes;
+	const auto numVertexBuffers = m_pMeshHeader->NumVertexBuffers;
+
+	// This requires that a vertex buffer is the only stream of its meshes, and that its
+	// index buffers are not drawn with any other vertex buffer
+	ThreadPool::GetDefault().ParallelFor(numVertexBuffers, [this, numMeshes](uint32_t vb)
+	{
+		auto& vbHeader = m_pVertexBufferArray[vb];
+		const auto numVertices = static_cast<uint32_t>(vbHeader.NumVertices);
+		const auto stride = static_cast<uint32_t>(vbHeader.StrideBytes);
+
+		// Collect the index ranges of the subsets; subsets sharing a range are remapped once
+		vector<IndexRange> ranges;
+		for (auto m = 0u; m < numMeshes; ++m)
+		{
+			const auto& mesh = m_pMeshArray[m];
+			if (mesh.VertexBuffers[0] != vb)
+			{
+				for (auto i = 1u; i < mesh.NumVertexBuffers; ++i)
+					if (mesh.VertexBuffers[i] == vb) return;
+				continue;
+			}
+
+			if (mesh.NumVertexBuffers > 1) return;
+
+			const auto& ibHeader = m_pIndexBufferArray[mesh.IndexBuffer];
+			for (auto s = 0u; s < mesh.NumSubsets; ++s)
+			{
+				const auto& subset = *GetSubset(m, s);
+				if (subset.IndexStart + subset.IndexCount > ibHeader.NumIndices) return;
+
+				auto rangeIter = find_if(ranges.begin(), ranges.end(), [&](const IndexRange& range)
+				{
+					return range.IndexBuffer == mesh.IndexBuffer && range.IndexStart == subset.IndexStart &&
+						range.IndexCount == subset.IndexCount && range.VertexStart == subset.VertexStart;
+				});
+
+				if (rangeIter == ranges.end())
+				{
+					ranges.emplace_back();
+					rangeIter = ranges.end() - 1;
+					rangeIter->IndexBuffer = mesh.IndexBuffer;
+					rangeIter->IndexStart = subset.IndexStart;
+					rangeIter->IndexCount = subset.IndexCount;
+					rangeIter->VertexStart = subset.VertexStart;
+				}
+
+				rangeIter->Subsets.emplace_back(mesh.pSubsets[s]);
+			}
+		}
+
+		// No other meshes may draw the same index buffers
+		for (auto m = 0u; m < numMeshes; ++m)
+		{
+			const auto& mesh = m_pMeshArray[m];
+			if (mesh.VertexBuffers[0] == vb) continue;
+			for (const auto& range : ranges)
+				if (range.IndexBuffer == mesh.IndexBuffer) return;
+		}
+
+		if (ranges.empty()) return;
+
+		// Partially overlapping ranges cannot be remapped independently
+		for (auto i = 0u; i < ranges.size(); ++i)
+		{
+			for (auto j = i + 1; j < ranges.size(); ++j)
+			{
+				const auto& a = ranges[i];
+				const auto& b = ranges[j];
+				if (a.IndexBuffer == b.IndexBuffer && a.IndexStart < b.IndexStart + b.IndexCount &&
+					b.IndexStart < a.IndexStart + a.IndexCount) return;
+			}
+		}
+
+		// Sort the vertices by their bytes to find the first of each set of identical vertices
+		const auto pVertices = m_vertices[vb];
+		vector<uint32_t> order(numVertices);
+		for (auto v = 0u; v < numVertices; ++v) order[v] = v;
+		sort(order.begin(), order.end(), [pVertices, stride](uint32_t a, uint32_t b)
+		{
+			const auto result = memcmp(&pVertices[stride * a], &pVertices[stride * b], stride);
+
+			return result < 0 || (result == 0 && a < b);
+		});
+
+		vector<uint32_t> firstVertices(numVertices);
+		for (auto i = 0u; i < numVertices; ++i)
+		{
+			const auto v = order[i];
+			const auto isDuplicate = i > 0 && memcmp(&pVertices[stride * order[i - 1]], &pVertices[stride * v], stride) == 0;
+			firstVertices[v] = isDuplicate ? firstVertices[order[i - 1]] : v;
+		}
+
+		// Compact the unique vertices in order
+		vector<uint32_t> remap(numVertices);
+		auto numUniqueVertices = 0u;
+		for (auto v = 0u; v < numVertices; ++v)
+			remap[v] = firstVertices[v] == v ? numUniqueVertices++ : remap[firstVertices[v]];
+		if (numUniqueVertices == numVertices) return;
+
+		// The remapped indices of each range must fit in its index type, relative to a new base vertex
+		const auto loadIndex = [this](const IndexRange& range, uint64_t i)
+		{
+			const auto pIndices = m_indices[range.IndexBuffer];
+
+			return m_pIndexBufferArray[range.IndexBuffer].IndexType == IT_16BIT ?
+				reinterpret_cast<const uint16_t*>(pIndices)[i] : reinterpret_cast<const uint32_t*>(pIndices)[i];
+		};
+
+		for (auto& range : ranges)
+		{
+			auto minIndex = UINT32_MAX;
+			auto maxIndex = 0u;
+			for (auto i = range.IndexStart; i < range.IndexStart + range.IndexCount; ++i)
+			{
+				const auto v = range.VertexStart + loadIndex(range, i);
+				if (v >= numVertices) return;
+				minIndex = (min)(minIndex, remap[v]);
+				maxIndex = (max)(maxIndex, remap[v]);
+			}
+
+			range.VertexBase = range.IndexCount > 0 ? minIndex : 0;
+			if (m_pIndexBufferArray[range.IndexBuffer].IndexType == IT_16BIT &&
+				range.IndexCount > 0 && maxIndex - minIndex >= 0xffff) return;
+		}
+
+		// Remap the indices and rebase the subsets
+		for (const auto& range : ranges)
+		{
+			const auto pIndices = m_indices[range.IndexBuffer];
+			const auto is16Bit = m_pIndexBufferArray[range.IndexBuffer].IndexType == IT_16BIT;
+			for (auto i = range.IndexStart; i < range.IndexStart + range.IndexCount; ++i)
+			{
+				const auto index = remap[range.VertexStart + loadIndex(range, i)] - range.VertexBase;
+				if (is16Bit) reinterpret_cast<uint16_t*>(pIndices)[i] = static_cast<uint16_t>(index);
+				else reinterpret_cast<uint32_t*>(pIndices)[i] = index;
+			}
+
+			for (const auto& s : range.Subsets) m_pSubsetArray[s].VertexStart = range.VertexBase;
+		}
+
+		for (auto v = 0u; v < numVertices; ++v)
+			if (firstVertices[v] == v && remap[v] != v)
+				memcpy(&pVertices[stride * remap[v]], &pVertices[stride * v], stride);
+
+		vbHeader.NumVertices = numUniqueVertices;
+		vbHeader.SizeBytes = static_cast<uint64_t>(stride) * numUniqueVertices;
+	});
+}
+
+void SDKMesh_Impl::narrowIndices()
+{
+	struct IndexRange
+	{
+		uint32_t Subset;
+		uint64_t IndexStart;
+		uint64_t IndexCount;
+		uint32_t VertexBase;	// Subtracted from the indices, and added to the base vertex
+	};
+
+	static const uint32_t maxSpan = 0xffff;	// 0xffff is the strip cut value
+
+	const auto numMeshes = m_pMeshHeader->NumMeshes;
+	const auto numIndexBuffers = m_pMeshHeader->NumIndexBuffers;
+	const auto numSubsets = m_pMeshHeader->NumTotalSubsets;
+
+	// Collect the subsets of each 32-bit index buffer
+	vector<vector<uint32_t>> ibSubsets(numIndexBuffers);
+	for (auto m = 0u; m < numMeshes; ++m)
+	{
+		const auto& mesh = m_pMeshArray[m];
+		if (m_pIndexBufferArray[mesh.IndexBuffer].IndexType != IT_32BIT) continue;
+
+		auto& subsets = ibSubsets[mesh.IndexBuffer];
+		for (auto s = 0u; s < mesh.NumSubsets; ++s)
+			if (find(subsets.cbegin(), subsets.cend(), mesh.pSubsets[s]) == subsets.cend())
+				subsets.emplace_back(mesh.pSubsets[s]);
+	}
+
+	vector<vector<IndexRange>> subsetRanges(numSubsets);
+	auto hasSplits = false;
+	for (auto ib = 0u; ib < numIndexBuffers; ++ib)
+	{
+		auto& ibHeader = m_pIndexBufferArray[ib];
+		if (ibSubsets[ib].empty()) continue;
+
+		// Find a base vertex for each subset, so that its indices fit in 16 bits
+		const auto indices = reinterpret_cast<const uint32_t*>(m_indices[ib]);
+		vector<IndexRange> ranges;
+		auto isNarrowable = true;
+		for (const auto& s : ibSubsets[ib])
+		{
+			const auto& subset = m_pSubsetArray[s];
+			isNarrowable = subset.IndexStart + subset.IndexCount <= ibHeader.NumIndices;
+			if (!isNarrowable) break;
+
+			auto minIndex = UINT32_MAX;
+			auto maxIndex = 0u;
+			for (auto i = subset.IndexStart; i < subset.IndexStart + subset.IndexCount; ++i)
+			{
+				minIndex = (min)(minIndex, indices[i]);
+				maxIndex = (max)(maxIndex, indices[i]);
+			}
+
+			if (maxIndex < maxSpan) ranges.push_back({ s, subset.IndexStart, subset.IndexCount, 0 });
+			else if (maxIndex - minIndex < maxSpan) ranges.push_back({ s, subset.IndexStart, subset.IndexCount, minIndex });
+			else
+			{
+				isNarrowable = (m_loadFlags & MESH_LOAD_SPLIT_32BIT_SUBSETS) && subset.PrimitiveType == PT_TRIANGLE_LIST;
+				if (!isNarrowable) break;
+
+				// Split the triangles in order into ranges of which the indices span less than 16 bits
+				const auto indexEnd = subset.IndexStart + subset.IndexCount;
+				auto pieceStart = subset.IndexStart;
+				auto pieceMin = UINT32_MAX;
+				auto pieceMax = 0u;
+				for (auto i = subset.IndexStart; i + 3 <= indexEnd && isNarrowable; i += 3)
+				{
+					const auto triMin = (min)(indices[i], (min)(indices[i + 1], indices[i + 2]));
+					const auto triMax = (max)(indices[i], (max)(indices[i + 1], indices[i + 2]));
+					isNarrowable = triMax - triMin < maxSpan;
+
+					if ((max)(pieceMax, triMax) - (min)(pieceMin, triMin) >= maxSpan)
+					{
+						ranges.push_back({ s, pieceStart, i - pieceStart, pieceMin });
+						pieceStart = i;
+						pieceMin = triMin;
+						pieceMax = triMax;
+					}
+					else
+					{
+						pieceMin = (min)(pieceMin, triMin);
+						pieceMax = (max)(pieceMax, triMax);
+					}
+				}
+				if (!isNarrowable) break;
+
+				ranges.push_back({ s, pieceStart, indexEnd - pieceStart, pieceMin });
+			}
+		}
+
+		// Overlapping ranges must share the base vertex
+		for (auto i = 0u; i < ranges.size() && isNarrowable; ++i)
+		{
+			for (auto j = i + 1; j < ranges.size() && isNarrowable; ++j)
+			{
+				const auto& a = ranges[i];
+				const auto& b = ranges[j];
+				isNarrowable = a.VertexBase == b.VertexBase || a.IndexStart >= b.IndexStart + b.IndexCount ||
+					b.IndexStart >= a.IndexStart + a.IndexCount;
+			}
+		}
+		if (!isNarrowable) continue;
+
+		// Narrow the indices in place; indices not referenced by any subset are truncated
+		vector<uint16_t> narrowed(static_cast<size_t>(ibHeader.NumIndices));
+		for (auto i = 0u; i < narrowed.size(); ++i) narrowed[i] = static_cast<uint16_t>(indices[i]);
+		for (const auto& range : ranges)
+			for (auto i = range.IndexStart; i < range.IndexStart + range.IndexCount; ++i)
+				narrowed[i] = static_cast<uint16_t>(indices[i] - range.VertexBase);
+
+		memcpy(m_indices[ib], narrowed.data(), sizeof(uint16_t) * narrowed.size());
+		ibHeader.IndexType = IT_16BIT;
+		ibHeader.SizeBytes = sizeof(uint16_t) * ibHeader.NumIndices;
+
+		for (const auto& range : ranges)
+		{
+			auto& pieces = subsetRanges[range.Subset];
+			pieces.emplace_back(range);
+			hasSplits = hasSplits || pieces.size() > 1;
+		}
+	}
+
+	// Rebase the subsets
+	if (!hasSplits)
+	{
+		for (auto s = 0u; s < numSubsets; ++s)
+			if (!subsetRanges[s].empty()) m_pSubsetArray[s].VertexStart += subsetRanges[s][0].VertexBase;
+
+		return;
+	}
+
+	// Rebuild the subset array with the pieces of the split subsets
+	vector<vector<uint32_t>> pieceSubsets(numSubsets);
+	m_splitSubsets.clear();
+	for (auto s = 0u; s < numSubsets; ++s)
+	{
+		if (subsetRanges[s].empty())
+		{
+			pieceSubsets[s].emplace_back(static_cast<uint32_t>(m_splitSubsets.size()));
+			m_splitSubsets.emplace_back(m_pSubsetArray[s]);
+		}
+
+		for (const auto& range : subsetRanges[s])
+		{
+			pieceSubsets[s].emplace_back(static_cast<uint32_t>(m_splitSubsets.size()));
+			m_splitSubsets.emplace_back(m_pSubsetArray[s]);
+			auto& subset = m_splitSubsets.back();
+			subset.IndexStart = range.IndexStart;
+			subset.IndexCount = range.IndexCount;
+			subset.VertexStart += range.VertexBase;
+		}
+	}
+
+	vector<uint32_t> subsetOffsets(numMeshes);
+	m_splitSubsetIndices.clear();
+	for (auto m = 0u; m < numMeshes; ++m)
+	{
+		auto& mesh = m_pMeshArray[m];
+		subsetOffsets[m] = static_cast<uint32_t>(m_splitSubsetIndices.size());
+		for (auto s = 0u; s < mesh.NumSubsets; ++s)
+		{
+			const auto& pieces = pieceSubsets[mesh.pSubsets[s]];
+			m_splitSubsetIndices.insert(m_splitSubsetIndices.end(), pieces.cbegin(), pieces.cend());
+		}
+		mesh.NumSubsets = static_cast<uint32_t>(m_splitSubsetIndices.size()) - subsetOffsets[m];
+	}
+
+	for (auto m = 0u; m < numMeshes; ++m)
+		m_pMeshArray[m].pSubsets = m_splitSubsetIndices.data() + subsetOffsets[m];
+	m_pSubsetArray = m_splitSubsets.data();
+	m_pMeshHeader->NumTotalSubsets = static_cast<uint32_t>(m_splitSubsets.size());
+}
+
+void SDKMesh_Impl::optimizeVertexCache()
+{
+	struct IndexRange
+	{
+		uint32_t IndexBuffer;
+		uint32_t VertexBuffer;
+		uint64_t IndexStart;
+		uint64_t IndexCount;
+		uint64_t VertexStart;
+		bool IsOptimizable;
+		MeshOptimizer::CacheStats Stats[2];
+	};
+
+	const auto numMeshes = m_pMeshHeader->NumMeshes;
+	const auto numVertexBuffers = m_pMeshHeader->NumVertexBuffers;
+
+	// Collect the triangle-list ranges of the subsets; subsets sharing a range are optimized once.
+	// The vertex buffers of the meshes with any skipped subset keep their vertex order, since
+	// the indices of the skipped subsets would not be remapped.
+	vector<IndexRange> ranges;
+	vector<vector<uint32_t>> meshRanges(numMeshes);
+	vector<uint8_t> isVertexOrderFixed(numVertexBuffers);
+	for (auto m = 0u; m < numMeshes; ++m)
+	{
+		const auto& mesh = m_pMeshArray[m];
+		for (auto s = 0u; s < mesh.NumSubsets; ++s)
+		{
+			const auto& subset = *GetSubset(m, s);
+			const auto& vbHeader = m_pVertexBufferArray[mesh.VertexBuffers[0]];
+			const auto& ibHeader = m_pIndexBufferArray[mesh.IndexBuffer];
+			if (subset.PrimitiveType != PT_TRIANGLE_LIST ||
+				subset.IndexStart + subset.IndexCount > ibHeader.NumIndices ||
+				subset.VertexStart >= vbHeader.NumVertices)
+			{
+				for (auto i = 0u; i < mesh.NumVertexBuffers; ++i)
+					isVertexOrderFixed[mesh.VertexBuffers[i]] = 1;
+				continue;
+			}
+
+			const auto it = find_if(ranges.cbegin(), ranges.cend(), [&](const IndexRange& range)
+			{
+				return range.IndexBuffer == mesh.IndexBuffer && range.VertexBuffer == mesh.VertexBuffers[0] &&
+					range.IndexStart == subset.IndexStart && range.IndexCount == subset.IndexCount &&
+					range.VertexStart == subset.VertexStart;
+			});
+
+			const auto r = static_cast<uint32_t>(it - ranges.cbegin());
+			if (it == ranges.cend())
+			{
+				IndexRange range = {};
+				range.IndexBuffer = mesh.IndexBuffer;
+				range.VertexBuffer = mesh.VertexBuffers[0];
+				range.IndexStart = subset.IndexStart;
+				range.IndexCount = subset.IndexCount / 3 * 3;
+				range.VertexStart = subset.VertexStart;
+				range.IsOptimizable = true;
+				ranges.emplace_back(range);
+			}
+
+			if (find(meshRanges[m].cbegin(), meshRanges[m].cend(), r) == meshRanges[m].cend())
+				meshRanges[m].emplace_back(r);
+		}
+	}
+
+	// Partially overlapping ranges cannot be reordered independently
+	const auto numRanges = static_cast<uint32_t>(ranges.size());
+	for (auto i = 0u; i < numRanges; ++i)
+	{
+		for (auto j = i + 1; j < numRanges; ++j)
+		{
+			auto& a = ranges[i];
+			auto& b = ranges[j];
+			if (a.IndexBuffer == b.IndexBuffer && a.IndexStart < b.IndexStart + b.IndexCount &&
+				b.IndexStart < a.IndexStart + a.IndexCount)
+			{
+				a.IsOptimizable = false;
+				b.IsOptimizable = false;
+			}
+		}
+	}
+
+	// Reorder the triangles of each range for the vertex cache, then the clusters for overdraw
+	auto& threadPool = ThreadPool::GetDefault();
+	threadPool.ParallelFor(numRanges, [this, &ranges](uint32_t i)
+	{
+		auto& range = ranges[i];
+		const auto& vbHeader = m_pVertexBufferArray[range.VertexBuffer];
+		const auto vertexCount = static_cast<uint32_t>(vbHeader.NumVertices - range.VertexStart);
+		const auto indexCount = static_cast<uint32_t>(range.IndexCount);
+		const auto stride = static_cast<uint32_t>(vbHeader.StrideBytes);
+		const auto positionOffset = m_vertexLayouts[range.VertexBuffer].GetOffset(VertexLayout::USAGE_POSITION, VertexLayout::TYPE_FLOAT3);
+		const auto pPositions = positionOffset != VertexLayout::INVALID_OFFSET ?
+			m_vertices[range.VertexBuffer] + stride * range.VertexStart + positionOffset : nullptr;
+
+		const auto optimize = [&](auto indices)
+		{
+			indices += range.IndexStart;
+			for (auto j = 0u; j < indexCount; ++j)
+			{
+				if (indices[j] >= vertexCount)
+				{
+					range.IsOptimizable = false;
+					return;
+				}
+			}
+
+			range.Stats[0] = MeshOptimizer::AnalyzeVertexCache(indices, indexCount, vertexCount);
+			if (!range.IsOptimizable) return;
+
+			vector<uint32_t> clusters;
+			MeshOptimizer::OptimizeVertexCache(indices, indexCount, vertexCount,
+				MeshOptimizer::DEFAULT_CACHE_SIZE, &clusters);
+			MeshOptimizer::OptimizeOverdraw(indices, indexCount, clusters, pPositions, stride, vertexCount);
+			range.Stats[1] = MeshOptimizer::AnalyzeVertexCache(indices, indexCount, vertexCount);
+		};
+
+		if (m_pIndexBufferArray[range.IndexBuffer].IndexType == IT_16BIT)
+			optimize(reinterpret_cast<uint16_t*>(m_indices[range.IndexBuffer]));
+		else optimize(reinterpret_cast<uint32_t*>(m_indices[range.IndexBuffer]));
+	});
+
+	// Reorder the vertices by first use. This requires that a vertex buffer is the only stream
+	// of its meshes, that its ranges share one base vertex and that its index buffers are not
+	// drawn with any other vertex buffer.
+	threadPool.ParallelFor(numVertexBuffers, [this, &ranges, &isVertexOrderFixed, numMeshes](uint32_t vb)
+	{
+		if (isVertexOrderFixed[vb]) return;
+
+		vector<uint32_t> vbRanges;
+		for (auto r = 0u; r < static_cast<uint32_t>(ranges.size()); ++r)
+			if (ranges[r].VertexBuffer == vb) vbRanges.emplace_back(r);
+		if (vbRanges.empty()) return;
+
+		const auto& firstRange = ranges[vbRanges[0]];
+		const auto indexType = m_pIndexBufferArray[firstRange.IndexBuffer].IndexType;
+		for (const auto& r : vbRanges)
+		{
+			const auto& range = ranges[r];
+			if (!range.IsOptimizable || range.VertexStart != firstRange.VertexStart ||
+				m_pIndexBufferArray[range.IndexBuffer].IndexType != indexType) return;
+		}
+
+		for (auto m = 0u; m < numMeshes; ++m)
+		{
+			const auto& mesh = m_pMeshArray[m];
+			for (auto i = 1u; i < mesh.NumVertexBuffers; ++i)
+				if (mesh.VertexBuffers[i] == vb) return;
+
+			if (mesh.VertexBuffers[0] != vb)
+				for (const auto& r : vbRanges)
+					if (ranges[r].IndexBuffer == mesh.IndexBuffer) return;
+
+			if (mesh.VertexBuffers[0] == vb && mesh.NumVertexBuffers > 1) return;
+		}
+
+		const auto& vbHeader = m_pVertexBufferArray[vb];
+		const auto stride = static_cast<uint32_t>(vbHeader.StrideBytes);
+		const auto vertexCount = static_cast<uint32_t>(vbHeader.NumVertices - firstRange.VertexStart);
+		const auto pVertices = m_vertices[vb] + stride * firstRange.VertexStart;
+
+		const auto optimize = [&](auto indices)
+		{
+			vector<decltype(indices)> ppIndices;
+			vector<uint32_t> indexCounts;
+			for (const auto& r : vbRanges)
+			{
+				const auto& range = ranges[r];
+				ppIndices.emplace_back(reinterpret_cast<decltype(indices)>(m_indices[range.IndexBuffer]) + range.IndexStart);
+				indexCounts.emplace_back(static_cast<uint32_t>(range.IndexCount));
+			}
+
+			MeshOptimizer::OptimizeVertexFetch(pVertices, stride, vertexCount,
+				static_cast<uint32_t>(vbRanges.size()), ppIndices.data(), indexCounts.data());
+		};
+
+		if (indexType == IT_16BIT) optimize(static_cast<uint16_t*>(nullptr));
+		else optimize(static_cast<uint32_t*>(nullptr));
+	});
+
+	// Accumulate the statistics per mesh
+	m_cacheStatsBefore.assign(numMeshes, MeshOptimizer::CacheStats());
+	m_cacheStatsAfter.assign(numMeshes, MeshOptimizer::CacheStats());
+	for (auto m = 0u; m < numMeshes; ++m)
+	{
+		for (const auto& r : meshRanges[m])
+		{
+			m_cacheStatsBefore[m] += ranges[r].Stats[0];
+			m_cacheStatsAfter[m] += ranges[r].Stats[ranges[r].IsOptimizable ? 1 : 0];
+		}
+	}
+}
+
+void SDKMesh_Impl::generateLODs()
+{
+	struct LODRange
+	{
+		uint32_t IndexBuffer;
+		uint32_t VertexBuffer;
+		uint64_t IndexStart;
+		uint64_t IndexCount;
+		uint64_t VertexStart;
+		uint64_t IndexStarts[MAX_LODS];
+		float Errors[MAX_LODS];				// Accumulated over the LODs
+		vector<uint32_t> Indices[MAX_LODS];	// Empty if the range cannot be simplified
+	};
+
+	const auto numMeshes = m_pMeshHeader->NumMeshes;
+	const auto numVertexBuffers = m_pMeshHeader->NumVertexBuffers;
+	const auto numSubsets = m_pMeshHeader->NumTotalSubsets;
+
+	// The errors are relative to the diagonal of the bounds of all the vertices
+	auto lower = XMVectorReplicate(FLT_MAX);
+	auto upper = XMVectorReplicate(-FLT_MAX);
+	auto hasPositions = false;
+	for (auto vb = 0u; vb < numVertexBuffers; ++vb)
+	{
+		const auto numVertices = m_pVertexBufferArray[vb].NumVertices;
+		m_vertexLayouts[vb].Visit(VertexLayout::USAGE_POSITION, m_vertices[vb], [&](const auto& positions)
+		{
+			for (auto i = 0u; i < numVertices; ++i)
+			{
+				const auto pos = positions.Load(i);
+				lower = XMVectorMin(lower, pos);
+				upper = XMVectorMax(upper, pos);
+				hasPositions = true;
+			}
+		});
+	}
+
+	const auto diagonal = hasPositions ? XMVectorGetX(XMVector3Length(upper - lower)) : 0.0f;
+	if (diagonal <= 0.0f) return;
+
+	// Collect the triangle-list ranges of the subsets; subsets sharing a range are simplified once
+	vector<LODRange> ranges;
+	vector<uint32_t> subsetRanges(numSubsets, UINT32_MAX);
+	for (auto m = 0u; m < numMeshes; ++m)
+	{
+		const auto& mesh = m_pMeshArray[m];
+		const auto& layout = m_vertexLayouts[mesh.VertexBuffers[0]];
+		if (layout.GetOffset(VertexLayout::USAGE_POSITION, VertexLayout::TYPE_FLOAT3) == VertexLayout::INVALID_OFFSET) continue;
+
+		for (auto s = 0u; s < mesh.NumSubsets; ++s)
+		{
+			const auto& subset = *GetSubset(m, s);
+			if (subset.PrimitiveType != PT_TRIANGLE_LIST) continue;
+
+			const auto& vbHeader = m_pVertexBufferArray[mesh.VertexBuffers[0]];
+			const auto& ibHeader = m_pIndexBufferArray[mesh.IndexBuffer];
+			if (subset.IndexStart + subset.IndexCount > ibHeader.NumIndices) continue;
+			if (subset.VertexStart >= vbHeader.NumVertices) continue;
+
+			const auto it = find_if(ranges.cbegin(), ranges.cend(), [&](const LODRange& range)
+			{
+				return range.IndexBuffer == mesh.IndexBuffer && range.VertexBuffer == mesh.VertexBuffers[0] &&
+					range.IndexStart == subset.IndexStart && range.IndexCount == subset.IndexCount / 3 * 3 &&
+					range.VertexStart == subset.VertexStart;
+			});
+
+			const auto r = static_cast<uint32_t>(it - ranges.cbegin());
+			if (it == ranges.cend())
+			{
+				ranges.emplace_back();
+				auto& range = ranges.back();
+				range.IndexBuffer = mesh.IndexBuffer;
+				range.VertexBuffer = mesh.VertexBuffers[0];
+				range.IndexStart = subset.IndexStart;
+				range.IndexCount = subset.IndexCount / 3 * 3;
+				range.VertexStart = subset.VertexStart;
+				range.Errors[0] = 0.0f;
+			}
+
+			subsetRanges[mesh.pSubsets[s]] = r;
+		}
+	}
+
+	if (ranges.empty()) return;
+
+	// Simplify each LOD from the previous one, within the remaining error budget
+	const auto numRanges = static_cast<uint32_t>(ranges.size());
+	const auto maxError = MAX_LOD_ERROR * diagonal;
+	auto& threadPool = ThreadPool::GetDefault();
+	threadPool.ParallelFor(numRanges, [this, &ranges, maxError](uint32_t i)
+	{
+		auto& range = ranges[i];
+		const auto& vbHeader = m_pVertexBufferArray[range.VertexBuffer];
+		const auto& layout = m_vertexLayouts[range.VertexBuffer];
+
+		MeshSimplifier::VertexData vertexData;
+		vertexData.Stride = layout.GetStride();
+		vertexData.pVertices = m_vertices[range.VertexBuffer] + vertexData.Stride * range.VertexStart;
+		vertexData.NumVertices = static_cast<uint32_t>(vbHeader.NumVertices - range.VertexStart);
+		vertexData.PositionOffset = layout.GetOffset(VertexLayout::USAGE_POSITION, VertexLayout::TYPE_FLOAT3);
+		vertexData.WeightsOffset = layout.GetOffset(VertexLayout::USAGE_BLENDWEIGHT, VertexLayout::TYPE_UBYTE4N);
+		vertexData.BonesOffset = layout.GetOffset(VertexLayout::USAGE_BLENDINDICES, VertexLayout::TYPE_UBYTE4);
+
+		const auto is16Bit = m_pIndexBufferArray[range.IndexBuffer].IndexType == IT_16BIT;
+		const auto pIndices = m_indices[range.IndexBuffer];
+		auto& indices = range.Indices[0];
+		indices.resize(static_cast<size_t>(range.IndexCount));
+		for (auto j = 0u; j < indices.size(); ++j)
+		{
+			indices[j] = is16Bit ? reinterpret_cast<const uint16_t*>(pIndices)[range.IndexStart + j] :
+				reinterpret_cast<const uint32_t*>(pIndices)[range.IndexStart + j];
+			if (indices[j] >= vertexData.NumVertices)
+			{
+				indices.clear();
+				return;
+			}
+		}
+
+		for (auto lod = 1u; lod < MAX_LODS; ++lod)
+		{
+			auto& lodIndices = range.Indices[lod];
+			lodIndices = range.Indices[lod - 1];
+
+			const auto indexCount = static_cast<uint32_t>(lodIndices.size());
+			const auto targetError = maxError - range.Errors[lod - 1];
+			auto error = 0.0f;
+			if (targetError > 0.0f)
+			{
+				const auto lodIndexCount = MeshSimplifier::Simplify(lodIndices.data(), indexCount,
+					vertexData, indexCount / 6 * 3, targetError, &error);
+				if (lodIndexCount < indexCount)
+				{
+					lodIndices.resize(lodIndexCount);
+					if (m_loadFlags & MESH_LOAD_OPTIMIZE_VERTEX_CACHE)
+						MeshOptimizer::OptimizeVertexCache(lodIndices.data(), lodIndexCount, vertexData.NumVertices);
+				}
+				else lodIndices = range.Indices[lod - 1];
+			}
+
+			range.Errors[lod] = range.Errors[lod - 1] + error;
+		}
+	});
+
+	// Reorder the vertices so that the vertices of each LOD are a prefix of the vertex buffer,
+	// and the skinning of a LOD can skip the rest. This requires that a vertex buffer is the
+	// only stream of its meshes, and that all their subsets are simplified from disjoint ranges
+	// sharing one base vertex and not drawn with any other vertex buffer.
+	vector<vector<uint64_t>> vbNumVertices(numVertexBuffers);
+	threadPool.ParallelFor(numVertexBuffers, [this, &ranges, &subsetRanges, &vbNumVertices, numMeshes](uint32_t vb)
+	{
+		vector<uint32_t> vbRanges;
+		for (auto r = 0u; r < static_cast<uint32_t>(ranges.size()); ++r)
+		{
+			if (ranges[r].VertexBuffer != vb) continue;
+			if (ranges[r].Indices[0].empty()) return;
+			vbRanges.emplace_back(r);
+		}
+		if (vbRanges.empty()) return;
+
+		for (auto m = 0u; m < numMeshes; ++m)
+		{
+			const auto& mesh = m_pMeshArray[m];
+			if (find(mesh.VertexBuffers, mesh.VertexBuffers + mesh.NumVertexBuffers, vb) ==
+				mesh.VertexBuffers + mesh.NumVertexBuffers)
+			{
+				for (const auto& r : vbRanges)
+					if (ranges[r].IndexBuffer == mesh.IndexBuffer) return;
+				continue;
+			}
+
+			if (mesh.NumVertexBuffers > 1) return;
+			for (auto s = 0u; s < mesh.NumSubsets; ++s)
+				if (subsetRanges[mesh.pSubsets[s]] == UINT32_MAX) return;
+		}
+
+		const auto& firstRange = ranges[vbRanges[0]];
+		for (auto i = 0u; i < vbRanges.size(); ++i)
+		{
+			const auto& a = ranges[vbRanges[i]];
+			if (a.VertexStart != firstRange.VertexStart) return;
+
+			for (auto j = i + 1; j < vbRanges.size(); ++j)
+			{
+				const auto& b = ranges[vbRanges[j]];
+				if (a.IndexBuffer == b.IndexBuffer && a.IndexStart < b.IndexStart + b.IndexCount &&
+					b.IndexStart < a.IndexStart + a.IndexCount) return;
+			}
+		}
+
+		// From the coarsest LOD to the full detail
+		vector<uint32_t*> ppIndices;
+		vector<uint32_t> indexCounts;
+		for (auto lod = MAX_LODS; lod-- > 0;)
+		{
+			for (const auto& r : vbRanges)
+			{
+				ppIndices.emplace_back(ranges[r].Indices[lod].data());
+				indexCounts.emplace_back(static_cast<uint32_t>(ranges[r].Indices[lod].size()));
+			}
+		}
+
+		const auto& vbHeader = m_pVertexBufferArray[vb];
+		const auto stride = static_cast<uint32_t>(vbHeader.StrideBytes);
+		const auto vertexCount = static_cast<uint32_t>(vbHeader.NumVertices - firstRange.VertexStart);
+		if (!MeshOptimizer::OptimizeVertexFetch(m_vertices[vb] + stride * firstRange.VertexStart, stride,
+			vertexCount, static_cast<uint32_t>(ppIndices.size()), ppIndices.data(), indexCounts.data())) return;
+
+		// Write back the remapped full-detail indices
+		for (const auto& r : vbRanges)
+		{
+			const auto& range = ranges[r];
+			const auto pIndices = m_indices[range.IndexBuffer];
+			for (auto j = 0u; j < range.Indices[0].size(); ++j)
+			{
+				if (m_pIndexBufferArray[range.IndexBuffer].IndexType == IT_16BIT)
+					reinterpret_cast<uint16_t*>(pIndices)[range.IndexStart + j] = static_cast<uint16_t>(range.Indices[0][j]);
+				else reinterpret_cast<uint32_t*>(pIndices)[range.IndexStart + j] = range.Indices[0][j];
+			}
+		}
+
+		auto& numVertices = vbNumVertices[vb];
+		numVertices.resize(MAX_LODS - 1);
+		for (auto lod = 1u; lod < MAX_LODS; ++lod)
+		{
+			auto maxIndex = 0u;
+			for (const auto& r : vbRanges)
+				for (const auto& index : ranges[r].Indices[lod])
+					maxIndex = (max)(maxIndex, index + 1);
+			numVertices[lod - 1] = firstRange.VertexStart + maxIndex;
+		}
+	});
+
+	// Append the LOD indices to the index buffers
+	m_lodIndices.assign(m_pMeshHeader->NumIndexBuffers, vector<uint8_t>());
+	m_lodErrors.assign(MAX_LODS - 1, 0.0f);
+	for (auto& range : ranges)
+	{
+		if (range.Indices[0].empty()) continue;
+
+		const auto& ibHeader = m_pIndexBufferArray[range.IndexBuffer];
+		const auto indexSize = ibHeader.IndexType == IT_16BIT ? 2u : 4u;
+		auto& lodIndices = m_lodIndices[range.IndexBuffer];
+		range.IndexStarts[0] = range.IndexStart;
+		for (auto lod = 1u; lod < MAX_LODS; ++lod)
+		{
+			const auto& indices = range.Indices[lod];
+			m_lodErrors[lod - 1] = (max)(m_lodErrors[lod - 1], range.Errors[lod] / diagonal);
+			if (indices == range.Indices[lod - 1])
+			{
+				range.IndexStarts[lod] = range.IndexStarts[lod - 1];
+				continue;
+			}
+
+			const auto offset = lodIndices.size();
+			range.IndexStarts[lod] = (ibHeader.SizeBytes + offset) / indexSize;
+			lodIndices.resize(offset + indexSize * indices.size());
+			if (indexSize == 2)
+			{
+				const auto pIndices = reinterpret_cast<uint16_t*>(&lodIndices[offset]);
+				for (auto j = 0u; j < indices.size(); ++j) pIndices[j] = static_cast<uint16_t>(indices[j]);
+			}
+			else memcpy(&lodIndices[offset], indices.data(), indexSize * indices.size());
+		}
+	}
+
+	// Set up the LOD subsets; the subsets not simplified are shared by all the LODs
+	m_lodSubsets.assign(MAX_LODS - 1, vector<Subset>(m_pSubsetArray, m_pSubsetArray + numSubsets));
+	for (auto s = 0u; s < numSubsets; ++s)
+	{
+		const auto r = subsetRanges[s];
+		if (r == UINT32_MAX || ranges[r].Indices[0].empty()) continue;
+
+		for (auto lod = 1u; lod < MAX_LODS; ++lod)
+		{
+			auto& subset = m_lodSubsets[lod - 1][s];
+			subset.IndexStart = ranges[r].IndexStarts[lod];
+			subset.IndexCount = ranges[r].Indices[lod].size();
+		}
+	}
+
+	// Vertex counts to skin per LOD
+	m_lodNumVertices.assign(numMeshes, vector<uint64_t>());
+	for (auto m = 0u; m < numMeshes; ++m)
+	{
+		const auto& numVertices = vbNumVertices[m_pMeshArray[m].VertexBuffers[0]];
+		if (numVertices.empty()) m_lodNumVertices[m].assign(MAX_LODS - 1, GetNumVertices(m, 0));
+		else m_lodNumVertices[m] = numVertices;
+	}
+}
+
+void SDKMesh_Impl::buildMeshlets()
+{
+	const auto numMeshes = m_pMeshHeader->NumMeshes;
+
+	vector<pair<uint32_t, uint32_t>> subsets;
+	m_meshlets.assign(numMeshes, vector<MeshletSet>());
+	for (auto m = 0u; m < numMeshes; ++m)
+	{
+		m_meshlets[m].resize(m_pMeshArray[m].NumSubsets);
+		for (auto s = 0u; s < m_pMeshArray[m].NumSubsets; ++s)
+			subsets.emplace_back(m, s);
+	}
+
+	ThreadPool::GetDefault().ParallelFor(static_cast<uint32_t>(subsets.size()), [this, &subsets](uint32_t i)
+	{
+		const auto m = subsets[i].first;
+		const auto s = subsets[i].second;
+		const auto& mesh = m_pMeshArray[m];
+		const auto& subset = *GetSubset(m, s);
+		if (subset.PrimitiveType != PT_TRIANGLE_LIST) return;
+
+		const auto vb = mesh.VertexBuffers[0];
+		const auto& vbHeader = m_pVertexBufferArray[vb];
+		const auto& ibHeader = m_pIndexBufferArray[mesh.IndexBuffer];
+		if (subset.VertexStart >= vbHeader.NumVertices || subset.IndexStart + subset.IndexCount > ibHeader.NumIndices) return;
+
+		const auto& layout = m_vertexLayouts[vb];
+		const auto positionOffset = layout.GetOffset(VertexLayout::USAGE_POSITION, VertexLayout::TYPE_FLOAT3);
+		if (positionOffset == VertexLayout::INVALID_OFFSET) return;
+
+		MeshletBuilder::VertexData vertexData;
+		vertexData.Stride = layout.GetStride();
+		vertexData.pVertices = m_vertices[vb] + vertexData.Stride * subset.VertexStart;
+		vertexData.NumVertices = static_cast<uint32_t>(vbHeader.NumVertices - subset.VertexStart);
+		vertexData.PositionOffset = positionOffset;
+		vertexData.WeightsOffset = layout.GetOffset(VertexLayout::USAGE_BLENDWEIGHT, VertexLayout::TYPE_UBYTE4N);
+		vertexData.BonesOffset = layout.GetOffset(VertexLayout::USAGE_BLENDINDICES, VertexLayout::TYPE_UBYTE4);
+
+		auto& meshletSet = m_meshlets[m][s];
+		const auto indexCount = static_cast<uint32_t>(subset.IndexCount);
+		const auto succeeded = ibHeader.IndexType == IT_16BIT ?
+			MeshletBuilder::Build(meshletSet, reinterpret_cast<const uint16_t*>(m_indices[mesh.IndexBuffer]) + subset.IndexStart, indexCount, vertexData) :
+			MeshletBuilder::Build(meshletSet, reinterpret_cast<const uint32_t*>(m_indices[mesh.IndexBuffer]) + subset.IndexStart, indexCount, vertexData);
+		if (!succeeded) meshletSet = MeshletSet();
+	});
+}
+
 bool SDKMesh_Impl::executeCommandList(CommandList* pCommandList)
 {
 	if (pCommandList)
@@ -1110,12 +2760,111 @@ bool SDKMesh_Impl::executeCommandList(CommandList* pCommandList)
 			// Wait until the fence has been processed, and increment the fence value for the current frame.
 			XUSG_N_RETURN(fence->SetEventOnCompletion(fenceValue++, fenceEvent), false);
 			WaitForSingleObject(fenceEvent, INFINITE);
+			CloseHandle(fenceEvent);
 		}
 	}
 
 	return true;
 }
 
+bool SDKMesh_Impl::finishLoading(bool succeeded)
+{
+	// Publish the result; the mesh data become visible to the owner once nothing is outstanding
+	m_hadLoadingError = !succeeded;
+	m_numOutstandingBuffers = 0;
+	m_numOutstandingResources = 0;
+	m_isLoading = false;
+
+	return succeeded;
+}
+
+bool SDKMesh_Impl::loadAsync(const function<bool()>& create, const LoadCallback& callback,
+	const FinishCallback& finish, ThreadPool::Group group)
+{
+	XUSG_C_RETURN(isLoadPending(), false);
+
+	// The header stays outstanding until the loader thread has parsed the file
+	m_numOutstandingResources = 1;
+	m_numOutstandingBuffers = 1;
+	m_hadLoadingError = false;
+	m_isLoading = true;
+
+	// Parse, load textures, upload and wait for the GPU on a worker thread; waiting for the
+	// mesh only helps with its own load, unless it is loaded in a group
+	auto& threadPool = ThreadPool::GetDefault();
+	m_loadGroup = group != ThreadPool::NO_GROUP ? group : threadPool.CreateGroup();
+	m_loadTask = threadPool.Enqueue([this, create, callback, finish]()
+	{
+		m_loadThread = this_thread::get_id();
+		auto succeeded = create();
+		if (succeeded && finish) succeeded = finish(this);
+		succeeded = finishLoading(succeeded);
+		if (callback) callback(this, succeeded);
+
+		return succeeded;
+	}, m_loadGroup);
+
+	return true;
+}
+
+void SDKMesh_Impl::setFilePath(const wchar_t* fileName)
+{
+	// Keep the name, and change the path to just the directory
+	m_filePathW = fileName;
+	const auto found = m_filePathW.find_last_of(L"/\\");
+	m_name = m_filePathW.substr(found + 1);
+	m_filePathW = m_filePathW.substr(0, found + 1);
+	m_filePath.resize(m_filePathW.size());
+	for (size_t i = 0; i < m_filePath.size(); ++i) m_filePath[i] = static_cast<char>(m_filePathW[i]);
+}
+
+bool SDKMesh_Impl::isLoadPending() const
+{
+	return m_loadTask.valid() && m_loadTask.wait_for(chrono::seconds(0)) != future_status::ready;
+}
+
+bool SDKMesh_Impl::isOnLoadThread() const
+{
+	return isLoadPending() && m_loadThread.load() == this_thread::get_id();
+}
+
+void SDKMesh_Impl::trimCPUData()
+{
+	// Keep the header and the non-buffer data only
+	const auto staticSize = static_cast<size_t>(m_pMeshHeader->HeaderSize + m_pMeshHeader->NonBufferDataSize);
+	vector<uint8_t> staticData(m_pStaticMeshData, m_pStaticMeshData + staticSize);
+	const auto pStaticMeshData = staticData.data();
+
+	const auto relocate = [this, pStaticMeshData](const void* ptr)
+	{
+		return pStaticMeshData + (reinterpret_cast<const uint8_t*>(ptr) - m_pStaticMeshData);
+	};
+
+	// Pointer fixup
+	m_pMeshHeader = reinterpret_cast<Header*>(pStaticMeshData);
+	m_pVertexBufferArray = reinterpret_cast<VertexBufferHeader*>(relocate(m_pVertexBufferArray));
+	m_pIndexBufferArray = reinterpret_cast<IndexBufferHeader*>(relocate(m_pIndexBufferArray));
+	m_pMeshArray = reinterpret_cast<Data*>(relocate(m_pMeshArray));
+	if (m_splitSubsets.empty()) m_pSubsetArray = reinterpret_cast<Subset*>(relocate(m_pSubsetArray));
+	m_pFrameArray = reinterpret_cast<Frame*>(relocate(m_pFrameArray));
+	m_pMaterialArray = reinterpret_cast<Material*>(relocate(m_pMaterialArray));
+
+	for (auto i = 0u; i < m_pMeshHeader->NumMeshes; ++i)
+	{
+		if (m_splitSubsetIndices.empty()) m_pMeshArray[i].pSubsets = reinterpret_cast<uint32_t*>(relocate(m_pMeshArray[i].pSubsets));
+		m_pMeshArray[i].pFrameInfluences = reinterpret_cast<uint32_t*>(relocate(m_pMeshArray[i].pFrameInfluences));
+	}
+
+	// Release the file image, unless it is owned by the caller
+	m_heapData.swap(staticData);
+	m_pStaticMeshData = pStaticMeshData;
+
+	fill(m_vertices.begin(), m_vertices.end(), nullptr);
+	fill(m_indices.begin(), m_indices.end(), nullptr);
+	m_repackedVertices.clear();
+	m_lodIndices.clear();
+}
+
 //--------------------------------------------------------------------------------------
 // transform bind pose frame using a recursive traversal
 //--------------------------------------------------------------------------------------
@@ -5,6 +5,15 @@
 #pragma once
 
 #include "XUSGAdvanced.h"
+#include "XUSGThreadPool.h"
+#include "XUSGAsyncFileReader.h"
+#include "XUSGMeshOptimizer.h"
+#include "XUSGMeshletBuilder.h"
+#include "XUSGMeshSimplifier.h"
+#include "XUSGGeometryCache.h"
+#include "XUSGVertexKernels.h"
+#include "XUSGVertexQuantizer.h"
+#include "XUSGTexturePacker.h"
 
 //--------------------------------------------------------------------------------------
 // Hard Defines for the various structures
@@ -15,6 +24,8 @@
 #define INVALID_MESH			((uint32_t)-1)
 #define INVALID_MATERIAL		((uint32_t)-1)
 #define INVALID_SUBSET			((uint32_t)-1)
+#define MAX_LODS				4
+#define MAX_LOD_ERROR			0.05f
 #define INVALID_ANIMATION_DATA	((uint32_t)-1)
 #define INVALID_SAMPLER_SLOT	((uint32_t)-1)
 #define ERROR_RESOURCE_VALUE	1
@@ -81,15 +92,8 @@ namespace XUSG
 			uint64_t SizeBytes;
 			uint64_t StrideBytes;
 
-			struct VertexElement
-			{
-				uint16_t	Stream;		// Stream index
-				uint16_t	Offset;		// Offset in the stream in bytes
-				uint8_t		Type;		// Data type
-				uint8_t		Method;		// Processing method
-				uint8_t		Usage;		// Semantics
-				uint8_t		UsageIndex;	// Semantic index
-			} Decl[MAX_VERTEX_ELEMENTS];
+			typedef VertexLayout::DeclElement VertexElement;
+			VertexElement Decl[MAX_VERTEX_ELEMENTS];
 
 			uint64_t DataOffset;		// (This also forces the union to 64bits)
 		};
@@ -114,6 +118,8 @@ namespace XUSG
 		static_assert(sizeof(AnimationFileHeader) == 40, "SDK Mesh structure size incorrect");
 		static_assert(sizeof(AnimationData) == 40, "SDK Mesh structure size incorrect");
 		static_assert(sizeof(AnimationFrameData) == 112, "SDK Mesh structure size incorrect");
+		static_assert(VertexLayout::INVALID_OFFSET == MeshletBuilder::INVALID_OFFSET &&
+			VertexLayout::INVALID_OFFSET == MeshSimplifier::INVALID_OFFSET, "Invalid vertex element offsets mismatch");
 
 		SDKMesh_Impl(API api = API::DIRECTX_12);
 		virtual ~SDKMesh_Impl();
@@ -186,21 +192,78 @@ namespace XUSG
 		DirectX::XMMATRIX	GetBindMatrix(uint32_t frameIndex) const;
 		bool				GetAnimationProperties(uint32_t* pNumKeys, float* pFrameTime) const;
 
+		void SetLoadFlags(MeshLoadFlags flags);
+		MeshLoadFlags GetLoadFlags() const;
+		bool CreateAsync(const Device* pDevice, const wchar_t* fileName, const TextureLib& textureLib,
+			bool isStaticMesh = false, const LoadCallback& callback = nullptr,
+			const FinishCallback& finish = nullptr);
+		bool WaitForLoad();
+		bool LoadAnimationFromMemory(const uint8_t* pData, size_t dataBytes);
+		bool RefreshTextures();
+		uint32_t RegisterTextures(TextureStreamer* pStreamer) const;
+		void RequestTextures(TextureStreamer* pStreamer, float screenSize) const;
+
+		bool				GetVertexCacheStats(uint32_t mesh, VertexCacheStats* pBefore,
+			VertexCacheStats* pAfter = nullptr) const;
+		const MeshletSet*	GetMeshlets(uint32_t mesh, uint32_t subset) const;
+
+		const Subset*		GetLODSubset(uint32_t mesh, uint32_t subset, SubsetFlags materialType, uint32_t lod) const;
+		uint32_t			GetNumLODs() const;
+		float				GetLODError(uint32_t lod) const;
+		uint32_t			SelectLOD(float screenSize, float maxPixelError = 1.0f) const;
+		uint64_t			GetNumLODVertices(uint32_t mesh, uint32_t lod) const;
+
+		bool				IsVertexQuantized() const;
+		void				GetVertexDequantization(uint32_t mesh, DirectX::XMFLOAT3* pScale,
+			DirectX::XMFLOAT3* pBias) const;
+
+		uint32_t			GetNumTextureArraySets() const;
+		Texture*			GetTextureArray(uint32_t set, uint8_t channel) const;
+		uint32_t			GetMaterialTextureArraySet(uint32_t material, uint32_t* pSlice = nullptr) const;
+
+		// Load from the data of a file being read, e.g. in a batch by AsyncFileReader; the data
+		// are moved into the mesh. The load waits on the data helping with the read group, and is
+		// itself in the load group, if any, e.g. of the batch waited on together.
+		bool CreateAsync(const Device* pDevice, const wchar_t* fileName, const AsyncFileReader::FileData& fileData,
+			const TextureLib& textureLib, bool isStaticMesh = false, const LoadCallback& callback = nullptr,
+			const FinishCallback& finish = nullptr, ThreadPool::Group readGroup = ThreadPool::NO_GROUP,
+			ThreadPool::Group loadGroup = ThreadPool::NO_GROUP);
+
 	protected:
 		void loadMaterials(CommandList* pCommandList, Material* pMaterials,
-			uint32_t NumMaterials, std::vector<Resource::uptr>& uploaders);
+			uint32_t NumMaterials, std::vector<Resource::uptr>& uploaders,
+			std::vector<Texture::sptr>& discardedTextures);
+
+		void packTextures(CommandList* pCommandList);
 
 		bool createVertexBuffer(CommandList* pCommandList, std::vector<Resource::uptr>& uploaders);
 		bool createIndexBuffer(CommandList* pCommandList, std::vector<Resource::uptr>& uploaders);
 
 		virtual bool createFromFile(const Device* pDevice, const wchar_t* fileName,
 			const TextureLib& textureLib, bool isStaticMesh);
+		virtual bool createFromFileData(const Device* pDevice, const wchar_t* fileName,
+			std::vector<uint8_t>& fileData, const TextureLib& textureLib, bool isStaticMesh);
 		virtual bool createFromMemory(const Device* pDevice, uint8_t* pData, const TextureLib& textureLib,
 			size_t dataBytes, bool isStaticMesh, bool copyStatic);
 
 		void createAsStaticMesh();
+		void repackVertices();
+		void quantizeVertices();
+		void weldVertices();
+		void narrowIndices();
+		void setupAnimation();
 		void classifyMaterialType();
+		void optimizeVertexCache();
+		void generateLODs();
+		void buildMeshlets();
 		bool executeCommandList(CommandList* pCommandList);
+		void trimCPUData();
+		bool finishLoading(bool succeeded);
+		bool loadAsync(const std::function<bool()>& create, const LoadCallback& callback,
+			const FinishCallback& finish, ThreadPool::Group group = ThreadPool::NO_GROUP);
+		void setFilePath(const wchar_t* fileName);
+		bool isLoadPending() const;
+		bool isOnLoadThread() const;
 
 		// Frame manipulation
 		void transformBindPoseFrame(uint32_t frame, DirectX::CXMMATRIX parentWorld);
@@ -209,6 +272,8 @@ namespace XUSG
 
 		API m_api;
 
+		MeshLoadFlags m_loadFlags;
+
 		// These are the pointers to the two chunks of data loaded in from the mesh file
 		uint8_t* m_pStaticMeshData;
 		std::vector<uint8_t>	m_heapData;
@@ -216,6 +281,17 @@ namespace XUSG
 		std::vector<uint8_t*>	m_vertices;
 		std::vector<uint8_t*>	m_indices;
 
+		// Vertex layouts decoded from the declarations of the vertex buffers
+		std::vector<VertexLayout> m_vertexLayouts;
+
+		// Vertices repacked into the skinning input layout, replacing those in the file image
+		std::vector<std::vector<VertexRepacker::Vertex>> m_repackedVertices;
+
+		// Quantized skinning input per vertex buffer, released once uploaded, and the
+		// dequantization of each buffer
+		std::vector<std::vector<VertexQuantizer::QuantizedVertex>> m_quantizedVertices;
+		std::vector<VertexQuantizer::Dequantization> m_vertexDequantizations;
+
 		// Keep track of the path
 		std::wstring			m_name;
 		std::wstring			m_filePathW;
@@ -234,11 +310,25 @@ namespace XUSG
 		IndexBuffer::sptr		m_indexBuffer;
 		IndexBuffer::sptr		m_adjIndexBuffer;
 
+		// Content keys and uploaded bytes of the buffers in the geometry cache
+		GeometryCache::Key		m_vertexBufferKey;
+		GeometryCache::Key		m_indexBufferKey;
+		GeometryCache::BufferData m_vertexBufferData;
+		GeometryCache::BufferData m_indexBufferData;
+
+		// Index buffer views with the format of each index buffer
+		std::vector<IndexBufferView> m_indexBufferViews;
+
 		// Classified subsets
 		std::vector<std::vector<uint32_t>> m_classifiedSubsets[NUM_SUBSET_TYPE];
 
 		// Texture cache
 		TextureLib				m_textureLib;
+		uint64_t				m_textureGeneration;	// Of the library at the last refresh
+
+		// Texture arrays of the materials, NUM_CHANNEL per set, and the slot of each material
+		std::vector<Texture::sptr> m_textureArrays;
+		std::vector<TexturePacker::Slot> m_materialSlots;
 
 		// Adjacency information (not part of the m_pStaticMeshData, so it must be created and destroyed separately )
 		IndexBufferHeader*		m_pAdjIndexBufferArray;
@@ -250,8 +340,33 @@ namespace XUSG
 		std::vector<DirectX::XMFLOAT4X4> m_transformedFrameMatrices;
 		std::vector<DirectX::XMFLOAT4X4> m_worldPoseFrameMatrices;
 
+		// Vertex cache statistics per mesh, before and after the optimization
+		std::vector<MeshOptimizer::CacheStats> m_cacheStatsBefore;
+		std::vector<MeshOptimizer::CacheStats> m_cacheStatsAfter;
+
+		// Meshlets per subset of each mesh
+		std::vector<std::vector<MeshletSet>> m_meshlets;
+
+		// LODs from 1: the subsets in the order of the subset array, their indices appended
+		// to each index buffer, the errors, and the vertex counts per mesh
+		std::vector<std::vector<Subset>> m_lodSubsets;
+		std::vector<std::vector<uint8_t>> m_lodIndices;
+		std::vector<float>		m_lodErrors;
+		std::vector<std::vector<uint64_t>> m_lodNumVertices;
+
+		// Subsets and their indices per mesh, replacing those in the mesh data once any subset is split
+		std::vector<Subset>		m_splitSubsets;
+		std::vector<uint32_t>	m_splitSubsetIndices;
+
 	private:
-		uint32_t m_numOutstandingResources;
-		bool m_isLoading;
+		// Written by the loader thread, read by the owner
+		std::atomic<uint32_t> m_numOutstandingResources;
+		std::atomic<uint32_t> m_numOutstandingBuffers;
+		std::atomic_bool m_isLoading;
+		std::atomic_bool m_hadLoadingError;
+
+		std::future<bool> m_loadTask;
+		std::atomic<std::thread::id> m_loadThread;	// The worker running the load task
+		ThreadPool::Group m_loadGroup;				// Of the load task, which its waits help with
 	};
 }
@@ -0,0 +1,272 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "Core/XUSG.h"
+#include "XUSGStreamScheduler.h"
+
+using namespace std;
+using namespace XUSG;
+
+StreamScheduler::StreamScheduler(const ReadFunc& read, uint64_t budget, uint32_t tailSize, uint32_t maxNumReads) :
+	m_read(read),
+	m_budget(budget),
+	m_tailSize((max)(tailSize, 1u)),
+	m_maxNumReads((max)(maxNumReads, 1u)),
+	m_frame(1),
+	m_residentSize(0),
+	m_retainedSize(0),
+	m_numPendingReads(0),
+	m_entries(),
+	m_reads(),
+	m_readGroup(ThreadPool::GetDefault().CreateGroup()),
+	m_completions()
+{
+}
+
+StreamScheduler::~StreamScheduler()
+{
+	// The reads reference this object
+	for (const auto& read : m_reads) ThreadPool::GetDefault().Wait(read, m_readGroup);
+}
+
+bool StreamScheduler::Register(const string& key, uint32_t width, uint32_t height, const vector<uint64_t>& mipSizes)
+{
+	XUSG_C_RETURN(mipSizes.empty() || m_entries.find(key) != m_entries.cend(), false);
+
+	Entry entry = {};
+	entry.Width = width;
+	entry.Height = height;
+	entry.MipCount = static_cast<uint32_t>(mipSizes.size());
+
+	// The tail starts from the first mip within the tail size
+	const auto maxDim = (max)(width, height);
+	while (entry.TailMip + 1 < entry.MipCount && (maxDim >> entry.TailMip) > m_tailSize) ++entry.TailMip;
+
+	entry.ResidentMip = entry.MipCount;
+	entry.PendingMip = entry.MipCount;
+	entry.RequestedMip = entry.TailMip;
+
+	entry.TailSizes.resize(entry.MipCount + 1);
+	entry.TailSizes[entry.MipCount] = 0;
+	for (auto i = entry.MipCount; i > 0; --i)
+		entry.TailSizes[i - 1] = entry.TailSizes[i] + mipSizes[i - 1];
+
+	m_entries.emplace(key, move(entry));
+
+	return true;
+}
+
+void StreamScheduler::Unregister(const string& key)
+{
+	const auto entryIter = m_entries.find(key);
+	if (entryIter == m_entries.end()) return;
+
+	// A read in flight is still taken and resolved
+	m_residentSize -= entryIter->second.TailSizes[entryIter->second.PendingMip];
+	m_entries.erase(entryIter);
+}
+
+void StreamScheduler::Request(const string& key, float screenSize)
+{
+	const auto entryIter = m_entries.find(key);
+	if (entryIter == m_entries.end()) return;
+
+	auto& entry = entryIter->second;
+	if (entry.LastRequested == m_frame && screenSize <= entry.ScreenSize) return;
+
+	entry.ScreenSize = screenSize;
+	entry.LastRequested = m_frame;
+
+	// The smallest mip still covering the screen size
+	const auto ratio = static_cast<float>((max)(entry.Width, entry.Height)) / screenSize;
+	if (screenSize <= 0.0f) entry.RequestedMip = entry.TailMip;
+	else entry.RequestedMip = ratio > 1.0f ? (min)(static_cast<uint32_t>(log2f(ratio)), entry.TailMip) : 0;
+}
+
+void StreamScheduler::Update()
+{
+	// Drop the finished reads
+	m_reads.erase(remove_if(m_reads.begin(), m_reads.end(), [](const future<void>& read)
+	{
+		return read.wait_for(chrono::seconds(0)) == future_status::ready;
+	}), m_reads.end());
+
+	// Shrink to a lowered budget
+	if (m_residentSize > m_budget) evict(m_residentSize - m_budget);
+
+	// Gather the textures to stream in; the tails go first, and then the largest on screen
+	vector<pair<float, EntryIter>> candidates;
+	for (auto entryIter = m_entries.begin(); entryIter != m_entries.end(); ++entryIter)
+	{
+		const auto& entry = entryIter->second;
+		if (entry.HasFailed || entry.PendingMip != entry.ResidentMip) continue;
+		if (getTargetMip(entry) >= entry.ResidentMip) continue;
+
+		const auto priority = entry.ResidentMip < entry.MipCount ? entry.ScreenSize : FLT_MAX;
+		candidates.emplace_back(priority, entryIter);
+	}
+
+	sort(candidates.begin(), candidates.end(), [](const pair<float, EntryIter>& a, const pair<float, EntryIter>& b)
+	{
+		return a.first > b.first;
+	});
+
+	for (const auto& candidate : candidates)
+	{
+		if (m_numPendingReads >= m_maxNumReads) break;
+
+		const auto& entry = candidate.second->second;
+		const auto mip = getTargetMip(entry);
+		const auto size = entry.TailSizes[mip] - entry.TailSizes[entry.ResidentMip];
+
+		// The tails are always read; over the budget, the higher mips in priority order
+		// wait for the evictions to make room, and for the replaced mips to be released
+		if (entry.ResidentMip < entry.MipCount)
+		{
+			if (m_residentSize + size > m_budget)
+			{
+				const auto isEvicted = evict(m_residentSize + size - m_budget);
+				if (!isEvicted || m_numPendingReads >= m_maxNumReads) break;
+			}
+
+			if (m_retainedSize > 0 && m_residentSize + m_retainedSize + size > m_budget) break;
+		}
+
+		beginRead(candidate.second, mip);
+	}
+
+	++m_frame;
+}
+
+void StreamScheduler::TakeCompleted(vector<Completion>& completions)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	completions.insert(completions.end(), make_move_iterator(m_completions.begin()),
+		make_move_iterator(m_completions.end()));
+	m_completions.clear();
+}
+
+void StreamScheduler::Resolve(const Completion& completion, bool succeeded)
+{
+	assert(m_numPendingReads > 0);
+	--m_numPendingReads;
+
+	// The mips to replace are still in use if the read failed to apply
+	const auto mip = completion.Mip;
+	if (!succeeded) Release(completion.RetainedSize);
+
+	const auto entryIter = m_entries.find(completion.Key);
+	if (entryIter == m_entries.end() || entryIter->second.PendingMip != mip) return;
+
+	auto& entry = entryIter->second;
+	if (succeeded) entry.ResidentMip = mip;
+	else
+	{
+		// Keep the resident mips, and stop streaming the texture
+		m_residentSize = m_residentSize - entry.TailSizes[mip] + entry.TailSizes[entry.ResidentMip];
+		entry.PendingMip = entry.ResidentMip;
+		entry.HasFailed = true;
+	}
+}
+
+void StreamScheduler::Release(uint64_t retainedSize)
+{
+	assert(m_retainedSize >= retainedSize);
+	m_retainedSize -= retainedSize;
+}
+
+void StreamScheduler::SetBudget(uint64_t budget)
+{
+	m_budget = budget;
+}
+
+uint64_t StreamScheduler::GetBudget() const
+{
+	return m_budget;
+}
+
+uint64_t StreamScheduler::GetResidentSize() const
+{
+	return m_residentSize;
+}
+
+uint64_t StreamScheduler::GetRetainedSize() const
+{
+	return m_retainedSize;
+}
+
+uint32_t StreamScheduler::GetResidentMip(const string& key) const
+{
+	const auto entryIter = m_entries.find(key);
+
+	return entryIter != m_entries.cend() ? entryIter->second.ResidentMip : UINT32_MAX;
+}
+
+uint32_t StreamScheduler::GetNumPendingReads() const
+{
+	return m_numPendingReads;
+}
+
+uint32_t StreamScheduler::getTargetMip(const Entry& entry) const
+{
+	// The textures not requested in the current frame only keep their tails
+	return entry.LastRequested == m_frame ? entry.RequestedMip : entry.TailMip;
+}
+
+bool StreamScheduler::evict(uint64_t size)
+{
+	// Evict the mips over the targets, from the least recently requested and the smallest on screen
+	vector<EntryIter> victims;
+	for (auto entryIter = m_entries.begin(); entryIter != m_entries.end(); ++entryIter)
+	{
+		const auto& entry = entryIter->second;
+		if (entry.HasFailed || entry.PendingMip != entry.ResidentMip) continue;
+		if (getTargetMip(entry) > entry.ResidentMip) victims.emplace_back(entryIter);
+	}
+
+	sort(victims.begin(), victims.end(), [](const EntryIter& a, const EntryIter& b)
+	{
+		if (a->second.LastRequested != b->second.LastRequested)
+			return a->second.LastRequested < b->second.LastRequested;
+
+		return a->second.ScreenSize < b->second.ScreenSize;
+	});
+
+	// The lower mips are read again to replace the textures
+	uint64_t evictedSize = 0;
+	for (const auto& victim : victims)
+	{
+		if (evictedSize >= size || m_numPendingReads >= m_maxNumReads) break;
+
+		const auto& entry = victim->second;
+		const auto mip = getTargetMip(entry);
+		evictedSize += entry.TailSizes[entry.ResidentMip] - entry.TailSizes[mip];
+		beginRead(victim, mip);
+	}
+
+	return evictedSize >= size;
+}
+
+void StreamScheduler::beginRead(EntryIter entryIter, uint32_t mip)
+{
+	// The resident mips stay in use until the read is applied and its result released
+	auto& entry = entryIter->second;
+	const auto retainedSize = entry.TailSizes[entry.ResidentMip];
+	m_residentSize = m_residentSize - entry.TailSizes[entry.PendingMip] + entry.TailSizes[mip];
+	m_retainedSize += retainedSize;
+	entry.PendingMip = mip;
+	++m_numPendingReads;
+
+	const auto& key = entryIter->first;
+	const auto maxSize = (max)((max)(entry.Width, entry.Height) >> mip, 1u);
+	m_reads.emplace_back(ThreadPool::GetDefault().Enqueue([this, key, mip, maxSize, retainedSize]()
+	{
+		Completion completion = { key, mip, vector<uint8_t>(), retainedSize, false };
+		completion.Succeeded = m_read(key, maxSize, completion.Data);
+
+		lock_guard<mutex> lock(m_mutex);
+		m_completions.emplace_back(move(completion));
+	}, m_readGroup));
+}
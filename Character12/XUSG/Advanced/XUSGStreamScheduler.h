@@ -0,0 +1,104 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "XUSGThreadPool.h"
+
+namespace XUSG
+{
+	//--------------------------------------------------------------------------------------
+	// Device-independent scheduling of texture mip streaming. The tail mips of every texture
+	// are read first and stay resident; the higher mips are read in the order of the requested
+	// screen sizes, and the least recently requested textures are evicted back to their tails
+	// over the budget. The reads run on the thread pool; their results are taken by the owner,
+	// which resolves each of them once applied. The mips replaced by a read count against the
+	// budget until the owner releases them. Except for the reads, the scheduler is used from a
+	// single thread.
+	//--------------------------------------------------------------------------------------
+	class StreamScheduler
+	{
+	public:
+		// Read the mips of the texture within maxSize, as a DDS file image
+		using ReadFunc = std::function<bool(const std::string& key, uint32_t maxSize, std::vector<uint8_t>& data)>;
+
+		struct Completion
+		{
+			std::string Key;
+			uint32_t Mip;
+			std::vector<uint8_t> Data;
+			uint64_t RetainedSize;	// Size of the mips to replace, kept until released
+			bool Succeeded;
+		};
+
+		StreamScheduler(const ReadFunc& read, uint64_t budget, uint32_t tailSize = 64, uint32_t maxNumReads = 4);
+		virtual ~StreamScheduler();
+
+		// The mip sizes include all the array and depth slices
+		bool Register(const std::string& key, uint32_t width, uint32_t height, const std::vector<uint64_t>& mipSizes);
+		void Unregister(const std::string& key);
+
+		// Screen-space size in pixels of the texture in the current frame; the largest one is kept
+		void Request(const std::string& key, float screenSize);
+
+		// Schedule the evictions and the reads of the current frame, and start the next frame
+		void Update();
+
+		// Take the completed reads; each must be resolved once applied, or once failed to apply.
+		// The retained size of a failed one is released here, and the retained size of an
+		// applied one must be released once the replaced mips are no longer used.
+		void TakeCompleted(std::vector<Completion>& completions);
+		void Resolve(const Completion& completion, bool succeeded);
+		void Release(uint64_t retainedSize);
+
+		void SetBudget(uint64_t budget);
+		uint64_t GetBudget() const;
+		// Size of the resident mips once the reads in flight are resolved
+		uint64_t GetResidentSize() const;
+		// Size of the replaced mips not yet released, including the ones of the reads in flight
+		uint64_t GetRetainedSize() const;
+		// Returns the number of mips if none is resident, or UINT32_MAX if the texture is not registered
+		uint32_t GetResidentMip(const std::string& key) const;
+		uint32_t GetNumPendingReads() const;
+
+	protected:
+		struct Entry
+		{
+			uint32_t Width;
+			uint32_t Height;
+			uint32_t MipCount;
+			uint32_t TailMip;
+			uint32_t ResidentMip;	// MipCount if none is resident
+			uint32_t PendingMip;	// ResidentMip if no read is in flight
+			uint32_t RequestedMip;
+			float ScreenSize;
+			uint64_t LastRequested;	// Frame
+			bool HasFailed;
+			std::vector<uint64_t> TailSizes;	// Sizes from each mip down to the last one, followed by 0
+		};
+
+		using EntryIter = std::unordered_map<std::string, Entry>::iterator;
+
+		uint32_t getTargetMip(const Entry& entry) const;
+		bool evict(uint64_t size);
+		void beginRead(EntryIter entryIter, uint32_t mip);
+
+		ReadFunc	m_read;
+		uint64_t	m_budget;
+		uint32_t	m_tailSize;
+		uint32_t	m_maxNumReads;
+
+		uint64_t	m_frame;
+		uint64_t	m_residentSize;
+		uint64_t	m_retainedSize;
+		uint32_t	m_numPendingReads;
+
+		std::unordered_map<std::string, Entry> m_entries;
+		std::vector<std::future<void>> m_reads;
+		ThreadPool::Group m_readGroup;
+
+		std::mutex	m_mutex;
+		std::vector<Completion> m_completions;
+	};
+}
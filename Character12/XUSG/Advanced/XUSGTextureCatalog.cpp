@@ -0,0 +1,297 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include <unordered_set>
+#include "XUSGTextureCatalog.h"
+#include "XUSGHash.h"
+#include "XUSGThreadPool.h"
+#include "Core/XUSG_DX12.h"
+
+using namespace std;
+using namespace XUSG;
+
+struct DefaultCatalog
+{
+	mutex Mutex;
+	TextureCatalog::sptr Catalog;
+};
+
+static DefaultCatalog& GetDefaultCatalog()
+{
+	static DefaultCatalog defaultCatalog;
+
+	return defaultCatalog;
+}
+
+static bool IsDDSFile(const wstring& filePath)
+{
+	static const wstring extension = L".dds";
+
+	return filePath.size() > extension.size() &&
+		filePath.compare(filePath.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+//--------------------------------------------------------------------------------------
+// Create interfaces
+//--------------------------------------------------------------------------------------
+TextureCatalog::uptr TextureCatalog::MakeUnique(API api)
+{
+	return make_unique<TextureCatalog_Impl>(api);
+}
+
+TextureCatalog::sptr TextureCatalog::MakeShared(API api)
+{
+	return make_shared<TextureCatalog_Impl>(api);
+}
+
+void TextureCatalog::SetDefault(const sptr& catalog)
+{
+	auto& defaultCatalog = GetDefaultCatalog();
+	lock_guard<mutex> lock(defaultCatalog.Mutex);
+	defaultCatalog.Catalog = catalog;
+}
+
+TextureCatalog::sptr TextureCatalog::GetDefault()
+{
+	auto& defaultCatalog = GetDefaultCatalog();
+	lock_guard<mutex> lock(defaultCatalog.Mutex);
+
+	return defaultCatalog.Catalog;
+}
+
+//--------------------------------------------------------------------------------------
+// Texture catalog implementations
+//--------------------------------------------------------------------------------------
+TextureCatalog_Impl::TextureCatalog_Impl(API api) :
+	m_api(api),
+	m_records()
+{
+}
+
+TextureCatalog_Impl::~TextureCatalog_Impl()
+{
+}
+
+uint32_t TextureCatalog_Impl::Build(const wchar_t* rootPath)
+{
+	F_RETURN(!rootPath, cerr, E_INVALIDARG, 0);
+
+	// The paths are cataloged as normalized by the lookups
+	auto root = Hash::NormalizePath(rootPath, true);
+	if (root == L".\\") root.clear();
+
+	vector<FileStamp> files;
+	listFiles(root, files);
+
+	// Only the new and the changed files are read
+	vector<const FileStamp*> changedFiles;
+	{
+		shared_lock<shared_timed_mutex> lock(m_mutex);
+		for (const auto& file : files)
+		{
+			const auto recordIter = m_records.find(file.Path);
+			if (recordIter == m_records.cend() || recordIter->second.FileSize != file.FileSize ||
+				recordIter->second.LastWriteTime != file.LastWriteTime)
+				changedFiles.emplace_back(&file);
+		}
+	}
+
+	const auto numChangedFiles = static_cast<uint32_t>(changedFiles.size());
+	vector<Record> records(numChangedFiles);
+	vector<uint8_t> isRead(numChangedFiles);
+	ThreadPool::GetDefault().ParallelFor(numChangedFiles, [&](uint32_t i)
+	{
+		const auto& file = *changedFiles[i];
+		auto& record = records[i];
+		record = {};
+		record.FileSize = file.FileSize;
+		record.LastWriteTime = file.LastWriteTime;
+		record.PathLength = static_cast<uint32_t>(file.Path.size());
+		isRead[i] = DDS::Loader::LoadTextureInfo(file.Path.c_str(), record.Info);
+	});
+
+	unordered_set<wstring> filePaths;
+	for (const auto& file : files) filePaths.emplace(file.Path);
+
+	lock_guard<shared_timed_mutex> lock(m_mutex);
+
+	// Drop the removed files under the root, and the files no longer readable
+	for (auto recordIter = m_records.begin(); recordIter != m_records.end();)
+	{
+		const auto& filePath = recordIter->first;
+		if (filePath.compare(0, root.size(), root) == 0 && filePaths.find(filePath) == filePaths.cend())
+			recordIter = m_records.erase(recordIter);
+		else ++recordIter;
+	}
+
+	uint32_t numReadFiles = 0;
+	for (auto i = 0u; i < numChangedFiles; ++i)
+	{
+		const auto& filePath = changedFiles[i]->Path;
+		if (isRead[i])
+		{
+			m_records[filePath] = records[i];
+			++numReadFiles;
+		}
+		else m_records.erase(filePath);
+	}
+
+	return numReadFiles;
+}
+
+bool TextureCatalog_Impl::Load(const wchar_t* fileName)
+{
+	F_RETURN(!fileName, cerr, E_INVALIDARG, false);
+
+	ifstream fileStream(fileName, ios::in | ios::binary);
+	F_RETURN(!fileStream, cerr, MAKE_HRESULT(SEVERITY_ERROR, FACILITY_ITF, 0x0903), false);
+
+	Header header;
+	XUSG_N_RETURN(fileStream.read(reinterpret_cast<char*>(&header), sizeof(header)), false);
+	XUSG_C_RETURN(header.Magic != MAGIC || header.Version != VERSION, false);
+
+	unordered_map<wstring, Record> records;
+	records.reserve(header.NumRecords);
+	for (auto i = 0u; i < header.NumRecords; ++i)
+	{
+		Record record;
+		XUSG_N_RETURN(fileStream.read(reinterpret_cast<char*>(&record), sizeof(record)), false);
+		XUSG_C_RETURN(record.PathLength == 0 || record.PathLength > UNICODE_STRING_MAX_CHARS, false);
+
+		wstring filePath(record.PathLength, L'\0');
+		XUSG_N_RETURN(fileStream.read(reinterpret_cast<char*>(&filePath[0]),
+			sizeof(wchar_t) * record.PathLength), false);
+		records[move(filePath)] = record;
+	}
+
+	lock_guard<shared_timed_mutex> lock(m_mutex);
+	m_records.swap(records);
+
+	return true;
+}
+
+bool TextureCatalog_Impl::Save(const wchar_t* fileName) const
+{
+	F_RETURN(!fileName, cerr, E_INVALIDARG, false);
+
+	ofstream fileStream(fileName, ios::out | ios::binary);
+	F_RETURN(!fileStream, cerr, MAKE_HRESULT(SEVERITY_ERROR, FACILITY_ITF, 0x0903), false);
+
+	shared_lock<shared_timed_mutex> lock(m_mutex);
+
+	Header header = {};
+	header.Magic = MAGIC;
+	header.Version = VERSION;
+	header.NumRecords = static_cast<uint32_t>(m_records.size());
+	fileStream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	for (const auto& record : m_records)
+	{
+		const auto& filePath = record.first;
+		fileStream.write(reinterpret_cast<const char*>(&record.second), sizeof(Record));
+		fileStream.write(reinterpret_cast<const char*>(filePath.c_str()), sizeof(wchar_t) * filePath.size());
+	}
+
+	XUSG_N_RETURN(fileStream.flush(), false);
+
+	return true;
+}
+
+void TextureCatalog_Impl::Clear()
+{
+	lock_guard<shared_timed_mutex> lock(m_mutex);
+	m_records.clear();
+}
+
+bool TextureCatalog_Impl::Find(const wchar_t* filePath, DDS::TextureInfo* pInfo) const
+{
+	F_RETURN(!filePath, cerr, E_INVALIDARG, false);
+
+	// The files on disk are cataloged, but the loaders read the mounted archives first
+	XUSG_C_RETURN(PakArchive::ContainsMounted(filePath), false);
+
+	Record record;
+	{
+		const auto normalizedPath = Hash::NormalizePath(filePath);
+		shared_lock<shared_timed_mutex> lock(m_mutex);
+
+		const auto recordIter = m_records.find(normalizedPath);
+		XUSG_C_RETURN(recordIter == m_records.cend(), false);
+		record = recordIter->second;
+	}
+
+	// Check the stamp of the file, so that a changed file has its header read instead
+	WIN32_FILE_ATTRIBUTE_DATA fileData;
+	XUSG_N_RETURN(GetFileAttributesExW(filePath, GetFileExInfoStandard, &fileData), false);
+	const auto fileSize = (static_cast<uint64_t>(fileData.nFileSizeHigh) << 32) | fileData.nFileSizeLow;
+	const auto lastWriteTime = (static_cast<uint64_t>(fileData.ftLastWriteTime.dwHighDateTime) << 32) |
+		fileData.ftLastWriteTime.dwLowDateTime;
+	XUSG_C_RETURN(fileSize != record.FileSize || lastWriteTime != record.LastWriteTime, false);
+
+	if (pInfo) *pInfo = record.Info;
+
+	return true;
+}
+
+uint64_t TextureCatalog_Impl::GetTextureSize(const wchar_t* filePath) const
+{
+	DDS::TextureInfo info;
+	XUSG_C_RETURN(!Find(filePath, &info), 0);
+
+	uint64_t size = 0;
+	for (auto i = 0u; i < info.MipCount; ++i)
+	{
+		const auto width = (max)(info.Width >> i, 1u);
+		const auto height = (max)(info.Height >> i, 1u);
+		const auto depth = (max)(info.Depth >> i, 1u);
+		size += DDS::Loader::GetSurfaceSize(width, height, info.Format) * depth;
+	}
+
+	return size * info.ArraySize;
+}
+
+uint32_t TextureCatalog_Impl::GetNumTextures() const
+{
+	shared_lock<shared_timed_mutex> lock(m_mutex);
+
+	return static_cast<uint32_t>(m_records.size());
+}
+
+void TextureCatalog_Impl::listFiles(const wstring& directory, vector<FileStamp>& files)
+{
+	vector<wstring> directories(1, directory);
+	while (!directories.empty())
+	{
+		const auto currentDirectory = move(directories.back());
+		directories.pop_back();
+
+		WIN32_FIND_DATAW findData;
+		const auto hFind = FindFirstFileExW((currentDirectory + L"*").c_str(), FindExInfoBasic, &findData,
+			FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+		if (hFind == INVALID_HANDLE_VALUE) continue;
+
+		do
+		{
+			wstring fileName = findData.cFileName;
+			transform(fileName.begin(), fileName.end(), fileName.begin(), towlower);
+
+			if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			{
+				if (fileName != L"." && fileName != L"..")
+					directories.emplace_back(currentDirectory + fileName + L'\\');
+			}
+			else if (IsDDSFile(fileName))
+			{
+				FileStamp file;
+				file.Path = currentDirectory + fileName;
+				file.FileSize = (static_cast<uint64_t>(findData.nFileSizeHigh) << 32) | findData.nFileSizeLow;
+				file.LastWriteTime = (static_cast<uint64_t>(findData.ftLastWriteTime.dwHighDateTime) << 32) |
+					findData.ftLastWriteTime.dwLowDateTime;
+				files.emplace_back(move(file));
+			}
+		} while (FindNextFileW(hFind, &findData));
+
+		FindClose(hFind);
+	}
+}
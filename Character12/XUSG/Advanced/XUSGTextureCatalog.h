@@ -0,0 +1,63 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <shared_mutex>
+#include "XUSGAdvanced.h"
+
+namespace XUSG
+{
+	class TextureCatalog_Impl :
+		public virtual TextureCatalog
+	{
+	public:
+		TextureCatalog_Impl(API api = API::DIRECTX_12);
+		virtual ~TextureCatalog_Impl();
+
+		uint32_t Build(const wchar_t* rootPath);
+		bool Load(const wchar_t* fileName);
+		bool Save(const wchar_t* fileName) const;
+		void Clear();
+
+		bool Find(const wchar_t* filePath, DDS::TextureInfo* pInfo = nullptr) const;
+		uint64_t GetTextureSize(const wchar_t* filePath) const;
+		uint32_t GetNumTextures() const;
+
+		static const uint32_t MAGIC = 0x54435458;	// "XTCT"
+		static const uint32_t VERSION = 1;
+
+		struct Header
+		{
+			uint32_t Magic;
+			uint32_t Version;
+			uint32_t NumRecords;
+			uint32_t Reserved;
+		};
+
+		// Each record is followed by its path of PathLength characters
+		struct Record
+		{
+			uint64_t FileSize;
+			uint64_t LastWriteTime;
+			DDS::TextureInfo Info;
+			uint32_t PathLength;
+		};
+
+	protected:
+		struct FileStamp
+		{
+			std::wstring Path;
+			uint64_t FileSize;
+			uint64_t LastWriteTime;
+		};
+
+		static void listFiles(const std::wstring& directory, std::vector<FileStamp>& files);
+
+		API m_api;
+
+		mutable std::shared_timed_mutex m_mutex;
+		std::unordered_map<std::wstring, Record> m_records;
+	};
+}
@@ -0,0 +1,210 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "XUSGTextureLibrary.h"
+
+using namespace std;
+using namespace XUSG;
+
+//--------------------------------------------------------------------------------------
+// Create interfaces
+//--------------------------------------------------------------------------------------
+TextureLibrary::uptr TextureLibrary::MakeUnique(API api)
+{
+	return make_unique<TextureLibrary_Impl>(api);
+}
+
+TextureLibrary::sptr TextureLibrary::MakeShared(API api)
+{
+	return make_shared<TextureLibrary_Impl>(api);
+}
+
+ContentKey TextureLibrary::HashContent(const void* pData, size_t size, uint64_t seed)
+{
+	return Hash::GetContentKey(pData, size, seed);
+}
+
+//--------------------------------------------------------------------------------------
+// Texture library implementations
+//--------------------------------------------------------------------------------------
+TextureLibrary_Impl::TextureLibrary_Impl(API api) :
+	m_api(api),
+	m_ids(),
+	m_contents(),
+	m_isContentHashing(false),
+	m_generation(0)
+{
+}
+
+TextureLibrary_Impl::~TextureLibrary_Impl()
+{
+}
+
+uint32_t TextureLibrary_Impl::Intern(const string& key)
+{
+	auto normalizedKey = Hash::NormalizePath(key);
+	{
+		shared_lock<shared_timed_mutex> lock(m_idMutex);
+		const auto idIter = m_ids.find(normalizedKey);
+		if (idIter != m_ids.cend()) return idIter->second;
+	}
+
+	lock_guard<shared_timed_mutex> lock(m_idMutex);
+	const auto id = static_cast<uint32_t>(m_ids.size());
+
+	// Another thread may have interned the key meanwhile
+	return m_ids.emplace(move(normalizedKey), id).first->second;
+}
+
+bool TextureLibrary_Impl::Find(const string& key, TextureRecord* pRecord) const
+{
+	const auto id = findID(key);
+
+	return id != INVALID_ID ? Find(id, pRecord) : false;
+}
+
+bool TextureLibrary_Impl::Find(uint32_t id, TextureRecord* pRecord) const
+{
+	const auto& shard = getShard(id);
+	shared_lock<shared_timed_mutex> lock(shard.Mutex);
+
+	const auto recordIter = shard.Records.find(id);
+	XUSG_C_RETURN(recordIter == shard.Records.cend(), false);
+
+	if (pRecord) *pRecord = recordIter->second;
+
+	return true;
+}
+
+TextureRecord TextureLibrary_Impl::Insert(const string& key, const TextureRecord& record)
+{
+	return Insert(Intern(key), record);
+}
+
+TextureRecord TextureLibrary_Impl::Insert(uint32_t id, const TextureRecord& record)
+{
+	auto& shard = getShard(id);
+	lock_guard<shared_timed_mutex> lock(shard.Mutex);
+
+	// The first inserted record wins, so that every mesh shares the same texture
+	const auto inserted = shard.Records.emplace(id, record);
+	if (inserted.second) ++m_generation;
+
+	return inserted.first->second;
+}
+
+TextureRecord TextureLibrary_Impl::Assign(const string& key, const TextureRecord& record)
+{
+	return Assign(Intern(key), record);
+}
+
+TextureRecord TextureLibrary_Impl::Assign(uint32_t id, const TextureRecord& record)
+{
+	auto& shard = getShard(id);
+	lock_guard<shared_timed_mutex> lock(shard.Mutex);
+
+	auto& current = shard.Records[id];
+	const auto replaced = current;
+	current = record;
+	++m_generation;
+
+	return replaced;
+}
+
+bool TextureLibrary_Impl::Erase(const string& key)
+{
+	const auto id = findID(key);
+
+	return id != INVALID_ID ? Erase(id) : false;
+}
+
+bool TextureLibrary_Impl::Erase(uint32_t id)
+{
+	auto& shard = getShard(id);
+	lock_guard<shared_timed_mutex> lock(shard.Mutex);
+	XUSG_C_RETURN(shard.Records.erase(id) == 0, false);
+	++m_generation;
+
+	return true;
+}
+
+void TextureLibrary_Impl::Clear()
+{
+	// The IDs stay interned
+	for (auto& shard : m_shards)
+	{
+		lock_guard<shared_timed_mutex> lock(shard.Mutex);
+		shard.Records.clear();
+	}
+	++m_generation;
+
+	lock_guard<shared_timed_mutex> lock(m_contentMutex);
+	m_contents.clear();
+}
+
+void TextureLibrary_Impl::SetContentHashing(bool enable)
+{
+	m_isContentHashing = enable;
+}
+
+bool TextureLibrary_Impl::IsContentHashing() const
+{
+	return m_isContentHashing;
+}
+
+bool TextureLibrary_Impl::FindContent(const ContentKey& contentKey, TextureRecord* pRecord) const
+{
+	auto id = INVALID_ID;
+	{
+		shared_lock<shared_timed_mutex> lock(m_contentMutex);
+		const auto contentIter = m_contents.find(contentKey);
+		if (contentIter != m_contents.cend()) id = contentIter->second;
+	}
+
+	// The record of the ID may have been replaced or erased since
+	return id != INVALID_ID ? Find(id, pRecord) : false;
+}
+
+void TextureLibrary_Impl::InsertContent(const ContentKey& contentKey, uint32_t id)
+{
+	lock_guard<shared_timed_mutex> lock(m_contentMutex);
+	m_contents.emplace(contentKey, id);
+}
+
+size_t TextureLibrary_Impl::GetSize() const
+{
+	size_t size = 0;
+	for (const auto& shard : m_shards)
+	{
+		shared_lock<shared_timed_mutex> lock(shard.Mutex);
+		size += shard.Records.size();
+	}
+
+	return size;
+}
+
+uint64_t TextureLibrary_Impl::GetGeneration() const
+{
+	return m_generation;
+}
+
+uint32_t TextureLibrary_Impl::findID(const string& key) const
+{
+	const auto normalizedKey = Hash::NormalizePath(key);
+
+	shared_lock<shared_timed_mutex> lock(m_idMutex);
+	const auto idIter = m_ids.find(normalizedKey);
+
+	return idIter != m_ids.cend() ? idIter->second : INVALID_ID;
+}
+
+TextureLibrary_Impl::Shard& TextureLibrary_Impl::getShard(uint32_t id)
+{
+	return m_shards[id % NUM_SHARDS];
+}
+
+const TextureLibrary_Impl::Shard& TextureLibrary_Impl::getShard(uint32_t id) const
+{
+	return m_shards[id % NUM_SHARDS];
+}
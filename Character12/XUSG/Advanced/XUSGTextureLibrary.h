@@ -0,0 +1,71 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <shared_mutex>
+#include "XUSGHash.h"
+
+namespace XUSG
+{
+	//--------------------------------------------------------------------------------------
+	// Texture library, sharded by the interned IDs so that concurrent cache hits only take
+	// shared locks
+	//--------------------------------------------------------------------------------------
+	class TextureLibrary_Impl :
+		public virtual TextureLibrary
+	{
+	public:
+		TextureLibrary_Impl(API api = API::DIRECTX_12);
+		virtual ~TextureLibrary_Impl();
+
+		uint32_t Intern(const std::string& key);
+
+		bool Find(const std::string& key, TextureRecord* pRecord = nullptr) const;
+		bool Find(uint32_t id, TextureRecord* pRecord = nullptr) const;
+		TextureRecord Insert(const std::string& key, const TextureRecord& record);
+		TextureRecord Insert(uint32_t id, const TextureRecord& record);
+		TextureRecord Assign(const std::string& key, const TextureRecord& record);
+		TextureRecord Assign(uint32_t id, const TextureRecord& record);
+		bool Erase(const std::string& key);
+		bool Erase(uint32_t id);
+		void Clear();
+
+		void SetContentHashing(bool enable);
+		bool IsContentHashing() const;
+		bool FindContent(const ContentKey& contentKey, TextureRecord* pRecord = nullptr) const;
+		void InsertContent(const ContentKey& contentKey, uint32_t id);
+
+		size_t GetSize() const;
+		uint64_t GetGeneration() const;
+
+	protected:
+		static const uint32_t NUM_SHARDS = 16;
+		static const uint32_t INVALID_ID = UINT32_MAX;
+
+		struct Shard
+		{
+			mutable std::shared_timed_mutex Mutex;
+			std::unordered_map<uint32_t, TextureRecord> Records;
+		};
+
+		uint32_t findID(const std::string& key) const;
+
+		Shard& getShard(uint32_t id);
+		const Shard& getShard(uint32_t id) const;
+
+		API m_api;
+
+		mutable std::shared_timed_mutex m_idMutex;
+		std::unordered_map<std::string, uint32_t> m_ids;
+
+		mutable std::shared_timed_mutex m_contentMutex;
+		std::unordered_map<ContentKey, uint32_t, Hash::ContentKeyHasher> m_contents;
+		std::atomic<bool> m_isContentHashing;
+		std::atomic<uint64_t> m_generation;
+
+		Shard m_shards[NUM_SHARDS];
+	};
+}
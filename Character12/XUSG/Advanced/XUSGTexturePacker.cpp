@@ -0,0 +1,107 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include <array>
+#include <map>
+#include "XUSGTexturePacker.h"
+
+using namespace std;
+using namespace XUSG;
+
+using TextureTuple = array<uintptr_t, TexturePacker::NUM_CHANNEL>;
+
+//--------------------------------------------------------------------------------------
+// Helper functions
+//--------------------------------------------------------------------------------------
+static bool IsCompatibleAll(const TexturePacker::TextureDesc* pDescsA, const TexturePacker::TextureDesc* pDescsB)
+{
+	for (uint8_t c = 0; c < TexturePacker::NUM_CHANNEL; ++c)
+		if (!TexturePacker::IsCompatible(pDescsA[c], pDescsB[c])) return false;
+
+	return true;
+}
+
+//--------------------------------------------------------------------------------------
+// Texture packer
+//--------------------------------------------------------------------------------------
+uint32_t TexturePacker::ArraySet::GetNumSlices() const
+{
+	return static_cast<uint32_t>(Slices.size() / NUM_CHANNEL);
+}
+
+bool TexturePacker::IsCompatible(const TextureDesc& a, const TextureDesc& b)
+{
+	return a.ArraySize == 1 && b.ArraySize == 1 && a.Format != Format::UNKNOWN &&
+		a.Format == b.Format && a.Width == b.Width && a.Height == b.Height &&
+		a.NumMips == b.NumMips && a.Width > 0 && a.Height > 0 && a.NumMips > 0;
+}
+
+bool TexturePacker::Pack(const TextureDesc* pMaterialTextures, uint32_t numMaterials,
+	vector<ArraySet>& arraySets, vector<Slot>& slots, uint32_t maxSlices)
+{
+	arraySets.clear();
+	slots.assign(numMaterials, { UINT32_MAX, 0 });
+
+	// The slice of each texture tuple in each set
+	vector<map<TextureTuple, uint32_t>> sliceIndices;
+
+	for (auto m = 0u; m < numMaterials; ++m)
+	{
+		const auto pTextures = &pMaterialTextures[NUM_CHANNEL * m];
+
+		TextureTuple textures;
+		auto isComplete = true;
+		for (uint8_t c = 0; c < NUM_CHANNEL; ++c)
+		{
+			textures[c] = reinterpret_cast<uintptr_t>(pTextures[c].pTexture);
+			isComplete = isComplete && pTextures[c].pTexture;
+		}
+		if (!isComplete) continue;
+
+		// Textures that cannot be a slice of any array, e.g. cube maps
+		if (!IsCompatibleAll(pTextures, pTextures))
+		{
+			arraySets.clear();
+			slots.clear();
+
+			return false;
+		}
+
+		// The slice of the same textures, or else the first set of the same descriptions with room
+		auto set = UINT32_MAX;
+		auto slice = UINT32_MAX;
+		for (auto s = 0u; s < arraySets.size() && slice == UINT32_MAX; ++s)
+		{
+			if (!IsCompatibleAll(arraySets[s].Descs, pTextures)) continue;
+
+			const auto found = sliceIndices[s].find(textures);
+			if (found != sliceIndices[s].cend())
+			{
+				set = s;
+				slice = found->second;
+			}
+			else if (set == UINT32_MAX && arraySets[s].GetNumSlices() < maxSlices) set = s;
+		}
+
+		if (set == UINT32_MAX)
+		{
+			set = static_cast<uint32_t>(arraySets.size());
+			arraySets.emplace_back();
+			copy(pTextures, pTextures + NUM_CHANNEL, arraySets.back().Descs);
+			sliceIndices.emplace_back();
+		}
+
+		if (slice == UINT32_MAX)
+		{
+			auto& arraySet = arraySets[set];
+			slice = arraySet.GetNumSlices();
+			for (uint8_t c = 0; c < NUM_CHANNEL; ++c) arraySet.Slices.emplace_back(pTextures[c].pTexture);
+			sliceIndices[set][textures] = slice;
+		}
+
+		slots[m] = { set, slice };
+	}
+
+	return true;
+}
@@ -0,0 +1,66 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "XUSGAdvanced.h"
+
+namespace XUSG
+{
+	//--------------------------------------------------------------------------------------
+	// Texture packer, grouping the materials of which the albedo, normal and specular textures
+	// have the same formats, sizes and mip counts into texture array sets, with a slice index
+	// per material. The materials of identical textures share a slice. Only the plan is made
+	// here, so that it needs no device; the textures are copied into the arrays by the mesh.
+	//--------------------------------------------------------------------------------------
+	class TexturePacker
+	{
+	public:
+		enum Channel : uint8_t
+		{
+			ALBEDO,
+			NORMAL,
+			SPECULAR,
+
+			NUM_CHANNEL
+		};
+
+		// The texture is only an identity here; a null texture means the channel is missing
+		struct TextureDesc
+		{
+			const void*	pTexture;
+			Format		Format;
+			uint32_t	Width;
+			uint32_t	Height;
+			uint16_t	ArraySize;
+			uint8_t		NumMips;
+		};
+
+		// The textures of the slices are in the order of the channels
+		struct ArraySet
+		{
+			TextureDesc				Descs[NUM_CHANNEL];
+			std::vector<const void*> Slices;
+
+			uint32_t GetNumSlices() const;
+		};
+
+		// The set is UINT32_MAX for the materials not packed
+		struct Slot
+		{
+			uint32_t Set;
+			uint32_t Slice;
+		};
+
+		// Whether two textures can be slices of one array: single 2D textures of the same format,
+		// size and mip count
+		static bool IsCompatible(const TextureDesc& a, const TextureDesc& b);
+
+		// Pack the materials of NUM_CHANNEL texture descriptions each. Returns false, leaving the
+		// outputs empty, if any material of all the channels cannot be packed, so that the arrays
+		// are used for all the materials, or none; the materials missing a channel are not packed.
+		static bool Pack(const TextureDesc* pMaterialTextures, uint32_t numMaterials,
+			std::vector<ArraySet>& arraySets, std::vector<Slot>& slots, uint32_t maxSlices = 2048);
+	};
+}
@@ -0,0 +1,172 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "XUSGTextureStreamer.h"
+#include "Core/XUSG_DX12.h"
+
+using namespace std;
+using namespace XUSG;
+
+//--------------------------------------------------------------------------------------
+// Create interfaces
+//--------------------------------------------------------------------------------------
+TextureStreamer::uptr TextureStreamer::MakeUnique(API api)
+{
+	return make_unique<TextureStreamer_Impl>(api);
+}
+
+TextureStreamer::sptr TextureStreamer::MakeShared(API api)
+{
+	return make_shared<TextureStreamer_Impl>(api);
+}
+
+//--------------------------------------------------------------------------------------
+// Texture streamer implementations
+//--------------------------------------------------------------------------------------
+TextureStreamer_Impl::TextureStreamer_Impl(API api) :
+	m_api(api),
+	m_textureLib(nullptr),
+	m_scheduler(nullptr),
+	m_forceSRGBs(),
+	m_retiredTextures(),
+	m_numCommits(0)
+{
+}
+
+TextureStreamer_Impl::~TextureStreamer_Impl()
+{
+}
+
+bool TextureStreamer_Impl::Init(const TextureLib& textureLib, uint64_t budget,
+	uint32_t tailSize, uint32_t maxNumReads)
+{
+	F_RETURN(!textureLib, cerr, E_INVALIDARG, false);
+
+	m_textureLib = textureLib;
+	m_scheduler = make_unique<StreamScheduler>(readTexture, budget, tailSize, maxNumReads);
+	m_forceSRGBs.clear();
+
+	return true;
+}
+
+bool TextureStreamer_Impl::Register(const string& key, bool forceSRGB)
+{
+	assert(m_scheduler);
+
+	// Only the headers are read here, unless the default catalog has them
+	const wstring fileName(key.cbegin(), key.cend());
+	const auto catalog = TextureCatalog::GetDefault();
+	DDS::TextureInfo info;
+	if (!catalog || !catalog->Find(fileName.c_str(), &info))
+		XUSG_N_RETURN(DDS::Loader::LoadTextureInfo(fileName.c_str(), info), false);
+
+	vector<uint64_t> mipSizes(info.MipCount);
+	for (auto i = 0u; i < info.MipCount; ++i)
+	{
+		const auto width = (max)(info.Width >> i, 1u);
+		const auto height = (max)(info.Height >> i, 1u);
+		const auto depth = (max)(info.Depth >> i, 1u);
+		mipSizes[i] = DDS::Loader::GetSurfaceSize(width, height, info.Format) * depth * info.ArraySize;
+	}
+
+	XUSG_N_RETURN(m_scheduler->Register(key, info.Width, info.Height, mipSizes), false);
+	m_forceSRGBs[key] = forceSRGB;
+
+	return true;
+}
+
+void TextureStreamer_Impl::Unregister(const string& key)
+{
+	assert(m_scheduler);
+	m_scheduler->Unregister(key);
+	m_forceSRGBs.erase(key);
+}
+
+void TextureStreamer_Impl::Request(const string& key, float screenSize)
+{
+	assert(m_scheduler);
+	m_scheduler->Request(key, screenSize);
+}
+
+void TextureStreamer_Impl::Update()
+{
+	assert(m_scheduler);
+	m_scheduler->Update();
+}
+
+uint32_t TextureStreamer_Impl::Commit(CommandList* pCommandList, vector<Resource::uptr>& uploaders)
+{
+	assert(m_scheduler);
+
+	// Release the replaced textures once the frames in flight are done with them
+	++m_numCommits;
+	while (!m_retiredTextures.empty() && m_retiredTextures.front().Commit + XUSG_FRAME_COUNT <= m_numCommits)
+	{
+		m_scheduler->Release(m_retiredTextures.front().RetainedSize);
+		m_retiredTextures.pop_front();
+	}
+
+	vector<StreamScheduler::Completion> completions;
+	m_scheduler->TakeCompleted(completions);
+
+	DDS::Loader textureLoader;
+	uint32_t numCommitted = 0;
+	for (const auto& completion : completions)
+	{
+		// The texture may have been unregistered meanwhile
+		const auto forceSRGBIter = m_forceSRGBs.find(completion.Key);
+		auto succeeded = completion.Succeeded && forceSRGBIter != m_forceSRGBs.cend();
+
+		if (succeeded)
+		{
+			Texture::sptr texture;
+			DDS::AlphaMode alphaMode;
+			uploaders.emplace_back(Resource::MakeUnique(m_api));
+			succeeded = textureLoader.CreateTextureFromMemory(pCommandList, completion.Data.data(),
+				completion.Data.size(), 0, forceSRGBIter->second, texture, uploaders.back().get(),
+				&alphaMode, ResourceState::COMMON, MemoryFlag::NONE, m_api);
+
+			if (succeeded)
+			{
+				const auto replaced = m_textureLib->Assign(completion.Key, { texture, static_cast<uint8_t>(alphaMode) });
+				if (replaced.Texture) m_retiredTextures.push_back({ m_numCommits, replaced.Texture, completion.RetainedSize });
+				else m_scheduler->Release(completion.RetainedSize);
+				++numCommitted;
+			}
+		}
+
+		m_scheduler->Resolve(completion, succeeded);
+	}
+
+	return numCommitted;
+}
+
+void TextureStreamer_Impl::SetBudget(uint64_t budget)
+{
+	assert(m_scheduler);
+	m_scheduler->SetBudget(budget);
+}
+
+uint64_t TextureStreamer_Impl::GetBudget() const
+{
+	return m_scheduler ? m_scheduler->GetBudget() : 0;
+}
+
+uint64_t TextureStreamer_Impl::GetResidentSize() const
+{
+	return m_scheduler ? m_scheduler->GetResidentSize() + m_scheduler->GetRetainedSize() : 0;
+}
+
+uint32_t TextureStreamer_Impl::GetResidentMip(const string& key) const
+{
+	return m_scheduler ? m_scheduler->GetResidentMip(key) : UINT32_MAX;
+}
+
+bool TextureStreamer_Impl::readTexture(const string& key, uint32_t maxSize, vector<uint8_t>& data)
+{
+	// The mounted archives are looked up first
+	const wstring fileName(key.cbegin(), key.cend());
+
+	return DDS::Loader::LoadTextureData(fileName.c_str(), data, maxSize);
+}
@@ -0,0 +1,54 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "XUSGAdvanced.h"
+#include "XUSGStreamScheduler.h"
+
+namespace XUSG
+{
+	class TextureStreamer_Impl :
+		public virtual TextureStreamer
+	{
+	public:
+		TextureStreamer_Impl(API api = API::DIRECTX_12);
+		virtual ~TextureStreamer_Impl();
+
+		bool Init(const TextureLib& textureLib, uint64_t budget,
+			uint32_t tailSize = 64, uint32_t maxNumReads = 4);
+
+		bool Register(const std::string& key, bool forceSRGB);
+		void Unregister(const std::string& key);
+
+		void Request(const std::string& key, float screenSize);
+		void Update();
+		uint32_t Commit(CommandList* pCommandList, std::vector<Resource::uptr>& uploaders);
+
+		void SetBudget(uint64_t budget);
+		uint64_t GetBudget() const;
+		uint64_t GetResidentSize() const;
+		uint32_t GetResidentMip(const std::string& key) const;
+
+	protected:
+		static bool readTexture(const std::string& key, uint32_t maxSize, std::vector<uint8_t>& data);
+
+		API m_api;
+
+		TextureLib m_textureLib;
+		std::unique_ptr<StreamScheduler> m_scheduler;
+		std::unordered_map<std::string, bool> m_forceSRGBs;
+
+		struct RetiredTexture
+		{
+			uint64_t Commit;
+			Texture::sptr Texture;
+			uint64_t RetainedSize;
+		};
+
+		// The replaced textures are kept until the frames in flight are done with them
+		std::deque<RetiredTexture> m_retiredTextures;
+		uint64_t m_numCommits;
+	};
+}
@@ -0,0 +1,150 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include "XUSGThreadPool.h"
+
+using namespace std;
+using namespace XUSG;
+
+ThreadPool::ThreadPool(uint32_t numThreads) :
+	m_workers(0),
+	m_tasks(),
+	m_nextGroup(NO_GROUP + 1),
+	m_stop(false)
+{
+	if (numThreads == 0)
+	{
+		// Leave one hardware thread for the caller
+		numThreads = thread::hardware_concurrency();
+		numThreads = numThreads > 1 ? numThreads - 1 : 1;
+	}
+
+	m_workers.reserve(numThreads);
+	for (auto i = 0u; i < numThreads; ++i)
+		m_workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_condition.notify_all();
+
+	for (auto& worker : m_workers)
+		if (worker.joinable()) worker.join();
+}
+
+ThreadPool::Group ThreadPool::CreateGroup()
+{
+	// Skip the reserved value on wrapping around
+	auto group = m_nextGroup++;
+	if (group == NO_GROUP) group = m_nextGroup++;
+
+	return group;
+}
+
+void ThreadPool::Submit(Task&& task, Group group)
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_tasks.emplace_back(group, move(task));
+	}
+	m_condition.notify_one();
+}
+
+bool ThreadPool::RunPendingTask(Group group)
+{
+	if (group == NO_GROUP) return false;
+
+	Task task;
+	{
+		lock_guard<mutex> lock(m_mutex);
+		const auto taskIter = find_if(m_tasks.begin(), m_tasks.end(),
+			[group](const pair<Group, Task>& pendingTask) { return pendingTask.first == group; });
+		if (taskIter == m_tasks.end()) return false;
+		task = move(taskIter->second);
+		m_tasks.erase(taskIter);
+	}
+	task();
+
+	return true;
+}
+
+void ThreadPool::ParallelFor(uint32_t count, const function<void(uint32_t)>& func)
+{
+	if (count == 0) return;
+	if (count == 1)
+	{
+		func(0);
+		return;
+	}
+
+	// The state is shared, so that helpers started late by a busy pool
+	// never touch the stack of a caller that has already returned
+	struct State
+	{
+		function<void(uint32_t)> Func;
+		atomic<uint32_t> Next;
+		atomic<uint32_t> NumDone;
+		uint32_t Count;
+	};
+
+	const auto state = make_shared<State>();
+	state->Func = func;
+	state->Next = 0;
+	state->NumDone = 0;
+	state->Count = count;
+
+	const auto process = [](State& state)
+	{
+		for (auto i = state.Next++; i < state.Count; i = state.Next++)
+		{
+			state.Func(i);
+			++state.NumDone;
+		}
+	};
+
+	// The helpers are grouped, so that the caller only runs its own ones while waiting
+	const auto group = CreateGroup();
+	const auto numHelpers = (min)(GetNumThreads(), count - 1);
+	for (auto i = 0u; i < numHelpers; ++i)
+		Submit([state, process]() { process(*state); }, group);
+
+	process(*state);
+
+	// Items may still be running on the helpers
+	while (state->NumDone < count)
+		if (!RunPendingTask(group)) this_thread::yield();
+}
+
+uint32_t ThreadPool::GetNumThreads() const
+{
+	return static_cast<uint32_t>(m_workers.size());
+}
+
+ThreadPool& ThreadPool::GetDefault()
+{
+	static ThreadPool threadPool;
+
+	return threadPool;
+}
+
+void ThreadPool::workerLoop()
+{
+	while (true)
+	{
+		Task task;
+		{
+			unique_lock<mutex> lock(m_mutex);
+			m_condition.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+			if (m_stop && m_tasks.empty()) return;
+			task = move(m_tasks.front().second);
+			m_tasks.pop_front();
+		}
+		task();
+	}
+}
@@ -0,0 +1,90 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+
+namespace XUSG
+{
+	//--------------------------------------------------------------------------------------
+	// Thread pool for background asset loading. The waits only help with the tasks of their
+	// group, so that a wait never runs an unrelated task, e.g. a blocking mesh load.
+	//--------------------------------------------------------------------------------------
+	class ThreadPool
+	{
+	public:
+		using Task = std::function<void()>;
+		using Group = uint32_t;
+
+		// The tasks of no group are only run by the workers
+		static const Group NO_GROUP = 0;
+
+		ThreadPool(uint32_t numThreads = 0);
+		virtual ~ThreadPool();
+
+		// Get a new group, for the tasks that are waited on together
+		Group CreateGroup();
+
+		// Enqueue a task and get a future of its result
+		template<typename F>
+		auto Enqueue(F&& func, Group group = NO_GROUP) -> std::future<decltype(func())>;
+
+		// Enqueue a task without tracking its result
+		void Submit(Task&& task, Group group = NO_GROUP);
+
+		// Run the first pending task of the group on the calling thread, if any
+		bool RunPendingTask(Group group);
+
+		// Wait for a future, executing the pending tasks of the group meanwhile, so that waiting
+		// from a worker thread for the tasks of the group never starves the pool
+		template<typename TFuture>
+		void Wait(const TFuture& future, Group group = NO_GROUP);
+
+		// Run func(i) for i in [0, count); the calling thread participates
+		void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& func);
+
+		uint32_t GetNumThreads() const;
+
+		static ThreadPool& GetDefault();
+
+	protected:
+		void workerLoop();
+
+		std::vector<std::thread>	m_workers;
+		std::deque<std::pair<Group, Task>> m_tasks;
+		std::mutex					m_mutex;
+		std::condition_variable		m_condition;
+		std::atomic<Group>			m_nextGroup;
+		bool						m_stop;
+	};
+
+	//--------------------------------------------------------------------------------------
+	// Template implementations
+	//--------------------------------------------------------------------------------------
+	template<typename F>
+	auto ThreadPool::Enqueue(F&& func, Group group) -> std::future<decltype(func())>
+	{
+		using ResultType = decltype(func());
+
+		// std::function requires copyable callables, so share the packaged task
+		const auto task = std::make_shared<std::packaged_task<ResultType()>>(std::forward<F>(func));
+		auto future = task->get_future();
+		Submit([task]() { (*task)(); }, group);
+
+		return future;
+	}
+
+	template<typename TFuture>
+	void ThreadPool::Wait(const TFuture& future, Group group)
+	{
+		while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			if (!RunPendingTask(group)) future.wait_for(std::chrono::microseconds(100));
+	}
+}
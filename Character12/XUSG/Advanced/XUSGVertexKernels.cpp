@@ -0,0 +1,140 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "XUSGVertexKernels.h"
+
+#if defined(_M_IX86) || defined(_M_X64)
+#define XUSG_F16C_KERNELS 1
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#define XUSG_F16C_KERNELS 0
+#endif
+
+using namespace std;
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+using namespace XUSG;
+
+#if XUSG_F16C_KERNELS
+static bool CheckF16C()
+{
+	int cpuInfo[4];
+	__cpuid(cpuInfo, 1);
+
+	// F16C instructions are VEX encoded, so the OS must also save the AVX states
+	const auto hasF16C = (cpuInfo[2] & (1 << 29)) != 0;
+	const auto hasOSXSAVE = (cpuInfo[2] & (1 << 27)) != 0;
+
+	return hasF16C && hasOSXSAVE && (_xgetbv(0) & 0x6) == 0x6;
+}
+
+static void ConvertHalfToFloatF16C(float* pDst, const uint16_t* pSrc, size_t count)
+{
+	auto i = size_t(0);
+	for (; i + 8 <= count; i += 8)
+		_mm256_storeu_ps(&pDst[i], _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&pSrc[i]))));
+
+	for (; i < count; ++i) pDst[i] = _mm_cvtss_f32(_mm_cvtph_ps(_mm_cvtsi32_si128(pSrc[i])));
+}
+
+static void ConvertFloatToHalfF16C(uint16_t* pDst, const float* pSrc, size_t count)
+{
+	auto i = size_t(0);
+	for (; i + 8 <= count; i += 8)
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&pDst[i]), _mm256_cvtps_ph(_mm256_loadu_ps(&pSrc[i]), _MM_FROUND_TO_NEAREST_INT));
+
+	for (; i < count; ++i)
+		pDst[i] = static_cast<uint16_t>(_mm_cvtsi128_si32(_mm_cvtps_ph(_mm_set_ss(pSrc[i]), _MM_FROUND_TO_NEAREST_INT)));
+}
+
+static void ConvertHalf4ToFloat4F16C(XMFLOAT4* pDst, const uint8_t* pSrc, uint32_t srcStride, size_t count)
+{
+	for (auto i = size_t(0); i < count; ++i)
+		_mm_storeu_ps(&pDst[i].x, _mm_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&pSrc[srcStride * i]))));
+}
+
+static void ConvertFloat4ToHalf4F16C(uint8_t* pDst, uint32_t dstStride, const XMFLOAT4* pSrc, size_t count)
+{
+	for (auto i = size_t(0); i < count; ++i)
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(&pDst[dstStride * i]),
+			_mm_cvtps_ph(_mm_loadu_ps(&pSrc[i].x), _MM_FROUND_TO_NEAREST_INT));
+}
+#endif
+
+bool VertexKernels::IsF16CSupported()
+{
+#if XUSG_F16C_KERNELS
+	static const auto isF16CSupported = CheckF16C();
+
+	return isF16CSupported;
+#else
+	return false;
+#endif
+}
+
+void VertexKernels::ConvertHalfToFloat(float* pDst, const uint16_t* pSrc, size_t count)
+{
+#if XUSG_F16C_KERNELS
+	if (IsF16CSupported()) return ConvertHalfToFloatF16C(pDst, pSrc, count);
+#endif
+
+	XMConvertHalfToFloatStream(pDst, sizeof(float), pSrc, sizeof(HALF), count);
+}
+
+void VertexKernels::ConvertFloatToHalf(uint16_t* pDst, const float* pSrc, size_t count)
+{
+#if XUSG_F16C_KERNELS
+	if (IsF16CSupported()) return ConvertFloatToHalfF16C(pDst, pSrc, count);
+#endif
+
+	XMConvertFloatToHalfStream(pDst, sizeof(HALF), pSrc, sizeof(float), count);
+}
+
+void VertexKernels::ConvertHalf4ToFloat4(XMFLOAT4* pDst, const uint8_t* pSrc, uint32_t srcStride, size_t count)
+{
+#if XUSG_F16C_KERNELS
+	if (IsF16CSupported()) return ConvertHalf4ToFloat4F16C(pDst, pSrc, srcStride, count);
+#endif
+
+	for (auto i = size_t(0); i < count; ++i)
+		XMStoreFloat4(&pDst[i], XMLoadHalf4(reinterpret_cast<const XMHALF4*>(&pSrc[srcStride * i])));
+}
+
+void VertexKernels::ConvertFloat4ToHalf4(uint8_t* pDst, uint32_t dstStride, const XMFLOAT4* pSrc, size_t count)
+{
+#if XUSG_F16C_KERNELS
+	if (IsF16CSupported()) return ConvertFloat4ToHalf4F16C(pDst, dstStride, pSrc, count);
+#endif
+
+	for (auto i = size_t(0); i < count; ++i)
+		XMStoreHalf4(reinterpret_cast<XMHALF4*>(&pDst[dstStride * i]), XMLoadFloat4(&pSrc[i]));
+}
+
+void VertexKernels::TransformPositions(uint8_t* pPositions, uint32_t stride, size_t count, FXMMATRIX matrix)
+{
+	// Each element is loaded before it is stored, so the stream can be transformed in place
+	const auto pStream = reinterpret_cast<XMFLOAT3*>(pPositions);
+	XMVector3TransformCoordStream(pStream, stride, pStream, stride, count, matrix);
+}
+
+void VertexKernels::TransformNormals(uint8_t* pNormals, uint32_t stride, size_t count,
+	FXMMATRIX matrix, bool preserveW)
+{
+	XMFLOAT4 batch[BATCH_SIZE];
+	for (auto i = size_t(0); i < count; i += BATCH_SIZE)
+	{
+		const auto batchSize = (min)(count - i, BATCH_SIZE);
+		const auto pBatch = &pNormals[stride * i];
+
+		ConvertHalf4ToFloat4(batch, pBatch, stride, batchSize);
+		for (auto j = size_t(0); j < batchSize; ++j)
+		{
+			const auto normal = XMLoadFloat4(&batch[j]);
+			const auto result = XMVector3TransformNormal(normal, matrix);
+			XMStoreFloat4(&batch[j], preserveW ? XMVectorSelect(result, normal, g_XMSelect0001) : result);
+		}
+		ConvertFloat4ToHalf4(pBatch, stride, batch, batchSize);
+	}
+}
@@ -0,0 +1,36 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+namespace XUSG
+{
+	//--------------------------------------------------------------------------------------
+	// Batch kernels for CPU-side vertex processing. Half-float conversions use F16C
+	// if the CPU supports it, and fall back to DirectXMath otherwise.
+	//--------------------------------------------------------------------------------------
+	class VertexKernels
+	{
+	public:
+		static bool IsF16CSupported();
+
+		// Contiguous conversions
+		static void ConvertHalfToFloat(float* pDst, const uint16_t* pSrc, size_t count);
+		static void ConvertFloatToHalf(uint16_t* pDst, const float* pSrc, size_t count);
+
+		// Conversions of strided half4 vertex attributes
+		static void ConvertHalf4ToFloat4(DirectX::XMFLOAT4* pDst, const uint8_t* pSrc, uint32_t srcStride, size_t count);
+		static void ConvertFloat4ToHalf4(uint8_t* pDst, uint32_t dstStride, const DirectX::XMFLOAT4* pSrc, size_t count);
+
+		// In-place stream transforms: positions are float3, and normals are half4 of which
+		// w is either preserved (e.g. the handedness of tangents) or set by the transform
+		static void TransformPositions(uint8_t* pPositions, uint32_t stride, size_t count,
+			DirectX::FXMMATRIX matrix);
+		static void TransformNormals(uint8_t* pNormals, uint32_t stride, size_t count,
+			DirectX::FXMMATRIX matrix, bool preserveW = false);
+
+	protected:
+		static const size_t BATCH_SIZE = 256;
+	};
+}
@@ -0,0 +1,70 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "XUSGVertexLayout.h"
+
+using namespace std;
+using namespace XUSG;
+
+VertexLayout::VertexLayout() :
+	m_stride(0)
+{
+	for (auto& element : m_elements) element = { INVALID_OFFSET, TYPE_UNUSED };
+}
+
+void VertexLayout::Decode(const DeclElement* pDecl, uint32_t maxElements, uint32_t stride)
+{
+	m_stride = stride;
+	for (auto& element : m_elements) element = { INVALID_OFFSET, TYPE_UNUSED };
+
+	for (auto i = 0u; i < maxElements; ++i)
+	{
+		const auto& decl = pDecl[i];
+		if (decl.Stream == 0xff || decl.Type >= TYPE_UNUSED) break;
+		if (i > 0 && decl.Offset <= pDecl[i - 1].Offset) break;
+
+		// Keep the first of each usage, which must fit in the vertex
+		if (decl.Stream != 0 || decl.UsageIndex != 0 || decl.Usage >= NUM_USAGE) continue;
+		if (decl.Offset + GetElementSize(static_cast<DeclType>(decl.Type)) > stride) continue;
+
+		auto& element = m_elements[decl.Usage];
+		if (element.Type == TYPE_UNUSED) element = { decl.Offset, static_cast<DeclType>(decl.Type) };
+	}
+}
+
+const VertexLayout::Element* VertexLayout::GetElement(DeclUsage usage) const
+{
+	assert(usage < NUM_USAGE);
+	const auto& element = m_elements[usage];
+
+	return element.Type != TYPE_UNUSED ? &element : nullptr;
+}
+
+uint32_t VertexLayout::GetOffset(DeclUsage usage, DeclType type) const
+{
+	const auto pElement = GetElement(usage);
+
+	return pElement && pElement->Type == type ? pElement->Offset : INVALID_OFFSET;
+}
+
+uint32_t VertexLayout::GetStride() const
+{
+	return m_stride;
+}
+
+uint32_t VertexLayout::GetElementSize(DeclType type)
+{
+	static const uint8_t sizes[] =
+	{
+		4, 8, 12, 16,	// FLOAT1-4
+		4, 4,			// D3DCOLOR, UBYTE4
+		4, 8,			// SHORT2, SHORT4
+		4, 4, 8,		// UBYTE4N, SHORT2N, SHORT4N
+		4, 8,			// USHORT2N, USHORT4N
+		4, 4,			// UDEC3, DEC3N
+		4, 8			// FLOAT16_2, FLOAT16_4
+	};
+
+	return type < TYPE_UNUSED ? sizes[type] : 0;
+}
@@ -0,0 +1,206 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+namespace XUSG
+{
+	template<typename T> class VertexStream;
+
+	//--------------------------------------------------------------------------------------
+	// Vertex layout decoded once from a vertex declaration (D3DVERTEXELEMENT9). CPU vertex
+	// passes dispatch on the data type of an element once per stream, to strided accessors
+	// specialized at compile time, instead of branching on the declaration per vertex.
+	//--------------------------------------------------------------------------------------
+	class VertexLayout
+	{
+	public:
+		static const uint32_t INVALID_OFFSET = UINT32_MAX;
+
+		enum DeclUsage : uint8_t
+		{
+			USAGE_POSITION,
+			USAGE_BLENDWEIGHT,
+			USAGE_BLENDINDICES,
+			USAGE_NORMAL,
+			USAGE_PSIZE,
+			USAGE_TEXCOORD,
+			USAGE_TANGENT,
+			USAGE_BINORMAL,
+			USAGE_TESSFACTOR,
+			USAGE_POSITIONT,
+			USAGE_COLOR,
+			USAGE_FOG,
+			USAGE_DEPTH,
+			USAGE_SAMPLE,
+
+			NUM_USAGE
+		};
+
+		enum DeclType : uint8_t
+		{
+			TYPE_FLOAT1,
+			TYPE_FLOAT2,
+			TYPE_FLOAT3,
+			TYPE_FLOAT4,
+			TYPE_D3DCOLOR,
+			TYPE_UBYTE4,
+			TYPE_SHORT2,
+			TYPE_SHORT4,
+			TYPE_UBYTE4N,
+			TYPE_SHORT2N,
+			TYPE_SHORT4N,
+			TYPE_USHORT2N,
+			TYPE_USHORT4N,
+			TYPE_UDEC3,
+			TYPE_DEC3N,
+			TYPE_FLOAT16_2,
+			TYPE_FLOAT16_4,
+			TYPE_UNUSED
+		};
+
+		struct DeclElement
+		{
+			uint16_t	Stream;		// Stream index
+			uint16_t	Offset;		// Offset in the stream in bytes
+			uint8_t		Type;		// Data type
+			uint8_t		Method;		// Processing method
+			uint8_t		Usage;		// Semantics
+			uint8_t		UsageIndex;	// Semantic index
+		};
+
+		struct Element
+		{
+			uint32_t	Offset;
+			DeclType	Type;
+		};
+
+		VertexLayout();
+
+		// Decode the elements of stream 0 with usage index 0; the declaration ends at
+		// D3DDECL_END, at an unused element, or at an element not following the previous one
+		void Decode(const DeclElement* pDecl, uint32_t maxElements, uint32_t stride);
+
+		// Returns nullptr if the element is not in the layout
+		const Element* GetElement(DeclUsage usage) const;
+
+		// Returns INVALID_OFFSET unless the element is in the layout with the given type
+		uint32_t GetOffset(DeclUsage usage, DeclType type) const;
+		uint32_t GetStride() const;
+
+		static uint32_t GetElementSize(DeclType type);
+
+		// Calls func once with the VertexStream of the element type; returns false without
+		// calling it if the element is not in the layout or its type is not supported
+		template<typename F>
+		bool Visit(DeclUsage usage, uint8_t* pVertices, F&& func) const;
+
+	protected:
+		Element		m_elements[NUM_USAGE];
+		uint32_t	m_stride;
+	};
+
+	//--------------------------------------------------------------------------------------
+	// Loads and stores of the declaration types, specialized per element type
+	//--------------------------------------------------------------------------------------
+	template<typename T> struct VertexElementTraits;
+
+#define XUSG_VERTEX_ELEMENT_TRAITS(T, declType, load, store) \
+	template<> struct VertexElementTraits<T> \
+	{ \
+		static const VertexLayout::DeclType Type = VertexLayout::declType; \
+		static DirectX::XMVECTOR XM_CALLCONV Load(const T& src) { return load(&src); } \
+		static void XM_CALLCONV Store(T& dst, DirectX::FXMVECTOR v) { store(&dst, v); } \
+	}
+
+	XUSG_VERTEX_ELEMENT_TRAITS(float, TYPE_FLOAT1, DirectX::XMLoadFloat, DirectX::XMStoreFloat);
+	XUSG_VERTEX_ELEMENT_TRAITS(DirectX::XMFLOAT2, TYPE_FLOAT2, DirectX::XMLoadFloat2, DirectX::XMStoreFloat2);
+	XUSG_VERTEX_ELEMENT_TRAITS(DirectX::XMFLOAT3, TYPE_FLOAT3, DirectX::XMLoadFloat3, DirectX::XMStoreFloat3);
+	XUSG_VERTEX_ELEMENT_TRAITS(DirectX::XMFLOAT4, TYPE_FLOAT4, DirectX::XMLoadFloat4, DirectX::XMStoreFloat4);
+	XUSG_VERTEX_ELEMENT_TRAITS(DirectX::PackedVector::XMCOLOR, TYPE_D3DCOLOR, DirectX::PackedVector::XMLoadColor, DirectX::PackedVector::XMStoreColor);
+	XUSG_VERTEX_ELEMENT_TRAITS(DirectX::PackedVector::XMUBYTE4, TYPE_UBYTE4, DirectX::PackedVector::XMLoadUByte4, DirectX::PackedVector::XMStoreUByte4);
+	XUSG_VERTEX_ELEMENT_TRAITS(DirectX::PackedVector::XMSHORT2, TYPE_SHORT2, DirectX::PackedVector::XMLoadShort2, DirectX::PackedVector::XMStoreShort2);
+	XUSG_VERTEX_ELEMENT_TRAITS(DirectX::PackedVector::XMSHORT4, TYPE_SHORT4, DirectX::PackedVector::XMLoadShort4, DirectX::PackedVector::XMStoreShort4);
+	XUSG_VERTEX_ELEMENT_TRAITS(DirectX::PackedVector::XMUBYTEN4, TYPE_UBYTE4N, DirectX::PackedVector::XMLoadUByteN4, DirectX::PackedVector::XMStoreUByteN4);
+	XUSG_VERTEX_ELEMENT_TRAITS(DirectX::PackedVector::XMSHORTN2, TYPE_SHORT2N, DirectX::PackedVector::XMLoadShortN2, DirectX::PackedVector::XMStoreShortN2);
+	XUSG_VERTEX_ELEMENT_TRAITS(DirectX::PackedVector::XMSHORTN4, TYPE_SHORT4N, DirectX::PackedVector::XMLoadShortN4, DirectX::PackedVector::XMStoreShortN4);
+	XUSG_VERTEX_ELEMENT_TRAITS(DirectX::PackedVector::XMUSHORTN2, TYPE_USHORT2N, DirectX::PackedVector::XMLoadUShortN2, DirectX::PackedVector::XMStoreUShortN2);
+	XUSG_VERTEX_ELEMENT_TRAITS(DirectX::PackedVector::XMUSHORTN4, TYPE_USHORT4N, DirectX::PackedVector::XMLoadUShortN4, DirectX::PackedVector::XMStoreUShortN4);
+	XUSG_VERTEX_ELEMENT_TRAITS(DirectX::PackedVector::XMHALF2, TYPE_FLOAT16_2, DirectX::PackedVector::XMLoadHalf2, DirectX::PackedVector::XMStoreHalf2);
+	XUSG_VERTEX_ELEMENT_TRAITS(DirectX::PackedVector::XMHALF4, TYPE_FLOAT16_4, DirectX::PackedVector::XMLoadHalf4, DirectX::PackedVector::XMStoreHalf4);
+
+#undef XUSG_VERTEX_ELEMENT_TRAITS
+
+	//--------------------------------------------------------------------------------------
+	// Strided accessor of a vertex element
+	//--------------------------------------------------------------------------------------
+	template<typename T>
+	class VertexStream
+	{
+	public:
+		typedef VertexElementTraits<T> Traits;
+
+		VertexStream(uint8_t* pVertices, uint32_t stride, uint32_t offset) :
+			m_pData(pVertices + offset), m_stride(stride) {}
+
+		T& operator[](size_t i) const { return *reinterpret_cast<T*>(m_pData + m_stride * i); }
+
+		DirectX::XMVECTOR XM_CALLCONV Load(size_t i) const { return Traits::Load((*this)[i]); }
+		void XM_CALLCONV Store(size_t i, DirectX::FXMVECTOR v) const { Traits::Store((*this)[i], v); }
+
+	protected:
+		uint8_t*	m_pData;
+		uint32_t	m_stride;
+	};
+
+	template<typename F>
+	bool VertexLayout::Visit(DeclUsage usage, uint8_t* pVertices, F&& func) const
+	{
+		const auto pElement = GetElement(usage);
+		if (!pElement) return false;
+
+#define XUSG_VISIT_VERTEX_STREAM(T) \
+	func(VertexStream<T>(pVertices, m_stride, pElement->Offset)); \
+	return true
+
+		switch (pElement->Type)
+		{
+		case TYPE_FLOAT1:
+			XUSG_VISIT_VERTEX_STREAM(float);
+		case TYPE_FLOAT2:
+			XUSG_VISIT_VERTEX_STREAM(DirectX::XMFLOAT2);
+		case TYPE_FLOAT3:
+			XUSG_VISIT_VERTEX_STREAM(DirectX::XMFLOAT3);
+		case TYPE_FLOAT4:
+			XUSG_VISIT_VERTEX_STREAM(DirectX::XMFLOAT4);
+		case TYPE_D3DCOLOR:
+			XUSG_VISIT_VERTEX_STREAM(DirectX::PackedVector::XMCOLOR);
+		case TYPE_UBYTE4:
+			XUSG_VISIT_VERTEX_STREAM(DirectX::PackedVector::XMUBYTE4);
+		case TYPE_SHORT2:
+			XUSG_VISIT_VERTEX_STREAM(DirectX::PackedVector::XMSHORT2);
+		case TYPE_SHORT4:
+			XUSG_VISIT_VERTEX_STREAM(DirectX::PackedVector::XMSHORT4);
+		case TYPE_UBYTE4N:
+			XUSG_VISIT_VERTEX_STREAM(DirectX::PackedVector::XMUBYTEN4);
+		case TYPE_SHORT2N:
+			XUSG_VISIT_VERTEX_STREAM(DirectX::PackedVector::XMSHORTN2);
+		case TYPE_SHORT4N:
+			XUSG_VISIT_VERTEX_STREAM(DirectX::PackedVector::XMSHORTN4);
+		case TYPE_USHORT2N:
+			XUSG_VISIT_VERTEX_STREAM(DirectX::PackedVector::XMUSHORTN2);
+		case TYPE_USHORT4N:
+			XUSG_VISIT_VERTEX_STREAM(DirectX::PackedVector::XMUSHORTN4);
+		case TYPE_FLOAT16_2:
+			XUSG_VISIT_VERTEX_STREAM(DirectX::PackedVector::XMHALF2);
+		case TYPE_FLOAT16_4:
+			XUSG_VISIT_VERTEX_STREAM(DirectX::PackedVector::XMHALF4);
+		default:
+			// UDEC3 and DEC3N have no DirectXMath loads without w
+			return false;
+		}
+
+#undef XUSG_VISIT_VERTEX_STREAM
+	}
+}
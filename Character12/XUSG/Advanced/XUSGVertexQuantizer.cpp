@@ -0,0 +1,321 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "Core/XUSG.h"
+#include "XUSGVertexQuantizer.h"
+
+using namespace std;
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+using namespace XUSG;
+
+static const float UNORM16_SCALE = 65535.0f;
+static const float SNORM16_SCALE = 32767.0f;
+static const float ANGLE_SCALE = 32768.0f;
+static const uint16_t NEGATIVE_HANDEDNESS = 0x8000;
+
+//--------------------------------------------------------------------------------------
+// Helper functions
+//--------------------------------------------------------------------------------------
+static float SignNotZero(float x)
+{
+	return x < 0.0f ? -1.0f : 1.0f;
+}
+
+// Angle between two unit vectors, accurate for small angles
+static float AngleBetween(FXMVECTOR a, FXMVECTOR b)
+{
+	return atan2f(XMVectorGetX(XMVector3Length(XMVector3Cross(a, b))), XMVectorGetX(XMVector3Dot(a, b)));
+}
+
+static XMVECTOR DecodeOctahedron(const int16_t oct[2])
+{
+	const auto u = (max)(oct[0] / SNORM16_SCALE, -1.0f);
+	const auto v = (max)(oct[1] / SNORM16_SCALE, -1.0f);
+	const auto z = 1.0f - fabsf(u) - fabsf(v);
+
+	// Unfold the lower hemisphere
+	const auto x = z < 0.0f ? (1.0f - fabsf(v)) * SignNotZero(u) : u;
+	const auto y = z < 0.0f ? (1.0f - fabsf(u)) * SignNotZero(v) : v;
+
+	return XMVector3Normalize(XMVectorSet(x, y, z, 0.0f));
+}
+
+static void EncodeOctahedron(int16_t oct[2], FXMVECTOR normal)
+{
+	XMFLOAT3 n;
+	XMStoreFloat3(&n, normal);
+	const auto l1Norm = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+	auto u = n.x / l1Norm;
+	auto v = n.y / l1Norm;
+
+	// Fold the lower hemisphere
+	if (n.z < 0.0f)
+	{
+		const auto x = u;
+		u = (1.0f - fabsf(v)) * SignNotZero(x);
+		v = (1.0f - fabsf(x)) * SignNotZero(v);
+	}
+
+	// Pick the closest of the 4 neighboring grid points on the sphere [Cigolle et al. 2014]
+	const auto fu = floorf(u * SNORM16_SCALE);
+	const auto fv = floorf(v * SNORM16_SCALE);
+	auto bestDistSq = FLT_MAX;
+	for (auto i = 0u; i < 4; ++i)
+	{
+		const int16_t candidate[] =
+		{
+			static_cast<int16_t>((min)((max)(fu + (i & 1), -SNORM16_SCALE), SNORM16_SCALE)),
+			static_cast<int16_t>((min)((max)(fv + (i >> 1), -SNORM16_SCALE), SNORM16_SCALE))
+		};
+
+		// Dot products are too close to 1 to be compared in single precision
+		const auto distSq = XMVectorGetX(XMVector3LengthSq(DecodeOctahedron(candidate) - normal));
+		if (distSq < bestDistSq)
+		{
+			bestDistSq = distSq;
+			oct[0] = candidate[0];
+			oct[1] = candidate[1];
+		}
+	}
+}
+
+// Continuous orthonormal basis around the normal [Duff et al. 2017]
+static void GetOrthonormalBasis(FXMVECTOR normal, XMVECTOR& b1, XMVECTOR& b2)
+{
+	XMFLOAT3 n;
+	XMStoreFloat3(&n, normal);
+	const auto sign = SignNotZero(n.z);
+	const auto a = -1.0f / (sign + n.z);
+	const auto b = n.x * n.y * a;
+	b1 = XMVectorSet(1.0f + sign * n.x * n.x * a, sign * b, -sign * n.x, 0.0f);
+	b2 = XMVectorSet(b, sign + n.y * n.y * a, -n.y, 0.0f);
+}
+
+// Remove the component along the normal; falls back to the basis if degenerated
+static XMVECTOR Orthogonalize(FXMVECTOR tangent, FXMVECTOR normal)
+{
+	const auto t = tangent - normal * XMVector3Dot(normal, tangent);
+	if (XMVectorGetX(XMVector3LengthSq(t)) > FLT_EPSILON) return XMVector3Normalize(t);
+
+	XMVECTOR b1, b2;
+	GetOrthonormalBasis(normal, b1, b2);
+
+	return b1;
+}
+
+// Quantize the weights, so that the 8-bit values sum to exactly 255 (largest remainders)
+static void QuantizeWeights(XMUBYTEN4& dst, const XMFLOAT4& weights)
+{
+	const float w[] = { weights.x, weights.y, weights.z, weights.w };
+	float remainders[4];
+	uint8_t q[4];
+	auto sum = 0u;
+	for (auto i = 0u; i < 4; ++i)
+	{
+		const auto x = (min)((max)(w[i], 0.0f), 1.0f) * 255.0f;
+		q[i] = static_cast<uint8_t>(floorf(x));
+		remainders[i] = x - q[i];
+		sum += q[i];
+	}
+
+	for (; sum < 255; ++sum)
+	{
+		const auto i = static_cast<uint32_t>(max_element(remainders, remainders + 4) - remainders);
+		++q[i];
+		remainders[i] = -1.0f;
+	}
+
+	dst.x = q[0];
+	dst.y = q[1];
+	dst.z = q[2];
+	dst.w = q[3];
+}
+
+static XMFLOAT4 NormalizeWeights(const XMFLOAT4& weights)
+{
+	const auto sum = weights.x + weights.y + weights.z + weights.w;
+	if (sum <= 0.0f) return XMFLOAT4(1.0f, 0.0f, 0.0f, 0.0f);
+
+	return XMFLOAT4(weights.x / sum, weights.y / sum, weights.z / sum, weights.w / sum);
+}
+
+//--------------------------------------------------------------------------------------
+// Vertex quantizer
+//--------------------------------------------------------------------------------------
+void VertexQuantizer::GetBounds(const Vertex* pSrc, uint32_t numVertices, XMFLOAT3& center, XMFLOAT3& extents)
+{
+	XMVECTOR vMin = g_XMFltMax;
+	auto vMax = XMVectorNegate(vMin);
+	for (auto i = 0u; i < numVertices; ++i)
+	{
+		const auto pos = XMLoadFloat3(&pSrc[i].Pos);
+		vMin = XMVectorMin(vMin, pos);
+		vMax = XMVectorMax(vMax, pos);
+	}
+
+	if (numVertices == 0) vMin = vMax = XMVectorZero();
+	XMStoreFloat3(&center, (vMin + vMax) * 0.5f);
+	XMStoreFloat3(&extents, (vMax - vMin) * 0.5f);
+}
+
+VertexQuantizer::Dequantization VertexQuantizer::GetDequantization(const XMFLOAT3& center, const XMFLOAT3& extents)
+{
+	const auto vExtents = XMLoadFloat3(&extents);
+
+	Dequantization dequantization;
+	XMStoreFloat3(&dequantization.Scale, vExtents * (2.0f / UNORM16_SCALE));
+	XMStoreFloat3(&dequantization.Bias, XMLoadFloat3(&center) - vExtents);
+
+	return dequantization;
+}
+
+void VertexQuantizer::Unpack(DecodedVertex& dst, const Vertex& src)
+{
+	dst.Pos = src.Pos;
+	XMStoreFloat4(&dst.Weights, XMLoadUByteN4(&src.Weights));
+	dst.Bones[0] = src.Bones.x;
+	dst.Bones[1] = src.Bones.y;
+	dst.Bones[2] = src.Bones.z;
+	dst.Bones[3] = src.Bones.w;
+	XMStoreFloat3(&dst.Norm, XMLoadHalf4(&src.Norm));
+	XMStoreFloat2(&dst.UV, XMLoadHalf2(&src.UV));
+	XMStoreFloat4(&dst.Tan, XMLoadHalf4(&src.Tan));
+}
+
+void VertexQuantizer::Encode(QuantizedVertex& dst, const DecodedVertex& src,
+	const XMFLOAT3& center, const XMFLOAT3& extents)
+{
+	// Position in the bounding box
+	const float p[] = { src.Pos.x - center.x, src.Pos.y - center.y, src.Pos.z - center.z };
+	const float e[] = { extents.x, extents.y, extents.z };
+	for (auto i = 0u; i < 3; ++i)
+	{
+		const auto t = e[i] > 0.0f ? (min)((max)(0.5f * p[i] / e[i] + 0.5f, 0.0f), 1.0f) : 0.5f;
+		dst.Pos[i] = static_cast<uint16_t>(t * UNORM16_SCALE + 0.5f);
+	}
+
+	// Normal
+	auto normal = XMLoadFloat3(&src.Norm);
+	normal = XMVectorGetX(XMVector3LengthSq(normal)) > FLT_EPSILON ?
+		XMVector3Normalize(normal) : XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
+	EncodeOctahedron(dst.Norm, normal);
+
+	// Tangent angle in the basis of the decoded normal, so that the decoder reproduces the basis
+	normal = DecodeOctahedron(dst.Norm);
+	XMVECTOR b1, b2;
+	GetOrthonormalBasis(normal, b1, b2);
+	const auto tangent = Orthogonalize(XMLoadFloat4(&src.Tan), normal);
+	auto angle = atan2f(XMVectorGetX(XMVector3Dot(tangent, b2)), XMVectorGetX(XMVector3Dot(tangent, b1)));
+	if (angle < 0.0f) angle += XM_2PI;
+	dst.TangentAngle = static_cast<uint16_t>(static_cast<uint32_t>(angle / XM_2PI * ANGLE_SCALE + 0.5f) & 0x7fff);
+	if (src.Tan.w < 0.0f) dst.TangentAngle |= NEGATIVE_HANDEDNESS;
+
+	QuantizeWeights(dst.Weights, NormalizeWeights(src.Weights));
+	dst.Bones.x = src.Bones[0];
+	dst.Bones.y = src.Bones[1];
+	dst.Bones.z = src.Bones[2];
+	dst.Bones.w = src.Bones[3];
+	XMStoreHalf2(&dst.UV, XMLoadFloat2(&src.UV));
+}
+
+void VertexQuantizer::Decode(DecodedVertex& dst, const QuantizedVertex& src, const Dequantization& dequantization)
+{
+	const auto pos = XMVectorSet(src.Pos[0], src.Pos[1], src.Pos[2], 0.0f);
+	XMStoreFloat3(&dst.Pos, XMVectorMultiplyAdd(pos, XMLoadFloat3(&dequantization.Scale),
+		XMLoadFloat3(&dequantization.Bias)));
+
+	const auto normal = DecodeOctahedron(src.Norm);
+	XMStoreFloat3(&dst.Norm, normal);
+
+	XMVECTOR b1, b2;
+	GetOrthonormalBasis(normal, b1, b2);
+	const auto angle = (src.TangentAngle & 0x7fff) / ANGLE_SCALE * XM_2PI;
+	const auto tangent = b1 * cosf(angle) + b2 * sinf(angle);
+	const auto handedness = (src.TangentAngle & NEGATIVE_HANDEDNESS) ? -1.0f : 1.0f;
+	XMStoreFloat4(&dst.Tan, XMVectorSetW(tangent, handedness));
+
+	XMStoreFloat4(&dst.Weights, XMLoadUByteN4(&src.Weights));
+	dst.Bones[0] = src.Bones.x;
+	dst.Bones[1] = src.Bones.y;
+	dst.Bones[2] = src.Bones.z;
+	dst.Bones[3] = src.Bones.w;
+	XMStoreFloat2(&dst.UV, XMLoadHalf2(&src.UV));
+}
+
+void VertexQuantizer::Quantize(QuantizedVertex* pDst, const Vertex* pSrc, uint32_t numVertices,
+	const XMFLOAT3& center, const XMFLOAT3& extents)
+{
+	DecodedVertex vertex;
+	for (auto i = 0u; i < numVertices; ++i)
+	{
+		Unpack(vertex, pSrc[i]);
+		Encode(pDst[i], vertex, center, extents);
+	}
+}
+
+VertexQuantizer::ErrorBounds VertexQuantizer::GetErrorBounds(const XMFLOAT3& center, const XMFLOAT3& extents)
+{
+	// Half a quantization step, with a margin for the float arithmetic
+	const auto margin = 1.0f + 1.0e-3f;
+	const auto magnitude = (max)((max)(fabsf(center.x), fabsf(center.y)), fabsf(center.z)) +
+		(max)((max)(fabsf(extents.x), fabsf(extents.y)), fabsf(extents.z));
+
+	ErrorBounds bounds;
+	bounds.Pos = XMVectorGetX(XMVector3Length(XMLoadFloat3(&extents))) / UNORM16_SCALE * margin +
+		4.0f * FLT_EPSILON * magnitude;
+
+	// The distance to the closest grid point of the octahedron is at most sqrt(2)/2 steps,
+	// and the projection to the sphere stretches it by at most 3 times.
+	bounds.Norm = 3.0f * 0.70710678f / SNORM16_SCALE * margin + 1.0e-6f;
+
+	// Half an angle step, with the float error of the basis and the trigonometry
+	bounds.Tan = XM_PI / ANGLE_SCALE * margin + 1.0e-5f;
+
+	bounds.Weight = 1.0f / 255.0f * margin;
+
+	return bounds;
+}
+
+bool VertexQuantizer::Validate(const QuantizedVertex* pQuantized, const Vertex* pSrc, uint32_t numVertices,
+	const XMFLOAT3& center, const XMFLOAT3& extents, ErrorBounds* pMaxErrors)
+{
+	const auto dequantization = GetDequantization(center, extents);
+	ErrorBounds maxErrors = {};
+	DecodedVertex original, decoded;
+
+	for (auto i = 0u; i < numVertices; ++i)
+	{
+		Unpack(original, pSrc[i]);
+		Decode(decoded, pQuantized[i], dequantization);
+
+		const auto posError = XMVectorGetX(XMVector3Length(XMLoadFloat3(&decoded.Pos) - XMLoadFloat3(&original.Pos)));
+		maxErrors.Pos = (max)(maxErrors.Pos, posError);
+
+		const auto normal = XMLoadFloat3(&original.Norm);
+		if (XMVectorGetX(XMVector3LengthSq(normal)) > FLT_EPSILON)
+			maxErrors.Norm = (max)(maxErrors.Norm, AngleBetween(XMVector3Normalize(normal), XMLoadFloat3(&decoded.Norm)));
+
+		const auto tangent = Orthogonalize(XMLoadFloat4(&original.Tan), XMLoadFloat3(&decoded.Norm));
+		auto tanError = AngleBetween(tangent, XMLoadFloat4(&decoded.Tan));
+		if ((original.Tan.w < 0.0f) != (decoded.Tan.w < 0.0f)) tanError = XM_PI;
+		maxErrors.Tan = (max)(maxErrors.Tan, tanError);
+
+		const auto weights = NormalizeWeights(original.Weights);
+		const auto weightErrors = XMVectorAbs(XMLoadFloat4(&decoded.Weights) - XMLoadFloat4(&weights));
+		maxErrors.Weight = (max)(maxErrors.Weight, (max)((max)(XMVectorGetX(weightErrors), XMVectorGetY(weightErrors)),
+			(max)(XMVectorGetZ(weightErrors), XMVectorGetW(weightErrors))));
+
+		// The bone indices and the UVs are exact
+		if (memcmp(original.Bones, decoded.Bones, sizeof(original.Bones)) != 0 ||
+			pQuantized[i].UV.x != pSrc[i].UV.x || pQuantized[i].UV.y != pSrc[i].UV.y) return false;
+	}
+
+	if (pMaxErrors) *pMaxErrors = maxErrors;
+
+	const auto bounds = GetErrorBounds(center, extents);
+
+	return maxErrors.Pos <= bounds.Pos && maxErrors.Norm <= bounds.Norm &&
+		maxErrors.Tan <= bounds.Tan && maxErrors.Weight <= bounds.Weight;
+}
@@ -0,0 +1,82 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "XUSGVertexRepacker.h"
+
+namespace XUSG
+{
+	//--------------------------------------------------------------------------------------
+	// Vertex quantizer, compressing the 40-byte skinning input (CS_Input) to the 24 bytes
+	// read by CSSkinningQuantized. Positions are 16-bit UNORM in the bounding box of the
+	// vertex buffer, the normal is octahedral encoded, the tangent is stored as an angle
+	// around the normal, orthogonalized to it, and the weights are renormalized.
+	//--------------------------------------------------------------------------------------
+	class VertexQuantizer
+	{
+	public:
+		using Vertex = VertexRepacker::Vertex;
+
+		// Read as uint2 PosTan, uint Norm, uint Weights, uint Bones and uint UV by the shader
+		struct QuantizedVertex
+		{
+			uint16_t	Pos[3];			// UNORM in the bounding box
+			uint16_t	TangentAngle;	// 15-bit UNORM angle around the normal; the top bit is set for negative handedness
+			int16_t		Norm[2];		// SNORM octahedral normal
+			DirectX::PackedVector::XMUBYTEN4 Weights;	// Renormalized to sum to 1
+			DirectX::PackedVector::XMUBYTE4	Bones;
+			DirectX::PackedVector::XMHALF2	UV;
+		};
+
+		// Full precision vertex attributes
+		struct DecodedVertex
+		{
+			DirectX::XMFLOAT3	Pos;
+			DirectX::XMFLOAT4	Weights;
+			uint8_t				Bones[4];
+			DirectX::XMFLOAT3	Norm;
+			DirectX::XMFLOAT2	UV;
+			DirectX::XMFLOAT4	Tan;
+		};
+
+		// The decoded position is the 16-bit value times the scale plus the bias, as in the shader
+		struct Dequantization
+		{
+			DirectX::XMFLOAT3	Scale;
+			DirectX::XMFLOAT3	Bias;
+		};
+
+		// Maximum absolute errors: distance for the position, radians for the normal and the tangent
+		struct ErrorBounds
+		{
+			float Pos;
+			float Norm;
+			float Tan;
+			float Weight;
+		};
+
+		static void GetBounds(const Vertex* pSrc, uint32_t numVertices,
+			DirectX::XMFLOAT3& center, DirectX::XMFLOAT3& extents);
+		static Dequantization GetDequantization(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents);
+
+		static void Unpack(DecodedVertex& dst, const Vertex& src);
+		static void Encode(QuantizedVertex& dst, const DecodedVertex& src,
+			const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents);
+		static void Decode(DecodedVertex& dst, const QuantizedVertex& src, const Dequantization& dequantization);
+
+		static void Quantize(QuantizedVertex* pDst, const Vertex* pSrc, uint32_t numVertices,
+			const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents);
+
+		// Analytic bounds of the quantization errors for a bounding box
+		static ErrorBounds GetErrorBounds(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents);
+
+		// Decode the quantized vertices, and check the errors against the analytic bounds. The
+		// tangents are compared after orthogonalizing the source ones to the decoded normals.
+		static bool Validate(const QuantizedVertex* pQuantized, const Vertex* pSrc, uint32_t numVertices,
+			const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents, ErrorBounds* pMaxErrors = nullptr);
+	};
+
+	static_assert(sizeof(VertexQuantizer::QuantizedVertex) == 24, "Quantized vertex structure size incorrect");
+}
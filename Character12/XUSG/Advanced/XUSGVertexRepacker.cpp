@@ -0,0 +1,235 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "Core/XUSG.h"
+#include "XUSGVertexRepacker.h"
+
+using namespace std;
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+using namespace XUSG;
+
+struct VertexRepacker::Streams
+{
+	VertexStream<XMFLOAT3>	Pos;
+	VertexStream<XMUBYTEN4>	Weights;
+	VertexStream<XMUBYTE4>	Bones;
+	VertexStream<XMHALF4>	Norm;
+	VertexStream<XMHALF2>	UV;
+	VertexStream<XMHALF4>	Tan;
+};
+
+// Element-wise conversions go through DirectXMath vectors
+template<typename T, typename U>
+static void CopyStream(const VertexStream<T>& dst, const VertexStream<U>& src, uint32_t numVertices)
+{
+	for (auto i = 0u; i < numVertices; ++i) dst.Store(i, src.Load(i));
+}
+
+// Elements of the same type are copied bitwise
+template<typename T>
+static void CopyStream(const VertexStream<T>& dst, const VertexStream<T>& src, uint32_t numVertices)
+{
+	for (auto i = 0u; i < numVertices; ++i) dst[i] = src[i];
+}
+
+template<typename T>
+static void FillStream(const VertexStream<T>& dst, FXMVECTOR value, uint32_t numVertices)
+{
+	T element;
+	VertexElementTraits<T>::Store(element, value);
+	for (auto i = 0u; i < numVertices; ++i) dst[i] = element;
+}
+
+// Maximum absolute rounding errors of the destination types
+static XMVECTOR GetTolerance(const XMFLOAT3&, FXMVECTOR)
+{
+	return XMVectorZero();
+}
+
+static XMVECTOR GetTolerance(const XMUBYTE4&, FXMVECTOR)
+{
+	return XMVectorZero();
+}
+
+static XMVECTOR GetTolerance(const XMUBYTEN4&, FXMVECTOR)
+{
+	return XMVectorReplicate(0.5f / 255.0f + FLT_EPSILON);
+}
+
+template<typename T>
+static XMVECTOR GetTolerance(const T&, FXMVECTOR value)
+{
+	// Half floats: half an ulp of 11-bit mantissas, or half the smallest denormal
+	return XMVectorMultiplyAdd(XMVectorAbs(value), XMVectorReplicate(1.0f / 2048.0f), XMVectorReplicate(1.0f / 33554432.0f));
+}
+
+template<typename T, typename U>
+static bool CompareStream(const VertexStream<T>& dst, const VertexStream<U>& src, uint32_t numVertices)
+{
+	for (auto i = 0u; i < numVertices; ++i)
+	{
+		const auto value = src.Load(i);
+		const auto error = XMVectorAbs(dst.Load(i) - value);
+		XUSG_C_RETURN(!XMVector4LessOrEqual(error, GetTolerance(dst[i], value)), false);
+	}
+
+	return true;
+}
+
+template<typename T>
+static bool CompareStream(const VertexStream<T>& dst, const VertexStream<T>& src, uint32_t numVertices)
+{
+	for (auto i = 0u; i < numVertices; ++i)
+		XUSG_C_RETURN(memcmp(&dst[i], &src[i], sizeof(T)) != 0, false);
+
+	return true;
+}
+
+template<typename T>
+static bool CompareStream(const VertexStream<T>& dst, FXMVECTOR value, uint32_t numVertices)
+{
+	T element;
+	VertexElementTraits<T>::Store(element, value);
+	for (auto i = 0u; i < numVertices; ++i)
+		XUSG_C_RETURN(memcmp(&dst[i], &element, sizeof(T)) != 0, false);
+
+	return true;
+}
+
+bool VertexRepacker::IsCanonical(const VertexLayout& layout)
+{
+	return layout.GetStride() == sizeof(Vertex) &&
+		layout.GetOffset(VertexLayout::USAGE_POSITION, VertexLayout::TYPE_FLOAT3) == offsetof(Vertex, Pos) &&
+		layout.GetOffset(VertexLayout::USAGE_BLENDWEIGHT, VertexLayout::TYPE_UBYTE4N) == offsetof(Vertex, Weights) &&
+		layout.GetOffset(VertexLayout::USAGE_BLENDINDICES, VertexLayout::TYPE_UBYTE4) == offsetof(Vertex, Bones) &&
+		layout.GetOffset(VertexLayout::USAGE_NORMAL, VertexLayout::TYPE_FLOAT16_4) == offsetof(Vertex, Norm) &&
+		layout.GetOffset(VertexLayout::USAGE_TEXCOORD, VertexLayout::TYPE_FLOAT16_2) == offsetof(Vertex, UV) &&
+		layout.GetOffset(VertexLayout::USAGE_TANGENT, VertexLayout::TYPE_FLOAT16_4) == offsetof(Vertex, Tan);
+}
+
+bool VertexRepacker::GetCanonicalDecl(VertexLayout::DeclElement* pDecl, uint32_t maxElements)
+{
+	XUSG_C_RETURN(maxElements < NUM_CANONICAL_ELEMENTS + 1, false);
+
+	const VertexLayout::DeclElement decl[NUM_CANONICAL_ELEMENTS + 1] =
+	{
+		{ 0, offsetof(Vertex, Pos),		VertexLayout::TYPE_FLOAT3,		0, VertexLayout::USAGE_POSITION,		0 },
+		{ 0, offsetof(Vertex, Weights),	VertexLayout::TYPE_UBYTE4N,		0, VertexLayout::USAGE_BLENDWEIGHT,		0 },
+		{ 0, offsetof(Vertex, Bones),	VertexLayout::TYPE_UBYTE4,		0, VertexLayout::USAGE_BLENDINDICES,	0 },
+		{ 0, offsetof(Vertex, Norm),	VertexLayout::TYPE_FLOAT16_4,	0, VertexLayout::USAGE_NORMAL,			0 },
+		{ 0, offsetof(Vertex, UV),		VertexLayout::TYPE_FLOAT16_2,	0, VertexLayout::USAGE_TEXCOORD,		0 },
+		{ 0, offsetof(Vertex, Tan),		VertexLayout::TYPE_FLOAT16_4,	0, VertexLayout::USAGE_TANGENT,			0 },
+		{ 0xff, 0,						VertexLayout::TYPE_UNUSED,		0, 0,									0 }	// D3DDECL_END
+	};
+	copy(decl, decl + NUM_CANONICAL_ELEMENTS + 1, pDecl);
+
+	return true;
+}
+
+bool VertexRepacker::Repack(Vertex* pDst, const uint8_t* pSrc, const VertexLayout& layout, uint32_t numVertices)
+{
+	return repack(getStreams(pDst), pSrc, layout, numVertices);
+}
+
+bool VertexRepacker::Repack(HotVertex* pHot, ColdVertex* pCold, const uint8_t* pSrc,
+	const VertexLayout& layout, uint32_t numVertices)
+{
+	return repack(getStreams(pHot, pCold), pSrc, layout, numVertices);
+}
+
+bool VertexRepacker::Validate(const Vertex* pDst, const uint8_t* pSrc, const VertexLayout& layout, uint32_t numVertices)
+{
+	return validate(getStreams(const_cast<Vertex*>(pDst)), pSrc, layout, numVertices);
+}
+
+bool VertexRepacker::Validate(const HotVertex* pHot, const ColdVertex* pCold, const uint8_t* pSrc,
+	const VertexLayout& layout, uint32_t numVertices)
+{
+	return validate(getStreams(const_cast<HotVertex*>(pHot), const_cast<ColdVertex*>(pCold)), pSrc, layout, numVertices);
+}
+
+VertexRepacker::Streams VertexRepacker::getStreams(Vertex* pVertices)
+{
+	const auto pData = reinterpret_cast<uint8_t*>(pVertices);
+	const auto stride = static_cast<uint32_t>(sizeof(Vertex));
+
+	return
+	{
+		VertexStream<XMFLOAT3>(pData, stride, offsetof(Vertex, Pos)),
+		VertexStream<XMUBYTEN4>(pData, stride, offsetof(Vertex, Weights)),
+		VertexStream<XMUBYTE4>(pData, stride, offsetof(Vertex, Bones)),
+		VertexStream<XMHALF4>(pData, stride, offsetof(Vertex, Norm)),
+		VertexStream<XMHALF2>(pData, stride, offsetof(Vertex, UV)),
+		VertexStream<XMHALF4>(pData, stride, offsetof(Vertex, Tan))
+	};
+}
+
+VertexRepacker::Streams VertexRepacker::getStreams(HotVertex* pHot, ColdVertex* pCold)
+{
+	const auto pHotData = reinterpret_cast<uint8_t*>(pHot);
+	const auto pColdData = reinterpret_cast<uint8_t*>(pCold);
+	const auto hotStride = static_cast<uint32_t>(sizeof(HotVertex));
+	const auto coldStride = static_cast<uint32_t>(sizeof(ColdVertex));
+
+	return
+	{
+		VertexStream<XMFLOAT3>(pHotData, hotStride, offsetof(HotVertex, Pos)),
+		VertexStream<XMUBYTEN4>(pHotData, hotStride, offsetof(HotVertex, Weights)),
+		VertexStream<XMUBYTE4>(pHotData, hotStride, offsetof(HotVertex, Bones)),
+		VertexStream<XMHALF4>(pColdData, coldStride, offsetof(ColdVertex, Norm)),
+		VertexStream<XMHALF2>(pColdData, coldStride, offsetof(ColdVertex, UV)),
+		VertexStream<XMHALF4>(pColdData, coldStride, offsetof(ColdVertex, Tan))
+	};
+}
+
+bool VertexRepacker::repack(const Streams& dst, const uint8_t* pSrc, const VertexLayout& layout, uint32_t numVertices)
+{
+	XUSG_C_RETURN(!layout.GetElement(VertexLayout::USAGE_POSITION), false);
+
+	// One pass per element, dispatched on the source type once; the source is only read
+	const auto pVertices = const_cast<uint8_t*>(pSrc);
+	const auto repackElement = [&](VertexLayout::DeclUsage usage, const auto& dstStream, FXMVECTOR defaultValue)
+	{
+		if (layout.GetElement(usage))
+			return layout.Visit(usage, pVertices, [&](const auto& srcStream) { CopyStream(dstStream, srcStream, numVertices); });
+
+		FillStream(dstStream, defaultValue, numVertices);
+
+		return true;
+	};
+
+	return repackElement(VertexLayout::USAGE_POSITION, dst.Pos, XMVectorZero()) &&
+		repackElement(VertexLayout::USAGE_BLENDWEIGHT, dst.Weights, g_XMIdentityR0) &&
+		repackElement(VertexLayout::USAGE_BLENDINDICES, dst.Bones, XMVectorZero()) &&
+		repackElement(VertexLayout::USAGE_NORMAL, dst.Norm, g_XMIdentityR2) &&
+		repackElement(VertexLayout::USAGE_TEXCOORD, dst.UV, XMVectorZero()) &&
+		repackElement(VertexLayout::USAGE_TANGENT, dst.Tan, XMVectorSet(1.0f, 0.0f, 0.0f, 1.0f));
+}
+
+bool VertexRepacker::validate(const Streams& dst, const uint8_t* pSrc, const VertexLayout& layout, uint32_t numVertices)
+{
+	XUSG_C_RETURN(!layout.GetElement(VertexLayout::USAGE_POSITION), false);
+
+	const auto pVertices = const_cast<uint8_t*>(pSrc);
+	const auto validateElement = [&](VertexLayout::DeclUsage usage, const auto& dstStream, FXMVECTOR defaultValue)
+	{
+		if (!layout.GetElement(usage)) return CompareStream(dstStream, defaultValue, numVertices);
+
+		auto isValid = false;
+		const auto isVisited = layout.Visit(usage, pVertices, [&](const auto& srcStream)
+		{
+			isValid = CompareStream(dstStream, srcStream, numVertices);
+		});
+
+		return isVisited && isValid;
+	};
+
+	return validateElement(VertexLayout::USAGE_POSITION, dst.Pos, XMVectorZero()) &&
+		validateElement(VertexLayout::USAGE_BLENDWEIGHT, dst.Weights, g_XMIdentityR0) &&
+		validateElement(VertexLayout::USAGE_BLENDINDICES, dst.Bones, XMVectorZero()) &&
+		validateElement(VertexLayout::USAGE_NORMAL, dst.Norm, g_XMIdentityR2) &&
+		validateElement(VertexLayout::USAGE_TEXCOORD, dst.UV, XMVectorZero()) &&
+		validateElement(VertexLayout::USAGE_TANGENT, dst.Tan, XMVectorSet(1.0f, 0.0f, 0.0f, 1.0f));
+}
@@ -0,0 +1,74 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "XUSGVertexLayout.h"
+
+namespace XUSG
+{
+	//--------------------------------------------------------------------------------------
+	// Vertex repacker, converting the vertices of any supported declaration into the skinning
+	// input layout (CS_Input), either interleaved, or split into a hot stream (position and
+	// skin weights) and a cold stream (normal, UV and tangent). Missing elements are filled
+	// with a full weight on bone 0, a +z normal, a zero UV and a +x tangent.
+	//--------------------------------------------------------------------------------------
+	class VertexRepacker
+	{
+	public:
+		// Layout of CS_Input, which is also the SDKMesh vertex layout of the characters
+		struct Vertex
+		{
+			DirectX::XMFLOAT3				Pos;
+			DirectX::PackedVector::XMUBYTEN4 Weights;
+			DirectX::PackedVector::XMUBYTE4	Bones;
+			DirectX::PackedVector::XMHALF4	Norm;
+			DirectX::PackedVector::XMHALF2	UV;
+			DirectX::PackedVector::XMHALF4	Tan;	// w is the handedness
+		};
+
+		struct HotVertex
+		{
+			DirectX::XMFLOAT3				Pos;
+			DirectX::PackedVector::XMUBYTEN4 Weights;
+			DirectX::PackedVector::XMUBYTE4	Bones;
+		};
+
+		struct ColdVertex
+		{
+			DirectX::PackedVector::XMHALF4	Norm;
+			DirectX::PackedVector::XMHALF2	UV;
+			DirectX::PackedVector::XMHALF4	Tan;	// w is the handedness
+		};
+
+		static const uint32_t NUM_CANONICAL_ELEMENTS = 6;
+
+		// Whether the layout is CS_Input already
+		static bool IsCanonical(const VertexLayout& layout);
+
+		// Write the declaration of CS_Input followed by D3DDECL_END; returns false if it does not fit
+		static bool GetCanonicalDecl(VertexLayout::DeclElement* pDecl, uint32_t maxElements);
+
+		// Returns false if the source has no position, or an element of an unsupported type
+		static bool Repack(Vertex* pDst, const uint8_t* pSrc, const VertexLayout& layout, uint32_t numVertices);
+		static bool Repack(HotVertex* pHot, ColdVertex* pCold, const uint8_t* pSrc,
+			const VertexLayout& layout, uint32_t numVertices);
+
+		// Check the repacked vertices against the source, within the precision of the destination types
+		static bool Validate(const Vertex* pDst, const uint8_t* pSrc, const VertexLayout& layout, uint32_t numVertices);
+		static bool Validate(const HotVertex* pHot, const ColdVertex* pCold, const uint8_t* pSrc,
+			const VertexLayout& layout, uint32_t numVertices);
+
+	protected:
+		struct Streams;
+
+		static Streams getStreams(Vertex* pVertices);
+		static Streams getStreams(HotVertex* pHot, ColdVertex* pCold);
+
+		static bool repack(const Streams& dst, const uint8_t* pSrc, const VertexLayout& layout, uint32_t numVertices);
+		static bool validate(const Streams& dst, const uint8_t* pSrc, const VertexLayout& layout, uint32_t numVertices);
+	};
+
+	static_assert(sizeof(VertexRepacker::Vertex) == 40, "Vertex structure size incorrect");
+}
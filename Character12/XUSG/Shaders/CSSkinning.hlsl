@@ -9,6 +9,16 @@
 //--------------------------------------------------------------------------------------
 // Input/Output structures
 //--------------------------------------------------------------------------------------
+#ifdef _QUANTIZED_
+struct CS_Input
+{
+	uint2	PosTan;		// 16-bit UNORM position, and 15-bit tangent angle with the handedness in the top bit
+	uint	Norm;		// 16-bit SNORM octahedral normal
+	uint	Weights;	// Bone weights
+	uint	Bones;		// Bone indices
+	uint	UV;			// Texture coordinate
+};
+#else
 struct CS_Input
 {
 	float3	Pos;		// Position
@@ -20,6 +30,7 @@ struct CS_Input
 	uint2	Tan;		// Normalized Tangent vector
 #endif
 };
+#endif
 
 struct CS_Output
 {
@@ -37,6 +48,17 @@ struct CS_Output
 RWStructuredBuffer<CS_Output>	g_rwVertices;
 StructuredBuffer<CS_Input>		g_roVertices;
 
+#ifdef _QUANTIZED_
+//--------------------------------------------------------------------------------------
+// Constant buffer
+//--------------------------------------------------------------------------------------
+cbuffer cbDequantization
+{
+	float3	g_posScale;	// Position = UNORM16 value * scale + bias
+	float3	g_posBias;
+};
+#endif
+
 //--------------------------------------------------------------------------------------
 // Encode R16G16B16_FLOAT
 //--------------------------------------------------------------------------------------
@@ -85,6 +107,41 @@ float4 DecodeRGBA16f(uint2 u)
 	return f16tof32(uint4(u, u >> 16).xzyw);
 }
 
+#ifdef _QUANTIZED_
+//--------------------------------------------------------------------------------------
+// Decode the octahedral normal of R16G16_SNORM
+//--------------------------------------------------------------------------------------
+float3 DecodeOctahedron(uint u)
+{
+	const int2 oct = int2(u << 16, u) >> 16;
+	const float2 f = max(oct / 32767.0, -1.0);
+	const float z = 1.0 - abs(f.x) - abs(f.y);
+
+	// Unfold the lower hemisphere
+	const float2 xy = z < 0.0 ? (1.0 - abs(f.yx)) * float2(Sign(f.x, 1.0), Sign(f.y, 1.0)) : f;
+
+	return normalize(float3(xy, z));
+}
+
+//--------------------------------------------------------------------------------------
+// Decode the tangent angle around the normal, in the continuous orthonormal basis
+// [Duff et al. 2017], with the handedness in the top bit
+//--------------------------------------------------------------------------------------
+float4 DecodeTangent(uint u, float3 n)
+{
+	const float sign = Sign(n.z, 1.0);
+	const float a = -1.0 / (sign + n.z);
+	const float b = n.x * n.y * a;
+	const float3 b1 = float3(1.0 + sign * n.x * n.x * a, sign * b, -sign * n.x);
+	const float3 b2 = float3(b, sign + n.y * n.y * a, -n.y);
+
+	float s, c;
+	sincos((u & 0x7fff) * (6.283185307 / 32768.0), s, c);
+
+	return float4(b1 * c + b2 * s, (u & 0x8000) ? -1.0 : 1.0);
+}
+#endif
+
 //--------------------------------------------------------------------------------------
 // Load vertex data
 //--------------------------------------------------------------------------------------
@@ -93,13 +150,22 @@ VS_Input LoadVertex(uint i)
 	VS_Input vertex;
 
 	CS_Input vertexIn = g_roVertices[i];
+#ifdef _QUANTIZED_
+	const uint3 pos = uint3(vertexIn.PosTan & 0xffff, vertexIn.PosTan.x >> 16).xzy;
+	vertex.Pos = pos * g_posScale + g_posBias;
+	vertex.Norm = DecodeOctahedron(vertexIn.Norm);
+#ifdef _TANGENT_
+	vertex.Tan = DecodeTangent(vertexIn.PosTan.y >> 16, vertex.Norm);
+#endif
+#else
 	vertex.Pos = vertexIn.Pos;
-	vertex.Weights = DecodeRGBA8(vertexIn.Weights);
-	vertex.Bones = DecodeRGBA8u(vertexIn.Bones);
 	vertex.Norm = DecodeRGB16f(vertexIn.Norm);
 #ifdef _TANGENT_
 	vertex.Tan = DecodeRGBA16f(vertexIn.Tan);
 #endif
+#endif
+	vertex.Weights = DecodeRGBA8(vertexIn.Weights);
+	vertex.Bones = DecodeRGBA8u(vertexIn.Bones);
 	vertex.UV = vertexIn.UV;
 	
 	return vertex;
@@ -0,0 +1,8 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) XU, Tianchen. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+// Skinning of the vertices quantized by VertexQuantizer
+#define _QUANTIZED_
+
+#include "CSSkinning.hlsl"